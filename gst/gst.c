@@ -141,6 +141,9 @@ extern gboolean _priv_gst_disable_registry_update;
 
 gchar *_gst_executable_path = NULL;
 
+extern guint _priv_gst_pipeline_max_threads;
+extern gchar *_priv_gst_pipeline_cpu_set;
+
 #ifndef GST_DISABLE_GST_DEBUG
 const gchar *priv_gst_dump_dot_dir;
 #endif
@@ -190,7 +193,9 @@ enum
   ARG_PLUGIN_LOAD,
   ARG_SEGTRAP_DISABLE,
   ARG_REGISTRY_UPDATE_DISABLE,
-  ARG_REGISTRY_FORK_DISABLE
+  ARG_REGISTRY_FORK_DISABLE,
+  ARG_PIPELINE_MAX_THREADS,
+  ARG_PIPELINE_CPU_SET
 };
 
 /* debug-spec ::= category-spec [, category-spec]*
@@ -302,6 +307,16 @@ gst_init_get_option_group (void)
           (gpointer) parse_goption_arg,
           N_("Disable spawning a helper process while scanning the registry"),
         NULL},
+    {"gst-pipeline-max-threads", 0, 0, G_OPTION_ARG_CALLBACK,
+          (gpointer) parse_goption_arg,
+          N_("Default maximum number of streaming threads per pipeline, "
+              "0 for no limit"),
+        N_("THREADS")},
+    {"gst-pipeline-cpu-set", 0, 0, G_OPTION_ARG_CALLBACK,
+          (gpointer) parse_goption_arg,
+          N_("Default comma-separated list of CPUs and CPU ranges the "
+              "streaming threads of pipelines run on. Example: 0-3,6"),
+        N_("CPUS")},
     {NULL}
   };
 
@@ -596,6 +611,17 @@ init_pre (GOptionContext * context, GOptionGroup * group, gpointer data,
   }
 #endif
 
+  {
+    const gchar *env;
+
+    if ((env = g_getenv ("GST_PIPELINE_MAX_THREADS")))
+      _priv_gst_pipeline_max_threads = strtoul (env, NULL, 10);
+    if ((env = g_getenv ("GST_PIPELINE_CPU_SET"))) {
+      g_free (_priv_gst_pipeline_cpu_set);
+      _priv_gst_pipeline_cpu_set = g_strdup (env);
+    }
+  }
+
   /* Print some basic system details if possible (OS/architecture) */
 #ifdef HAVE_SYS_UTSNAME_H
   {
@@ -1007,6 +1033,13 @@ parse_one_option (gint opt, const gchar * arg, GError ** err)
     case ARG_REGISTRY_FORK_DISABLE:
       gst_registry_fork_set_enabled (FALSE);
       break;
+    case ARG_PIPELINE_MAX_THREADS:
+      _priv_gst_pipeline_max_threads = strtoul (arg, NULL, 10);
+      break;
+    case ARG_PIPELINE_CPU_SET:
+      g_free (_priv_gst_pipeline_cpu_set);
+      _priv_gst_pipeline_cpu_set = g_strdup (arg);
+      break;
     default:
       g_set_error (err, G_OPTION_ERROR, G_OPTION_ERROR_UNKNOWN_OPTION,
           _("Unknown option"));
@@ -1044,6 +1077,8 @@ parse_goption_arg (const gchar * opt,
     "--gst-disable-segtrap", ARG_SEGTRAP_DISABLE}, {
     "--gst-disable-registry-update", ARG_REGISTRY_UPDATE_DISABLE}, {
     "--gst-disable-registry-fork", ARG_REGISTRY_FORK_DISABLE}, {
+    "--gst-pipeline-max-threads", ARG_PIPELINE_MAX_THREADS}, {
+    "--gst-pipeline-cpu-set", ARG_PIPELINE_CPU_SET}, {
     NULL}
   };
   gint val = 0, n;
@@ -1109,10 +1144,14 @@ gst_deinit (void)
     _gst_executable_path = NULL;
   }
 
+  g_free (_priv_gst_pipeline_cpu_set);
+  _priv_gst_pipeline_cpu_set = NULL;
+
   clock = gst_system_clock_obtain ();
   gst_object_unref (clock);
   gst_object_unref (clock);
 
+  _priv_gst_element_factory_cleanup ();
   _priv_gst_registry_cleanup ();
   _priv_gst_allocator_cleanup ();
 
@@ -57,6 +57,9 @@ extern const char             g_log_domain_gstreamer[];
 /* for GstElement */
 #include "gstelement.h"
 
+/* for the caps cache of toplevel bins */
+#include "gstbin.h"
+
 /* for GstDeviceProvider */
 #include "gstdeviceprovider.h"
 
@@ -67,6 +70,9 @@ extern const char             g_log_domain_gstreamer[];
 
 #include "gsttracerutils.h"
 
+/* for GstPoll */
+#include "gstpoll.h"
+
 G_BEGIN_DECLS
 
 /* used by gstparse.c and grammar.y */
@@ -90,6 +96,12 @@ typedef struct {
 struct _GstPluginPrivate {
   GList *deps;    /* list of GstPluginDep structures */
   GstStructure *cache_data;
+
+  /* static plugin from gst_registry_add_prelinked() whose init function
+   * did not run yet, it is set by gst_plugin_register_static() */
+  gboolean prelinked;
+  GstPluginInitFunc prelinked_init;
+  gpointer prelinked_user_data;
 };
 
 /* FIXME: could rename all priv_gst_* functions to __gst_* now */
@@ -134,6 +146,7 @@ G_GNUC_INTERNAL  void  _priv_gst_date_time_initialize (void);
 G_GNUC_INTERNAL  void  _priv_gst_allocator_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_caps_features_cleanup (void);
 G_GNUC_INTERNAL  void  _priv_gst_caps_cleanup (void);
+G_GNUC_INTERNAL  void  _priv_gst_element_factory_cleanup (void);
 
 /* called from gst_task_cleanup_all(). */
 G_GNUC_INTERNAL  void  _priv_gst_element_cleanup (void);
@@ -142,6 +155,32 @@ G_GNUC_INTERNAL  void  _priv_gst_element_cleanup (void);
 G_GNUC_INTERNAL
 gboolean _priv_gst_registry_remove_cache_plugins (GstRegistry *registry);
 
+/* directory fingerprints stored in the registry cache */
+typedef struct {
+  gint64    mtime;
+  guint     n_entries;
+  gboolean  seen;        /* checked by the current scan */
+} GstRegistryDirFingerprint;
+
+G_GNUC_INTERNAL
+GHashTable * _priv_gst_registry_get_dir_fingerprints (GstRegistry *registry);
+
+/* feature in the mapped registry cache, created when it is first used */
+typedef struct {
+  const gchar  *name;
+  gchar        *data;         /* first chunk of the feature */
+  GstPlugin    *plugin;       /* NULL once the plugin was replaced */
+  const gchar  *plugin_name;
+  gboolean      pending;      /* not created or dropped yet */
+} GstRegistryLazyFeature;
+
+/* takes @features, sorted by name */
+G_GNUC_INTERNAL
+void _priv_gst_registry_add_lazy_features (GstRegistry *registry,
+                                           GBytes *backing,
+                                           GstRegistryLazyFeature *features,
+                                           guint n_features);
+
 G_GNUC_INTERNAL  void _priv_gst_registry_cleanup (void);
 
 GST_API
@@ -159,11 +198,22 @@ G_GNUC_INTERNAL gboolean _priv_gst_value_parse_string (gchar * s, gchar ** end,
 G_GNUC_INTERNAL gboolean _priv_gst_value_parse_simple_string (gchar * str, gchar ** end);
 G_GNUC_INTERNAL gboolean _priv_gst_value_parse_value (gchar * str, gchar ** after, GValue * value, GType default_type);
 G_GNUC_INTERNAL gchar * _priv_gst_value_serialize_any_list (const GValue * value, const gchar * begin, const gchar * end, gboolean print_type);
+G_GNUC_INTERNAL gint _priv_gst_value_intersect_fast (GValue * dest, const GValue * value1, const GValue * value2);
+G_GNUC_INTERNAL gint _priv_gst_value_is_subset_fast (const GValue * value1, const GValue * value2);
+
+/* Used by the binary value serialization */
+G_GNUC_INTERNAL GstStructure * _priv_gst_structure_new_backed (GQuark quark, guint prealloc, GBytes * backing);
 
 /* Used in GstBin for manual state handling */
 G_GNUC_INTERNAL  void _priv_gst_element_state_changed (GstElement *element,
                       GstState oldstate, GstState newstate, GstState pending);
 
+/* Drops the cached caps query results of all pads in the toplevel bin of
+ * @object, or of all pads outside of bins */
+G_GNUC_INTERNAL  void _priv_gst_pad_caps_cache_invalidate (GstObject *object);
+G_GNUC_INTERNAL  gint _priv_gst_pad_caps_cache_new_cookie (void);
+G_GNUC_INTERNAL  gint * _priv_gst_bin_get_caps_cache_cookie (GstBin *bin);
+
 /* used in both gststructure.c and gstcaps.c; numbers are completely made up */
 #define STRUCTURE_ESTIMATED_STRING_LEN(s) (16 + gst_structure_n_fields(s) * 22)
 #define FEATURES_ESTIMATED_STRING_LEN(s) (16 + gst_caps_features_get_size(s) * 14)
@@ -179,6 +229,18 @@ gboolean priv__gst_structure_append_template_to_gstring (GQuark field_id,
 G_GNUC_INTERNAL
 void priv_gst_caps_features_append_to_gstring (const GstCapsFeatures * features, GString *s);
 
+/* sorted structure names of interned caps, also used for the compiled pad
+ * templates of element factories */
+typedef struct {
+  guint n_names;
+  GQuark names[1];
+} GstCapsMediaTypes;
+
+G_GNUC_INTERNAL
+gint priv_gst_caps_compare_quarks (gconstpointer a, gconstpointer b, gpointer user_data);
+G_GNUC_INTERNAL
+gboolean priv_gst_caps_media_types_contain (const GstCapsMediaTypes * types, GQuark name);
+
 G_GNUC_INTERNAL
 gboolean priv_gst_structure_parse_name (gchar * str, gchar **start, gchar ** end, gchar ** next);
 G_GNUC_INTERNAL
@@ -191,12 +253,23 @@ gboolean priv_gst_structure_parse_fields (gchar *str, gchar ** end, GstStructure
 G_GNUC_INTERNAL
 gchar *priv_gst_string_take_and_wrap (gchar * s);
 
+/* used by gstbus.c to acknowledge several messages at once */
+G_GNUC_INTERNAL
+guint priv_gst_poll_read_control_many (GstPoll * set, guint count);
+
+/* used by gstpipeline.c to share the threads of the default task pool */
+G_GNUC_INTERNAL
+GstTaskPool * priv_gst_task_get_default_pool (void);
+
 /* registry cache backends */
 G_GNUC_INTERNAL
 gboolean		priv_gst_registry_binary_read_cache	(GstRegistry * registry, const char *location);
 
 G_GNUC_INTERNAL
-gboolean		priv_gst_registry_binary_write_cache	(GstRegistry * registry, GList * plugins, const char *location);
+gboolean		priv_gst_registry_binary_write_cache	(GstRegistry * registry, GList * plugins, const char *location, gboolean prelinked);
+
+G_GNUC_INTERNAL
+gboolean		priv_gst_registry_binary_read_prelinked	(GstRegistry * registry, const guint8 * data, gsize size);
 
 
 G_GNUC_INTERNAL
@@ -207,6 +280,12 @@ G_GNUC_INTERNAL
 void      __gst_element_factory_add_interface           (GstElementFactory    * elementfactory,
                                                          const gchar          * interfacename);
 
+G_GNUC_INTERNAL
+gboolean  _priv_gst_element_factory_can_accept_caps     (GstElementFactory    * factory,
+                                                         const GstCaps        * caps,
+                                                         GstPadDirection        direction,
+                                                         gboolean               subset);
+
 /* used in gstvalue.c and gststructure.c */
 #define GST_ASCII_IS_STRING(c) (g_ascii_isalnum((c)) || ((c) == '_') || \
     ((c) == '-') || ((c) == '+') || ((c) == '/') || ((c) == ':') || \
@@ -463,6 +542,15 @@ struct _GstElementFactory {
   GList *               interfaces;             /* interface type names this element implements */
 
   /*< private >*/
+  gpointer              compiled_templates;     /* created on first caps filtering */
+
+  /* serialized metadata from the registry cache, parsed on first use. Points
+   * into metadata_backing if that is set, else owned */
+  gchar *               metadata_string;
+  GBytes *              metadata_backing;
+  /* set when metadata_string could not be parsed */
+  gint                  metadata_invalid;
+
   gpointer _gst_reserved[GST_PADDING];
 };
 
@@ -136,6 +136,8 @@
 
 #include "gstutils.h"
 #include "gstchildproxy.h"
+#include "gsttaskpool.h"
+#include "gstsystemclock.h"
 
 GST_DEBUG_CATEGORY_STATIC (bin_debug);
 #define GST_CAT_DEFAULT bin_debug
@@ -167,8 +169,47 @@ struct _GstBinPrivate
   gboolean posted_eos;
   gboolean posted_playing;
   GstElementFlags suppressed_flags;
+
+  /* change the state of independent children concurrently */
+  gboolean parallel_state_change;
+  GstTaskPool *state_change_pool;
+
+  /* incremented whenever the topology of the children changes, also when
+   * the bin has the NO_RESYNC flag */
+  guint32 sort_cookie;
+  /* last topologically sorted children, valid for sorted_cache_cookie */
+  GArray *sorted_cache;
+  guint32 sorted_cache_cookie;
+
+  /* only requery the latency of the sinks downstream of a LATENCY message */
+  gboolean incremental_latency;
+  GstClockTime latency_debounce;
+  gboolean latency_pending;
+  /* waits for latency_debounce before recalculating */
+  GstClockID latency_id;
+  /* BinLatencyEntry of the sink children, query results are valid for
+   * latency_cache_cookie */
+  GHashTable *latency_cache;
+  guint32 latency_cache_cookie;
+
+  /* caps query results of the pads below a toplevel bin are valid while
+   * this is unchanged, see gstpad.c */
+  gint caps_cache_cookie;
 };
 
+typedef struct
+{
+  /* result of the last LATENCY query of the sink */
+  gboolean valid;
+  gboolean live;
+  GstClockTime min;
+  GstClockTime max;
+  /* incremented when the result is invalidated */
+  guint generation;
+  /* latency last configured on the sink, or GST_CLOCK_TIME_NONE */
+  GstClockTime configured;
+} BinLatencyEntry;
+
 typedef struct
 {
   guint32 cookie;
@@ -192,6 +233,8 @@ static void bin_handle_async_done (GstBin * bin, GstStateChangeReturn ret,
 static void bin_handle_async_start (GstBin * bin);
 static void bin_push_state_continue (GstBin * bin, BinContinueData * data);
 static void bin_do_eos (GstBin * bin);
+static void bin_latency_cache_invalidate (GstBin * bin, GstElement * sink);
+static void bin_unschedule_latency (GstBin * bin);
 
 static gboolean gst_bin_add_func (GstBin * bin, GstElement * element);
 static gboolean gst_bin_remove_func (GstBin * bin, GstElement * element);
@@ -241,12 +284,18 @@ enum
 
 #define DEFAULT_ASYNC_HANDLING	FALSE
 #define DEFAULT_MESSAGE_FORWARD	FALSE
+#define DEFAULT_PARALLEL_STATE_CHANGE	FALSE
+#define DEFAULT_INCREMENTAL_LATENCY	FALSE
+#define DEFAULT_LATENCY_DEBOUNCE	0
 
 enum
 {
   PROP_0,
   PROP_ASYNC_HANDLING,
   PROP_MESSAGE_FORWARD,
+  PROP_PARALLEL_STATE_CHANGE,
+  PROP_INCREMENTAL_LATENCY,
+  PROP_LATENCY_DEBOUNCE,
   PROP_LAST
 };
 
@@ -445,6 +494,70 @@ gst_bin_class_init (GstBinClass * klass)
           "Forwards all children messages",
           DEFAULT_MESSAGE_FORWARD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstBin:parallel-state-change:
+   *
+   * Change the state of children that do not depend on each other
+   * concurrently. The children are grouped in topological levels, where
+   * the children of one level are not linked to each other and are only
+   * linked downstream to children of the previous levels. The state of all
+   * children of a level is changed on a #GstTaskPool and the bin waits for
+   * all of them before continuing with the next level.
+   *
+   * This can reduce the time needed for state changes of wide pipelines with
+   * many independent branches where elements are slow to change state, for
+   * example because they open devices or files. All children must be safe
+   * to change state from another thread than the one changing the state of
+   * the bin.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_PARALLEL_STATE_CHANGE,
+      g_param_spec_boolean ("parallel-state-change", "Parallel State Change",
+          "Change the state of independent children concurrently",
+          DEFAULT_PARALLEL_STATE_CHANGE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBin:incremental-latency:
+   *
+   * Cache the result of the LATENCY query of every sink child and only query
+   * the sinks again that are downstream of an element that posted a
+   * #GST_MESSAGE_LATENCY, or when the links between the children changed.
+   * A LATENCY event is only sent to the sinks that did not get the same
+   * latency configured before.
+   *
+   * When this is set on a toplevel bin, the bin also recalculates the
+   * latency itself when a child posts a #GST_MESSAGE_LATENCY, after waiting
+   * for #GstBin:latency-debounce. The message is then not posted on the bus,
+   * so applications don't recalculate the latency a second time.
+   *
+   * Child bins need this property set as well to benefit from it.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_INCREMENTAL_LATENCY,
+      g_param_spec_boolean ("incremental-latency", "Incremental Latency",
+          "Only requery the latency of the sinks affected by a latency change",
+          DEFAULT_INCREMENTAL_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBin:latency-debounce:
+   *
+   * Time in nanoseconds to wait after a #GST_MESSAGE_LATENCY before a
+   * toplevel bin in #GstBin:incremental-latency mode recalculates the
+   * latency. All LATENCY messages posted in this time are handled by one
+   * recalculation.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_LATENCY_DEBOUNCE,
+      g_param_spec_uint64 ("latency-debounce", "Latency Debounce",
+          "Time to wait for more latency changes before recalculating the "
+          "latency in nanoseconds", 0, G_MAXUINT64, DEFAULT_LATENCY_DEBOUNCE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->dispose = gst_bin_dispose;
 
   gst_element_class_set_static_metadata (gstelement_class, "Generic bin",
@@ -504,6 +617,10 @@ gst_bin_init (GstBin * bin)
   bin->priv->asynchandling = DEFAULT_ASYNC_HANDLING;
   bin->priv->structure_cookie = 0;
   bin->priv->message_forward = DEFAULT_MESSAGE_FORWARD;
+  bin->priv->parallel_state_change = DEFAULT_PARALLEL_STATE_CHANGE;
+  bin->priv->incremental_latency = DEFAULT_INCREMENTAL_LATENCY;
+  bin->priv->latency_debounce = DEFAULT_LATENCY_DEBOUNCE;
+  bin->priv->caps_cache_cookie = _priv_gst_pad_caps_cache_new_cookie ();
 }
 
 static void
@@ -513,16 +630,34 @@ gst_bin_dispose (GObject * object)
   GstBus **child_bus_p = &bin->child_bus;
   GstClock **provided_clock_p = &bin->provided_clock;
   GstElement **clock_provider_p = &bin->clock_provider;
+  GstTaskPool *state_change_pool;
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_REFCOUNTING, object, "%p dispose", object);
 
+  bin_unschedule_latency (bin);
+
   GST_OBJECT_LOCK (object);
   gst_object_replace ((GstObject **) child_bus_p, NULL);
   gst_object_replace ((GstObject **) provided_clock_p, NULL);
   gst_object_replace ((GstObject **) clock_provider_p, NULL);
   bin_remove_messages (bin, NULL, GST_MESSAGE_ANY);
+  state_change_pool = bin->priv->state_change_pool;
+  bin->priv->state_change_pool = NULL;
+  if (bin->priv->sorted_cache) {
+    g_array_free (bin->priv->sorted_cache, TRUE);
+    bin->priv->sorted_cache = NULL;
+  }
+  if (bin->priv->latency_cache) {
+    g_hash_table_destroy (bin->priv->latency_cache);
+    bin->priv->latency_cache = NULL;
+  }
   GST_OBJECT_UNLOCK (object);
 
+  if (state_change_pool) {
+    gst_task_pool_cleanup (state_change_pool);
+    gst_object_unref (state_change_pool);
+  }
+
   while (bin->children) {
     gst_bin_remove (bin, GST_ELEMENT_CAST (bin->children->data));
   }
@@ -567,6 +702,22 @@ gst_bin_set_property (GObject * object, guint prop_id,
       gstbin->priv->message_forward = g_value_get_boolean (value);
       GST_OBJECT_UNLOCK (gstbin);
       break;
+    case PROP_PARALLEL_STATE_CHANGE:
+      GST_OBJECT_LOCK (gstbin);
+      gstbin->priv->parallel_state_change = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_INCREMENTAL_LATENCY:
+      GST_OBJECT_LOCK (gstbin);
+      gstbin->priv->incremental_latency = g_value_get_boolean (value);
+      bin_latency_cache_invalidate (gstbin, NULL);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_LATENCY_DEBOUNCE:
+      GST_OBJECT_LOCK (gstbin);
+      gstbin->priv->latency_debounce = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -592,6 +743,21 @@ gst_bin_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, gstbin->priv->message_forward);
       GST_OBJECT_UNLOCK (gstbin);
       break;
+    case PROP_PARALLEL_STATE_CHANGE:
+      GST_OBJECT_LOCK (gstbin);
+      g_value_set_boolean (value, gstbin->priv->parallel_state_change);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_INCREMENTAL_LATENCY:
+      GST_OBJECT_LOCK (gstbin);
+      g_value_set_boolean (value, gstbin->priv->incremental_latency);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
+    case PROP_LATENCY_DEBOUNCE:
+      GST_OBJECT_LOCK (gstbin);
+      g_value_set_uint64 (value, gstbin->priv->latency_debounce);
+      GST_OBJECT_UNLOCK (gstbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1205,6 +1371,7 @@ gst_bin_add_func (GstBin * bin, GstElement * element)
   bin->children = g_list_prepend (bin->children, element);
   bin->numchildren++;
   bin->children_cookie++;
+  bin->priv->sort_cookie++;
   if (!GST_BIN_IS_NO_RESYNC (bin))
     bin->priv->structure_cookie++;
 
@@ -1642,6 +1809,9 @@ gst_bin_remove_func (GstBin * bin, GstElement * element)
    * so that others can detect a change in the children list. */
   bin->numchildren--;
   bin->children_cookie++;
+  bin->priv->sort_cookie++;
+  if (bin->priv->latency_cache)
+    g_hash_table_remove (bin->priv->latency_cache, element);
   if (!GST_BIN_IS_NO_RESYNC (bin))
     bin->priv->structure_cookie++;
 
@@ -2114,8 +2284,22 @@ typedef struct _GstBinSortIterator
   gint best_deg;                /* best degree */
   GHashTable *hash;             /* hashtable with element dependencies */
   gboolean dirty;               /* we detected structure change */
+  gboolean loop;                /* we detected a loop in the graph */
+  gboolean cached;              /* queue was filled from the bin sort cache */
+  guint32 sort_cookie;          /* sort cookie of the bin when we resynced */
+  GArray *order;                /* elements returned so far, for the cache */
 } GstBinSortIterator;
 
+/* an entry in the sort cache of the bin. We keep the flags that influence the
+ * sort order so that we can detect changes to them */
+typedef struct
+{
+  GstElement *element;
+  guint flags;
+} BinSortedChild;
+
+#define BIN_SORT_FLAGS (GST_ELEMENT_FLAG_SINK | GST_ELEMENT_FLAG_SOURCE)
+
 static void
 copy_to_queue (gpointer data, gpointer user_data)
 {
@@ -2144,6 +2328,79 @@ gst_bin_sort_iterator_copy (const GstBinSortIterator * it,
   g_hash_table_iter_init (&iter, it->hash);
   while (g_hash_table_iter_next (&iter, &key, &value))
     g_hash_table_insert (copy->hash, key, value);
+
+  copy->order = g_array_sized_new (FALSE, FALSE, sizeof (BinSortedChild),
+      it->order->len);
+  g_array_append_vals (copy->order, it->order->data, it->order->len);
+}
+
+/* check if the sort order cached in the bin is still valid. This is the case
+ * when no children were added, removed, linked or unlinked and none of them
+ * changed the flags we sort on since the cache was made.
+ * must be called with the bin LOCK held */
+static gboolean
+bin_sorted_cache_is_valid (GstBin * bin)
+{
+  GArray *cache = bin->priv->sorted_cache;
+  guint i;
+
+  if (cache == NULL || bin->priv->sorted_cache_cookie != bin->priv->sort_cookie)
+    return FALSE;
+
+  if (cache->len != bin->numchildren)
+    return FALSE;
+
+  /* pads busy in a link or unlink are not followed when sorting, the order
+   * will be different when the structure change completes */
+  if (find_message (bin, NULL, GST_MESSAGE_STRUCTURE_CHANGE))
+    return FALSE;
+
+  for (i = 0; i < cache->len; i++) {
+    BinSortedChild *child = &g_array_index (cache, BinSortedChild, i);
+
+    if ((GST_OBJECT_FLAGS (child->element) & BIN_SORT_FLAGS) != child->flags)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* store the order of a completed sort in the bin so that the next iterators
+ * can use it without sorting again.
+ * must be called with the bin LOCK held */
+static void
+bin_sorted_cache_store (GstBin * bin, GstBinSortIterator * bit)
+{
+  /* the structure changed while sorting, don't cache a stale order */
+  if (bit->dirty || bit->loop || bit->sort_cookie != bin->priv->sort_cookie)
+    return;
+
+  if (bit->order->len != bin->numchildren)
+    return;
+
+  if (find_message (bin, NULL, GST_MESSAGE_STRUCTURE_CHANGE))
+    return;
+
+  GST_DEBUG_OBJECT (bin, "caching sort order of %u children", bit->order->len);
+
+  if (bin->priv->sorted_cache)
+    g_array_free (bin->priv->sorted_cache, TRUE);
+  bin->priv->sorted_cache = g_array_sized_new (FALSE, FALSE,
+      sizeof (BinSortedChild), bit->order->len);
+  g_array_append_vals (bin->priv->sorted_cache, bit->order->data,
+      bit->order->len);
+  bin->priv->sorted_cache_cookie = bit->sort_cookie;
+}
+
+/* remember that @element was returned by the iterator */
+static void
+bin_sort_iterator_record (GstBinSortIterator * bit, GstElement * element)
+{
+  BinSortedChild child;
+
+  child.element = element;
+  child.flags = GST_OBJECT_FLAGS (element) & BIN_SORT_FLAGS;
+  g_array_append_val (bit->order, child);
 }
 
 /* we add and subtract 1 to make sure we don't confuse NULL and 0 */
@@ -2335,6 +2592,19 @@ gst_bin_sort_iterator_next (GstBinSortIterator * bit, GValue * result)
   GstElement *best;
   GstBin *bin = bit->bin;
 
+  /* the queue was filled in sorted order from the cache */
+  if (bit->cached) {
+    if ((best = g_queue_pop_head (&bit->queue)) == NULL) {
+      GST_DEBUG_OBJECT (bin, "cached queue empty, elements exhausted");
+      return GST_ITERATOR_DONE;
+    }
+    GST_DEBUG_OBJECT (bin, "cached queue head gives %s",
+        GST_ELEMENT_NAME (best));
+    g_value_set_object (result, best);
+    gst_object_unref (best);
+    return GST_ITERATOR_OK;
+  }
+
   /* empty queue, we have to find a next best element */
   if (g_queue_is_empty (&bit->queue)) {
     bit->best = NULL;
@@ -2348,6 +2618,7 @@ gst_bin_sort_iterator_next (GstBinSortIterator * bit, GValue * result)
         GST_WARNING_OBJECT (bin, "loop dected in graph");
         g_warning ("loop detected in the graph of bin '%s'!!",
             GST_ELEMENT_NAME (bin));
+        bit->loop = TRUE;
       }
       /* best unhandled element, schedule as next element */
       GST_DEBUG_OBJECT (bin, "queue empty, next best: %s",
@@ -2357,6 +2628,7 @@ gst_bin_sort_iterator_next (GstBinSortIterator * bit, GValue * result)
     } else {
       GST_DEBUG_OBJECT (bin, "queue empty, elements exhausted");
       /* no more unhandled elements, we are done */
+      bin_sorted_cache_store (bin, bit);
       return GST_ITERATOR_DONE;
     }
   } else {
@@ -2367,6 +2639,7 @@ gst_bin_sort_iterator_next (GstBinSortIterator * bit, GValue * result)
   }
 
   GST_DEBUG_OBJECT (bin, "queue head gives %s", GST_ELEMENT_NAME (best));
+  bin_sort_iterator_record (bit, best);
   /* update degrees of linked elements */
   update_degree (best, bit);
 
@@ -2381,7 +2654,26 @@ gst_bin_sort_iterator_resync (GstBinSortIterator * bit)
 
   GST_DEBUG_OBJECT (bin, "resync");
   bit->dirty = FALSE;
+  bit->loop = FALSE;
   clear_queue (&bit->queue);
+  g_array_set_size (bit->order, 0);
+  bit->sort_cookie = bin->priv->sort_cookie;
+
+  /* nothing changed since the last sort, reuse its order */
+  bit->cached = bin_sorted_cache_is_valid (bin);
+  if (bit->cached) {
+    GArray *cache = bin->priv->sorted_cache;
+    guint i;
+
+    GST_DEBUG_OBJECT (bin, "using cached sort order");
+    for (i = 0; i < cache->len; i++) {
+      GstElement *element = g_array_index (cache, BinSortedChild, i).element;
+
+      g_queue_push_tail (&bit->queue, gst_object_ref (element));
+    }
+    return;
+  }
+
   /* reset degrees */
   g_list_foreach (bin->children, (GFunc) reset_degree, bit);
   /* calc degrees, incrementing */
@@ -2400,6 +2692,7 @@ gst_bin_sort_iterator_free (GstBinSortIterator * bit)
   GST_DEBUG_OBJECT (bin, "free");
   clear_queue (&bit->queue);
   g_hash_table_destroy (bit->hash);
+  g_array_free (bit->order, TRUE);
   gst_object_unref (bin);
 }
 
@@ -2423,6 +2716,7 @@ gst_bin_sort_iterator_new (GstBin * bin)
       (GstIteratorFreeFunction) gst_bin_sort_iterator_free);
   g_queue_init (&result->queue);
   result->hash = g_hash_table_new (NULL, NULL);
+  result->order = g_array_new (FALSE, FALSE, sizeof (BinSortedChild));
   gst_object_ref (bin);
   result->bin = bin;
   gst_bin_sort_iterator_resync (result);
@@ -2441,6 +2735,9 @@ gst_bin_sort_iterator_new (GstBin * bin)
  * This function is used internally to perform the state changes
  * of the bin elements and for clock selection.
  *
+ * The sort order is cached in the bin and reused by later iterators
+ * until children are added, removed, linked or unlinked.
+ *
  * MT safe.  Caller owns returned value.
  *
  * Returns: (transfer full) (nullable): a #GstIterator of #GstElement,
@@ -2739,6 +3036,351 @@ gst_bin_recalculate_latency (GstBin * bin)
   return res;
 }
 
+static void
+bin_latency_entry_free (BinLatencyEntry * entry)
+{
+  g_slice_free (BinLatencyEntry, entry);
+}
+
+/* invalidates the cached LATENCY query result of @sink, or of all sinks when
+ * @sink is %NULL. Must be called with the bin LOCK */
+static void
+bin_latency_cache_invalidate (GstBin * bin, GstElement * sink)
+{
+  BinLatencyEntry *entry;
+  GHashTableIter iter;
+
+  if (bin->priv->latency_cache == NULL)
+    return;
+
+  if (sink) {
+    if ((entry = g_hash_table_lookup (bin->priv->latency_cache, sink))) {
+      entry->valid = FALSE;
+      entry->generation++;
+    }
+    return;
+  }
+
+  g_hash_table_iter_init (&iter, bin->priv->latency_cache);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) & entry)) {
+    entry->valid = FALSE;
+    entry->generation++;
+  }
+}
+
+/* must be called with the bin LOCK */
+static BinLatencyEntry *
+bin_latency_cache_get (GstBin * bin, GstElement * sink)
+{
+  BinLatencyEntry *entry;
+
+  if (bin->priv->latency_cache == NULL)
+    bin->priv->latency_cache = g_hash_table_new_full (NULL, NULL, NULL,
+        (GDestroyNotify) bin_latency_entry_free);
+
+  /* children were added, removed, linked or unlinked, the latency of all
+   * sinks might have changed */
+  if (bin->priv->latency_cache_cookie != bin->priv->sort_cookie) {
+    bin_latency_cache_invalidate (bin, NULL);
+    bin->priv->latency_cache_cookie = bin->priv->sort_cookie;
+  }
+
+  entry = g_hash_table_lookup (bin->priv->latency_cache, sink);
+  if (entry == NULL) {
+    entry = g_slice_new0 (BinLatencyEntry);
+    entry->configured = GST_CLOCK_TIME_NONE;
+    g_hash_table_insert (bin->priv->latency_cache, sink, entry);
+  }
+  return entry;
+}
+
+/* LATENCY query in incremental-latency mode, only the sinks without a valid
+ * cached result are queried. Returns FALSE when a sink could not be queried,
+ * the caller then falls back to the normal query. */
+static gboolean
+bin_query_latency_cached (GstBin * bin, GstQuery * query)
+{
+  GstIterator *iter;
+  GValue data = { 0, };
+  gboolean done = FALSE, res = TRUE;
+  gboolean live = FALSE;
+  GstClockTime min = 0, max = GST_CLOCK_TIME_NONE;
+
+  iter = gst_bin_iterate_sinks (bin);
+  while (!done && res) {
+    switch (gst_iterator_next (iter, &data)) {
+      case GST_ITERATOR_OK:
+      {
+        GstElement *child = g_value_get_object (&data);
+        BinLatencyEntry *entry;
+        gboolean c_live, valid;
+        GstClockTime c_min, c_max;
+        guint generation;
+
+        GST_OBJECT_LOCK (bin);
+        entry = bin_latency_cache_get (bin, child);
+        valid = entry->valid;
+        c_live = entry->live;
+        c_min = entry->min;
+        c_max = entry->max;
+        generation = entry->generation;
+        GST_OBJECT_UNLOCK (bin);
+
+        if (valid) {
+          GST_LOG_OBJECT (child, "using cached latency");
+        } else {
+          GstQuery *cquery = gst_query_new_latency ();
+
+          if ((res = gst_element_query (child, cquery))) {
+            gst_query_parse_latency (cquery, &c_live, &c_min, &c_max);
+
+            /* don't cache the result when it was invalidated meanwhile */
+            GST_OBJECT_LOCK (bin);
+            entry = bin_latency_cache_get (bin, child);
+            if (entry->generation == generation) {
+              entry->valid = TRUE;
+              entry->live = c_live;
+              entry->min = c_min;
+              entry->max = c_max;
+            }
+            GST_OBJECT_UNLOCK (bin);
+          } else {
+            GST_DEBUG_OBJECT (child, "failed query");
+          }
+          gst_query_unref (cquery);
+        }
+
+        /* for the combined latency we collect the MAX of all min latencies
+         * and the MIN of all max latencies */
+        if (res && c_live) {
+          if (c_min > min)
+            min = c_min;
+          if (c_max < max)
+            max = c_max;
+          live = TRUE;
+        }
+        g_value_reset (&data);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (iter);
+        live = FALSE;
+        min = 0;
+        max = GST_CLOCK_TIME_NONE;
+        break;
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
+      case GST_ITERATOR_ERROR:
+        res = FALSE;
+        break;
+    }
+  }
+  g_value_unset (&data);
+  gst_iterator_free (iter);
+
+  if (res) {
+    GST_DEBUG_OBJECT (bin,
+        "latency min %" GST_TIME_FORMAT ", max %" GST_TIME_FORMAT
+        ", live %d", GST_TIME_ARGS (min), GST_TIME_ARGS (max), live);
+    gst_query_set_latency (query, live, min, max);
+  }
+
+  return res;
+}
+
+/* invalidates the cached latency of the sinks downstream of the child of @bin
+ * that contains @src */
+static void
+bin_latency_cache_invalidate_downstream (GstBin * bin, GstObject * src)
+{
+  GstObject *child, *parent;
+  GQueue queue = G_QUEUE_INIT;
+  GHashTable *visited;
+  GstElement *element;
+
+  /* find the child of the bin that contains src */
+  child = src ? gst_object_ref (src) : NULL;
+  while (child) {
+    parent = gst_object_get_parent (child);
+    if (parent == GST_OBJECT_CAST (bin)) {
+      gst_object_unref (parent);
+      break;
+    }
+    gst_object_unref (child);
+    child = parent;
+  }
+
+  if (child == NULL || !GST_IS_ELEMENT (child)) {
+    GST_DEBUG_OBJECT (bin, "latency change not from a child, invalidating all");
+    GST_OBJECT_LOCK (bin);
+    bin_latency_cache_invalidate (bin, NULL);
+    GST_OBJECT_UNLOCK (bin);
+    if (child)
+      gst_object_unref (child);
+    return;
+  }
+
+  /* follow the links downstream within the bin */
+  visited = g_hash_table_new (NULL, NULL);
+  g_hash_table_add (visited, child);
+  g_queue_push_tail (&queue, child);
+  while ((element = g_queue_pop_head (&queue))) {
+    GstIterator *it;
+    GValue data = { 0, };
+    gboolean done = FALSE;
+
+    GST_OBJECT_LOCK (bin);
+    bin_latency_cache_invalidate (bin, element);
+    GST_OBJECT_UNLOCK (bin);
+
+    it = gst_element_iterate_src_pads (element);
+    while (!done) {
+      switch (gst_iterator_next (it, &data)) {
+        case GST_ITERATOR_OK:
+        {
+          GstPad *peer = gst_pad_get_peer (g_value_get_object (&data));
+
+          if (peer) {
+            GstObject *peer_parent = gst_pad_get_parent (peer);
+
+            if (peer_parent && GST_IS_ELEMENT (peer_parent)
+                && gst_object_has_as_parent (peer_parent,
+                    GST_OBJECT_CAST (bin))
+                && !g_hash_table_contains (visited, peer_parent)) {
+              g_hash_table_add (visited, peer_parent);
+              g_queue_push_tail (&queue, peer_parent);
+            } else if (peer_parent) {
+              gst_object_unref (peer_parent);
+            }
+            gst_object_unref (peer);
+          }
+          g_value_reset (&data);
+          break;
+        }
+        case GST_ITERATOR_RESYNC:
+          gst_iterator_resync (it);
+          break;
+        default:
+          done = TRUE;
+          break;
+      }
+    }
+    g_value_unset (&data);
+    gst_iterator_free (it);
+    gst_object_unref (element);
+  }
+  g_hash_table_destroy (visited);
+}
+
+static void
+bin_recalculate_latency_async (GstElement * element, gpointer user_data)
+{
+  GstBin *bin = GST_BIN_CAST (element);
+
+  GST_OBJECT_LOCK (bin);
+  bin->priv->latency_pending = FALSE;
+  GST_OBJECT_UNLOCK (bin);
+
+  gst_bin_recalculate_latency (bin);
+}
+
+static gboolean
+bin_latency_debounce_done (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data)
+{
+  GstBin *bin;
+
+  if (!(bin = g_weak_ref_get ((GWeakRef *) user_data)))
+    return TRUE;
+
+  GST_OBJECT_LOCK (bin);
+  if (bin->priv->latency_id == id) {
+    gst_clock_id_unref (bin->priv->latency_id);
+    bin->priv->latency_id = NULL;
+  }
+  GST_OBJECT_UNLOCK (bin);
+
+  gst_element_call_async (GST_ELEMENT_CAST (bin),
+      bin_recalculate_latency_async, NULL, NULL);
+  gst_object_unref (bin);
+
+  return TRUE;
+}
+
+static void
+bin_latency_weak_ref_free (GWeakRef * ref)
+{
+  g_weak_ref_clear (ref);
+  g_free (ref);
+}
+
+/* recalculates the latency from another thread, all LATENCY messages that
+ * arrive before that are handled by the same recalculation */
+static void
+bin_schedule_latency (GstBin * bin)
+{
+  GstClockTime debounce;
+  GstClock *clock;
+  GstClockID id;
+  GWeakRef *ref;
+
+  GST_OBJECT_LOCK (bin);
+  if (!BIN_IS_TOPLEVEL (bin) || bin->priv->latency_pending) {
+    GST_OBJECT_UNLOCK (bin);
+    return;
+  }
+  bin->priv->latency_pending = TRUE;
+  debounce = bin->priv->latency_debounce;
+  GST_OBJECT_UNLOCK (bin);
+
+  if (debounce == 0) {
+    gst_element_call_async (GST_ELEMENT_CAST (bin),
+        bin_recalculate_latency_async, NULL, NULL);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (bin, "recalculating latency in %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (debounce));
+
+  clock = gst_system_clock_obtain ();
+  id = gst_clock_new_single_shot_id (clock,
+      gst_clock_get_time (clock) + debounce);
+
+  GST_OBJECT_LOCK (bin);
+  bin->priv->latency_id = gst_clock_id_ref (id);
+  GST_OBJECT_UNLOCK (bin);
+
+  /* the wait is unscheduled when the bin is disposed, it only keeps a weak
+   * reference */
+  ref = g_new0 (GWeakRef, 1);
+  g_weak_ref_init (ref, bin);
+  gst_clock_id_wait_async (id, bin_latency_debounce_done, ref,
+      (GDestroyNotify) bin_latency_weak_ref_free);
+  gst_clock_id_unref (id);
+  gst_object_unref (clock);
+}
+
+/* cancels a scheduled recalculation that did not start yet */
+static void
+bin_unschedule_latency (GstBin * bin)
+{
+  GstClockID id;
+
+  GST_OBJECT_LOCK (bin);
+  id = bin->priv->latency_id;
+  bin->priv->latency_id = NULL;
+  if (id)
+    bin->priv->latency_pending = FALSE;
+  GST_OBJECT_UNLOCK (bin);
+
+  if (id) {
+    GST_DEBUG_OBJECT (bin, "unscheduling latency recalculation");
+    gst_clock_id_unschedule (id);
+    gst_clock_id_unref (id);
+  }
+}
+
 static gboolean
 gst_bin_do_latency_func (GstBin * bin)
 {
@@ -2829,6 +3471,325 @@ reset_state (const GValue * data, gpointer user_data)
         gst_element_state_get_name (state));
 }
 
+/* handle the result of changing the state of @child to @next. Returns %FALSE
+ * when the state change of @bin has to be undone. */
+static gboolean
+gst_bin_handle_child_state_return (GstBin * bin, GstElement * child,
+    GstState next, GstStateChangeReturn ret, gboolean * have_async,
+    gboolean * have_no_preroll)
+{
+  GstElement *element = GST_ELEMENT_CAST (bin);
+
+  switch (ret) {
+    case GST_STATE_CHANGE_SUCCESS:
+      GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
+          "child '%s' changed state to %d(%s) successfully",
+          GST_ELEMENT_NAME (child), next, gst_element_state_get_name (next));
+      break;
+    case GST_STATE_CHANGE_ASYNC:
+    {
+      GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
+          "child '%s' is changing state asynchronously to %s",
+          GST_ELEMENT_NAME (child), gst_element_state_get_name (next));
+      *have_async = TRUE;
+      break;
+    }
+    case GST_STATE_CHANGE_FAILURE:{
+      GstObject *parent;
+
+      GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
+          "child '%s' failed to go to state %d(%s)",
+          GST_ELEMENT_NAME (child), next, gst_element_state_get_name (next));
+
+      /* Only fail if the child is still inside
+       * this bin. It might've been removed already
+       * because of the error by the bin subclass
+       * to ignore the error.  */
+      parent = gst_object_get_parent (GST_OBJECT_CAST (child));
+      if (parent == GST_OBJECT_CAST (element)) {
+        /* element is still in bin, really error now */
+        gst_object_unref (parent);
+        return FALSE;
+      }
+      /* child removed from bin, let the resync code redo the state
+       * change */
+      GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
+          "child '%s' was removed from the bin", GST_ELEMENT_NAME (child));
+
+      if (parent)
+        gst_object_unref (parent);
+
+      break;
+    }
+    case GST_STATE_CHANGE_NO_PREROLL:
+      GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
+          "child '%s' changed state to %d(%s) successfully without preroll",
+          GST_ELEMENT_NAME (child), next, gst_element_state_get_name (next));
+      *have_no_preroll = TRUE;
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+  }
+
+  return TRUE;
+}
+
+/* get the topological level of @element, given the levels of the elements
+ * that were handled before in state change order. Elements without
+ * handled downstream peers are at level 0, all others are one level after
+ * their highest downstream peer. Levels are stored +1 in @levels so that
+ * we don't confuse NULL and 0. */
+static guint
+bin_element_get_level (GstElement * element, GHashTable * levels)
+{
+  guint level = 0;
+  GList *pads;
+
+  GST_OBJECT_LOCK (element);
+  for (pads = element->srcpads; pads; pads = g_list_next (pads)) {
+    GstPad *peer;
+
+    if ((peer = gst_pad_get_peer (GST_PAD_CAST (pads->data)))) {
+      GstElement *peer_element;
+
+      if ((peer_element = gst_pad_get_parent_element (peer))) {
+        /* peers outside of the bin or not handled yet (in a loop) are not
+         * in the table and give 0 */
+        level = MAX (level, GPOINTER_TO_UINT (g_hash_table_lookup (levels,
+                    peer_element)));
+        gst_object_unref (peer_element);
+      }
+      gst_object_unref (peer);
+    }
+  }
+  GST_OBJECT_UNLOCK (element);
+
+  return level;
+}
+
+/* get the children of @bin in state change order, grouped in topological
+ * levels. Returns an array of levels, each an array of reffed children. */
+static GPtrArray *
+gst_bin_get_sorted_levels (GstBin * bin)
+{
+  GstIterator *it;
+  GHashTable *levels_hash;
+  GPtrArray *levels;
+  GValue data = { 0, };
+  gboolean done = FALSE;
+
+  levels_hash = g_hash_table_new (NULL, NULL);
+  levels = g_ptr_array_new_with_free_func ((GDestroyNotify) g_ptr_array_unref);
+
+  it = gst_bin_iterate_sorted (bin);
+  while (!done) {
+    switch (gst_iterator_next (it, &data)) {
+      case GST_ITERATOR_OK:
+      {
+        GstElement *child;
+        guint level;
+
+        child = g_value_get_object (&data);
+        level = bin_element_get_level (child, levels_hash);
+        g_hash_table_insert (levels_hash, child, GUINT_TO_POINTER (level + 1));
+
+        /* levels only ever grow by one */
+        if (level == levels->len)
+          g_ptr_array_add (levels,
+              g_ptr_array_new_with_free_func ((GDestroyNotify)
+                  gst_object_unref));
+        g_ptr_array_add (g_ptr_array_index (levels, level),
+            gst_object_ref (child));
+
+        GST_CAT_LOG_OBJECT (GST_CAT_STATES, bin, "child '%s' at level %u",
+            GST_ELEMENT_NAME (child), level);
+        g_value_reset (&data);
+        break;
+      }
+      case GST_ITERATOR_RESYNC:
+        GST_CAT_DEBUG_OBJECT (GST_CAT_STATES, bin, "iterator doing resync");
+        g_hash_table_remove_all (levels_hash);
+        g_ptr_array_set_size (levels, 0);
+        gst_iterator_resync (it);
+        break;
+      default:
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
+    }
+  }
+  g_value_unset (&data);
+  gst_iterator_free (it);
+  g_hash_table_destroy (levels_hash);
+
+  return levels;
+}
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} BinStateLevel;
+
+typedef struct
+{
+  GstBin *bin;
+  GstElement *child;
+  GstClockTime base_time;
+  GstClockTime start_time;
+  GstState current;
+  GstState next;
+  GstStateChangeReturn ret;
+  BinStateLevel *level;
+} BinChildStateChange;
+
+static void
+bin_child_state_change_func (BinChildStateChange * change)
+{
+  BinStateLevel *level = change->level;
+
+  change->ret = gst_bin_element_set_state (change->bin, change->child,
+      change->base_time, change->start_time, change->current, change->next);
+
+  g_mutex_lock (&level->lock);
+  if (--level->pending == 0)
+    g_cond_signal (&level->cond);
+  g_mutex_unlock (&level->lock);
+}
+
+/* run the state change of a child on the task pool of @bin. Returns %FALSE
+ * when this was not possible and the state change has to be done from
+ * the calling thread. */
+static gboolean
+gst_bin_push_child_state_change (GstBin * bin, BinChildStateChange * change)
+{
+  GstTaskPool *pool;
+  GError *error = NULL;
+
+  GST_OBJECT_LOCK (bin);
+  if (G_UNLIKELY (bin->priv->state_change_pool == NULL)) {
+    pool = gst_task_pool_new ();
+    gst_task_pool_prepare (pool, &error);
+    if (G_UNLIKELY (error != NULL)) {
+      GST_OBJECT_UNLOCK (bin);
+      gst_object_unref (pool);
+      goto push_failed;
+    }
+    bin->priv->state_change_pool = pool;
+  }
+  pool = gst_object_ref (bin->priv->state_change_pool);
+  GST_OBJECT_UNLOCK (bin);
+
+  gst_task_pool_push (pool, (GstTaskPoolFunction) bin_child_state_change_func,
+      change, &error);
+  gst_object_unref (pool);
+  if (G_UNLIKELY (error != NULL))
+    goto push_failed;
+
+  return TRUE;
+
+  /* ERRORS */
+push_failed:
+  {
+    GST_CAT_WARNING_OBJECT (GST_CAT_STATES, bin,
+        "failed to push state change of '%s' to the task pool: %s",
+        GST_ELEMENT_NAME (change->child), error->message);
+    g_clear_error (&error);
+    return FALSE;
+  }
+}
+
+/* change the state of the children of @bin level by level, the children of
+ * one level concurrently. Returns %FALSE when the state change of @bin has
+ * to be undone. */
+static gboolean
+gst_bin_change_children_state_parallel (GstBin * bin, GstState current,
+    GstState next, gboolean * have_async, gboolean * have_no_preroll)
+{
+  GstElement *element = GST_ELEMENT_CAST (bin);
+  GstClockTime base_time, start_time;
+  BinStateLevel level;
+  GPtrArray *levels;
+  guint32 cookie;
+  gboolean res = TRUE, resync;
+  guint i, j;
+
+  g_mutex_init (&level.lock);
+  g_cond_init (&level.cond);
+
+  do {
+    GST_OBJECT_LOCK (bin);
+    cookie = bin->priv->structure_cookie;
+    GST_OBJECT_UNLOCK (bin);
+
+    /* take base_time */
+    base_time = gst_element_get_base_time (element);
+    start_time = gst_element_get_start_time (element);
+
+    *have_no_preroll = FALSE;
+
+    levels = gst_bin_get_sorted_levels (bin);
+
+    for (i = 0; i < levels->len && res; i++) {
+      GPtrArray *children = g_ptr_array_index (levels, i);
+      BinChildStateChange *changes;
+
+      GST_CAT_DEBUG_OBJECT (GST_CAT_STATES, bin,
+          "changing state of %u children at level %u", children->len, i);
+
+      changes = g_new0 (BinChildStateChange, children->len);
+      level.pending = children->len;
+
+      for (j = 0; j < children->len; j++) {
+        BinChildStateChange *change = &changes[j];
+
+        change->bin = bin;
+        change->child = g_ptr_array_index (children, j);
+        change->base_time = base_time;
+        change->start_time = start_time;
+        change->current = current;
+        change->next = next;
+        change->level = &level;
+
+        /* the last child of the level is handled from this thread while
+         * the others are busy */
+        if (j == children->len - 1
+            || !gst_bin_push_child_state_change (bin, change))
+          bin_child_state_change_func (change);
+      }
+
+      g_mutex_lock (&level.lock);
+      while (level.pending > 0)
+        g_cond_wait (&level.cond, &level.lock);
+      g_mutex_unlock (&level.lock);
+
+      /* handle the results in state change order */
+      for (j = 0; j < children->len && res; j++)
+        res = gst_bin_handle_child_state_return (bin, changes[j].child, next,
+            changes[j].ret, have_async, have_no_preroll);
+
+      g_free (changes);
+    }
+    g_ptr_array_unref (levels);
+
+    /* children were added, removed, linked or unlinked while we were changing
+     * states, redo the state change like the iterator resync would do */
+    GST_OBJECT_LOCK (bin);
+    resync = res && cookie != bin->priv->structure_cookie;
+    GST_OBJECT_UNLOCK (bin);
+
+    if (resync)
+      GST_CAT_DEBUG_OBJECT (GST_CAT_STATES, bin, "structure changed, resync");
+  } while (resync);
+
+  g_cond_clear (&level.cond);
+  g_mutex_clear (&level.lock);
+
+  return res;
+}
+
 static GstStateChangeReturn
 gst_bin_change_state_func (GstElement * element, GstStateChange transition)
 {
@@ -2838,8 +3799,9 @@ gst_bin_change_state_func (GstElement * element, GstStateChange transition)
   gboolean have_async;
   gboolean have_no_preroll;
   GstClockTime base_time, start_time;
-  GstIterator *it;
+  GstIterator *it = NULL;
   gboolean done;
+  gboolean parallel;
   GValue data = { 0, };
 
   /* we don't need to take the STATE_LOCK, it is already taken */
@@ -2887,7 +3849,12 @@ gst_bin_change_state_func (GstElement * element, GstStateChange transition)
       GST_OBJECT_LOCK (bin);
       GST_DEBUG_OBJECT (element, "clearing all cached messages");
       bin_remove_messages (bin, NULL, GST_MESSAGE_ANY);
+      /* the sinks forget their latency when going to READY */
+      if (bin->priv->latency_cache)
+        g_hash_table_remove_all (bin->priv->latency_cache);
       GST_OBJECT_UNLOCK (bin);
+      if (current == GST_STATE_PAUSED)
+        bin_unschedule_latency (bin);
       /* We might not have reached PAUSED yet due to async errors,
        * make sure to always deactivate the pads nonetheless */
       if (!(gst_bin_src_pads_activate (bin, FALSE)))
@@ -2912,17 +3879,27 @@ gst_bin_change_state_func (GstElement * element, GstStateChange transition)
    * don't want them to interfere with this state change */
   GST_OBJECT_LOCK (bin);
   bin->polling = TRUE;
+  parallel = bin->priv->parallel_state_change;
   GST_OBJECT_UNLOCK (bin);
 
-  /* iterate in state change order */
-  it = gst_bin_iterate_sorted (bin);
-
   /* mark if we've seen an ASYNC element in the bin when we did a state change.
    * Note how we don't reset this value when a resync happens, the reason being
    * that the async element posted ASYNC_START and we want to post ASYNC_DONE
    * even after a resync when the async element is gone */
   have_async = FALSE;
 
+  if (parallel) {
+    if (!gst_bin_change_children_state_parallel (bin, current, next,
+            &have_async, &have_no_preroll)) {
+      ret = GST_STATE_CHANGE_FAILURE;
+      goto undo;
+    }
+    goto children_done;
+  }
+
+  /* iterate in state change order */
+  it = gst_bin_iterate_sorted (bin);
+
 restart:
   /* take base_time */
   base_time = gst_element_get_base_time (element);
@@ -2943,61 +3920,10 @@ restart:
         ret = gst_bin_element_set_state (bin, child, base_time, start_time,
             current, next);
 
-        switch (ret) {
-          case GST_STATE_CHANGE_SUCCESS:
-            GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
-                "child '%s' changed state to %d(%s) successfully",
-                GST_ELEMENT_NAME (child), next,
-                gst_element_state_get_name (next));
-            break;
-          case GST_STATE_CHANGE_ASYNC:
-          {
-            GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
-                "child '%s' is changing state asynchronously to %s",
-                GST_ELEMENT_NAME (child), gst_element_state_get_name (next));
-            have_async = TRUE;
-            break;
-          }
-          case GST_STATE_CHANGE_FAILURE:{
-            GstObject *parent;
-
-            GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
-                "child '%s' failed to go to state %d(%s)",
-                GST_ELEMENT_NAME (child),
-                next, gst_element_state_get_name (next));
-
-            /* Only fail if the child is still inside
-             * this bin. It might've been removed already
-             * because of the error by the bin subclass
-             * to ignore the error.  */
-            parent = gst_object_get_parent (GST_OBJECT_CAST (child));
-            if (parent == GST_OBJECT_CAST (element)) {
-              /* element is still in bin, really error now */
-              gst_object_unref (parent);
-              goto undo;
-            }
-            /* child removed from bin, let the resync code redo the state
-             * change */
-            GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
-                "child '%s' was removed from the bin",
-                GST_ELEMENT_NAME (child));
-
-            if (parent)
-              gst_object_unref (parent);
+        if (!gst_bin_handle_child_state_return (bin, child, next, ret,
+                &have_async, &have_no_preroll))
+          goto undo;
 
-            break;
-          }
-          case GST_STATE_CHANGE_NO_PREROLL:
-            GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
-                "child '%s' changed state to %d(%s) successfully without preroll",
-                GST_ELEMENT_NAME (child), next,
-                gst_element_state_get_name (next));
-            have_no_preroll = TRUE;
-            break;
-          default:
-            g_assert_not_reached ();
-            break;
-        }
         g_value_reset (&data);
         break;
       }
@@ -3013,6 +3939,7 @@ restart:
     }
   }
 
+children_done:
   ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
   if (G_UNLIKELY (ret == GST_STATE_CHANGE_FAILURE))
     goto done;
@@ -3031,7 +3958,8 @@ restart:
 
 done:
   g_value_unset (&data);
-  gst_iterator_free (it);
+  if (it)
+    gst_iterator_free (it);
 
   GST_OBJECT_LOCK (bin);
   bin->polling = FALSE;
@@ -3125,6 +4053,16 @@ gst_bin_send_event (GstElement * element, GstEvent * event)
   gboolean res = TRUE;
   gboolean done = FALSE;
   GValue data = { 0, };
+  GstClockTime latency = GST_CLOCK_TIME_NONE;
+
+  /* in incremental-latency mode we only configure sinks that did not get
+   * this latency yet */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_LATENCY) {
+    GST_OBJECT_LOCK (bin);
+    if (bin->priv->incremental_latency)
+      gst_event_parse_latency (event, &latency);
+    GST_OBJECT_UNLOCK (bin);
+  }
 
   if (GST_EVENT_IS_DOWNSTREAM (event)) {
     iter = gst_bin_iterate_sources (bin);
@@ -3142,8 +4080,33 @@ gst_bin_send_event (GstElement * element, GstEvent * event)
       {
         GstElement *child = g_value_get_object (&data);
 
+        if (latency != GST_CLOCK_TIME_NONE) {
+          BinLatencyEntry *entry;
+          gboolean configured;
+
+          GST_OBJECT_LOCK (bin);
+          entry = bin_latency_cache_get (bin, child);
+          configured = (entry->configured == latency);
+          GST_OBJECT_UNLOCK (bin);
+
+          if (configured) {
+            GST_LOG_OBJECT (child, "latency %" GST_TIME_FORMAT
+                " already configured", GST_TIME_ARGS (latency));
+            g_value_reset (&data);
+            break;
+          }
+        }
+
         gst_event_ref (event);
-        res &= gst_element_send_event (child, event);
+        if (gst_element_send_event (child, event)) {
+          if (latency != GST_CLOCK_TIME_NONE) {
+            GST_OBJECT_LOCK (bin);
+            bin_latency_cache_get (bin, child)->configured = latency;
+            GST_OBJECT_UNLOCK (bin);
+          }
+        } else {
+          res = FALSE;
+        }
 
         GST_LOG_OBJECT (child, "After handling %s event: %d",
             GST_EVENT_TYPE_NAME (event), res);
@@ -3994,6 +4957,7 @@ gst_bin_handle_message_func (GstBin * bin, GstMessage * message)
          * need to resync by updating the structure_cookie. */
         bin_remove_messages (bin, GST_MESSAGE_SRC (message),
             GST_MESSAGE_STRUCTURE_CHANGE);
+        bin->priv->sort_cookie++;
         if (!GST_BIN_IS_NO_RESYNC (bin))
           bin->priv->structure_cookie++;
       }
@@ -4032,6 +4996,28 @@ gst_bin_handle_message_func (GstBin * bin, GstMessage * message)
 
       break;
     }
+    case GST_MESSAGE_LATENCY:
+    {
+      gboolean incremental, toplevel;
+
+      GST_OBJECT_LOCK (bin);
+      incremental = bin->priv->incremental_latency;
+      toplevel = BIN_IS_TOPLEVEL (bin);
+      GST_OBJECT_UNLOCK (bin);
+
+      if (!incremental)
+        goto forward;
+
+      bin_latency_cache_invalidate_downstream (bin, src);
+      if (!toplevel)
+        goto forward;
+
+      /* we recalculate the latency ourselves, don't make the application do
+       * it again */
+      bin_schedule_latency (bin);
+      gst_message_unref (message);
+      break;
+    }
     case GST_MESSAGE_HAVE_CONTEXT:{
       GstContext *context;
 
@@ -4356,6 +5342,15 @@ gst_bin_query (GstElement * element, GstQuery * query)
     }
     case GST_QUERY_LATENCY:
     {
+      gboolean incremental;
+
+      GST_OBJECT_LOCK (bin);
+      incremental = bin->priv->incremental_latency;
+      GST_OBJECT_UNLOCK (bin);
+
+      if (incremental && bin_query_latency_cached (bin, query))
+        return TRUE;
+
       fold_func = (GstIteratorFoldFunction) bin_query_latency_fold;
       fold_init = bin_query_min_max_init;
       fold_done = bin_query_latency_done;
@@ -4621,3 +5616,9 @@ gst_bin_iterate_all_by_interface (GstBin * bin, GType iface)
 
   return result;
 }
+
+gint *
+_priv_gst_bin_get_caps_cache_cookie (GstBin * bin)
+{
+  return &bin->priv->caps_cache_cookie;
+}
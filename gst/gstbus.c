@@ -62,6 +62,14 @@
  *
  * Every #GstPipeline has one bus.
  *
+ * Applications that supervise many pipelines from one thread can make the
+ * pipelines post into a single shared group bus with
+ * gst_pipeline_set_bus_group(). Each pipeline then gets a lightweight bus
+ * without file descriptor of its own (see gst_bus_new_for_group()) that
+ * forwards its messages to the group bus, tagged with the pipeline. The
+ * messages of all those pipelines can then be handled with one bus watch,
+ * and gst_bus_message_get_owner() tells which pipeline a message belongs to.
+ *
  * Note that a #GstPipeline will set its bus into flushing state when changing
  * from READY to NULL state.
  */
@@ -109,6 +117,8 @@ static void gst_bus_finalize (GObject * object);
 
 static guint gst_bus_signals[LAST_SIGNAL] = { 0 };
 
+static GQuark bus_group_owner_quark = 0;
+
 struct _GstBusPrivate
 {
   GstAtomicQueue *queue;
@@ -126,6 +136,10 @@ struct _GstBusPrivate
   gboolean enable_async;
   GstPoll *poll;
   GPollFD pollfd;
+
+  /* for buses created with gst_bus_new_for_group() */
+  GstBus *group;
+  GWeakRef group_owner;
 };
 
 #define gst_bus_parent_class parent_class
@@ -217,6 +231,8 @@ gst_bus_class_init (GstBusClass * klass)
       G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
       G_STRUCT_OFFSET (GstBusClass, message), NULL, NULL,
       g_cclosure_marshal_generic, G_TYPE_NONE, 1, GST_TYPE_MESSAGE);
+
+  bus_group_owner_quark = g_quark_from_static_string ("GstBusGroupOwner");
 }
 
 static void
@@ -226,6 +242,7 @@ gst_bus_init (GstBus * bus)
   bus->priv->enable_async = DEFAULT_ENABLE_ASYNC;
   g_mutex_init (&bus->priv->queue_lock);
   bus->priv->queue = gst_atomic_queue_new (32);
+  g_weak_ref_init (&bus->priv->group_owner, NULL);
 
   GST_DEBUG_OBJECT (bus, "created");
 }
@@ -254,6 +271,8 @@ gst_bus_dispose (GObject * object)
     bus->priv->poll = NULL;
   }
 
+  gst_object_replace ((GstObject **) & bus->priv->group, NULL);
+
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
@@ -265,6 +284,8 @@ gst_bus_finalize (GObject * object)
   if (bus->priv->sync_handler_notify)
     bus->priv->sync_handler_notify (bus->priv->sync_handler_data);
 
+  g_weak_ref_clear (&bus->priv->group_owner);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -290,28 +311,84 @@ gst_bus_new (void)
 }
 
 /**
- * gst_bus_post:
- * @bus: a #GstBus to post on
- * @message: (transfer full): the #GstMessage to post
+ * gst_bus_new_for_group:
+ * @group: the #GstBus to forward messages to
+ * @owner: (allow-none): the #GstObject to tag forwarded messages with
  *
- * Post a message on the given bus. Ownership of the message
- * is taken by the bus.
+ * Creates a new #GstBus that does not queue messages itself but forwards all
+ * messages that pass its sync handler to @group. Such a bus has no file
+ * descriptor of its own, so many of them can share the single file
+ * descriptor and watch of @group.
  *
- * Returns: %TRUE if the message could be posted, %FALSE if the bus is flushing.
+ * Messages forwarded to @group are tagged with @owner, which can be
+ * retrieved with gst_bus_message_get_owner(). Only a weak reference to
+ * @owner is kept, so @owner can own the returned bus.
  *
- * MT safe.
+ * The returned bus does not support watches or gst_bus_pop(), these have to
+ * be used on @group instead. Setting the returned bus to flushing only drops
+ * the messages posted on it, @group is not affected.
+ *
+ * When the sync handler of the returned bus returns %GST_BUS_ASYNC, the
+ * message is queued on @group and gst_bus_post() blocks until it was handled
+ * there, unless the sync handler of @group drops it.
+ *
+ * Returns: (transfer full): a new #GstBus instance
+ *
+ * Since: 1.16
  */
-gboolean
-gst_bus_post (GstBus * bus, GstMessage * message)
+GstBus *
+gst_bus_new_for_group (GstBus * group, GstObject * owner)
+{
+  GstBus *result;
+
+  g_return_val_if_fail (GST_IS_BUS (group), NULL);
+  g_return_val_if_fail (owner == NULL || GST_IS_OBJECT (owner), NULL);
+
+  result = g_object_new (gst_bus_get_type (), "enable-async", FALSE, NULL);
+  result->priv->group = gst_object_ref (group);
+  g_weak_ref_set (&result->priv->group_owner, owner);
+  GST_DEBUG_OBJECT (result, "created new bus for group %" GST_PTR_FORMAT,
+      group);
+
+  /* clear floating flag */
+  gst_object_ref_sink (result);
+
+  return result;
+}
+
+/**
+ * gst_bus_message_get_owner:
+ * @message: a #GstMessage
+ *
+ * Gets the owner that was passed to gst_bus_new_for_group() when @message was
+ * forwarded from such a bus to its group, usually the #GstPipeline the
+ * message belongs to.
+ *
+ * Returns: (transfer none) (nullable): the owner of the bus @message was
+ *     posted on, or %NULL if @message was not forwarded to a group or the
+ *     owner was already destroyed when it was posted.
+ *
+ * Since: 1.16
+ */
+GstObject *
+gst_bus_message_get_owner (GstMessage * message)
+{
+  g_return_val_if_fail (GST_IS_MESSAGE (message), NULL);
+
+  return gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (message),
+      bus_group_owner_quark);
+}
+
+/* with @async, messages that pass the sync handler are delivered like with
+ * GST_BUS_ASYNC, for a member of a group whose sync handler asked for that */
+static gboolean
+gst_bus_post_full (GstBus * bus, GstMessage * message, gboolean async)
 {
   GstBusSyncReply reply = GST_BUS_PASS;
   GstBusSyncHandler handler;
   gboolean emit_sync_message;
   gpointer handler_data;
 
-  g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
-  g_return_val_if_fail (GST_IS_MESSAGE (message), FALSE);
-
   GST_DEBUG_OBJECT (bus, "[msg %p] posting on bus %" GST_PTR_FORMAT, message,
       message);
 
@@ -333,12 +410,20 @@ gst_bus_post (GstBus * bus, GstMessage * message)
   if (handler)
     reply = handler (bus, message, handler_data);
 
+  if (async && reply == GST_BUS_PASS)
+    reply = GST_BUS_ASYNC;
+
   /* emit sync-message if requested to do so via
      gst_bus_enable_sync_message_emission. terrible but effective */
   if (emit_sync_message && reply != GST_BUS_DROP
       && handler != gst_bus_sync_signal_handler)
     gst_bus_sync_signal_handler (bus, message, NULL);
 
+  /* If this bus is part of a group, the group bus takes care of
+   * delivering the message */
+  if (bus->priv->group && reply != GST_BUS_DROP)
+    goto forward_to_group;
+
   /* If this is a bus without async message delivery
    * always drop the message */
   if (!bus->priv->poll)
@@ -402,6 +487,23 @@ gst_bus_post (GstBus * bus, GstMessage * message)
   }
   return TRUE;
 
+forward_to_group:
+  {
+    GstObject *owner;
+
+    GST_DEBUG_OBJECT (bus, "[msg %p] forwarding to group %" GST_PTR_FORMAT,
+        message, bus->priv->group);
+
+    owner = g_weak_ref_get (&bus->priv->group_owner);
+    if (owner)
+      gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (message),
+          bus_group_owner_quark, owner, (GDestroyNotify) gst_object_unref);
+
+    /* an ASYNC reply blocks until the message was handled on the group */
+    return gst_bus_post_full (bus->priv->group, message,
+        reply == GST_BUS_ASYNC);
+  }
+
   /* ERRORS */
 is_flushing:
   {
@@ -413,6 +515,27 @@ is_flushing:
   }
 }
 
+/**
+ * gst_bus_post:
+ * @bus: a #GstBus to post on
+ * @message: (transfer full): the #GstMessage to post
+ *
+ * Post a message on the given bus. Ownership of the message
+ * is taken by the bus.
+ *
+ * Returns: %TRUE if the message could be posted, %FALSE if the bus is flushing.
+ *
+ * MT safe.
+ */
+gboolean
+gst_bus_post (GstBus * bus, GstMessage * message)
+{
+  g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
+  g_return_val_if_fail (GST_IS_MESSAGE (message), FALSE);
+
+  return gst_bus_post_full (bus, message, FALSE);
+}
+
 /**
  * gst_bus_have_pending:
  * @bus: a #GstBus to check
@@ -476,68 +599,58 @@ gst_bus_set_flushing (GstBus * bus, gboolean flushing)
   g_list_free_full (message_list, (GDestroyNotify) gst_message_unref);
 }
 
-/**
- * gst_bus_timed_pop_filtered:
- * @bus: a #GstBus to pop from
- * @timeout: a timeout in nanoseconds, or GST_CLOCK_TIME_NONE to wait forever
- * @types: message types to take into account, GST_MESSAGE_ANY for any type
- *
- * Get a message from the bus whose type matches the message type mask @types,
- * waiting up to the specified timeout (and discarding any messages that do not
- * match the mask provided).
- *
- * If @timeout is 0, this function behaves like gst_bus_pop_filtered(). If
- * @timeout is #GST_CLOCK_TIME_NONE, this function will block forever until a
- * matching message was posted on the bus.
- *
- * Returns: (transfer full) (nullable): a #GstMessage matching the
- *     filter in @types, or %NULL if no matching message was found on
- *     the bus until the timeout expired. The message is taken from
- *     the bus and needs to be unreffed with gst_message_unref() after
- *     usage.
- *
- * MT safe.
- */
-GstMessage *
-gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
-    GstMessageType types)
+/* acknowledge @count popped messages on the poll of @bus, with a single
+ * read of the control socket when possible.
+ * Must be called with the queue_lock. */
+static void
+gst_bus_release_control (GstBus * bus, guint count)
+{
+  while (count > 0) {
+    guint released;
+
+    released = priv_gst_poll_read_control_many (bus->priv->poll, count);
+    if (released > 0) {
+      count -= released;
+    } else if (errno == EWOULDBLOCK) {
+      /* Retry, this can happen if pushing to the queue has finished,
+       * popping here succeeded but writing control did not finish
+       * before we got to this line. */
+      /* Give other threads the chance to do something */
+      g_thread_yield ();
+    } else {
+      /* This is a real error and means that either the bus is in an
+       * inconsistent state, or the GstPoll is invalid. GstPoll already
+       * prints a critical warning about this, no need to do that again
+       * ourselves */
+      break;
+    }
+  }
+}
+
+/* pops up to @max_messages messages matching @types into @messages, waiting
+ * up to @timeout for the first one. Returns the number of messages stored. */
+static guint
+gst_bus_timed_pop_filtered_many (GstBus * bus, GstClockTime timeout,
+    GstMessageType types, GstMessage ** messages, guint max_messages)
 {
   GstMessage *message;
   GTimeVal now, then;
   gboolean first_round = TRUE;
   GstClockTime elapsed = 0;
-
-  g_return_val_if_fail (GST_IS_BUS (bus), NULL);
-  g_return_val_if_fail (types != 0, NULL);
-  g_return_val_if_fail (timeout == 0 || bus->priv->poll != NULL, NULL);
+  guint n_messages = 0;
 
   g_mutex_lock (&bus->priv->queue_lock);
 
   while (TRUE) {
+    guint n_popped = 0;
     gint ret;
 
     GST_LOG_OBJECT (bus, "have %d messages",
         gst_atomic_queue_length (bus->priv->queue));
 
-    while ((message = gst_atomic_queue_pop (bus->priv->queue))) {
-      if (bus->priv->poll) {
-        while (!gst_poll_read_control (bus->priv->poll)) {
-          if (errno == EWOULDBLOCK) {
-            /* Retry, this can happen if pushing to the queue has finished,
-             * popping here succeeded but writing control did not finish
-             * before we got to this line. */
-            /* Give other threads the chance to do something */
-            g_thread_yield ();
-            continue;
-          } else {
-            /* This is a real error and means that either the bus is in an
-             * inconsistent state, or the GstPoll is invalid. GstPoll already
-             * prints a critical warning about this, no need to do that again
-             * ourselves */
-            break;
-          }
-        }
-      }
+    while (n_messages < max_messages
+        && (message = gst_atomic_queue_pop (bus->priv->queue))) {
+      n_popped++;
 
       GST_DEBUG_OBJECT (bus, "got message %p, %s from %s, type mask is %u",
           message, GST_MESSAGE_TYPE_NAME (message),
@@ -547,18 +660,21 @@ gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
          * asked for */
         if ((!GST_MESSAGE_TYPE_IS_EXTENDED (message))
             || (types & GST_MESSAGE_EXTENDED)) {
-          /* exit the loop, we have a message */
-          goto beach;
+          /* keep the message */
+          messages[n_messages++] = message;
+          continue;
         }
       }
 
       GST_DEBUG_OBJECT (bus, "discarding message, does not match mask");
       gst_message_unref (message);
-      message = NULL;
     }
 
-    /* no need to wait, exit loop */
-    if (timeout == 0)
+    if (n_popped > 0 && bus->priv->poll)
+      gst_bus_release_control (bus, n_popped);
+
+    /* we have messages or no need to wait, exit loop */
+    if (n_messages > 0 || timeout == 0)
       break;
 
     else if (timeout != GST_CLOCK_TIME_NONE) {
@@ -589,13 +705,117 @@ gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
     }
   }
 
-beach:
-
   g_mutex_unlock (&bus->priv->queue_lock);
 
+  return n_messages;
+}
+
+/**
+ * gst_bus_timed_pop_filtered:
+ * @bus: a #GstBus to pop from
+ * @timeout: a timeout in nanoseconds, or GST_CLOCK_TIME_NONE to wait forever
+ * @types: message types to take into account, GST_MESSAGE_ANY for any type
+ *
+ * Get a message from the bus whose type matches the message type mask @types,
+ * waiting up to the specified timeout (and discarding any messages that do not
+ * match the mask provided).
+ *
+ * If @timeout is 0, this function behaves like gst_bus_pop_filtered(). If
+ * @timeout is #GST_CLOCK_TIME_NONE, this function will block forever until a
+ * matching message was posted on the bus.
+ *
+ * Returns: (transfer full) (nullable): a #GstMessage matching the
+ *     filter in @types, or %NULL if no matching message was found on
+ *     the bus until the timeout expired. The message is taken from
+ *     the bus and needs to be unreffed with gst_message_unref() after
+ *     usage.
+ *
+ * MT safe.
+ */
+GstMessage *
+gst_bus_timed_pop_filtered (GstBus * bus, GstClockTime timeout,
+    GstMessageType types)
+{
+  GstMessage *message = NULL;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), NULL);
+  g_return_val_if_fail (types != 0, NULL);
+  g_return_val_if_fail (timeout == 0 || bus->priv->poll != NULL, NULL);
+
+  gst_bus_timed_pop_filtered_many (bus, timeout, types, &message, 1);
+
   return message;
 }
 
+/**
+ * gst_bus_timed_pop_batch_filtered:
+ * @bus: a #GstBus to pop from
+ * @timeout: a timeout in nanoseconds, or GST_CLOCK_TIME_NONE to wait forever
+ * @types: message types to take into account, GST_MESSAGE_ANY for any type
+ * @messages: (out caller-allocates) (array length=max_messages) (transfer full):
+ *     array of at least @max_messages entries to store the messages in
+ * @max_messages: the maximum number of messages to pop
+ *
+ * Get up to @max_messages messages from the bus whose type matches the
+ * message type mask @types, waiting up to the specified timeout for the
+ * first one (and discarding any messages that do not match the mask
+ * provided).
+ *
+ * Unlike calling gst_bus_timed_pop_filtered() repeatedly, all messages that
+ * are already queued are taken from the bus in one go and acknowledged on the
+ * bus file descriptor with a single read. This is useful for applications
+ * that handle messages of many busses from one thread.
+ *
+ * Returns: the number of messages stored in @messages. The messages are taken
+ *     from the bus and each needs to be unreffed with gst_message_unref()
+ *     after usage.
+ *
+ * MT safe.
+ *
+ * Since: 1.16
+ */
+guint
+gst_bus_timed_pop_batch_filtered (GstBus * bus, GstClockTime timeout,
+    GstMessageType types, GstMessage ** messages, guint max_messages)
+{
+  g_return_val_if_fail (GST_IS_BUS (bus), 0);
+  g_return_val_if_fail (types != 0, 0);
+  g_return_val_if_fail (messages != NULL || max_messages == 0, 0);
+  g_return_val_if_fail (timeout == 0 || bus->priv->poll != NULL, 0);
+
+  if (max_messages == 0)
+    return 0;
+
+  return gst_bus_timed_pop_filtered_many (bus, timeout, types, messages,
+      max_messages);
+}
+
+/**
+ * gst_bus_pop_batch:
+ * @bus: a #GstBus to pop from
+ * @messages: (out caller-allocates) (array length=max_messages) (transfer full):
+ *     array of at least @max_messages entries to store the messages in
+ * @max_messages: the maximum number of messages to pop
+ *
+ * Get up to @max_messages messages from the bus without waiting. See
+ * gst_bus_timed_pop_batch_filtered().
+ *
+ * Returns: the number of messages stored in @messages. The messages are taken
+ *     from the bus and each needs to be unreffed with gst_message_unref()
+ *     after usage.
+ *
+ * MT safe.
+ *
+ * Since: 1.16
+ */
+guint
+gst_bus_pop_batch (GstBus * bus, GstMessage ** messages, guint max_messages)
+{
+  g_return_val_if_fail (GST_IS_BUS (bus), 0);
+
+  return gst_bus_timed_pop_batch_filtered (bus, 0, GST_MESSAGE_ANY, messages,
+      max_messages);
+}
 
 /**
  * gst_bus_timed_pop:
@@ -790,6 +1010,10 @@ typedef struct
 {
   GSource source;
   GstBus *bus;
+
+  /* for batch watches, 0 otherwise */
+  guint max_messages;
+  GstMessage **messages;
 } GstBusSource;
 
 static gboolean
@@ -852,6 +1076,59 @@ no_handler:
   }
 }
 
+static gboolean
+gst_bus_batch_source_dispatch (GSource * source, GSourceFunc callback,
+    gpointer user_data)
+{
+  GstBusBatchFunc handler = (GstBusBatchFunc) callback;
+  GstBusSource *bsource = (GstBusSource *) source;
+  guint i, n_messages;
+  gboolean keep;
+  GstBus *bus;
+
+  g_return_val_if_fail (bsource != NULL, FALSE);
+
+  bus = bsource->bus;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), FALSE);
+
+  n_messages = gst_bus_pop_batch (bus, bsource->messages,
+      bsource->max_messages);
+
+  /* The message queue might be empty if some other thread or callback set
+   * the bus to flushing between check/prepare and dispatch */
+  if (G_UNLIKELY (n_messages == 0))
+    return TRUE;
+
+  if (!handler)
+    goto no_handler;
+
+  GST_DEBUG_OBJECT (bus, "source %p calling dispatch with %u messages",
+      source, n_messages);
+
+  keep = handler (bus, bsource->messages, n_messages, user_data);
+
+  for (i = 0; i < n_messages; i++) {
+    gst_message_unref (bsource->messages[i]);
+    bsource->messages[i] = NULL;
+  }
+
+  GST_DEBUG_OBJECT (bus, "source %p handler returns %d", source, keep);
+
+  return keep;
+
+no_handler:
+  {
+    g_warning ("GstBus watch dispatched without callback\n"
+        "You must call g_source_set_callback().");
+    for (i = 0; i < n_messages; i++) {
+      gst_message_unref (bsource->messages[i]);
+      bsource->messages[i] = NULL;
+    }
+    return FALSE;
+  }
+}
+
 static void
 gst_bus_source_finalize (GSource * source)
 {
@@ -869,6 +1146,9 @@ gst_bus_source_finalize (GSource * source)
 
   gst_object_unref (bsource->bus);
   bsource->bus = NULL;
+
+  g_free (bsource->messages);
+  bsource->messages = NULL;
 }
 
 static GSourceFuncs gst_bus_source_funcs = {
@@ -878,6 +1158,13 @@ static GSourceFuncs gst_bus_source_funcs = {
   gst_bus_source_finalize
 };
 
+static GSourceFuncs gst_bus_batch_source_funcs = {
+  gst_bus_source_prepare,
+  gst_bus_source_check,
+  gst_bus_batch_source_dispatch,
+  gst_bus_source_finalize
+};
+
 /**
  * gst_bus_create_watch:
  * @bus: a #GstBus to create the watch for
@@ -907,10 +1194,49 @@ gst_bus_create_watch (GstBus * bus)
   return (GSource *) source;
 }
 
-/* must be called with the bus OBJECT LOCK */
+/**
+ * gst_bus_create_batch_watch:
+ * @bus: a #GstBus to create the watch for
+ * @max_messages: the maximum number of messages to handle per dispatch
+ *
+ * Create a batch watch for this bus. The GSource will be dispatched whenever
+ * messages are on the bus, and will then pop up to @max_messages messages
+ * at once with gst_bus_pop_batch(). The callback set on the source with
+ * g_source_set_callback() must be a #GstBusBatchFunc. After the GSource is
+ * dispatched, the messages are unreffed.
+ *
+ * Returns: (transfer full) (nullable): a #GSource that can be added to a mainloop.
+ *
+ * Since: 1.16
+ */
+GSource *
+gst_bus_create_batch_watch (GstBus * bus, guint max_messages)
+{
+  GstBusSource *source;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), NULL);
+  g_return_val_if_fail (bus->priv->poll != NULL, NULL);
+  g_return_val_if_fail (max_messages > 0, NULL);
+
+  source = (GstBusSource *) g_source_new (&gst_bus_batch_source_funcs,
+      sizeof (GstBusSource));
+
+  g_source_set_name ((GSource *) source, "GStreamer message bus batch watch");
+
+  source->bus = gst_object_ref (bus);
+  source->max_messages = max_messages;
+  source->messages = g_new0 (GstMessage *, max_messages);
+  g_source_add_poll ((GSource *) source, &bus->priv->pollfd);
+
+  return (GSource *) source;
+}
+
+/* must be called with the bus OBJECT LOCK. Creates a batch watch when
+ * @max_messages is not 0, @func is a GstBusBatchFunc then. */
 static guint
 gst_bus_add_watch_full_unlocked (GstBus * bus, gint priority,
-    GstBusFunc func, gpointer user_data, GDestroyNotify notify)
+    guint max_messages, GSourceFunc func, gpointer user_data,
+    GDestroyNotify notify)
 {
   GMainContext *ctx;
   guint id;
@@ -922,7 +1248,10 @@ gst_bus_add_watch_full_unlocked (GstBus * bus, gint priority,
     return 0;
   }
 
-  source = gst_bus_create_watch (bus);
+  if (max_messages > 0)
+    source = gst_bus_create_batch_watch (bus, max_messages);
+  else
+    source = gst_bus_create_watch (bus);
   if (!source) {
     g_critical ("Creating bus watch failed");
     return 0;
@@ -931,7 +1260,7 @@ gst_bus_add_watch_full_unlocked (GstBus * bus, gint priority,
   if (priority != G_PRIORITY_DEFAULT)
     g_source_set_priority (source, priority);
 
-  g_source_set_callback (source, (GSourceFunc) func, user_data, notify);
+  g_source_set_callback (source, func, user_data, notify);
 
   ctx = g_main_context_get_thread_default ();
   id = g_source_attach (source, ctx);
@@ -988,7 +1317,55 @@ gst_bus_add_watch_full (GstBus * bus, gint priority,
   g_return_val_if_fail (GST_IS_BUS (bus), 0);
 
   GST_OBJECT_LOCK (bus);
-  id = gst_bus_add_watch_full_unlocked (bus, priority, func, user_data, notify);
+  id = gst_bus_add_watch_full_unlocked (bus, priority, 0, (GSourceFunc) func,
+      user_data, notify);
+  GST_OBJECT_UNLOCK (bus);
+
+  return id;
+}
+
+/**
+ * gst_bus_add_batch_watch_full:
+ * @bus: a #GstBus to create the watch for.
+ * @priority: The priority of the watch.
+ * @max_messages: the maximum number of messages to pass to @func at once.
+ * @func: A function to call when messages are received.
+ * @user_data: user data passed to @func.
+ * @notify: the function to call when the source is removed.
+ *
+ * Adds a batch bus watch to the thread default main context with the given
+ * @priority. This behaves like gst_bus_add_watch_full() but drains up to
+ * @max_messages messages from the bus per main loop iteration and passes
+ * them to @func in one call. All messages are acknowledged on the bus file
+ * descriptor with a single read, which reduces the number of system calls
+ * and main loop iterations when many messages are posted.
+ *
+ * When @func is called, the messages belong to the caller; if you want to
+ * keep a copy of any of them, call gst_message_ref() before leaving @func.
+ *
+ * There can only be a single bus watch per bus, you must remove it before you
+ * can set a new one. The watch can be removed using gst_bus_remove_watch()
+ * or by returning %FALSE from @func.
+ *
+ * MT safe.
+ *
+ * Returns: The event source id or 0 if @bus already got an event source.
+ *
+ * Since: 1.16
+ */
+guint
+gst_bus_add_batch_watch_full (GstBus * bus, gint priority,
+    guint max_messages, GstBusBatchFunc func, gpointer user_data,
+    GDestroyNotify notify)
+{
+  guint id;
+
+  g_return_val_if_fail (GST_IS_BUS (bus), 0);
+  g_return_val_if_fail (max_messages > 0, 0);
+
+  GST_OBJECT_LOCK (bus);
+  id = gst_bus_add_watch_full_unlocked (bus, priority, max_messages,
+      (GSourceFunc) func, user_data, notify);
   GST_OBJECT_UNLOCK (bus);
 
   return id;
@@ -1377,8 +1754,8 @@ gst_bus_add_signal_watch_full (GstBus * bus, gint priority)
   /* this should not fail because the counter above takes care of it */
   g_assert (!bus->priv->signal_watch);
 
-  gst_bus_add_watch_full_unlocked (bus, priority, gst_bus_async_signal_func,
-      NULL, NULL);
+  gst_bus_add_watch_full_unlocked (bus, priority, 0,
+      (GSourceFunc) gst_bus_async_signal_func, NULL, NULL);
 
   if (G_UNLIKELY (!bus->priv->signal_watch))
     goto add_failed;
@@ -105,6 +105,25 @@ typedef GstBusSyncReply (*GstBusSyncHandler)    (GstBus * bus, GstMessage * mess
  */
 typedef gboolean        (*GstBusFunc)           (GstBus * bus, GstMessage * message, gpointer user_data);
 
+/**
+ * GstBusBatchFunc:
+ * @bus: the #GstBus that sent the messages
+ * @messages: (array length=n_messages): the #GstMessages
+ * @n_messages: the number of messages in @messages
+ * @user_data: user data that has been given, when registering the handler
+ *
+ * Specifies the type of function passed to gst_bus_add_batch_watch_full(),
+ * which is called from the mainloop when messages are available on the bus.
+ *
+ * The messages passed to the function will be unreffed after execution of
+ * this function so it should not be freed in the function.
+ *
+ * Returns: %FALSE if the event source should be removed.
+ *
+ * Since: 1.16
+ */
+typedef gboolean        (*GstBusBatchFunc)      (GstBus * bus, GstMessage ** messages, guint n_messages, gpointer user_data);
+
 /**
  * GstBus:
  *
@@ -138,9 +157,15 @@ GType                   gst_bus_get_type                (void);
 GST_API
 GstBus*                 gst_bus_new                     (void);
 
+GST_API
+GstBus*                 gst_bus_new_for_group           (GstBus * group, GstObject * owner);
+
 GST_API
 gboolean                gst_bus_post                    (GstBus * bus, GstMessage * message);
 
+GST_API
+GstObject *             gst_bus_message_get_owner       (GstMessage * message);
+
 GST_API
 gboolean                gst_bus_have_pending            (GstBus * bus);
 
@@ -159,6 +184,14 @@ GstMessage *            gst_bus_timed_pop               (GstBus * bus, GstClockT
 GST_API
 GstMessage *            gst_bus_timed_pop_filtered      (GstBus * bus, GstClockTime timeout, GstMessageType types);
 
+GST_API
+guint                   gst_bus_pop_batch               (GstBus * bus, GstMessage ** messages,
+                                                         guint max_messages);
+GST_API
+guint                   gst_bus_timed_pop_batch_filtered (GstBus * bus, GstClockTime timeout,
+                                                         GstMessageType types,
+                                                         GstMessage ** messages,
+                                                         guint max_messages);
 GST_API
 void                    gst_bus_set_flushing            (GstBus * bus, gboolean flushing);
 
@@ -189,6 +222,16 @@ guint                   gst_bus_add_watch               (GstBus * bus,
                                                          GstBusFunc func,
                                                          gpointer user_data);
 GST_API
+GSource *               gst_bus_create_batch_watch      (GstBus * bus, guint max_messages);
+
+GST_API
+guint                   gst_bus_add_batch_watch_full    (GstBus * bus,
+                                                         gint priority,
+                                                         guint max_messages,
+                                                         GstBusBatchFunc func,
+                                                         gpointer user_data,
+                                                         GDestroyNotify notify);
+GST_API
 gboolean                gst_bus_remove_watch            (GstBus * bus);
 
 /* polling the bus */
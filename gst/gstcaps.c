@@ -82,9 +82,13 @@ typedef struct _GstCapsImpl
   GstCaps caps;
 
   GArray *array;
+
+  GstCapsMediaTypes *media_types;
 } GstCapsImpl;
 
 #define GST_CAPS_ARRAY(c) (((GstCapsImpl *)(c))->array)
+#define GST_CAPS_MEDIA_TYPES(c) ((const GstCapsMediaTypes *) \
+    g_atomic_pointer_get (&((GstCapsImpl *)(c))->media_types))
 
 #define GST_CAPS_LEN(c)   (GST_CAPS_ARRAY(c)->len)
 
@@ -102,6 +106,16 @@ typedef struct _GstCapsImpl
 #define CAPS_IS_EMPTY_SIMPLE(caps)					\
   ((GST_CAPS_ARRAY (caps) == NULL) || (GST_CAPS_LEN (caps) == 0))
 
+/* private flags of caps returned by gst_caps_intern(), never copied */
+#define CAPS_FLAG_INTERNED       (GST_MINI_OBJECT_FLAG_LAST << 8)
+#define CAPS_FLAG_INTERNED_FIXED (GST_MINI_OBJECT_FLAG_LAST << 9)
+#define CAPS_FLAGS_PRIVATE       (CAPS_FLAG_INTERNED | CAPS_FLAG_INTERNED_FIXED)
+
+#define CAPS_IS_INTERNED(caps) \
+  (!!(GST_CAPS_FLAGS(caps) & CAPS_FLAG_INTERNED))
+#define CAPS_IS_INTERNED_FIXED(caps) \
+  (!!(GST_CAPS_FLAGS(caps) & CAPS_FLAG_INTERNED_FIXED))
+
 #define gst_caps_features_copy_conditional(f) ((f && (gst_caps_features_is_any (f) || !gst_caps_features_is_equal (f, GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY))) ? gst_caps_features_copy (f) : NULL)
 
 /* quick way to get a caps structure at an index without doing a type or array
@@ -123,10 +137,22 @@ typedef struct _GstCapsImpl
 /* lock to protect multiple invocations of static caps to caps conversion */
 G_LOCK_DEFINE_STATIC (static_caps_lock);
 
+/* interned caps and the memoized intersections between them */
+G_LOCK_DEFINE_STATIC (intern_lock);
+static GHashTable *intern_table;
+static GHashTable *intersect_memo;
+
+/* intersections remembered before the memo is cleared */
+#define INTERSECT_MEMO_MAX 1024
+
 static void gst_caps_transform_to_string (const GValue * src_value,
     GValue * dest_value);
 static gboolean gst_caps_from_string_inplace (GstCaps * caps,
     const gchar * string);
+static GstCaps *gst_caps_intersect_mode (GstCaps * caps1, GstCaps * caps2,
+    GstCapsIntersectMode mode);
+static GstCaps *gst_caps_intersect_interned (GstCaps * caps1, GstCaps * caps2,
+    GstCapsIntersectMode mode);
 
 GType _gst_caps_type = 0;
 GstCaps *_gst_caps_any;
@@ -153,6 +179,17 @@ _priv_gst_caps_cleanup (void)
   _gst_caps_any = NULL;
   gst_caps_unref (_gst_caps_none);
   _gst_caps_none = NULL;
+
+  G_LOCK (intern_lock);
+  if (intersect_memo) {
+    g_hash_table_destroy (intersect_memo);
+    intersect_memo = NULL;
+  }
+  if (intern_table) {
+    g_hash_table_destroy (intern_table);
+    intern_table = NULL;
+  }
+  G_UNLOCK (intern_lock);
 }
 
 GstCapsFeatures *
@@ -172,7 +209,7 @@ _gst_caps_copy (const GstCaps * caps)
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
 
   newcaps = gst_caps_new_empty ();
-  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps);
+  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps) & ~CAPS_FLAGS_PRIVATE;
   n = GST_CAPS_LEN (caps);
 
   GST_CAT_DEBUG_OBJECT (GST_CAT_PERFORMANCE, caps, "doing copy %p -> %p",
@@ -212,6 +249,7 @@ _gst_caps_free (GstCaps * caps)
     }
   }
   g_array_free (GST_CAPS_ARRAY (caps), TRUE);
+  g_free (((GstCapsImpl *) caps)->media_types);
 
 #ifdef DEBUG_REFCOUNT
   GST_CAT_TRACE (GST_CAT_CAPS, "freeing caps %p", caps);
@@ -238,6 +276,7 @@ gst_caps_init (GstCaps * caps)
    */
   GST_CAPS_ARRAY (caps) =
       g_array_new (FALSE, TRUE, sizeof (GstCapsArrayElement));
+  ((GstCapsImpl *) caps)->media_types = NULL;
 }
 
 /**
@@ -436,6 +475,10 @@ gst_static_caps_get (GstStaticCaps * static_caps)
       goto done;
     }
 
+    /* share the caps with all other static caps (for example of pad
+     * templates loaded from the registry) that have the same contents */
+    *caps = gst_caps_intern (*caps);
+
     /* Caps generated from static caps are usually leaked */
     GST_MINI_OBJECT_FLAG_SET (*caps, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
 
@@ -952,7 +995,7 @@ gst_caps_copy_nth (const GstCaps * caps, guint nth)
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
 
   newcaps = gst_caps_new_empty ();
-  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps);
+  GST_CAPS_FLAGS (newcaps) = GST_CAPS_FLAGS (caps) & ~CAPS_FLAGS_PRIVATE;
 
   if (G_LIKELY (GST_CAPS_LEN (caps) > nth)) {
     structure = gst_caps_get_structure_unchecked (caps, nth);
@@ -1189,6 +1232,87 @@ gst_caps_is_equal_fixed (const GstCaps * caps1, const GstCaps * caps2)
       gst_caps_features_is_equal (features1, features2);
 }
 
+/* Interned caps, like template caps, keep the sorted names of their
+ * structures so that caps with no media type in common can be told apart
+ * without comparing every pair of structures. */
+gint
+priv_gst_caps_compare_quarks (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  GQuark q1 = *(const GQuark *) a, q2 = *(const GQuark *) b;
+
+  return q1 < q2 ? -1 : (q1 > q2 ? 1 : 0);
+}
+
+static void
+gst_caps_build_media_types (GstCaps * caps)
+{
+  GstCapsMediaTypes *types;
+  guint i, n, len;
+
+  len = GST_CAPS_LEN (caps);
+  types = g_malloc (sizeof (GstCapsMediaTypes) + MAX (len, 1) *
+      sizeof (GQuark));
+  for (i = 0; i < len; i++)
+    types->names[i] =
+        gst_structure_get_name_id (gst_caps_get_structure_unchecked (caps, i));
+  g_qsort_with_data (types->names, len, sizeof (GQuark),
+      priv_gst_caps_compare_quarks, NULL);
+
+  for (i = 1, n = MIN (len, 1); i < len; i++) {
+    if (types->names[i] != types->names[n - 1])
+      types->names[n++] = types->names[i];
+  }
+  types->n_names = n;
+
+  if (!g_atomic_pointer_compare_and_exchange (&((GstCapsImpl *) caps)->
+          media_types, NULL, types))
+    g_free (types);
+}
+
+gboolean
+priv_gst_caps_media_types_contain (const GstCapsMediaTypes * types,
+    GQuark name)
+{
+  guint lo = 0, hi = types->n_names;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (types->names[mid] == name)
+      return TRUE;
+    if (types->names[mid] < name)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return FALSE;
+}
+
+/* Returns %FALSE if @caps1 and @caps2, which must not be ANY or empty,
+ * have no media type in common */
+static gboolean
+gst_caps_media_types_overlap (const GstCaps * caps1, const GstCaps * caps2)
+{
+  const GstCapsMediaTypes *types;
+  guint i, len;
+
+  if ((types = GST_CAPS_MEDIA_TYPES (caps2)) == NULL) {
+    if ((types = GST_CAPS_MEDIA_TYPES (caps1)) == NULL)
+      return TRUE;
+    caps1 = caps2;
+  }
+
+  len = GST_CAPS_LEN (caps1);
+  for (i = 0; i < len; i++) {
+    if (priv_gst_caps_media_types_contain (types,
+            gst_structure_get_name_id (gst_caps_get_structure_unchecked
+                (caps1, i))))
+      return TRUE;
+  }
+  return FALSE;
+}
+
 /**
  * gst_caps_is_always_compatible:
  * @caps1: the #GstCaps to test
@@ -1223,17 +1347,30 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
 {
   GstStructure *s1, *s2;
   GstCapsFeatures *f1, *f2;
+  const GstCapsMediaTypes *types;
   gboolean ret = TRUE;
   gint i, j;
 
   g_return_val_if_fail (subset != NULL, FALSE);
   g_return_val_if_fail (superset != NULL, FALSE);
 
+  if (G_UNLIKELY (subset == superset))
+    return TRUE;
+
   if (CAPS_IS_EMPTY (subset) || CAPS_IS_ANY (superset))
     return TRUE;
   if (CAPS_IS_ANY (subset) || CAPS_IS_EMPTY (superset))
     return FALSE;
 
+  if ((types = GST_CAPS_MEDIA_TYPES (superset))) {
+    for (i = GST_CAPS_LEN (subset) - 1; i >= 0; i--) {
+      s1 = gst_caps_get_structure_unchecked (subset, i);
+      if (!priv_gst_caps_media_types_contain (types,
+              gst_structure_get_name_id (s1)))
+        return FALSE;
+    }
+  }
+
   for (i = GST_CAPS_LEN (subset) - 1; i >= 0; i--) {
     for (j = GST_CAPS_LEN (superset) - 1; j >= 0; j--) {
       s1 = gst_caps_get_structure_unchecked (subset, i);
@@ -1365,6 +1502,11 @@ gst_caps_is_equal (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (caps1 == caps2))
     return TRUE;
 
+  /* fixed caps are only equal when they are strictly equal, and there is
+   * only one interned instance of those */
+  if (CAPS_IS_INTERNED_FIXED (caps1) && CAPS_IS_INTERNED_FIXED (caps2))
+    return FALSE;
+
   if (G_UNLIKELY (gst_caps_is_fixed (caps1) && gst_caps_is_fixed (caps2)))
     return gst_caps_is_equal_fixed (caps1, caps2);
 
@@ -1393,6 +1535,10 @@ gst_caps_is_strictly_equal (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (caps1 == caps2))
     return TRUE;
 
+  /* there is only one interned instance of strictly equal caps */
+  if (CAPS_IS_INTERNED (caps1) && CAPS_IS_INTERNED (caps2))
+    return FALSE;
+
   if (GST_CAPS_LEN (caps1) != GST_CAPS_LEN (caps2))
     return FALSE;
 
@@ -1452,6 +1598,9 @@ gst_caps_can_intersect (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (CAPS_IS_ANY (caps1) || CAPS_IS_ANY (caps2)))
     return TRUE;
 
+  if (!gst_caps_media_types_overlap (caps1, caps2))
+    return FALSE;
+
   /* run zigzag on top line then right line, this preserves the caps order
    * much better than a simple loop.
    *
@@ -1677,9 +1826,31 @@ GstCaps *
 gst_caps_intersect_full (GstCaps * caps1, GstCaps * caps2,
     GstCapsIntersectMode mode)
 {
+  GstCaps *res;
+
   g_return_val_if_fail (GST_IS_CAPS (caps1), NULL);
   g_return_val_if_fail (GST_IS_CAPS (caps2), NULL);
 
+  GST_TRACER_CAPS_INTERSECT_PRE (caps1, caps2);
+
+  if (G_UNLIKELY (CAPS_IS_INTERNED (caps1) && CAPS_IS_INTERNED (caps2)))
+    res = gst_caps_intersect_interned (caps1, caps2, mode);
+  else if (!CAPS_IS_ANY (caps1) && !CAPS_IS_ANY (caps2)
+      && !CAPS_IS_EMPTY (caps1) && !CAPS_IS_EMPTY (caps2)
+      && !gst_caps_media_types_overlap (caps1, caps2))
+    res = gst_caps_new_empty ();
+  else
+    res = gst_caps_intersect_mode (caps1, caps2, mode);
+
+  GST_TRACER_CAPS_INTERSECT_POST (caps1, caps2, res);
+
+  return res;
+}
+
+static GstCaps *
+gst_caps_intersect_mode (GstCaps * caps1, GstCaps * caps2,
+    GstCapsIntersectMode mode)
+{
   switch (mode) {
     case GST_CAPS_INTERSECT_FIRST:
       return gst_caps_intersect_first (caps1, caps2);
@@ -2159,6 +2330,8 @@ gst_caps_fixate (GstCaps * caps)
 
   g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
 
+  GST_TRACER_CAPS_FIXATE_PRE (caps);
+
   /* default fixation */
   caps = gst_caps_truncate (caps);
   caps = gst_caps_make_writable (caps);
@@ -2172,9 +2345,193 @@ gst_caps_fixate (GstCaps * caps)
     gst_caps_set_features (caps, 0, f);
   }
 
+  GST_TRACER_CAPS_FIXATE_POST (caps);
+
   return caps;
 }
 
+/* interning */
+
+typedef struct
+{
+  GstCaps *caps1;
+  GstCaps *caps2;
+  GstCapsIntersectMode mode;
+} IntersectKey;
+
+static gboolean
+caps_intern_hash_field (GQuark field_id, const GValue * value,
+    gpointer user_data)
+{
+  guint *hash = user_data;
+
+  /* values that compare equal can have different types or representations,
+   * so only the field names are hashed. Field order doesn't matter. */
+  *hash += field_id * 2654435761u;
+
+  return TRUE;
+}
+
+static guint
+caps_intern_hash (gconstpointer key)
+{
+  const GstCaps *caps = key;
+  GstStructure *structure;
+  GstCapsFeatures *features;
+  guint i, j, n, hash, h;
+
+  hash = CAPS_IS_ANY (caps) ? 1 : 0;
+  n = GST_CAPS_LEN (caps);
+
+  for (i = 0; i < n; i++) {
+    structure = gst_caps_get_structure_unchecked (caps, i);
+    features = gst_caps_get_features_unchecked (caps, i);
+
+    h = gst_structure_get_name_id (structure);
+    gst_structure_foreach (structure, caps_intern_hash_field, &h);
+
+    /* gst_caps_get_features() can replace missing features with system
+     * memory features at any time, even on interned caps, so both have to
+     * hash the same */
+    if (features && gst_caps_features_is_any (features)) {
+      h ^= 1;
+    } else if (features && !gst_caps_features_is_equal (features,
+            GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY)) {
+      for (j = 0; j < gst_caps_features_get_size (features); j++)
+        h += gst_caps_features_get_nth_id (features, j);
+    }
+
+    hash = hash * 31 + h;
+  }
+
+  return hash;
+}
+
+static gboolean
+caps_intern_equal (gconstpointer a, gconstpointer b)
+{
+  const GstCaps *caps1 = a, *caps2 = b;
+
+  return CAPS_IS_ANY (caps1) == CAPS_IS_ANY (caps2)
+      && gst_caps_is_strictly_equal (caps1, caps2);
+}
+
+static guint
+intersect_key_hash (gconstpointer key)
+{
+  const IntersectKey *k = key;
+
+  return (GPOINTER_TO_UINT (k->caps1) * 31 + GPOINTER_TO_UINT (k->caps2)) ^
+      k->mode;
+}
+
+static gboolean
+intersect_key_equal (gconstpointer a, gconstpointer b)
+{
+  const IntersectKey *k1 = a, *k2 = b;
+
+  return k1->caps1 == k2->caps1 && k1->caps2 == k2->caps2
+      && k1->mode == k2->mode;
+}
+
+static void
+intersect_key_free (gpointer key)
+{
+  g_slice_free (IntersectKey, key);
+}
+
+/**
+ * gst_caps_intern:
+ * @caps: (transfer full): a #GstCaps
+ *
+ * Returns the process-wide canonical instance of @caps. The first time
+ * caps with certain contents are interned they become that instance,
+ * later calls with strictly equal caps return a reference to it and unref
+ * @caps.
+ *
+ * Interned caps are never writable, use gst_caps_make_writable() to get a
+ * copy that can be modified. Checking two interned caps for strict
+ * equality, or two fixed interned caps for equality, is a pointer
+ * comparison, and the intersections of interned caps are remembered.
+ *
+ * Interned caps are only freed in gst_deinit(), so only intern caps that
+ * are used again and again, like template caps.
+ *
+ * Returns: (transfer full): the interned caps
+ *
+ * Since: 1.16
+ */
+GstCaps *
+gst_caps_intern (GstCaps * caps)
+{
+  GstCaps *interned;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
+
+  if (CAPS_IS_INTERNED (caps))
+    return caps;
+
+  G_LOCK (intern_lock);
+  if (G_UNLIKELY (intern_table == NULL))
+    intern_table = g_hash_table_new_full (caps_intern_hash, caps_intern_equal,
+        (GDestroyNotify) gst_mini_object_unref, NULL);
+
+  interned = g_hash_table_lookup (intern_table, caps);
+  if (interned == NULL) {
+    interned = caps;
+    gst_caps_build_media_types (interned);
+    GST_CAPS_FLAGS (interned) |= CAPS_FLAG_INTERNED;
+    if (gst_caps_is_fixed (interned))
+      GST_CAPS_FLAGS (interned) |= CAPS_FLAG_INTERNED_FIXED;
+    GST_MINI_OBJECT_FLAG_SET (interned, GST_MINI_OBJECT_FLAG_MAY_BE_LEAKED);
+    /* the table's reference keeps interned caps from being writable */
+    g_hash_table_add (intern_table, gst_caps_ref (interned));
+
+    GST_CAT_TRACE (GST_CAT_CAPS, "interned %" GST_PTR_FORMAT, interned);
+  } else {
+    gst_caps_ref (interned);
+    gst_caps_unref (caps);
+  }
+  G_UNLOCK (intern_lock);
+
+  return interned;
+}
+
+static GstCaps *
+gst_caps_intersect_interned (GstCaps * caps1, GstCaps * caps2,
+    GstCapsIntersectMode mode)
+{
+  IntersectKey key = { caps1, caps2, mode }, *new_key;
+  GstCaps *result;
+
+  G_LOCK (intern_lock);
+  if (intersect_memo && (result = g_hash_table_lookup (intersect_memo, &key))) {
+    gst_caps_ref (result);
+    G_UNLOCK (intern_lock);
+    return result;
+  }
+  G_UNLOCK (intern_lock);
+
+  /* results are not interned, that would keep every one of them alive
+   * until gst_deinit() even after the memo was cleared */
+  result = gst_caps_intersect_mode (caps1, caps2, mode);
+
+  G_LOCK (intern_lock);
+  if (G_UNLIKELY (intersect_memo == NULL))
+    intersect_memo = g_hash_table_new_full (intersect_key_hash,
+        intersect_key_equal, intersect_key_free,
+        (GDestroyNotify) gst_mini_object_unref);
+  else if (g_hash_table_size (intersect_memo) >= INTERSECT_MEMO_MAX)
+    g_hash_table_remove_all (intersect_memo);
+
+  new_key = g_slice_new (IntersectKey);
+  *new_key = key;
+  g_hash_table_replace (intersect_memo, new_key, gst_caps_ref (result));
+  G_UNLOCK (intern_lock);
+
+  return result;
+}
+
 /* utility */
 
 /**
@@ -558,6 +558,9 @@ GstCaps *         gst_caps_normalize               (GstCaps *caps) G_GNUC_WARN_U
 GST_API
 GstCaps *         gst_caps_simplify                (GstCaps *caps) G_GNUC_WARN_UNUSED_RESULT;
 
+GST_API
+GstCaps *         gst_caps_intern                  (GstCaps *caps) G_GNUC_WARN_UNUSED_RESULT;
+
 GST_API
 GstCaps *         gst_caps_fixate                  (GstCaps *caps) G_GNUC_WARN_UNUSED_RESULT;
 
@@ -569,6 +572,12 @@ gchar *           gst_caps_to_string               (const GstCaps *caps) G_GNUC_
 GST_API
 GstCaps *         gst_caps_from_string             (const gchar   *string) G_GNUC_WARN_UNUSED_RESULT;
 
+GST_API
+GBytes *          gst_caps_to_bytes                (const GstCaps *caps) G_GNUC_MALLOC;
+
+GST_API
+GstCaps *         gst_caps_new_from_bytes          (GBytes        *bytes) G_GNUC_WARN_UNUSED_RESULT;
+
 #ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstCaps, gst_caps_unref)
 #endif
@@ -84,6 +84,12 @@ gchar *           gst_caps_features_to_string (const GstCapsFeatures * features)
 GST_API
 GstCapsFeatures * gst_caps_features_from_string (const gchar * features);
 
+GST_API
+GBytes *          gst_caps_features_to_bytes (const GstCapsFeatures * features);
+
+GST_API
+GstCapsFeatures * gst_caps_features_new_from_bytes (GBytes * bytes);
+
 GST_API
 guint             gst_caps_features_get_size (const GstCapsFeatures * features);
 
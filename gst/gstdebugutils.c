@@ -51,6 +51,7 @@
 #include "gstpad.h"
 #include "gstutils.h"
 #include "gstvalue.h"
+#include "gstenumtypes.h"
 
 /*** PIPELINE GRAPHS **********************************************************/
 
@@ -76,15 +77,12 @@ debug_dump_make_object_name (GstObject * obj)
 }
 
 static gchar *
-debug_dump_get_element_state (GstElement * element)
+debug_dump_format_state (GstState state, GstState pending, gboolean is_locked)
 {
   gchar *state_name = NULL;
   const gchar *state_icons = "~0-=>";
-  GstState state = GST_STATE_VOID_PENDING, pending = GST_STATE_VOID_PENDING;
 
-  gst_element_get_state (element, &state, &pending, 0);
   if (pending == GST_STATE_VOID_PENDING) {
-    gboolean is_locked = gst_element_is_locked_state (element);
     state_name = g_strdup_printf ("\\n[%c]%s", state_icons[state],
         (is_locked ? "(locked)" : ""));
   } else {
@@ -221,146 +219,246 @@ debug_dump_get_object_params (GObject * object,
   return param_name;
 }
 
+/*** SNAPSHOTS ****************************************************************/
+
+/* The snapshot only collects raw values (names, enums, flags and caps refs)
+ * while walking the live pipeline, each of them under the object lock of the
+ * object it belongs to for as long as it takes to read it. Apart from the
+ * non-default parameters, which are only collected on request, all
+ * formatting, caps comparisons and string building happen later on the
+ * detached structure, so rendering never blocks the streaming threads. */
+
 static void
-debug_dump_pad (GstPad * pad, const gchar * color_name,
-    const gchar * element_name, GstDebugGraphDetails details, GString * str,
-    const gint indent)
+debug_snapshot_take_string (GstStructure * s, const gchar * fieldname,
+    gchar * str)
+{
+  GValue value = G_VALUE_INIT;
+
+  g_value_init (&value, G_TYPE_STRING);
+  g_value_take_string (&value, str);
+  gst_structure_take_value (s, fieldname, &value);
+}
+
+static void
+debug_snapshot_set_object_name (GstStructure * s, const gchar * fieldname,
+    GstObject * obj)
+{
+  debug_snapshot_take_string (s, fieldname,
+      obj ? debug_dump_make_object_name (obj) : g_strdup (""));
+}
+
+static void
+debug_snapshot_set_caps (GstStructure * s, const gchar * fieldname,
+    GstPad * pad)
+{
+  GstCaps *caps;
+
+  caps = gst_pad_get_current_caps (pad);
+  if (!caps)
+    caps = gst_pad_get_pad_template_caps (pad);
+  if (caps) {
+    gst_structure_set (s, fieldname, GST_TYPE_CAPS, caps, NULL);
+    gst_caps_unref (caps);
+  }
+}
+
+static GstStructure *
+debug_snapshot_pad (GstPad * pad, GstDebugGraphDetails details,
+    gboolean follow_ghost)
 {
-  GstPadTemplate *pad_templ;
-  GstPadPresence presence;
-  gchar *pad_name, *param_name = NULL;
-  const gchar *style_name;
   static const char *const ignore_propnames[] =
       { "parent", "direction", "template",
     "caps", NULL
   };
-  const gchar *spc = MAKE_INDENT (indent);
-
-  pad_name = debug_dump_make_object_name (GST_OBJECT (pad));
+  GstStructure *s;
+  GstPadTemplate *pad_templ;
+  GstPadPresence presence = GST_PAD_ALWAYS;
+  GstPad *peer_pad, *tmp_pad, *target_pad;
+  GstElement *element;
+  gchar *param_name;
 
-  /* pad availability */
-  style_name = "filled,solid";
   if ((pad_templ = gst_pad_get_pad_template (pad))) {
     presence = GST_PAD_TEMPLATE_PRESENCE (pad_templ);
     gst_object_unref (pad_templ);
-    if (presence == GST_PAD_SOMETIMES) {
-      style_name = "filled,dotted";
-    } else if (presence == GST_PAD_REQUEST) {
-      style_name = "filled,dashed";
-    }
   }
 
+  s = gst_structure_new ("pad",
+      "name", G_TYPE_STRING, GST_OBJECT_NAME (pad),
+      "direction", GST_TYPE_PAD_DIRECTION, GST_PAD_DIRECTION (pad),
+      "presence", GST_TYPE_PAD_PRESENCE, presence,
+      "ghost", G_TYPE_BOOLEAN, GST_IS_GHOST_PAD (pad), NULL);
+  debug_snapshot_set_object_name (s, "id", GST_OBJECT (pad));
+
   param_name =
       debug_dump_get_object_params (G_OBJECT (pad), details, ignore_propnames);
+  if (param_name)
+    debug_snapshot_take_string (s, "params", param_name);
+
   if (details & GST_DEBUG_GRAPH_SHOW_STATES) {
-    gchar pad_flags[5];
-    const gchar *activation_mode = "-><";
-    const gchar *task_mode = "";
+    GstPadMode mode;
+    guint flags;
     GstTask *task;
+    GstTaskState task_state = GST_TASK_STOPPED;
 
     GST_OBJECT_LOCK (pad);
+    mode = GST_PAD_MODE (pad);
+    flags = GST_OBJECT_FLAGS (pad);
     task = GST_PAD_TASK (pad);
-    if (task) {
-      switch (gst_task_get_state (task)) {
-        case GST_TASK_STARTED:
-          task_mode = "[T]";
-          break;
-        case GST_TASK_PAUSED:
-          task_mode = "[t]";
-          break;
-        default:
-          /* Invalid task state, ignoring */
-          break;
-      }
-    }
+    if (task)
+      task_state = gst_task_get_state (task);
     GST_OBJECT_UNLOCK (pad);
 
-    /* check if pad flags */
-    pad_flags[0] =
-        GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_FLAG_BLOCKED) ? 'B' : 'b';
-    pad_flags[1] =
-        GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_FLAG_FLUSHING) ? 'F' : 'f';
-    pad_flags[2] =
-        GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_FLAG_BLOCKING) ? 'B' : 'b';
-    pad_flags[3] = GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_FLAG_EOS) ? 'E' : '\0';
-    pad_flags[4] = '\0';
+    gst_structure_set (s, "mode", GST_TYPE_PAD_MODE, mode,
+        "flags", G_TYPE_UINT, flags, NULL);
+    if (task)
+      gst_structure_set (s, "task", GST_TYPE_TASK_STATE, task_state, NULL);
+  }
 
-    g_string_append_printf (str,
-        "%s  %s_%s [color=black, fillcolor=\"%s\", label=\"%s%s\\n[%c][%s]%s\", height=\"0.2\", style=\"%s\"];\n",
-        spc, element_name, pad_name, color_name, GST_OBJECT_NAME (pad),
-        (param_name ? param_name : ""),
-        activation_mode[pad->mode], pad_flags, task_mode, style_name);
-  } else {
-    g_string_append_printf (str,
-        "%s  %s_%s [color=black, fillcolor=\"%s\", label=\"%s%s\", height=\"0.2\", style=\"%s\"];\n",
-        spc, element_name, pad_name, color_name, GST_OBJECT_NAME (pad),
-        (param_name ? param_name : ""), style_name);
+  if ((peer_pad = gst_pad_get_peer (pad))) {
+    debug_snapshot_set_object_name (s, "peer", GST_OBJECT (peer_pad));
+    element = gst_pad_get_parent_element (peer_pad);
+    debug_snapshot_set_object_name (s, "peer-parent",
+        GST_OBJECT_CAST (element));
+    if (element)
+      gst_object_unref (element);
+    gst_structure_set (s, "peer-proxy", G_TYPE_BOOLEAN,
+        !GST_IS_GHOST_PAD (peer_pad) && GST_IS_PROXY_PAD (peer_pad), NULL);
+
+    if ((details & GST_DEBUG_GRAPH_SHOW_MEDIA_TYPE) ||
+        (details & GST_DEBUG_GRAPH_SHOW_CAPS_DETAILS)) {
+      debug_snapshot_set_caps (s, "caps", pad);
+      debug_snapshot_set_caps (s, "peer-caps", peer_pad);
+    }
+    gst_object_unref (peer_pad);
   }
 
-  g_free (param_name);
-  g_free (pad_name);
+  /* record the internal proxy pad so that it can be drawn as part of the
+   * element owning the ghostpad */
+  if (follow_ghost && GST_IS_GHOST_PAD (pad) &&
+      (tmp_pad = gst_ghost_pad_get_target (GST_GHOST_PAD (pad)))) {
+    if ((target_pad = gst_pad_get_peer (tmp_pad))) {
+      GstStructure *internal;
+
+      internal = debug_snapshot_pad (target_pad, details, FALSE);
+      element = gst_pad_get_parent_element (target_pad);
+      debug_snapshot_set_object_name (internal, "parent",
+          GST_OBJECT_CAST (element));
+      if (element)
+        gst_object_unref (element);
+      gst_structure_set (s, "internal", GST_TYPE_STRUCTURE, internal, NULL);
+      gst_structure_free (internal);
+      gst_object_unref (target_pad);
+    }
+    gst_object_unref (tmp_pad);
+  }
+
+  return s;
 }
 
 static void
-debug_dump_element_pad (GstPad * pad, GstElement * element,
-    GstDebugGraphDetails details, GString * str, const gint indent)
+debug_snapshot_levels (GstElement * element, GstStructure * s)
 {
-  GstElement *target_element;
-  GstPad *target_pad, *tmp_pad;
-  GstPadDirection dir;
-  gchar *element_name;
-  gchar *target_element_name;
-  const gchar *color_name;
+  static const gchar *const level_propnames[] = {
+    "current-level-buffers", "current-level-bytes", "current-level-time", NULL
+  };
+  GObjectClass *klass = G_OBJECT_GET_CLASS (element);
+  GParamSpec *property;
+  guint i;
 
-  dir = gst_pad_get_direction (pad);
-  element_name = debug_dump_make_object_name (GST_OBJECT (element));
-  if (GST_IS_GHOST_PAD (pad)) {
-    color_name =
-        (dir == GST_PAD_SRC) ? "#ffdddd" : ((dir ==
-            GST_PAD_SINK) ? "#ddddff" : "#ffffff");
-    /* output target-pad so that it belongs to this element */
-    if ((tmp_pad = gst_ghost_pad_get_target (GST_GHOST_PAD (pad)))) {
-      if ((target_pad = gst_pad_get_peer (tmp_pad))) {
-        gchar *pad_name, *target_pad_name;
-        const gchar *spc = MAKE_INDENT (indent);
-
-        if ((target_element = gst_pad_get_parent_element (target_pad))) {
-          target_element_name =
-              debug_dump_make_object_name (GST_OBJECT (target_element));
-        } else {
-          target_element_name = g_strdup ("");
-        }
-        debug_dump_pad (target_pad, color_name, target_element_name, details,
-            str, indent);
-        /* src ghostpad relationship */
-        pad_name = debug_dump_make_object_name (GST_OBJECT (pad));
-        target_pad_name = debug_dump_make_object_name (GST_OBJECT (target_pad));
-        if (dir == GST_PAD_SRC) {
-          g_string_append_printf (str,
-              "%s%s_%s -> %s_%s [style=dashed, minlen=0]\n", spc,
-              target_element_name, target_pad_name, element_name, pad_name);
-        } else {
-          g_string_append_printf (str,
-              "%s%s_%s -> %s_%s [style=dashed, minlen=0]\n", spc,
-              element_name, pad_name, target_element_name, target_pad_name);
-        }
-        g_free (target_pad_name);
-        g_free (target_element_name);
-        if (target_element)
-          gst_object_unref (target_element);
-        gst_object_unref (target_pad);
-        g_free (pad_name);
+  for (i = 0; level_propnames[i]; i++) {
+    GValue value = G_VALUE_INIT;
+
+    property = g_object_class_find_property (klass, level_propnames[i]);
+    if (!property || !(property->flags & G_PARAM_READABLE))
+      continue;
+
+    g_value_init (&value, property->value_type);
+    g_object_get_property (G_OBJECT (element), property->name, &value);
+    gst_structure_take_value (s, property->name, &value);
+  }
+}
+
+static GstStructure *debug_snapshot_element (GstElement * element,
+    GstDebugGraphDetails details);
+
+static void
+debug_snapshot_collect (GstStructure * s, const gchar * fieldname,
+    GstIterator * iter, GstDebugGraphDetails details)
+{
+  GValue item = G_VALUE_INIT;
+  GValue array = G_VALUE_INIT;
+  gboolean done = FALSE;
+
+  g_value_init (&array, GST_TYPE_ARRAY);
+  while (!done) {
+    switch (gst_iterator_next (iter, &item)) {
+      case GST_ITERATOR_OK:{
+        GObject *object = g_value_get_object (&item);
+        GValue value = G_VALUE_INIT;
+
+        g_value_init (&value, GST_TYPE_STRUCTURE);
+        if (GST_IS_PAD (object))
+          g_value_take_boxed (&value, debug_snapshot_pad (GST_PAD (object),
+                  details, TRUE));
+        else
+          g_value_take_boxed (&value,
+              debug_snapshot_element (GST_ELEMENT (object), details));
+        gst_value_array_append_and_take_value (&array, &value);
+        g_value_reset (&item);
+        break;
       }
-      gst_object_unref (tmp_pad);
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (iter);
+        g_value_unset (&array);
+        g_value_init (&array, GST_TYPE_ARRAY);
+        break;
+      case GST_ITERATOR_ERROR:
+      case GST_ITERATOR_DONE:
+        done = TRUE;
+        break;
     }
-  } else {
-    color_name =
-        (dir == GST_PAD_SRC) ? "#ffaaaa" : ((dir ==
-            GST_PAD_SINK) ? "#aaaaff" : "#cccccc");
   }
-  /* pads */
-  debug_dump_pad (pad, color_name, element_name, details, str, indent);
-  g_free (element_name);
+  g_value_unset (&item);
+  gst_iterator_free (iter);
+
+  gst_structure_take_value (s, fieldname, &array);
+}
+
+static GstStructure *
+debug_snapshot_element (GstElement * element, GstDebugGraphDetails details)
+{
+  GstStructure *s;
+
+  s = gst_structure_new ("element",
+      "name", G_TYPE_STRING, GST_OBJECT_NAME (element),
+      "type", G_TYPE_STRING, G_OBJECT_TYPE_NAME (element), NULL);
+  debug_snapshot_set_object_name (s, "id", GST_OBJECT (element));
+
+  if (details & GST_DEBUG_GRAPH_SHOW_STATES) {
+    GstState state = GST_STATE_VOID_PENDING, pending = GST_STATE_VOID_PENDING;
+
+    gst_element_get_state (element, &state, &pending, 0);
+    gst_structure_set (s, "state", GST_TYPE_STATE, state,
+        "pending", GST_TYPE_STATE, pending,
+        "locked", G_TYPE_BOOLEAN, gst_element_is_locked_state (element), NULL);
+  }
+  if (details & GST_DEBUG_GRAPH_SHOW_NON_DEFAULT_PARAMS) {
+    gchar *param_name;
+
+    param_name = debug_dump_get_object_params (G_OBJECT (element), details,
+        NULL);
+    if (param_name)
+      debug_snapshot_take_string (s, "params", param_name);
+  }
+  debug_snapshot_levels (element, s);
+
+  debug_snapshot_collect (s, "pads", gst_element_iterate_pads (element),
+      details);
+  if (GST_IS_BIN (element))
+    debug_snapshot_collect (s, "children",
+        gst_bin_iterate_elements (GST_BIN (element)), details);
+
+  return s;
 }
 
 static gboolean
@@ -411,7 +509,8 @@ string_append_field (GQuark field, const GValue * value, gpointer ptr)
 }
 
 static gchar *
-debug_dump_describe_caps (GstCaps * caps, GstDebugGraphDetails details)
+debug_dump_describe_caps (const GstCaps * caps,
+    GstDebugGraphDetails details)
 {
   gchar *media = NULL;
 
@@ -462,299 +561,352 @@ debug_dump_describe_caps (GstCaps * caps, GstDebugGraphDetails details)
   return media;
 }
 
+static gchar *
+debug_render_element_state (const GstStructure * element,
+    GstDebugGraphDetails details)
+{
+  gint state, pending;
+  gboolean is_locked = FALSE;
+
+  if (!(details & GST_DEBUG_GRAPH_SHOW_STATES))
+    return NULL;
+  if (!gst_structure_get_enum (element, "state", GST_TYPE_STATE, &state) ||
+      !gst_structure_get_enum (element, "pending", GST_TYPE_STATE, &pending))
+    return NULL;
+  gst_structure_get_boolean (element, "locked", &is_locked);
+
+  return debug_dump_format_state (state, pending, is_locked);
+}
+
+static const GstCaps *
+debug_render_get_caps (const GstStructure * s, const gchar * fieldname)
+{
+  const GValue *value = gst_structure_get_value (s, fieldname);
+
+  if (value && GST_VALUE_HOLDS_CAPS (value))
+    return gst_value_get_caps (value);
+  return NULL;
+}
+
 static void
-debug_dump_element_pad_link (GstPad * pad, GstElement * element,
-    GstDebugGraphDetails details, GString * str, const gint indent)
+debug_render_pad (const GstStructure * pad, const gchar * color_name,
+    const gchar * element_name, GstDebugGraphDetails details, GString * str,
+    const gint indent)
 {
-  GstElement *peer_element;
-  GstPad *peer_pad;
-  GstCaps *caps, *peer_caps;
-  gchar *media = NULL;
-  gchar *media_src = NULL, *media_sink = NULL;
-  gchar *pad_name, *element_name;
-  gchar *peer_pad_name, *peer_element_name;
+  const gchar *pad_name, *param_name;
+  const gchar *style_name;
+  gint presence = GST_PAD_ALWAYS;
+  gint mode;
   const gchar *spc = MAKE_INDENT (indent);
 
-  if ((peer_pad = gst_pad_get_peer (pad))) {
-    if ((details & GST_DEBUG_GRAPH_SHOW_MEDIA_TYPE) ||
-        (details & GST_DEBUG_GRAPH_SHOW_CAPS_DETAILS)
-        ) {
-      caps = gst_pad_get_current_caps (pad);
-      if (!caps)
-        caps = gst_pad_get_pad_template_caps (pad);
-      peer_caps = gst_pad_get_current_caps (peer_pad);
-      if (!peer_caps)
-        peer_caps = gst_pad_get_pad_template_caps (peer_pad);
-
-      media = debug_dump_describe_caps (caps, details);
-      /* check if peer caps are different */
-      if (peer_caps && !gst_caps_is_equal (caps, peer_caps)) {
-        gchar *tmp;
-
-        tmp = debug_dump_describe_caps (peer_caps, details);
-        if (gst_pad_get_direction (pad) == GST_PAD_SRC) {
-          media_src = media;
-          media_sink = tmp;
-        } else {
-          media_src = tmp;
-          media_sink = media;
-        }
-        media = NULL;
+  pad_name = gst_structure_get_string (pad, "id");
+  param_name = gst_structure_get_string (pad, "params");
+
+  /* pad availability */
+  style_name = "filled,solid";
+  gst_structure_get_enum (pad, "presence", GST_TYPE_PAD_PRESENCE, &presence);
+  if (presence == GST_PAD_SOMETIMES) {
+    style_name = "filled,dotted";
+  } else if (presence == GST_PAD_REQUEST) {
+    style_name = "filled,dashed";
+  }
+
+  if ((details & GST_DEBUG_GRAPH_SHOW_STATES) &&
+      gst_structure_get_enum (pad, "mode", GST_TYPE_PAD_MODE, &mode)) {
+    gchar pad_flags[5];
+    const gchar *activation_mode = "-><";
+    const gchar *task_mode = "";
+    gint task_state;
+    guint flags = 0;
+
+    if (gst_structure_get_enum (pad, "task", GST_TYPE_TASK_STATE,
+            &task_state)) {
+      switch (task_state) {
+        case GST_TASK_STARTED:
+          task_mode = "[T]";
+          break;
+        case GST_TASK_PAUSED:
+          task_mode = "[t]";
+          break;
+        default:
+          /* Invalid task state, ignoring */
+          break;
       }
-      gst_caps_unref (peer_caps);
-      gst_caps_unref (caps);
     }
 
-    pad_name = debug_dump_make_object_name (GST_OBJECT (pad));
-    if (element) {
-      element_name = debug_dump_make_object_name (GST_OBJECT (element));
-    } else {
-      element_name = g_strdup ("");
-    }
-    peer_pad_name = debug_dump_make_object_name (GST_OBJECT (peer_pad));
-    if ((peer_element = gst_pad_get_parent_element (peer_pad))) {
-      peer_element_name =
-          debug_dump_make_object_name (GST_OBJECT (peer_element));
-    } else {
-      peer_element_name = g_strdup ("");
+    /* check if pad flags */
+    gst_structure_get_uint (pad, "flags", &flags);
+    pad_flags[0] = (flags & GST_PAD_FLAG_BLOCKED) ? 'B' : 'b';
+    pad_flags[1] = (flags & GST_PAD_FLAG_FLUSHING) ? 'F' : 'f';
+    pad_flags[2] = (flags & GST_PAD_FLAG_BLOCKING) ? 'B' : 'b';
+    pad_flags[3] = (flags & GST_PAD_FLAG_EOS) ? 'E' : '\0';
+    pad_flags[4] = '\0';
+
+    g_string_append_printf (str,
+        "%s  %s_%s [color=black, fillcolor=\"%s\", label=\"%s%s\\n[%c][%s]%s\", height=\"0.2\", style=\"%s\"];\n",
+        spc, element_name, pad_name, color_name,
+        gst_structure_get_string (pad, "name"),
+        (param_name ? param_name : ""),
+        activation_mode[mode], pad_flags, task_mode, style_name);
+  } else {
+    g_string_append_printf (str,
+        "%s  %s_%s [color=black, fillcolor=\"%s\", label=\"%s%s\", height=\"0.2\", style=\"%s\"];\n",
+        spc, element_name, pad_name, color_name,
+        gst_structure_get_string (pad, "name"),
+        (param_name ? param_name : ""), style_name);
+  }
+}
+
+static void
+debug_render_element_pad (const GstStructure * pad, const gchar * element_name,
+    GstDebugGraphDetails details, GString * str, const gint indent)
+{
+  const GstStructure *target_pad = NULL;
+  const GValue *value;
+  gint dir = GST_PAD_UNKNOWN;
+  gboolean is_ghost = FALSE;
+  const gchar *color_name;
+
+  gst_structure_get_enum (pad, "direction", GST_TYPE_PAD_DIRECTION, &dir);
+  gst_structure_get_boolean (pad, "ghost", &is_ghost);
+  if (is_ghost) {
+    color_name =
+        (dir == GST_PAD_SRC) ? "#ffdddd" : ((dir ==
+            GST_PAD_SINK) ? "#ddddff" : "#ffffff");
+    /* output target-pad so that it belongs to this element */
+    if ((value = gst_structure_get_value (pad, "internal")))
+      target_pad = gst_value_get_structure (value);
+    if (target_pad) {
+      const gchar *pad_name, *target_pad_name, *target_element_name;
+      const gchar *spc = MAKE_INDENT (indent);
+
+      target_element_name = gst_structure_get_string (target_pad, "parent");
+      debug_render_pad (target_pad, color_name, target_element_name, details,
+          str, indent);
+      /* src ghostpad relationship */
+      pad_name = gst_structure_get_string (pad, "id");
+      target_pad_name = gst_structure_get_string (target_pad, "id");
+      if (dir == GST_PAD_SRC) {
+        g_string_append_printf (str,
+            "%s%s_%s -> %s_%s [style=dashed, minlen=0]\n", spc,
+            target_element_name, target_pad_name, element_name, pad_name);
+      } else {
+        g_string_append_printf (str,
+            "%s%s_%s -> %s_%s [style=dashed, minlen=0]\n", spc,
+            element_name, pad_name, target_element_name, target_pad_name);
+      }
     }
+  } else {
+    color_name =
+        (dir == GST_PAD_SRC) ? "#ffaaaa" : ((dir ==
+            GST_PAD_SINK) ? "#aaaaff" : "#cccccc");
+  }
+  /* pads */
+  debug_render_pad (pad, color_name, element_name, details, str, indent);
+}
 
-    /* pad link */
-    if (media) {
-      g_string_append_printf (str, "%s%s_%s -> %s_%s [label=\"%s\"]\n", spc,
-          element_name, pad_name, peer_element_name, peer_pad_name, media);
-      g_free (media);
-    } else if (media_src && media_sink) {
-      /* dot has some issues with placement of head and taillabels,
-       * we need an empty label to make space */
-      g_string_append_printf (str,
-          "%s%s_%s -> %s_%s [labeldistance=\"10\", labelangle=\"0\", "
-          "label=\"                                                  \", "
-          "taillabel=\"%s\", headlabel=\"%s\"]\n",
-          spc, element_name, pad_name, peer_element_name, peer_pad_name,
-          media_src, media_sink);
-      g_free (media_src);
-      g_free (media_sink);
-    } else {
-      g_string_append_printf (str, "%s%s_%s -> %s_%s\n", spc,
-          element_name, pad_name, peer_element_name, peer_pad_name);
+/* draws the link from the src side (@pad_name) to the sink side
+ * (@peer_pad_name) */
+static void
+debug_render_pad_link (const gchar * element_name, const gchar * pad_name,
+    const GstCaps * caps, const gchar * peer_element_name,
+    const gchar * peer_pad_name, const GstCaps * peer_caps,
+    GstDebugGraphDetails details, GString * str, const gint indent)
+{
+  gchar *media = NULL;
+  gchar *media_src = NULL, *media_sink = NULL;
+  const gchar *spc = MAKE_INDENT (indent);
+
+  if (((details & GST_DEBUG_GRAPH_SHOW_MEDIA_TYPE) ||
+          (details & GST_DEBUG_GRAPH_SHOW_CAPS_DETAILS)) && caps) {
+    media = debug_dump_describe_caps (caps, details);
+    /* check if peer caps are different */
+    if (peer_caps && !gst_caps_is_equal (caps, peer_caps)) {
+      media_src = media;
+      media_sink = debug_dump_describe_caps (peer_caps, details);
+      media = NULL;
     }
+  }
 
-    g_free (pad_name);
-    g_free (element_name);
-    g_free (peer_pad_name);
-    g_free (peer_element_name);
-    if (peer_element)
-      gst_object_unref (peer_element);
-    gst_object_unref (peer_pad);
+  /* pad link */
+  if (media) {
+    g_string_append_printf (str, "%s%s_%s -> %s_%s [label=\"%s\"]\n", spc,
+        element_name, pad_name, peer_element_name, peer_pad_name, media);
+    g_free (media);
+  } else if (media_src && media_sink) {
+    /* dot has some issues with placement of head and taillabels,
+     * we need an empty label to make space */
+    g_string_append_printf (str,
+        "%s%s_%s -> %s_%s [labeldistance=\"10\", labelangle=\"0\", "
+        "label=\"                                                  \", "
+        "taillabel=\"%s\", headlabel=\"%s\"]\n",
+        spc, element_name, pad_name, peer_element_name, peer_pad_name,
+        media_src, media_sink);
+    g_free (media_src);
+    g_free (media_sink);
+  } else {
+    g_string_append_printf (str, "%s%s_%s -> %s_%s\n", spc,
+        element_name, pad_name, peer_element_name, peer_pad_name);
   }
 }
 
 static void
-debug_dump_element_pads (GstIterator * pad_iter, GstPad * pad,
-    GstElement * element, GstDebugGraphDetails details, GString * str,
-    const gint indent, guint * num_pads, gchar * cluster_name,
-    gchar ** first_pad_name)
+debug_render_element_pads (const GValue * pads, GstPadDirection direction,
+    const gchar * element_name, GstDebugGraphDetails details, GString * str,
+    const gint indent, guint * num_pads, const gchar * cluster_name,
+    const gchar ** first_pad_name)
 {
-  GValue item = { 0, };
-  gboolean pads_done;
+  const GstStructure *pad;
+  guint i, n_pads;
+  gint dir;
   const gchar *spc = MAKE_INDENT (indent);
 
-  pads_done = FALSE;
-  while (!pads_done) {
-    switch (gst_iterator_next (pad_iter, &item)) {
-      case GST_ITERATOR_OK:
-        pad = g_value_get_object (&item);
-        if (!*num_pads) {
-          g_string_append_printf (str, "%ssubgraph cluster_%s {\n", spc,
-              cluster_name);
-          g_string_append_printf (str, "%s  label=\"\";\n", spc);
-          g_string_append_printf (str, "%s  style=\"invis\";\n", spc);
-          (*first_pad_name) = debug_dump_make_object_name (GST_OBJECT (pad));
-        }
-        debug_dump_element_pad (pad, element, details, str, indent);
-        (*num_pads)++;
-        g_value_reset (&item);
-        break;
-      case GST_ITERATOR_RESYNC:
-        gst_iterator_resync (pad_iter);
-        break;
-      case GST_ITERATOR_ERROR:
-      case GST_ITERATOR_DONE:
-        pads_done = TRUE;
-        break;
+  n_pads = pads ? gst_value_array_get_size (pads) : 0;
+  for (i = 0; i < n_pads; i++) {
+    pad = gst_value_get_structure (gst_value_array_get_value (pads, i));
+    if (!gst_structure_get_enum (pad, "direction", GST_TYPE_PAD_DIRECTION,
+            &dir) || dir != direction)
+      continue;
+
+    if (!*num_pads) {
+      g_string_append_printf (str, "%ssubgraph cluster_%s_%s {\n", spc,
+          element_name, cluster_name);
+      g_string_append_printf (str, "%s  label=\"\";\n", spc);
+      g_string_append_printf (str, "%s  style=\"invis\";\n", spc);
+      (*first_pad_name) = gst_structure_get_string (pad, "id");
     }
+    debug_render_element_pad (pad, element_name, details, str, indent);
+    (*num_pads)++;
   }
   if (*num_pads) {
     g_string_append_printf (str, "%s}\n\n", spc);
   }
 }
 
+static void debug_render_children (const GstStructure * bin,
+    GstDebugGraphDetails details, GString * str, const gint indent);
+
 /*
- * debug_dump_element:
- * @bin: the bin that should be analyzed
- * @out: file to write to
+ * debug_render_element:
+ * @element: the element snapshot that should be rendered
+ * @str: string to append to
  * @indent: level of graph indentation
  *
- * Helper for gst_debug_bin_to_dot_file() to recursively dump a pipeline.
+ * Helper for gst_debug_snapshot_to_dot_data() to recursively render a
+ * pipeline snapshot.
  */
 static void
-debug_dump_element (GstBin * bin, GstDebugGraphDetails details,
-    GString * str, const gint indent)
+debug_render_element (const GstStructure * element,
+    GstDebugGraphDetails details, GString * str, const gint indent)
 {
-  GstIterator *element_iter, *pad_iter;
-  gboolean elements_done, pads_done;
-  GValue item = { 0, };
-  GValue item2 = { 0, };
-  GstElement *element;
-  GstPad *pad = NULL;
+  const GValue *pads;
+  const GstStructure *pad;
+  guint i, n_pads;
   guint src_pads, sink_pads;
-  gchar *src_pad_name = NULL, *sink_pad_name = NULL;
-  gchar *element_name;
+  const gchar *src_pad_name = NULL, *sink_pad_name = NULL;
+  const gchar *element_name;
+  const gchar *param_name = NULL;
   gchar *state_name = NULL;
-  gchar *param_name = NULL;
   const gchar *spc = MAKE_INDENT (indent);
 
-  element_iter = gst_bin_iterate_elements (bin);
-  elements_done = FALSE;
-  while (!elements_done) {
-    switch (gst_iterator_next (element_iter, &item)) {
-      case GST_ITERATOR_OK:
-        element = g_value_get_object (&item);
-        element_name = debug_dump_make_object_name (GST_OBJECT (element));
-
-        if (details & GST_DEBUG_GRAPH_SHOW_STATES) {
-          state_name = debug_dump_get_element_state (GST_ELEMENT (element));
-        }
-        if (details & GST_DEBUG_GRAPH_SHOW_NON_DEFAULT_PARAMS) {
-          param_name = debug_dump_get_object_params (G_OBJECT (element),
-              details, NULL);
-        }
-        /* elements */
-        g_string_append_printf (str, "%ssubgraph cluster_%s {\n", spc,
-            element_name);
-        g_string_append_printf (str, "%s  fontname=\"Bitstream Vera Sans\";\n",
-            spc);
-        g_string_append_printf (str, "%s  fontsize=\"8\";\n", spc);
-        g_string_append_printf (str, "%s  style=\"filled,rounded\";\n", spc);
-        g_string_append_printf (str, "%s  color=black;\n", spc);
-        g_string_append_printf (str, "%s  label=\"%s\\n%s%s%s\";\n", spc,
-            G_OBJECT_TYPE_NAME (element), GST_OBJECT_NAME (element),
-            (state_name ? state_name : ""), (param_name ? param_name : "")
-            );
-        if (state_name) {
-          g_free (state_name);
-          state_name = NULL;
-        }
-        if (param_name) {
-          g_free (param_name);
-          param_name = NULL;
-        }
-
-        src_pads = sink_pads = 0;
-        if ((pad_iter = gst_element_iterate_sink_pads (element))) {
-          gchar *cluster_name = g_strdup_printf ("%s_sink", element_name);
-          debug_dump_element_pads (pad_iter, pad, element, details, str,
-              indent + 1, &sink_pads, cluster_name, &sink_pad_name);
-          g_free (cluster_name);
-          gst_iterator_free (pad_iter);
-        }
-        if ((pad_iter = gst_element_iterate_src_pads (element))) {
-          gchar *cluster_name = g_strdup_printf ("%s_src", element_name);
-          debug_dump_element_pads (pad_iter, pad, element, details, str,
-              indent + 1, &src_pads, cluster_name, &src_pad_name);
-          g_free (cluster_name);
-          gst_iterator_free (pad_iter);
-        }
-        if (sink_pads && src_pads) {
-          /* add invisible link from first sink to first src pad */
-          g_string_append_printf (str,
-              "%s  %s_%s -> %s_%s [style=\"invis\"];\n",
-              spc, element_name, sink_pad_name, element_name, src_pad_name);
-        }
-        g_free (sink_pad_name);
-        g_free (src_pad_name);
-        g_free (element_name);
-        sink_pad_name = src_pad_name = NULL;
-        if (GST_IS_BIN (element)) {
-          g_string_append_printf (str, "%s  fillcolor=\"#ffffff\";\n", spc);
-          /* recurse */
-          debug_dump_element (GST_BIN (element), details, str, indent + 1);
-        } else {
-          if (src_pads && !sink_pads)
-            g_string_append_printf (str, "%s  fillcolor=\"#ffaaaa\";\n", spc);
-          else if (!src_pads && sink_pads)
-            g_string_append_printf (str, "%s  fillcolor=\"#aaaaff\";\n", spc);
-          else if (src_pads && sink_pads)
-            g_string_append_printf (str, "%s  fillcolor=\"#aaffaa\";\n", spc);
-          else
-            g_string_append_printf (str, "%s  fillcolor=\"#ffffff\";\n", spc);
-        }
-        g_string_append_printf (str, "%s}\n\n", spc);
-        if ((pad_iter = gst_element_iterate_pads (element))) {
-          pads_done = FALSE;
-          while (!pads_done) {
-            switch (gst_iterator_next (pad_iter, &item2)) {
-              case GST_ITERATOR_OK:
-                pad = g_value_get_object (&item2);
-                if (gst_pad_is_linked (pad)) {
-                  if (gst_pad_get_direction (pad) == GST_PAD_SRC) {
-                    debug_dump_element_pad_link (pad, element, details, str,
-                        indent);
-                  } else {
-                    GstPad *peer_pad = gst_pad_get_peer (pad);
-
-                    if (peer_pad) {
-                      if (!GST_IS_GHOST_PAD (peer_pad)
-                          && GST_IS_PROXY_PAD (peer_pad)) {
-                        debug_dump_element_pad_link (peer_pad, NULL, details,
-                            str, indent);
-                      }
-                      gst_object_unref (peer_pad);
-                    }
-                  }
-                }
-                g_value_reset (&item2);
-                break;
-              case GST_ITERATOR_RESYNC:
-                gst_iterator_resync (pad_iter);
-                break;
-              case GST_ITERATOR_ERROR:
-              case GST_ITERATOR_DONE:
-                pads_done = TRUE;
-                break;
-            }
-          }
-          g_value_unset (&item2);
-          gst_iterator_free (pad_iter);
-        }
-        g_value_reset (&item);
-        break;
-      case GST_ITERATOR_RESYNC:
-        gst_iterator_resync (element_iter);
-        break;
-      case GST_ITERATOR_ERROR:
-      case GST_ITERATOR_DONE:
-        elements_done = TRUE;
-        break;
+  element_name = gst_structure_get_string (element, "id");
+  state_name = debug_render_element_state (element, details);
+  if (details & GST_DEBUG_GRAPH_SHOW_NON_DEFAULT_PARAMS)
+    param_name = gst_structure_get_string (element, "params");
+
+  /* elements */
+  g_string_append_printf (str, "%ssubgraph cluster_%s {\n", spc, element_name);
+  g_string_append_printf (str, "%s  fontname=\"Bitstream Vera Sans\";\n", spc);
+  g_string_append_printf (str, "%s  fontsize=\"8\";\n", spc);
+  g_string_append_printf (str, "%s  style=\"filled,rounded\";\n", spc);
+  g_string_append_printf (str, "%s  color=black;\n", spc);
+  g_string_append_printf (str, "%s  label=\"%s\\n%s%s%s\";\n", spc,
+      gst_structure_get_string (element, "type"),
+      gst_structure_get_string (element, "name"),
+      (state_name ? state_name : ""), (param_name ? param_name : "")
+      );
+  g_free (state_name);
+
+  pads = gst_structure_get_value (element, "pads");
+  src_pads = sink_pads = 0;
+  debug_render_element_pads (pads, GST_PAD_SINK, element_name, details, str,
+      indent + 1, &sink_pads, "sink", &sink_pad_name);
+  debug_render_element_pads (pads, GST_PAD_SRC, element_name, details, str,
+      indent + 1, &src_pads, "src", &src_pad_name);
+  if (sink_pads && src_pads) {
+    /* add invisible link from first sink to first src pad */
+    g_string_append_printf (str,
+        "%s  %s_%s -> %s_%s [style=\"invis\"];\n",
+        spc, element_name, sink_pad_name, element_name, src_pad_name);
+  }
+  if (gst_structure_has_field (element, "children")) {
+    g_string_append_printf (str, "%s  fillcolor=\"#ffffff\";\n", spc);
+    /* recurse */
+    debug_render_children (element, details, str, indent + 1);
+  } else {
+    if (src_pads && !sink_pads)
+      g_string_append_printf (str, "%s  fillcolor=\"#ffaaaa\";\n", spc);
+    else if (!src_pads && sink_pads)
+      g_string_append_printf (str, "%s  fillcolor=\"#aaaaff\";\n", spc);
+    else if (src_pads && sink_pads)
+      g_string_append_printf (str, "%s  fillcolor=\"#aaffaa\";\n", spc);
+    else
+      g_string_append_printf (str, "%s  fillcolor=\"#ffffff\";\n", spc);
+  }
+  g_string_append_printf (str, "%s}\n\n", spc);
+
+  n_pads = pads ? gst_value_array_get_size (pads) : 0;
+  for (i = 0; i < n_pads; i++) {
+    gint dir = GST_PAD_UNKNOWN;
+    gboolean peer_is_proxy = FALSE;
+
+    pad = gst_value_get_structure (gst_value_array_get_value (pads, i));
+    if (!gst_structure_has_field (pad, "peer"))
+      continue;
+
+    gst_structure_get_enum (pad, "direction", GST_TYPE_PAD_DIRECTION, &dir);
+    gst_structure_get_boolean (pad, "peer-proxy", &peer_is_proxy);
+    if (dir == GST_PAD_SRC) {
+      debug_render_pad_link (element_name, gst_structure_get_string (pad, "id"),
+          debug_render_get_caps (pad, "caps"),
+          gst_structure_get_string (pad, "peer-parent"),
+          gst_structure_get_string (pad, "peer"),
+          debug_render_get_caps (pad, "peer-caps"), details, str, indent);
+    } else if (peer_is_proxy) {
+      /* link from the internal pad of a sink ghostpad */
+      debug_render_pad_link ("", gst_structure_get_string (pad, "peer"),
+          debug_render_get_caps (pad, "peer-caps"), element_name,
+          gst_structure_get_string (pad, "id"),
+          debug_render_get_caps (pad, "caps"), details, str, indent);
     }
   }
+}
 
-  g_value_unset (&item);
-  gst_iterator_free (element_iter);
+static void
+debug_render_children (const GstStructure * bin, GstDebugGraphDetails details,
+    GString * str, const gint indent)
+{
+  const GValue *children;
+  guint i, n_children;
+
+  children = gst_structure_get_value (bin, "children");
+  n_children = children ? gst_value_array_get_size (children) : 0;
+  for (i = 0; i < n_children; i++) {
+    debug_render_element (gst_value_get_structure (gst_value_array_get_value
+            (children, i)), details, str, indent);
+  }
 }
 
 static void
-debug_dump_header (GstBin * bin, GstDebugGraphDetails details, GString * str)
+debug_dump_header (const GstStructure * bin, GstDebugGraphDetails details,
+    GString * str)
 {
   gchar *state_name = NULL;
-  gchar *param_name = NULL;
+  const gchar *param_name = NULL;
 
-  if (details & GST_DEBUG_GRAPH_SHOW_STATES) {
-    state_name = debug_dump_get_element_state (GST_ELEMENT (bin));
-  }
+  state_name = debug_render_element_state (bin, details);
   if (details & GST_DEBUG_GRAPH_SHOW_NON_DEFAULT_PARAMS) {
-    param_name = debug_dump_get_object_params (G_OBJECT (bin), details, NULL);
+    param_name = gst_structure_get_string (bin, "params");
   }
 
   /* write header */
@@ -776,14 +928,12 @@ debug_dump_header (GstBin * bin, GstDebugGraphDetails details, GString * str)
       "    style=\"filled\",\n"
       "    label=\"Legend\\lElement-States: [~] void-pending, [0] null, [-] ready, [=] paused, [>] playing\\lPad-Activation: [-] none, [>] push, [<] pull\\lPad-Flags: [b]locked, [f]lushing, [b]locking, [E]OS; upper-case is set\\lPad-Task: [T] has started task, [t] has paused task\\l\",\n"
       "  ];"
-      "\n", G_OBJECT_TYPE_NAME (bin), GST_OBJECT_NAME (bin),
+      "\n", gst_structure_get_string (bin, "type"),
+      gst_structure_get_string (bin, "name"),
       (state_name ? state_name : ""), (param_name ? param_name : "")
       );
 
-  if (state_name)
-    g_free (state_name);
-  if (param_name)
-    g_free (param_name);
+  g_free (state_name);
 }
 
 static void
@@ -792,6 +942,86 @@ debug_dump_footer (GString * str)
   g_string_append_printf (str, "}\n");
 }
 
+/**
+ * gst_debug_bin_snapshot:
+ * @bin: the top-level pipeline that should be analyzed
+ * @details: type of #GstDebugGraphDetails to use
+ *
+ * Takes a structured snapshot of @bin and all of its children. Only the
+ * raw values selected by @details are collected, every object is locked just
+ * long enough to read them and no strings are formatted while walking the
+ * pipeline, so this is cheap enough to be called on live pipelines.
+ *
+ * The snapshot is a #GstStructure named "element" with the fields "name",
+ * "id", "type" and "pads", plus "state", "pending" and "locked" when states
+ * are requested, "params" when non-default parameters are requested and the
+ * "current-level-buffers", "current-level-bytes" and "current-level-time"
+ * values of elements that have these properties (like queues). Bins carry
+ * their children as a #GST_TYPE_ARRAY of such structures in "children". Pads
+ * are "pad" structures describing their direction, presence, peer and, if
+ * requested, their caps, activation mode, flags and task state. The
+ * top-level structure also contains the "details" it was taken with and the
+ * "timestamp" of the snapshot.
+ *
+ * The snapshot can be serialized with gst_structure_to_string() and turned
+ * into a graph later with gst_debug_snapshot_to_dot_data().
+ *
+ * Returns: (transfer full): a new #GstStructure describing @bin.
+ *
+ * Since: 1.16
+ */
+GstStructure *
+gst_debug_bin_snapshot (GstBin * bin, GstDebugGraphDetails details)
+{
+  GstStructure *snapshot;
+
+  g_return_val_if_fail (GST_IS_BIN (bin), NULL);
+
+  snapshot = debug_snapshot_element (GST_ELEMENT_CAST (bin), details);
+  gst_structure_set (snapshot,
+      "details", GST_TYPE_DEBUG_GRAPH_DETAILS, details,
+      "timestamp", G_TYPE_UINT64, gst_util_get_timestamp (), NULL);
+
+  return snapshot;
+}
+
+/**
+ * gst_debug_snapshot_to_dot_data:
+ * @snapshot: a pipeline snapshot obtained with gst_debug_bin_snapshot()
+ *
+ * Renders a snapshot taken with gst_debug_bin_snapshot() into the same graph
+ * gst_debug_bin_to_dot_data() would have produced for the pipeline at the
+ * time the snapshot was taken. This does not touch the pipeline at all and
+ * can be done at any later point.
+ *
+ * Returns: (transfer full): a string containing the pipeline in graphviz
+ * dot format.
+ *
+ * Since: 1.16
+ */
+gchar *
+gst_debug_snapshot_to_dot_data (const GstStructure * snapshot)
+{
+  GstDebugGraphDetails details = 0;
+  const GValue *value;
+  GString *str;
+
+  g_return_val_if_fail (snapshot != NULL, NULL);
+  g_return_val_if_fail (gst_structure_has_name (snapshot, "element"), NULL);
+
+  value = gst_structure_get_value (snapshot, "details");
+  if (value && G_VALUE_HOLDS_FLAGS (value))
+    details = g_value_get_flags (value);
+
+  str = g_string_sized_new (4096);
+
+  debug_dump_header (snapshot, details, str);
+  debug_render_children (snapshot, details, str, 1);
+  debug_dump_footer (str);
+
+  return g_string_free (str, FALSE);
+}
+
 /**
  * gst_debug_bin_to_dot_data:
  * @bin: the top-level pipeline that should be analyzed
@@ -807,17 +1037,16 @@ debug_dump_footer (GString * str)
 gchar *
 gst_debug_bin_to_dot_data (GstBin * bin, GstDebugGraphDetails details)
 {
-  GString *str;
+  GstStructure *snapshot;
+  gchar *data;
 
   g_return_val_if_fail (GST_IS_BIN (bin), NULL);
 
-  str = g_string_new (NULL);
-
-  debug_dump_header (bin, details, str);
-  debug_dump_element (bin, details, str, 1);
-  debug_dump_footer (str);
+  snapshot = gst_debug_bin_snapshot (bin, details);
+  data = gst_debug_snapshot_to_dot_data (snapshot);
+  gst_structure_free (snapshot);
 
-  return g_string_free (str, FALSE);
+  return data;
 }
 
 /**
@@ -920,5 +1149,17 @@ gst_debug_bin_to_dot_file_with_ts (GstBin * bin, GstDebugGraphDetails details,
     const gchar * file_name)
 {
 }
+
+GstStructure *
+gst_debug_bin_snapshot (GstBin * bin, GstDebugGraphDetails details)
+{
+  return NULL;
+}
+
+gchar *
+gst_debug_snapshot_to_dot_data (const GstStructure * snapshot)
+{
+  return NULL;
+}
 #endif /* GST_REMOVE_DISABLED */
 #endif /* GST_DISABLE_GST_DEBUG */
@@ -67,6 +67,12 @@ gchar * gst_debug_bin_to_dot_data (GstBin *bin, GstDebugGraphDetails details);
 GST_API
 void gst_debug_bin_to_dot_file (GstBin *bin, GstDebugGraphDetails details, const gchar *file_name);
 
+GST_API
+GstStructure * gst_debug_bin_snapshot (GstBin *bin, GstDebugGraphDetails details);
+
+GST_API
+gchar * gst_debug_snapshot_to_dot_data (const GstStructure *snapshot);
+
 GST_API
 void gst_debug_bin_to_dot_file_with_ts (GstBin *bin, GstDebugGraphDetails details, const gchar *file_name);
 
@@ -2951,6 +2951,19 @@ gst_element_change_state (GstElement * element, GstStateChange transition)
 
   GST_TRACER_ELEMENT_CHANGE_STATE_POST (element, transition, ret);
 
+  /* caps queries might give a different result once resources were opened
+   * or closed, PAUSED<->PLAYING never changes them */
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+    case GST_STATE_CHANGE_READY_TO_NULL:
+      _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (element));
+      break;
+    default:
+      break;
+  }
+
   switch (ret) {
     case GST_STATE_CHANGE_FAILURE:
       GST_CAT_INFO_OBJECT (GST_CAT_STATES, element,
@@ -70,6 +70,7 @@ GST_DEBUG_CATEGORY_STATIC (element_factory_debug);
 
 static void gst_element_factory_finalize (GObject * object);
 static void gst_element_factory_cleanup (GstElementFactory * factory);
+static void gst_compiled_pad_templates_free (gpointer compiled);
 
 /* static guint gst_element_factory_signals[LAST_SIGNAL] = { 0 }; */
 
@@ -104,6 +105,12 @@ gst_element_factory_init (GstElementFactory * factory)
   factory->uri_protocols = NULL;
 
   factory->interfaces = NULL;
+
+  factory->compiled_templates = NULL;
+
+  factory->metadata_string = NULL;
+  factory->metadata_backing = NULL;
+  factory->metadata_invalid = FALSE;
 }
 
 static void
@@ -152,6 +159,14 @@ gst_element_factory_cleanup (GstElementFactory * factory)
     gst_structure_free ((GstStructure *) factory->metadata);
     factory->metadata = NULL;
   }
+  if (factory->metadata_backing) {
+    g_bytes_unref (factory->metadata_backing);
+    factory->metadata_backing = NULL;
+  } else {
+    g_free (factory->metadata_string);
+  }
+  factory->metadata_string = NULL;
+  factory->metadata_invalid = FALSE;
   if (factory->type) {
     factory->type = G_TYPE_INVALID;
   }
@@ -165,6 +180,8 @@ gst_element_factory_cleanup (GstElementFactory * factory)
   g_list_free (factory->staticpadtemplates);
   factory->staticpadtemplates = NULL;
   factory->numpadtemplates = 0;
+  gst_compiled_pad_templates_free (factory->compiled_templates);
+  factory->compiled_templates = NULL;
   factory->uri_type = GST_URI_UNKNOWN;
   if (factory->uri_protocols) {
     g_strfreev (factory->uri_protocols);
@@ -474,6 +491,10 @@ __gst_element_factory_add_static_pad_template (GstElementFactory * factory,
   factory->staticpadtemplates =
       g_list_append (factory->staticpadtemplates, templ);
   factory->numpadtemplates++;
+
+  /* templates are only added while loading the registry */
+  gst_compiled_pad_templates_free (factory->compiled_templates);
+  factory->compiled_templates = NULL;
 }
 
 /**
@@ -495,6 +516,35 @@ gst_element_factory_get_element_type (GstElementFactory * factory)
   return factory->type;
 }
 
+/* metadata loaded from the registry cache is only parsed when used */
+static GstStructure *
+gst_element_factory_get_metadata_structure (GstElementFactory * factory)
+{
+  GstStructure *metadata;
+
+  metadata = g_atomic_pointer_get (&factory->metadata);
+  if (G_LIKELY (metadata != NULL) || factory->metadata_string == NULL ||
+      g_atomic_int_get (&factory->metadata_invalid))
+    return metadata;
+
+  metadata = gst_structure_from_string (factory->metadata_string, NULL);
+  if (G_UNLIKELY (metadata == NULL)) {
+    GST_ERROR_OBJECT (factory, "Error when trying to deserialize structure "
+        "for metadata '%s'", factory->metadata_string);
+    /* don't try again on every call */
+    g_atomic_int_set (&factory->metadata_invalid, TRUE);
+    return NULL;
+  }
+
+  if (!g_atomic_pointer_compare_and_exchange (&factory->metadata, NULL,
+          metadata)) {
+    gst_structure_free (metadata);
+    metadata = g_atomic_pointer_get (&factory->metadata);
+  }
+
+  return metadata;
+}
+
 /**
  * gst_element_factory_get_metadata:
  * @factory: a #GstElementFactory
@@ -509,7 +559,13 @@ const gchar *
 gst_element_factory_get_metadata (GstElementFactory * factory,
     const gchar * key)
 {
-  return gst_structure_get_string ((GstStructure *) factory->metadata, key);
+  GstStructure *metadata;
+
+  metadata = gst_element_factory_get_metadata_structure (factory);
+  if (metadata == NULL)
+    return NULL;
+
+  return gst_structure_get_string (metadata, key);
 }
 
 /**
@@ -531,7 +587,7 @@ gst_element_factory_get_metadata_keys (GstElementFactory * factory)
 
   g_return_val_if_fail (GST_IS_ELEMENT_FACTORY (factory), NULL);
 
-  metadata = (GstStructure *) factory->metadata;
+  metadata = gst_element_factory_get_metadata_structure (factory);
   if (metadata == NULL)
     return NULL;
 
@@ -808,6 +864,336 @@ gst_element_factory_list_get_elements (GstElementFactoryListType type,
   return result;
 }
 
+/* The pad templates of a factory in a form for quick caps filtering: the
+ * interned template caps, and per direction the sorted media types of all
+ * templates, so that most factories can be ruled out by looking up the
+ * structure names of the caps. Interned caps keep their own media type
+ * index, which gst_caps_can_intersect() and gst_caps_is_subset() use. */
+typedef struct
+{
+  GstCapsMediaTypes *media_types;
+  /* one of the templates has ANY caps */
+  gboolean any;
+} GstCompiledDirection;
+
+typedef struct
+{
+  GstPadDirection direction;
+  GstCaps *caps;
+} GstCompiledPadTemplate;
+
+#define N_PAD_DIRECTIONS (GST_PAD_SINK + 1)
+
+typedef struct
+{
+  /* indexed by GstPadDirection */
+  GstCompiledDirection directions[N_PAD_DIRECTIONS];
+
+  guint n_templates;
+  GstCompiledPadTemplate templates[1];
+} GstCompiledPadTemplates;
+
+static void
+gst_compiled_pad_templates_free (gpointer data)
+{
+  GstCompiledPadTemplates *compiled = data;
+  guint i;
+
+  if (compiled == NULL)
+    return;
+
+  for (i = 0; i < N_PAD_DIRECTIONS; i++)
+    g_free (compiled->directions[i].media_types);
+  for (i = 0; i < compiled->n_templates; i++)
+    gst_caps_unref (compiled->templates[i].caps);
+  g_free (compiled);
+}
+
+static GstCompiledPadTemplates *
+gst_element_factory_compile_templates (GstElementFactory * factory)
+{
+  GstCompiledPadTemplates *compiled;
+  GArray *media_types[N_PAD_DIRECTIONS];
+  GList *walk;
+  guint i, j, n;
+
+  n = g_list_length (factory->staticpadtemplates);
+  compiled = g_malloc0 (sizeof (GstCompiledPadTemplates) +
+      MAX (n, 1) * sizeof (GstCompiledPadTemplate));
+
+  for (i = 0; i < N_PAD_DIRECTIONS; i++)
+    media_types[i] = g_array_new (FALSE, FALSE, sizeof (GQuark));
+
+  for (walk = factory->staticpadtemplates, i = 0; walk; walk = walk->next) {
+    GstStaticPadTemplate *templ = walk->data;
+    GstCompiledPadTemplate *ct;
+    GstCaps *caps;
+
+    if ((guint) templ->direction >= N_PAD_DIRECTIONS)
+      continue;
+
+    /* static caps are interned */
+    caps = gst_static_caps_get (&templ->static_caps);
+    if (caps == NULL)
+      continue;
+
+    ct = &compiled->templates[i++];
+    ct->direction = templ->direction;
+    ct->caps = caps;
+
+    if (gst_caps_is_any (caps)) {
+      compiled->directions[templ->direction].any = TRUE;
+    } else {
+      for (j = 0; j < gst_caps_get_size (caps); j++) {
+        GQuark name =
+            gst_structure_get_name_id (gst_caps_get_structure (caps, j));
+
+        g_array_append_val (media_types[templ->direction], name);
+      }
+    }
+  }
+  compiled->n_templates = i;
+
+  for (i = 0; i < N_PAD_DIRECTIONS; i++) {
+    GstCapsMediaTypes *types;
+    GQuark *names = (GQuark *) media_types[i]->data;
+    guint len = media_types[i]->len;
+
+    g_qsort_with_data (names, len, sizeof (GQuark),
+        priv_gst_caps_compare_quarks, NULL);
+    for (j = 1, n = MIN (len, 1); j < len; j++) {
+      if (names[j] != names[n - 1])
+        names[n++] = names[j];
+    }
+
+    types = g_malloc (sizeof (GstCapsMediaTypes) + MAX (n, 1) *
+        sizeof (GQuark));
+    types->n_names = n;
+    memcpy (types->names, names, n * sizeof (GQuark));
+    compiled->directions[i].media_types = types;
+    g_array_free (media_types[i], TRUE);
+  }
+
+  return compiled;
+}
+
+static GstCompiledPadTemplates *
+gst_element_factory_get_compiled_templates (GstElementFactory * factory)
+{
+  GstCompiledPadTemplates *compiled;
+
+  compiled = g_atomic_pointer_get (&factory->compiled_templates);
+  if (G_LIKELY (compiled != NULL))
+    return compiled;
+
+  compiled = gst_element_factory_compile_templates (factory);
+  if (!g_atomic_pointer_compare_and_exchange (&factory->compiled_templates,
+          NULL, compiled)) {
+    gst_compiled_pad_templates_free (compiled);
+    compiled = g_atomic_pointer_get (&factory->compiled_templates);
+  }
+
+  return compiled;
+}
+
+/* Returns %FALSE if no template in @dir can possibly accept @caps. For
+ * @subset all media types of @caps need to be in the templates, else at
+ * least one. */
+static gboolean
+gst_compiled_direction_may_accept (const GstCompiledDirection * dir,
+    const GstCaps * caps, gboolean subset)
+{
+  guint i, len;
+
+  if (dir->any || gst_caps_is_any (caps) || gst_caps_is_empty (caps))
+    return TRUE;
+
+  len = gst_caps_get_size (caps);
+  for (i = 0; i < len; i++) {
+    GQuark name = gst_structure_get_name_id (gst_caps_get_structure (caps, i));
+
+    if (priv_gst_caps_media_types_contain (dir->media_types, name) != subset)
+      return !subset;
+  }
+  return subset;
+}
+
+/* Checks if a pad template of @factory in @direction is a superset of
+ * @caps, if @subset, or can intersect with @caps otherwise */
+gboolean
+_priv_gst_element_factory_can_accept_caps (GstElementFactory * factory,
+    const GstCaps * caps, GstPadDirection direction, gboolean subset)
+{
+  GstCompiledPadTemplates *compiled;
+  guint i;
+
+  if ((guint) direction >= N_PAD_DIRECTIONS)
+    return FALSE;
+
+  compiled = gst_element_factory_get_compiled_templates (factory);
+  if (!gst_compiled_direction_may_accept (&compiled->directions[direction],
+          caps, subset))
+    return FALSE;
+
+  for (i = 0; i < compiled->n_templates; i++) {
+    GstCompiledPadTemplate *ct = &compiled->templates[i];
+
+    if (ct->direction != direction)
+      continue;
+
+    if (subset ? gst_caps_is_subset (caps, ct->caps) :
+        gst_caps_can_intersect (caps, ct->caps))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Long lists of factories are filtered in chunks on a thread pool. The
+ * first filtering is mostly spent parsing the template caps of every
+ * factory. */
+#define PARALLEL_FILTER_MIN_FACTORIES 256
+#define PARALLEL_FILTER_CHUNK_SIZE 64
+
+typedef struct
+{
+  GstElementFactory **factories;
+  gboolean *accepted;
+  const GstCaps *caps;
+  GstPadDirection direction;
+  gboolean subset;
+
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} FilterJob;
+
+typedef struct
+{
+  FilterJob *job;
+  guint start, end;
+} FilterChunk;
+
+G_LOCK_DEFINE_STATIC (filter_pool_lock);
+static GThreadPool *filter_pool;
+static gboolean filter_pool_failed;
+
+static void
+filter_chunk (FilterChunk * chunk)
+{
+  FilterJob *job = chunk->job;
+  guint i;
+
+  for (i = chunk->start; i < chunk->end; i++) {
+    job->accepted[i] =
+        _priv_gst_element_factory_can_accept_caps (job->factories[i],
+        job->caps, job->direction, job->subset);
+  }
+}
+
+static void
+filter_pool_func (gpointer data, gpointer user_data)
+{
+  FilterChunk *chunk = data;
+  FilterJob *job = chunk->job;
+
+  filter_chunk (chunk);
+
+  g_mutex_lock (&job->lock);
+  if (--job->pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+static GThreadPool *
+get_filter_pool (void)
+{
+  GThreadPool *pool;
+  GError *err = NULL;
+  guint n_threads;
+
+  G_LOCK (filter_pool_lock);
+  if (G_UNLIKELY (filter_pool == NULL && !filter_pool_failed)) {
+    n_threads = g_get_num_processors ();
+    if (n_threads > 1) {
+      filter_pool = g_thread_pool_new (filter_pool_func, NULL,
+          n_threads - 1, FALSE, &err);
+      if (err != NULL) {
+        GST_WARNING ("failed to create filter thread pool: %s", err->message);
+        g_clear_error (&err);
+      }
+    }
+    filter_pool_failed = (filter_pool == NULL);
+  }
+  pool = filter_pool;
+  G_UNLOCK (filter_pool_lock);
+
+  return pool;
+}
+
+/* Fills @accepted for the @n @factories using the thread pool, returns
+ * %FALSE if there is no pool */
+static gboolean
+gst_element_factory_filter_parallel (GstElementFactory ** factories,
+    gboolean * accepted, guint n, const GstCaps * caps,
+    GstPadDirection direction, gboolean subset)
+{
+  GThreadPool *pool;
+  FilterJob job;
+  FilterChunk *chunks;
+  guint i, n_chunks;
+
+  if ((pool = get_filter_pool ()) == NULL)
+    return FALSE;
+
+  job.factories = factories;
+  job.accepted = accepted;
+  job.caps = caps;
+  job.direction = direction;
+  job.subset = subset;
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+
+  n_chunks = (n + PARALLEL_FILTER_CHUNK_SIZE - 1) / PARALLEL_FILTER_CHUNK_SIZE;
+  chunks = g_new (FilterChunk, n_chunks);
+  for (i = 0; i < n_chunks; i++) {
+    chunks[i].job = &job;
+    chunks[i].start = i * PARALLEL_FILTER_CHUNK_SIZE;
+    chunks[i].end = MIN (n, chunks[i].start + PARALLEL_FILTER_CHUNK_SIZE);
+  }
+
+  /* the first chunk is done by this thread */
+  job.pending = n_chunks - 1;
+  for (i = 1; i < n_chunks; i++) {
+    if (!g_thread_pool_push (pool, &chunks[i], NULL))
+      filter_pool_func (&chunks[i], NULL);
+  }
+  filter_chunk (&chunks[0]);
+
+  g_mutex_lock (&job.lock);
+  while (job.pending > 0)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
+  g_free (chunks);
+
+  return TRUE;
+}
+
+void
+_priv_gst_element_factory_cleanup (void)
+{
+  G_LOCK (filter_pool_lock);
+  if (filter_pool) {
+    g_thread_pool_free (filter_pool, FALSE, TRUE);
+    filter_pool = NULL;
+  }
+  filter_pool_failed = FALSE;
+  G_UNLOCK (filter_pool_lock);
+}
+
 /**
  * gst_element_factory_list_filter:
  * @list: (transfer none) (element-type Gst.ElementFactory): a #GList of
@@ -832,45 +1218,51 @@ gst_element_factory_list_filter (GList * list,
     const GstCaps * caps, GstPadDirection direction, gboolean subsetonly)
 {
   GQueue results = G_QUEUE_INIT;
+  guint n;
 
   GST_DEBUG ("finding factories");
 
+  n = g_list_length (list);
+  if (n >= PARALLEL_FILTER_MIN_FACTORIES) {
+    GstElementFactory **factories;
+    gboolean *accepted;
+    GList *walk;
+    guint i;
+
+    factories = g_new (GstElementFactory *, n);
+    accepted = g_new (gboolean, n);
+    for (i = 0, walk = list; i < n; i++, walk = walk->next)
+      factories[i] = walk->data;
+
+    if (gst_element_factory_filter_parallel (factories, accepted, n, caps,
+            direction, subsetonly)) {
+      /* keep the order of the list */
+      for (i = 0; i < n; i++) {
+        if (accepted[i])
+          g_queue_push_tail (&results, gst_object_ref (factories[i]));
+      }
+      g_free (factories);
+      g_free (accepted);
+      return results.head;
+    }
+
+    g_free (factories);
+    g_free (accepted);
+  }
+
   /* loop over all the factories */
   for (; list; list = list->next) {
     GstElementFactory *factory;
-    const GList *templates;
-    GList *walk;
 
     factory = (GstElementFactory *) list->data;
 
     GST_DEBUG ("Trying %s",
         gst_plugin_feature_get_name ((GstPluginFeature *) factory));
 
-    /* get the templates from the element factory */
-    templates = gst_element_factory_get_static_pad_templates (factory);
-    for (walk = (GList *) templates; walk; walk = g_list_next (walk)) {
-      GstStaticPadTemplate *templ = walk->data;
-
-      /* we only care about the sink templates */
-      if (templ->direction == direction) {
-        GstCaps *tmpl_caps;
-
-        /* try to intersect the caps with the caps of the template */
-        tmpl_caps = gst_static_caps_get (&templ->static_caps);
-
-        /* FIXME, intersect is not the right method, we ideally want to check
-         * for a subset here */
-
-        /* check if the intersection is empty */
-        if ((subsetonly && gst_caps_is_subset (caps, tmpl_caps)) ||
-            (!subsetonly && gst_caps_can_intersect (caps, tmpl_caps))) {
-          /* non empty intersection, we can use this element */
-          g_queue_push_tail (&results, gst_object_ref (factory));
-          gst_caps_unref (tmpl_caps);
-          break;
-        }
-        gst_caps_unref (tmpl_caps);
-      }
+    if (_priv_gst_element_factory_can_accept_caps (factory, caps, direction,
+            subsetonly)) {
+      /* non empty intersection, we can use this element */
+      g_queue_push_tail (&results, gst_object_ref (factory));
     }
   }
   return results.head;
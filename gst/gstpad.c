@@ -132,6 +132,15 @@ typedef struct
   GstEvent *event;
 } PadEvent;
 
+/* number of filters a caps query result is cached for */
+#define CAPS_CACHE_SIZE 4
+
+typedef struct
+{
+  GstCaps *filter;
+  GstCaps *result;
+} CapsCacheEntry;
+
 struct _GstPadPrivate
 {
   guint events_cookie;
@@ -150,6 +159,12 @@ struct _GstPadPrivate
    * by a single thread at a time. Protected by the object lock */
   GCond activation_cond;
   gboolean in_activation;
+
+  /* caps query results, valid while caps_cache_cookie is current. Protected
+   * by the object lock */
+  gint caps_cache_cookie;
+  CapsCacheEntry caps_cache[CAPS_CACHE_SIZE];
+  guint caps_cache_next;
 };
 
 typedef struct
@@ -195,10 +210,18 @@ static GstFlowReturn gst_pad_push_event_unchecked (GstPad * pad,
 static gboolean activate_mode_internal (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active);
 
+static void caps_cache_clear (GstPad * pad);
+
 static guint gst_pad_signals[LAST_SIGNAL] = { 0 };
 
 static GParamSpec *pspec_caps = NULL;
 
+/* caps cache cookie of the pads outside of bins, toplevel bins have their
+ * own. Cookies are taken from caps_cache_serial so that no two are ever the
+ * same and pads moving between bins don't find stale results. */
+static gint caps_cache_cookie = 0;
+static gint caps_cache_serial = 0;
+
 /* quarks for probe signals */
 static GQuark buffer_quark;
 static GQuark buffer_list_quark;
@@ -723,6 +746,7 @@ gst_pad_dispose (GObject * object)
 
   GST_OBJECT_LOCK (pad);
   remove_events (pad);
+  caps_cache_clear (pad);
   GST_OBJECT_UNLOCK (pad);
 
   g_hook_list_clear (&pad->probes);
@@ -1209,8 +1233,10 @@ activate_mode_internal (GstPad * pad, GstObject * parent, GstPadMode mode,
   }
 
   /* Mark pad as needing reconfiguration */
-  if (active)
+  if (active) {
     GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_NEED_RECONFIGURE);
+    _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (pad));
+  }
 
   /* pre_activate returns TRUE if we weren't already in the process of
    * switching to the 'new' mode */
@@ -1693,6 +1719,8 @@ gst_pad_mark_reconfigure (GstPad * pad)
   GST_OBJECT_LOCK (pad);
   GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_NEED_RECONFIGURE);
   GST_OBJECT_UNLOCK (pad);
+
+  _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (pad));
 }
 
 /**
@@ -1984,6 +2012,8 @@ gst_pad_set_query_function_full (GstPad * pad, GstPadQueryFunction query,
   pad->querydata = user_data;
   pad->querynotify = notify;
 
+  _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (pad));
+
   GST_CAT_DEBUG_OBJECT (GST_CAT_PADS, pad, "queryfunc set to %s",
       GST_DEBUG_FUNCPTR_NAME (query));
 }
@@ -2175,6 +2205,9 @@ no_sink_parent:
   GST_OBJECT_UNLOCK (sinkpad);
   GST_OBJECT_UNLOCK (srcpad);
 
+  _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (srcpad));
+  _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (sinkpad));
+
   /* fire off a signal to each of the pads telling them
    * that they've been unlinked */
   g_signal_emit (srcpad, gst_pad_signals[PAD_UNLINKED], 0, sinkpad);
@@ -2573,6 +2606,9 @@ gst_pad_link_full (GstPad * srcpad, GstPad * sinkpad, GstPadLinkCheck flags)
   GST_OBJECT_UNLOCK (sinkpad);
   GST_OBJECT_UNLOCK (srcpad);
 
+  _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (srcpad));
+  _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (sinkpad));
+
   /* fire off a signal to each of the pads telling them
    * that they've been linked */
   g_signal_emit (srcpad, gst_pad_signals[PAD_LINKED], 0, sinkpad);
@@ -2653,6 +2689,8 @@ gst_pad_set_pad_template (GstPad * pad, GstPadTemplate * templ)
   gst_object_replace ((GstObject **) template_p, (GstObject *) templ);
   GST_OBJECT_UNLOCK (pad);
 
+  _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (pad));
+
   if (templ)
     gst_pad_template_pad_created (templ, pad);
 }
@@ -4003,6 +4041,141 @@ check_sticky (GstPad * pad, GstEvent * event)
   return data.ret;
 }
 
+/* caps query cache */
+
+gint
+_priv_gst_pad_caps_cache_new_cookie (void)
+{
+  return g_atomic_int_add (&caps_cache_serial, 1) + 1;
+}
+
+/* Returns the location of the caps cache cookie for the pads in the toplevel
+ * bin of @object, which can be %NULL. Must be called without the object lock
+ * of @object. The location stays valid as long as *@toplevel is alive. */
+static gint *
+caps_cache_get_cookie_location (GstObject * object, GstObject ** toplevel)
+{
+  GstObject *parent;
+
+  *toplevel = NULL;
+  if (object == NULL)
+    return &caps_cache_cookie;
+
+  object = gst_object_ref (object);
+  while ((parent = gst_object_get_parent (object))) {
+    gst_object_unref (object);
+    object = parent;
+  }
+
+  if (!GST_IS_BIN (object)) {
+    gst_object_unref (object);
+    return &caps_cache_cookie;
+  }
+
+  *toplevel = object;
+  return _priv_gst_bin_get_caps_cache_cookie (GST_BIN_CAST (object));
+}
+
+static gint
+caps_cache_get_cookie (GstObject * object)
+{
+  GstObject *toplevel;
+  gint cookie;
+
+  cookie = g_atomic_int_get (caps_cache_get_cookie_location (object,
+          &toplevel));
+  if (toplevel)
+    gst_object_unref (toplevel);
+
+  return cookie;
+}
+
+/* must be called without the object lock of @object */
+void
+_priv_gst_pad_caps_cache_invalidate (GstObject * object)
+{
+  GstObject *toplevel;
+
+  g_atomic_int_set (caps_cache_get_cookie_location (object, &toplevel),
+      _priv_gst_pad_caps_cache_new_cookie ());
+  if (toplevel)
+    gst_object_unref (toplevel);
+}
+
+/* with OBJECT_LOCK */
+static void
+caps_cache_clear (GstPad * pad)
+{
+  guint i;
+
+  for (i = 0; i < CAPS_CACHE_SIZE; i++) {
+    CapsCacheEntry *entry = &pad->priv->caps_cache[i];
+
+    gst_caps_replace (&entry->filter, NULL);
+    gst_caps_replace (&entry->result, NULL);
+  }
+}
+
+/* with OBJECT_LOCK. Sets the result of @query from the cache if it has one
+ * for the filter that is valid for @cookie */
+static gboolean
+caps_cache_lookup (GstPad * pad, GstQuery * query, gint cookie)
+{
+  GstPadPrivate *priv = pad->priv;
+  GstCaps *filter;
+  guint i;
+
+  if (priv->caps_cache_cookie != cookie) {
+    caps_cache_clear (pad);
+    priv->caps_cache_cookie = cookie;
+    return FALSE;
+  }
+
+  gst_query_parse_caps (query, &filter);
+
+  for (i = 0; i < CAPS_CACHE_SIZE; i++) {
+    CapsCacheEntry *entry = &priv->caps_cache[i];
+
+    if (entry->result == NULL)
+      continue;
+
+    if (entry->filter == filter || (entry->filter && filter
+            && gst_caps_is_strictly_equal (entry->filter, filter))) {
+      gst_query_set_caps_result (query, entry->result);
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+
+/* with OBJECT_LOCK. Stores the result of @query if nothing changed since
+ * @cookie was current, @current is the cookie after the query */
+static void
+caps_cache_store (GstPad * pad, GstQuery * query, gint cookie, gint current)
+{
+  GstPadPrivate *priv = pad->priv;
+  CapsCacheEntry *entry;
+  GstCaps *filter, *result;
+
+  if (current != cookie)
+    return;
+
+  gst_query_parse_caps_result (query, &result);
+  if (result == NULL)
+    return;
+
+  if (priv->caps_cache_cookie != cookie) {
+    caps_cache_clear (pad);
+    priv->caps_cache_cookie = cookie;
+  }
+
+  gst_query_parse_caps (query, &filter);
+
+  entry = &priv->caps_cache[priv->caps_cache_next];
+  priv->caps_cache_next = (priv->caps_cache_next + 1) % CAPS_CACHE_SIZE;
+  gst_caps_replace (&entry->filter, filter);
+  gst_caps_replace (&entry->result, result);
+}
 
 /**
  * gst_pad_query:
@@ -4030,6 +4203,8 @@ gst_pad_query (GstPad * pad, GstQuery * query)
   GstPadQueryFunction func;
   GstPadProbeType type;
   GstFlowReturn ret;
+  gboolean cache = FALSE, hit = FALSE;
+  gint cookie = 0;
 
   g_return_val_if_fail (GST_IS_PAD (pad), FALSE);
   g_return_val_if_fail (GST_IS_QUERY (query), FALSE);
@@ -4059,15 +4234,41 @@ gst_pad_query (GstPad * pad, GstQuery * query)
   PROBE_PUSH (pad, type | GST_PAD_PROBE_TYPE_PUSH, query, probe_stopped);
 
   ACQUIRE_PARENT (pad, parent, no_parent);
+
+  cache = GST_PAD_IS_CACHE_CAPS (pad)
+      && GST_QUERY_TYPE (query) == GST_QUERY_CAPS;
   GST_OBJECT_UNLOCK (pad);
 
-  if ((func = GST_PAD_QUERYFUNC (pad)) == NULL)
-    goto no_func;
+  if (G_UNLIKELY (cache)) {
+    cookie = caps_cache_get_cookie (parent);
+    GST_OBJECT_LOCK (pad);
+    hit = caps_cache_lookup (pad, query, cookie);
+    GST_OBJECT_UNLOCK (pad);
+  }
+
+  if (hit) {
+    GST_DEBUG_OBJECT (pad, "using cached caps query result");
+    res = TRUE;
+  } else {
+    if ((func = GST_PAD_QUERYFUNC (pad)) == NULL)
+      goto no_func;
 
-  res = func (pad, parent, query);
+    res = func (pad, parent, query);
+
+    if (cache && res) {
+      gint current = caps_cache_get_cookie (parent);
+
+      GST_OBJECT_LOCK (pad);
+      caps_cache_store (pad, query, cookie, current);
+      GST_OBJECT_UNLOCK (pad);
+    }
+  }
 
   RELEASE_PARENT (parent);
 
+  if (cache)
+    GST_TRACER_PAD_QUERY_CAPS_CACHE (pad, query, hit);
+
   GST_DEBUG_OBJECT (pad, "sent query %p (%s), result %d", query,
       GST_QUERY_TYPE_NAME (query), res);
   GST_TRACER_PAD_QUERY_POST (pad, query, res);
@@ -5222,6 +5423,8 @@ store_sticky_event (GstPad * pad, GstEvent * event)
       case GST_EVENT_CAPS:
         GST_OBJECT_UNLOCK (pad);
 
+        _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (pad));
+
         GST_DEBUG_OBJECT (pad, "notify caps");
         g_object_notify_by_pspec ((GObject *) pad, pspec_caps);
 
@@ -5346,6 +5549,12 @@ gst_pad_push_event_unchecked (GstPad * pad, GstEvent * event,
         case GST_EVENT_RECONFIGURE:
           if (GST_PAD_IS_SINK (pad))
             GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_NEED_RECONFIGURE);
+          /* the cookie is found through the parents of the pad */
+          GST_OBJECT_UNLOCK (pad);
+          _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (pad));
+          GST_OBJECT_LOCK (pad);
+          if (G_UNLIKELY (GST_PAD_IS_FLUSHING (pad)))
+            goto flushed;
           break;
         default:
           break;
@@ -5688,6 +5897,10 @@ gst_pad_send_event_unchecked (GstPad * pad, GstEvent * event,
     case GST_EVENT_RECONFIGURE:
       if (GST_PAD_IS_SRC (pad))
         GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_NEED_RECONFIGURE);
+      /* the cookie is found through the parents of the pad */
+      GST_OBJECT_UNLOCK (pad);
+      _priv_gst_pad_caps_cache_invalidate (GST_OBJECT_CAST (pad));
+      GST_OBJECT_LOCK (pad);
     default:
       GST_CAT_DEBUG_OBJECT (GST_CAT_EVENT, pad,
           "have event type %" GST_PTR_FORMAT, event);
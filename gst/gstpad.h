@@ -693,6 +693,13 @@ typedef gboolean  (*GstPadStickyEventsForeachFunction) (GstPad *pad, GstEvent **
  *                      the template pad caps instead of query caps to
  *                      compare with the accept caps. Use this in combination
  *                      with %GST_PAD_FLAG_ACCEPT_INTERSECT. (Since 1.6)
+ * @GST_PAD_FLAG_CACHE_CAPS: caps queries on the pad will return the previous
+ *                      result for the same filter as long as no pad in the
+ *                      same toplevel bin was linked or unlinked, no caps or
+ *                      template changed, no pad was marked for
+ *                      reconfiguration and no element went to or from the
+ *                      READY state. Only use this if the query-caps result
+ *                      depends on nothing else. (Since 1.16)
  * @GST_PAD_FLAG_LAST: offset to define more flags
  *
  * Pad state flags
@@ -711,6 +718,7 @@ typedef enum {
   GST_PAD_FLAG_PROXY_SCHEDULING = (GST_OBJECT_FLAG_LAST << 10),
   GST_PAD_FLAG_ACCEPT_INTERSECT = (GST_OBJECT_FLAG_LAST << 11),
   GST_PAD_FLAG_ACCEPT_TEMPLATE  = (GST_OBJECT_FLAG_LAST << 12),
+  GST_PAD_FLAG_CACHE_CAPS       = (GST_OBJECT_FLAG_LAST << 13),
   /* padding */
   GST_PAD_FLAG_LAST        = (GST_OBJECT_FLAG_LAST << 16)
 } GstPadFlags;
@@ -1225,6 +1233,35 @@ struct _GstPadClass {
  * Since: 1.6
  */
 #define GST_PAD_UNSET_ACCEPT_TEMPLATE(pad) (GST_OBJECT_FLAG_UNSET (pad, GST_PAD_FLAG_ACCEPT_TEMPLATE))
+/**
+ * GST_PAD_IS_CACHE_CAPS:
+ * @pad: a #GstPad
+ *
+ * Check if caps query results on @pad are cached.
+ *
+ * Since: 1.16
+ */
+#define GST_PAD_IS_CACHE_CAPS(pad)         (GST_OBJECT_FLAG_IS_SET (pad, GST_PAD_FLAG_CACHE_CAPS))
+/**
+ * GST_PAD_SET_CACHE_CAPS:
+ * @pad: a #GstPad
+ *
+ * Set @pad to cache the results of caps queries. Elements whose query-caps
+ * result changes for other reasons than links, caps events, templates or
+ * state changes must call gst_pad_mark_reconfigure() when it does.
+ *
+ * Since: 1.16
+ */
+#define GST_PAD_SET_CACHE_CAPS(pad)        (GST_OBJECT_FLAG_SET (pad, GST_PAD_FLAG_CACHE_CAPS))
+/**
+ * GST_PAD_UNSET_CACHE_CAPS:
+ * @pad: a #GstPad
+ *
+ * Unset cache caps flag.
+ *
+ * Since: 1.16
+ */
+#define GST_PAD_UNSET_CACHE_CAPS(pad)      (GST_OBJECT_FLAG_UNSET (pad, GST_PAD_FLAG_CACHE_CAPS))
 /**
  * GST_PAD_GET_STREAM_LOCK:
  * @pad: a #GstPad
@@ -72,6 +72,14 @@
  * between the clock time and the base time) will count how much time was spent
  * in the PLAYING state. This default behaviour can be changed with the
  * gst_element_set_start_time() method.
+ *
+ * The streaming threads of the elements in a #GstPipeline are taken from one
+ * process wide pool that is shared by all pipelines. The number of threads a
+ * pipeline can use at the same time and the CPUs they run on can be limited
+ * with gst_pipeline_set_max_threads() and gst_pipeline_set_cpu_set(), and
+ * gst_pipeline_get_cpu_time() then reports the CPU time they used. This does
+ * not require the application to handle #GST_MESSAGE_STREAM_STATUS messages.
+ * Both only apply to tasks that are created after they were set.
  */
 
 #include "gst_private.h"
@@ -83,6 +91,14 @@
 #include "gstsystemclock.h"
 #include "gstutils.h"
 
+#ifdef HAVE_PTHREAD_GETCPUCLOCKID
+#include <pthread.h>
+#include <time.h>
+#endif
+#ifdef HAVE_SCHED_SETAFFINITY
+#include <sched.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (pipeline_debug);
 #define GST_CAT_DEFAULT pipeline_debug
 
@@ -96,15 +112,430 @@ enum
 #define DEFAULT_DELAY           0
 #define DEFAULT_AUTO_FLUSH_BUS  TRUE
 #define DEFAULT_LATENCY         GST_CLOCK_TIME_NONE
+#define DEFAULT_MAX_THREADS     0
+#define DEFAULT_CPU_SET         NULL
 
 enum
 {
   PROP_0,
   PROP_DELAY,
   PROP_AUTO_FLUSH_BUS,
-  PROP_LATENCY
+  PROP_LATENCY,
+  PROP_MAX_THREADS,
+  PROP_CPU_SET
+};
+
+/* process wide defaults for the thread quota and CPU set of new pipelines,
+ * configured in gst_init() from GST_PIPELINE_MAX_THREADS and
+ * GST_PIPELINE_CPU_SET or the matching command line options */
+guint _priv_gst_pipeline_max_threads = DEFAULT_MAX_THREADS;
+gchar *_priv_gst_pipeline_cpu_set = DEFAULT_CPU_SET;
+
+/* GstPipelineTaskPool:
+ *
+ * The task pool a pipeline installs on the tasks of its children. It does not
+ * own any threads but starts the tasks on the process wide default pool of
+ * #GstTask, so that all pipelines share the same threads. It limits the
+ * number of threads the pipeline can use at the same time, binds them to the
+ * CPUs of the pipeline and accounts the CPU time they use.
+ */
+#define GST_TYPE_PIPELINE_TASK_POOL (gst_pipeline_task_pool_get_type ())
+#define GST_IS_PIPELINE_TASK_POOL(obj) \
+    (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_PIPELINE_TASK_POOL))
+#define GST_PIPELINE_TASK_POOL_CAST(obj) ((GstPipelineTaskPool *)(obj))
+
+typedef struct _GstPipelineTaskPool GstPipelineTaskPool;
+typedef struct _GstPipelineTaskPoolClass GstPipelineTaskPoolClass;
+
+struct _GstPipelineTaskPool
+{
+  GstTaskPool parent;
+
+  /* the pipeline that errors are posted on */
+  GWeakRef pipeline;
+
+  /* with LOCK */
+  guint max_threads;
+  GArray *cpus;
+  guint n_threads;
+  /* CPU time of the threads that are not running anymore */
+  GstClockTime cpu_time;
+  /* PipelineThread of the pushed threads, until they released their slot */
+  GList *threads;
+  guint next_id;
+  /* signaled when a thread released its slot */
+  GCond cond;
+};
+
+struct _GstPipelineTaskPoolClass
+{
+  GstTaskPoolClass parent_class;
 };
 
+typedef struct
+{
+  GstPipelineTaskPool *pool;
+  GstTaskPoolFunction func;
+  gpointer user_data;
+  /* returned from push, the thread frees itself before it might be joined */
+  guint id;
+
+#ifdef HAVE_PTHREAD_GETCPUCLOCKID
+  gboolean have_clock;
+  clockid_t clock;
+#endif
+  /* CPU time of the thread when the task was started on it */
+  GstClockTime start;
+} PipelineThread;
+
+static GType gst_pipeline_task_pool_get_type (void);
+G_DEFINE_TYPE (GstPipelineTaskPool, gst_pipeline_task_pool,
+    GST_TYPE_TASK_POOL);
+
+/* parses a comma separated list of CPU numbers and ranges like "0-3,6" */
+static GArray *
+parse_cpu_set (const gchar * str)
+{
+  GArray *cpus;
+  gchar **ranges;
+  guint i;
+
+  cpus = g_array_new (FALSE, FALSE, sizeof (guint));
+  ranges = g_strsplit (str, ",", -1);
+  for (i = 0; ranges[i]; i++) {
+    gchar *end;
+    guint64 first, last, cpu;
+
+    first = g_ascii_strtoull (ranges[i], &end, 10);
+    if (end == ranges[i])
+      goto invalid;
+    if (*end == '-') {
+      gchar *str_last = end + 1;
+
+      last = g_ascii_strtoull (str_last, &end, 10);
+      if (end == str_last || last < first)
+        goto invalid;
+    } else {
+      last = first;
+    }
+    if (*end != '\0' || last >= G_MAXUINT16)
+      goto invalid;
+
+    for (cpu = first; cpu <= last; cpu++) {
+      guint val = cpu;
+
+      g_array_append_val (cpus, val);
+    }
+  }
+  g_strfreev (ranges);
+
+  if (cpus->len == 0) {
+    g_array_free (cpus, TRUE);
+    return NULL;
+  }
+  return cpus;
+
+  /* ERRORS */
+invalid:
+  {
+    g_strfreev (ranges);
+    g_array_free (cpus, TRUE);
+    return NULL;
+  }
+}
+
+static GstClockTime
+pipeline_thread_get_cpu_time (PipelineThread * thread)
+{
+#ifdef HAVE_PTHREAD_GETCPUCLOCKID
+  struct timespec ts;
+
+  if (thread->have_clock && clock_gettime (thread->clock, &ts) == 0)
+    return GST_TIMESPEC_TO_TIME (ts);
+#endif
+  return 0;
+}
+
+static void
+pipeline_thread_func (PipelineThread * thread)
+{
+  GstPipelineTaskPool *pool = thread->pool;
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t saved, set;
+  gboolean restore = FALSE;
+
+  GST_OBJECT_LOCK (pool);
+  if (pool->cpus) {
+    guint i;
+
+    CPU_ZERO (&set);
+    for (i = 0; i < pool->cpus->len; i++) {
+      guint cpu = g_array_index (pool->cpus, guint, i);
+
+      if (cpu < CPU_SETSIZE)
+        CPU_SET (cpu, &set);
+    }
+    restore = TRUE;
+  }
+  GST_OBJECT_UNLOCK (pool);
+
+  /* the threads are shared with other pipelines, remember the affinity we
+   * need to restore when our task is done */
+  if (restore) {
+    restore = sched_getaffinity (0, sizeof (saved), &saved) == 0;
+    if (restore && sched_setaffinity (0, sizeof (set), &set) != 0) {
+      GST_WARNING_OBJECT (pool, "could not bind thread to CPU set");
+      restore = FALSE;
+    }
+  }
+#endif
+
+  GST_OBJECT_LOCK (pool);
+#ifdef HAVE_PTHREAD_GETCPUCLOCKID
+  thread->have_clock =
+      pthread_getcpuclockid (pthread_self (), &thread->clock) == 0;
+#endif
+  thread->start = pipeline_thread_get_cpu_time (thread);
+  GST_OBJECT_UNLOCK (pool);
+
+  thread->func (thread->user_data);
+
+  GST_OBJECT_LOCK (pool);
+  pool->threads = g_list_remove (pool->threads, thread);
+  pool->cpu_time += pipeline_thread_get_cpu_time (thread) - thread->start;
+  pool->n_threads--;
+  g_cond_broadcast (&pool->cond);
+  GST_OBJECT_UNLOCK (pool);
+
+#ifdef HAVE_SCHED_SETAFFINITY
+  if (restore)
+    sched_setaffinity (0, sizeof (saved), &saved);
+#endif
+
+  gst_object_unref (pool);
+  g_slice_free (PipelineThread, thread);
+}
+
+static gpointer
+gst_pipeline_task_pool_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer user_data, GError ** error)
+{
+  GstPipelineTaskPool *ppool = GST_PIPELINE_TASK_POOL_CAST (pool);
+  PipelineThread *thread;
+  GstTaskPool *shared;
+  GError *err = NULL;
+  guint id;
+
+  GST_OBJECT_LOCK (pool);
+  if (ppool->max_threads > 0 && ppool->n_threads >= ppool->max_threads)
+    goto quota_exceeded;
+  ppool->n_threads++;
+
+  thread = g_slice_new0 (PipelineThread);
+  thread->pool = gst_object_ref (pool);
+  thread->func = func;
+  thread->user_data = user_data;
+  /* 0 would be a NULL id, which is never joined */
+  if (++ppool->next_id == 0)
+    ppool->next_id = 1;
+  thread->id = id = ppool->next_id;
+  ppool->threads = g_list_prepend (ppool->threads, thread);
+  GST_OBJECT_UNLOCK (pool);
+
+  GST_DEBUG_OBJECT (pool, "starting thread %p", thread);
+
+  /* get the default pool for each thread, gst_task_cleanup_all() replaces it */
+  shared = priv_gst_task_get_default_pool ();
+  gst_task_pool_push (shared, (GstTaskPoolFunction) pipeline_thread_func,
+      thread, &err);
+  gst_object_unref (shared);
+
+  if (G_UNLIKELY (err != NULL))
+    goto push_failed;
+
+  return GUINT_TO_POINTER (id);
+
+  /* ERRORS */
+push_failed:
+  {
+    GST_WARNING_OBJECT (pool, "failed to start thread: %s", err->message);
+    g_propagate_error (error, err);
+
+    GST_OBJECT_LOCK (pool);
+    ppool->threads = g_list_remove (ppool->threads, thread);
+    ppool->n_threads--;
+    GST_OBJECT_UNLOCK (pool);
+
+    gst_object_unref (thread->pool);
+    g_slice_free (PipelineThread, thread);
+    return NULL;
+  }
+quota_exceeded:
+  {
+    guint max_threads = ppool->max_threads;
+    GstElement *pipeline;
+
+    GST_OBJECT_UNLOCK (pool);
+    GST_WARNING_OBJECT (pool, "thread quota of %u exceeded", max_threads);
+
+    /* this is not a programming error, the application learns about it
+     * like about any other error of the pipeline */
+    pipeline = g_weak_ref_get (&ppool->pipeline);
+    if (pipeline) {
+      GST_ELEMENT_ERROR (pipeline, CORE, THREAD, (NULL),
+          ("Thread quota of %u threads of the pipeline exceeded",
+              max_threads));
+      gst_object_unref (pipeline);
+    }
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_THREAD,
+        "Thread quota of %u threads of the pipeline exceeded", max_threads);
+    return NULL;
+  }
+}
+
+static gboolean
+gst_pipeline_task_pool_has_thread (GstPipelineTaskPool * pool, guint id)
+{
+  GList *walk;
+
+  for (walk = pool->threads; walk; walk = g_list_next (walk)) {
+    PipelineThread *thread = walk->data;
+
+    if (thread->id == id)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* the task is done when this is called, wait until its thread released the
+ * slot so that the task can be started again right away */
+static void
+gst_pipeline_task_pool_join (GstTaskPool * pool, gpointer id)
+{
+  GstPipelineTaskPool *ppool = GST_PIPELINE_TASK_POOL_CAST (pool);
+
+  GST_OBJECT_LOCK (pool);
+  while (gst_pipeline_task_pool_has_thread (ppool, GPOINTER_TO_UINT (id)))
+    g_cond_wait (&ppool->cond, GST_OBJECT_GET_LOCK (pool));
+  GST_OBJECT_UNLOCK (pool);
+}
+
+static void
+gst_pipeline_task_pool_prepare (GstTaskPool * pool, GError ** error)
+{
+  /* we don't own any threads */
+}
+
+static void
+gst_pipeline_task_pool_cleanup (GstTaskPool * pool)
+{
+  /* the threads are owned by the default pool */
+}
+
+static void
+gst_pipeline_task_pool_finalize (GObject * object)
+{
+  GstPipelineTaskPool *pool = GST_PIPELINE_TASK_POOL_CAST (object);
+
+  /* running threads keep a ref to the pool */
+  g_assert (pool->threads == NULL);
+
+  if (pool->cpus)
+    g_array_free (pool->cpus, TRUE);
+  g_cond_clear (&pool->cond);
+  g_weak_ref_clear (&pool->pipeline);
+
+  G_OBJECT_CLASS (gst_pipeline_task_pool_parent_class)->finalize (object);
+}
+
+static void
+gst_pipeline_task_pool_class_init (GstPipelineTaskPoolClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstTaskPoolClass *gsttaskpool_class = GST_TASK_POOL_CLASS (klass);
+
+  gobject_class->finalize = gst_pipeline_task_pool_finalize;
+
+  gsttaskpool_class->prepare = gst_pipeline_task_pool_prepare;
+  gsttaskpool_class->cleanup = gst_pipeline_task_pool_cleanup;
+  gsttaskpool_class->push = gst_pipeline_task_pool_push;
+  gsttaskpool_class->join = gst_pipeline_task_pool_join;
+}
+
+static void
+gst_pipeline_task_pool_init (GstPipelineTaskPool * pool)
+{
+  pool->max_threads = DEFAULT_MAX_THREADS;
+  g_cond_init (&pool->cond);
+  g_weak_ref_init (&pool->pipeline, NULL);
+}
+
+static void
+gst_pipeline_task_pool_set_max_threads (GstPipelineTaskPool * pool,
+    guint max_threads)
+{
+  GST_OBJECT_LOCK (pool);
+  pool->max_threads = max_threads;
+  GST_OBJECT_UNLOCK (pool);
+}
+
+/* only affects threads that are started after this call */
+static gboolean
+gst_pipeline_task_pool_set_cpu_set (GstPipelineTaskPool * pool,
+    const gchar * cpu_set)
+{
+  GArray *cpus = NULL, *old;
+
+  if (cpu_set && !(cpus = parse_cpu_set (cpu_set)))
+    return FALSE;
+
+  GST_OBJECT_LOCK (pool);
+  old = pool->cpus;
+  pool->cpus = cpus;
+  GST_OBJECT_UNLOCK (pool);
+
+  if (old)
+    g_array_free (old, TRUE);
+
+  return TRUE;
+}
+
+/* the pool is only installed on tasks when it has something to do, other
+ * pipelines start their tasks on the default pool directly */
+static gboolean
+gst_pipeline_task_pool_is_configured (GstPipelineTaskPool * pool)
+{
+  gboolean configured;
+
+  GST_OBJECT_LOCK (pool);
+  configured = pool->max_threads > 0 || pool->cpus != NULL;
+  GST_OBJECT_UNLOCK (pool);
+
+  return configured;
+}
+
+#ifdef HAVE_PTHREAD_GETCPUCLOCKID
+/* CPU time used by the threads of the pool, including the ones that are
+ * still running */
+static GstClockTime
+gst_pipeline_task_pool_get_cpu_time (GstPipelineTaskPool * pool)
+{
+  GstClockTime cpu_time;
+  GList *walk;
+
+  GST_OBJECT_LOCK (pool);
+  cpu_time = pool->cpu_time;
+  for (walk = pool->threads; walk; walk = g_list_next (walk)) {
+    PipelineThread *thread = walk->data;
+
+    cpu_time += pipeline_thread_get_cpu_time (thread) - thread->start;
+  }
+  GST_OBJECT_UNLOCK (pool);
+
+  return cpu_time;
+}
+#endif
+
 struct _GstPipelinePrivate
 {
   /* with LOCK */
@@ -116,10 +547,15 @@ struct _GstPipelinePrivate
   gboolean update_clock;
 
   GstClockTime latency;
+
+  /* installed on the tasks of the children */
+  GstPipelineTaskPool *task_pool;
+  gchar *cpu_set;
 };
 
 
 static void gst_pipeline_dispose (GObject * object);
+static void gst_pipeline_finalize (GObject * object);
 static void gst_pipeline_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_pipeline_get_property (GObject * object, guint prop_id,
@@ -192,7 +628,40 @@ gst_pipeline_class_init (GstPipelineClass * klass)
           "Latency to configure on the pipeline", 0, G_MAXUINT64,
           DEFAULT_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstPipeline:max-threads:
+   *
+   * The maximum number of streaming threads the tasks of the pipeline can use
+   * at the same time, or 0 for no limit. Starting a task beyond this quota
+   * fails. The default value is taken from the GST_PIPELINE_MAX_THREADS
+   * environment variable or the --gst-pipeline-max-threads option.
+   *
+   * Since: 1.16
+   **/
+  g_object_class_install_property (gobject_class, PROP_MAX_THREADS,
+      g_param_spec_uint ("max-threads", "Max Threads",
+          "Maximum number of streaming threads of the pipeline (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_MAX_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstPipeline:cpu-set:
+   *
+   * Comma separated list of CPU numbers and ranges, like "0-3,6", that the
+   * streaming threads of the pipeline are bound to, or %NULL to run them on
+   * any CPU. Only affects threads that are started after setting the
+   * property. The default value is taken from the GST_PIPELINE_CPU_SET
+   * environment variable or the --gst-pipeline-cpu-set option.
+   *
+   * Since: 1.16
+   **/
+  g_object_class_install_property (gobject_class, PROP_CPU_SET,
+      g_param_spec_string ("cpu-set", "CPU Set",
+          "CPUs the streaming threads of the pipeline run on, like \"0-3,6\"",
+          DEFAULT_CPU_SET, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->dispose = gst_pipeline_dispose;
+  gobject_class->finalize = gst_pipeline_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class, "Pipeline object",
       "Generic/Bin",
@@ -220,6 +689,19 @@ gst_pipeline_init (GstPipeline * pipeline)
   pipeline->delay = DEFAULT_DELAY;
   pipeline->priv->latency = DEFAULT_LATENCY;
 
+  /* the streaming threads of the children are started on our task pool,
+   * configured with the process wide defaults */
+  pipeline->priv->task_pool =
+      g_object_new (GST_TYPE_PIPELINE_TASK_POOL, NULL);
+  gst_object_ref_sink (pipeline->priv->task_pool);
+  g_weak_ref_set (&pipeline->priv->task_pool->pipeline, pipeline);
+  gst_pipeline_task_pool_set_max_threads (pipeline->priv->task_pool,
+      _priv_gst_pipeline_max_threads);
+  if (_priv_gst_pipeline_cpu_set &&
+      gst_pipeline_task_pool_set_cpu_set (pipeline->priv->task_pool,
+          _priv_gst_pipeline_cpu_set))
+    pipeline->priv->cpu_set = g_strdup (_priv_gst_pipeline_cpu_set);
+
   /* create and set a default bus */
   bus = gst_bus_new ();
 #if 0
@@ -248,6 +730,18 @@ gst_pipeline_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_pipeline_finalize (GObject * object)
+{
+  GstPipeline *pipeline = GST_PIPELINE (object);
+
+  /* tasks that still run keep a ref to the task pool */
+  gst_object_unref (pipeline->priv->task_pool);
+  g_free (pipeline->priv->cpu_set);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_pipeline_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -264,6 +758,12 @@ gst_pipeline_set_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       gst_pipeline_set_latency (pipeline, g_value_get_uint64 (value));
       break;
+    case PROP_MAX_THREADS:
+      gst_pipeline_set_max_threads (pipeline, g_value_get_uint (value));
+      break;
+    case PROP_CPU_SET:
+      gst_pipeline_set_cpu_set (pipeline, g_value_get_string (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -286,6 +786,12 @@ gst_pipeline_get_property (GObject * object, guint prop_id,
     case PROP_LATENCY:
       g_value_set_uint64 (value, gst_pipeline_get_latency (pipeline));
       break;
+    case PROP_MAX_THREADS:
+      g_value_set_uint (value, gst_pipeline_get_max_threads (pipeline));
+      break;
+    case PROP_CPU_SET:
+      g_value_take_string (value, gst_pipeline_get_cpu_set (pipeline));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -581,6 +1087,36 @@ gst_pipeline_handle_message (GstBin * bin, GstMessage * message)
   GstPipeline *pipeline = GST_PIPELINE_CAST (bin);
 
   switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_STREAM_STATUS:
+    {
+      GstStreamStatusType type;
+      const GValue *val;
+
+      gst_message_parse_stream_status (message, &type, NULL);
+      if (type != GST_STREAM_STATUS_TYPE_CREATE)
+        break;
+
+      val = gst_message_get_stream_status_object (message);
+      if (val && G_VALUE_HOLDS (val, GST_TYPE_TASK)) {
+        GstTask *task = g_value_get_object (val);
+        GstTaskPool *pool;
+
+        /* start the new task on our pool if a thread quota or CPU set is
+         * configured, unless a pipeline inside of us already did. The
+         * application can still set its own pool from a sync handler on our
+         * bus, which sees the message after us. */
+        pool = gst_task_get_pool (task);
+        if (!GST_IS_PIPELINE_TASK_POOL (pool) &&
+            gst_pipeline_task_pool_is_configured (pipeline->priv->task_pool)) {
+          GST_DEBUG_OBJECT (pipeline, "using pipeline task pool for %"
+              GST_PTR_FORMAT, task);
+          gst_task_set_pool (task, GST_TASK_POOL_CAST (pipeline->priv->
+                  task_pool));
+        }
+        gst_object_unref (pool);
+      }
+      break;
+    }
     case GST_MESSAGE_RESET_TIME:
     {
       GstClockTime running_time;
@@ -970,6 +1506,212 @@ gst_pipeline_get_auto_flush_bus (GstPipeline * pipeline)
   return res;
 }
 
+/**
+ * gst_pipeline_set_bus_group:
+ * @pipeline: a #GstPipeline
+ * @group: (allow-none): the #GstBus shared by a group of pipelines, or %NULL
+ *
+ * Makes @pipeline post its messages into the shared bus @group instead of
+ * into a bus of its own. The pipeline's bus is replaced by a bus created with
+ * gst_bus_new_for_group(), which does not use any file descriptor and
+ * forwards all messages to @group, tagged with @pipeline. Use
+ * gst_bus_message_get_owner() to find the pipeline of a message popped from
+ * @group.
+ *
+ * This allows an application to supervise many pipelines with a single bus
+ * watch or gst_bus_timed_pop_batch_filtered() loop. Flushing of the pipeline
+ * bus when going to the NULL state only affects the messages of @pipeline
+ * that were not forwarded yet, @group itself is never flushed by @pipeline.
+ *
+ * Passing %NULL for @group gives @pipeline a new bus of its own again.
+ *
+ * This function should be called while @pipeline is in the NULL state.
+ *
+ * MT safe.
+ *
+ * Since: 1.16
+ */
+void
+gst_pipeline_set_bus_group (GstPipeline * pipeline, GstBus * group)
+{
+  GstBus *bus;
+
+  g_return_if_fail (GST_IS_PIPELINE (pipeline));
+  g_return_if_fail (group == NULL || GST_IS_BUS (group));
+
+  if (group)
+    bus = gst_bus_new_for_group (group, GST_OBJECT_CAST (pipeline));
+  else
+    bus = gst_bus_new ();
+
+  gst_element_set_bus (GST_ELEMENT_CAST (pipeline), bus);
+  GST_DEBUG_OBJECT (pipeline, "set bus %" GST_PTR_FORMAT " for group %"
+      GST_PTR_FORMAT " on pipeline", bus, group);
+  gst_object_unref (bus);
+}
+
+/**
+ * gst_pipeline_set_max_threads:
+ * @pipeline: a #GstPipeline
+ * @max_threads: the maximum number of streaming threads, or 0 for no limit
+ *
+ * Limits the number of streaming threads the tasks of the elements in
+ * @pipeline can use at the same time. The threads are taken from the process
+ * wide default #GstTaskPool, which is shared by all pipelines. Starting a
+ * task beyond the quota fails with a #GST_CORE_ERROR_THREAD error message
+ * from @pipeline, which usually also makes the state change of the element
+ * that starts it fail.
+ *
+ * Only tasks that are created after a quota or a CPU set was configured are
+ * counted. Tasks that were given a different #GstTaskPool by the application
+ * are not counted either.
+ *
+ * MT safe.
+ *
+ * Since: 1.16
+ */
+void
+gst_pipeline_set_max_threads (GstPipeline * pipeline, guint max_threads)
+{
+  g_return_if_fail (GST_IS_PIPELINE (pipeline));
+
+  gst_pipeline_task_pool_set_max_threads (pipeline->priv->task_pool,
+      max_threads);
+}
+
+/**
+ * gst_pipeline_get_max_threads:
+ * @pipeline: a #GstPipeline
+ *
+ * Gets the streaming thread quota of @pipeline. See
+ * gst_pipeline_set_max_threads().
+ *
+ * Returns: the maximum number of streaming threads, or 0 for no limit.
+ *
+ * MT safe.
+ *
+ * Since: 1.16
+ */
+guint
+gst_pipeline_get_max_threads (GstPipeline * pipeline)
+{
+  GstPipelineTaskPool *pool;
+  guint max_threads;
+
+  g_return_val_if_fail (GST_IS_PIPELINE (pipeline), 0);
+
+  pool = pipeline->priv->task_pool;
+  GST_OBJECT_LOCK (pool);
+  max_threads = pool->max_threads;
+  GST_OBJECT_UNLOCK (pool);
+
+  return max_threads;
+}
+
+/**
+ * gst_pipeline_set_cpu_set:
+ * @pipeline: a #GstPipeline
+ * @cpu_set: (allow-none): comma separated list of CPU numbers and ranges,
+ *     or %NULL
+ *
+ * Binds the streaming threads of the elements in @pipeline to the CPUs in
+ * @cpu_set, for example "0-3,6". Passing %NULL lets them run on any CPU
+ * again. Only threads that are started after this call are affected.
+ *
+ * Binding threads to CPUs is not supported on all platforms, where it is not
+ * supported @cpu_set is ignored.
+ *
+ * MT safe.
+ *
+ * Returns: %TRUE if @cpu_set could be parsed.
+ *
+ * Since: 1.16
+ */
+gboolean
+gst_pipeline_set_cpu_set (GstPipeline * pipeline, const gchar * cpu_set)
+{
+  g_return_val_if_fail (GST_IS_PIPELINE (pipeline), FALSE);
+
+  if (!gst_pipeline_task_pool_set_cpu_set (pipeline->priv->task_pool,
+          cpu_set))
+    goto invalid;
+
+  GST_OBJECT_LOCK (pipeline);
+  g_free (pipeline->priv->cpu_set);
+  pipeline->priv->cpu_set = g_strdup (cpu_set);
+  GST_OBJECT_UNLOCK (pipeline);
+
+  return TRUE;
+
+  /* ERRORS */
+invalid:
+  {
+    GST_WARNING_OBJECT (pipeline, "invalid CPU set '%s'", cpu_set);
+    return FALSE;
+  }
+}
+
+/**
+ * gst_pipeline_get_cpu_set:
+ * @pipeline: a #GstPipeline
+ *
+ * Gets the CPUs the streaming threads of @pipeline are bound to. See
+ * gst_pipeline_set_cpu_set().
+ *
+ * Returns: (transfer full) (nullable): the CPU set, or %NULL. g_free()
+ *     after usage.
+ *
+ * MT safe.
+ *
+ * Since: 1.16
+ */
+gchar *
+gst_pipeline_get_cpu_set (GstPipeline * pipeline)
+{
+  gchar *cpu_set;
+
+  g_return_val_if_fail (GST_IS_PIPELINE (pipeline), NULL);
+
+  GST_OBJECT_LOCK (pipeline);
+  cpu_set = g_strdup (pipeline->priv->cpu_set);
+  GST_OBJECT_UNLOCK (pipeline);
+
+  return cpu_set;
+}
+
+/**
+ * gst_pipeline_get_cpu_time:
+ * @pipeline: a #GstPipeline
+ *
+ * Gets the CPU time used by the streaming threads of the elements in
+ * @pipeline so far, including the threads that are still running. This
+ * allows to account the CPU usage of several pipelines in one process.
+ *
+ * Only the threads of tasks that were created while a thread quota or a CPU
+ * set was configured, see gst_pipeline_set_max_threads() and
+ * gst_pipeline_set_cpu_set(), are accounted. Threads of tasks that were
+ * given a different #GstTaskPool by the application and threads created by
+ * elements themselves are not accounted either.
+ *
+ * MT safe.
+ *
+ * Returns: the CPU time, or #GST_CLOCK_TIME_NONE when CPU time accounting is
+ *     not supported on this platform.
+ *
+ * Since: 1.16
+ */
+GstClockTime
+gst_pipeline_get_cpu_time (GstPipeline * pipeline)
+{
+  g_return_val_if_fail (GST_IS_PIPELINE (pipeline), GST_CLOCK_TIME_NONE);
+
+#ifdef HAVE_PTHREAD_GETCPUCLOCKID
+  return gst_pipeline_task_pool_get_cpu_time (pipeline->priv->task_pool);
+#else
+  return GST_CLOCK_TIME_NONE;
+#endif
+}
+
 /**
  * gst_pipeline_set_latency:
  * @pipeline: a #GstPipeline
@@ -130,6 +130,24 @@ void            gst_pipeline_set_auto_flush_bus (GstPipeline *pipeline, gboolean
 GST_API
 gboolean        gst_pipeline_get_auto_flush_bus (GstPipeline *pipeline);
 
+GST_API
+void            gst_pipeline_set_bus_group      (GstPipeline *pipeline, GstBus *group);
+
+GST_API
+void            gst_pipeline_set_max_threads    (GstPipeline *pipeline, guint max_threads);
+
+GST_API
+guint           gst_pipeline_get_max_threads    (GstPipeline *pipeline);
+
+GST_API
+gboolean        gst_pipeline_set_cpu_set        (GstPipeline *pipeline, const gchar *cpu_set);
+
+GST_API
+gchar *         gst_pipeline_get_cpu_set        (GstPipeline *pipeline);
+
+GST_API
+GstClockTime    gst_pipeline_get_cpu_time       (GstPipeline *pipeline);
+
 #ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstPipeline, gst_object_unref)
 #endif
@@ -109,6 +109,10 @@ static void gst_plugin_desc_copy (GstPluginDesc * dest,
 
 static void gst_plugin_ext_dep_free (GstPluginDep * dep);
 
+static gboolean gst_plugin_defer_prelinked (const GstPluginDesc * desc,
+    gpointer user_data);
+static GstPlugin *gst_plugin_load_prelinked (GstPlugin * plugin);
+
 G_DEFINE_TYPE_WITH_PRIVATE (GstPlugin, gst_plugin, GST_TYPE_OBJECT);
 
 static void
@@ -216,6 +220,9 @@ gst_plugin_register_static (gint major_version, gint minor_version,
   /* make sure gst_init() has been called */
   g_return_val_if_fail (_gst_plugin_inited != FALSE, FALSE);
 
+  if (gst_plugin_defer_prelinked (&desc, NULL))
+    return TRUE;
+
   GST_LOG ("attempting to load static plugin \"%s\" now...", name);
   plugin = g_object_new (GST_TYPE_PLUGIN, NULL);
   if (gst_plugin_register_func (plugin, &desc, NULL) != NULL) {
@@ -283,6 +290,9 @@ gst_plugin_register_static_full (gint major_version, gint minor_version,
   /* make sure gst_init() has been called */
   g_return_val_if_fail (_gst_plugin_inited != FALSE, FALSE);
 
+  if (gst_plugin_defer_prelinked (&desc, user_data))
+    return TRUE;
+
   GST_LOG ("attempting to load static plugin \"%s\" now...", name);
   plugin = g_object_new (GST_TYPE_PLUGIN, NULL);
   if (gst_plugin_register_func (plugin, &desc, user_data) != NULL) {
@@ -914,6 +924,86 @@ return_error:
   }
 }
 
+/* A static plugin that is in the registry from gst_registry_add_prelinked()
+ * only gets its init function here, which runs when one of its features is
+ * loaded. Returns %FALSE if the plugin needs registering as usual. */
+static gboolean
+gst_plugin_defer_prelinked (const GstPluginDesc * desc, gpointer user_data)
+{
+  GstRegistry *registry = gst_registry_get ();
+  GstPlugin *plugin;
+  gboolean deferred = FALSE;
+
+  plugin = gst_registry_find_plugin (registry, desc->name);
+  if (plugin == NULL)
+    return FALSE;
+
+  g_mutex_lock (&gst_plugin_loading_mutex);
+  if (plugin->priv->prelinked && plugin->priv->prelinked_init == NULL) {
+    if (g_strcmp0 (plugin->desc.version, desc->version) == 0) {
+      GST_INFO ("deferring init of prelinked static plugin \"%s\"",
+          desc->name);
+      plugin->priv->prelinked_init = desc->plugin_init;
+      plugin->priv->prelinked_user_data = user_data;
+      deferred = TRUE;
+    } else {
+      GST_WARNING ("prelinked static plugin \"%s\" has version %s instead "
+          "of %s, replacing it", desc->name, plugin->desc.version,
+          desc->version);
+      gst_registry_remove_plugin (registry, plugin);
+    }
+  }
+  g_mutex_unlock (&gst_plugin_loading_mutex);
+  gst_object_unref (plugin);
+
+  return deferred;
+}
+
+/* Runs the init function of a prelinked static plugin, the features it
+ * registers take over the ones from the prelinked registry */
+static GstPlugin *
+gst_plugin_load_prelinked (GstPlugin * plugin)
+{
+  GstPluginDesc desc;
+
+  g_mutex_lock (&gst_plugin_loading_mutex);
+  /* another thread might have loaded it in the meantime */
+  if (!plugin->priv->prelinked)
+    goto done;
+
+  if (plugin->priv->prelinked_init == NULL)
+    goto not_registered;
+
+  GST_LOG ("initialising prelinked static plugin \"%s\"", plugin->desc.name);
+  desc = plugin->desc;
+  desc.plugin_init = plugin->priv->prelinked_init;
+  if (gst_plugin_register_func (plugin, &desc,
+          plugin->priv->prelinked_user_data) == NULL)
+    goto init_failed;
+
+  plugin->priv->prelinked = FALSE;
+
+done:
+  g_mutex_unlock (&gst_plugin_loading_mutex);
+  return gst_object_ref (plugin);
+
+  /* ERRORS */
+not_registered:
+  {
+    GST_WARNING ("prelinked static plugin \"%s\" was not registered",
+        plugin->desc.name);
+    g_mutex_unlock (&gst_plugin_loading_mutex);
+    return NULL;
+  }
+init_failed:
+  {
+    GST_WARNING ("prelinked static plugin \"%s\" failed to initialise",
+        plugin->desc.name);
+    g_mutex_unlock (&gst_plugin_loading_mutex);
+    return NULL;
+  }
+}
+
 static void
 gst_plugin_desc_copy (GstPluginDesc * dest, const GstPluginDesc * src)
 {
@@ -1095,7 +1185,8 @@ gst_plugin_is_loaded (GstPlugin * plugin)
 {
   g_return_val_if_fail (plugin != NULL, FALSE);
 
-  return (plugin->module != NULL || plugin->filename == NULL);
+  return (plugin->module != NULL || (plugin->filename == NULL &&
+          !plugin->priv->prelinked));
 }
 
 /**
@@ -1317,6 +1408,11 @@ gst_plugin_load_by_name (const gchar * name)
 
   GST_DEBUG ("looking up plugin %s in default registry", name);
   plugin = gst_registry_find_plugin (gst_registry_get (), name);
+  if (plugin && plugin->priv->prelinked) {
+    newplugin = gst_plugin_load_prelinked (plugin);
+    gst_object_unref (plugin);
+    return newplugin;
+  }
   if (plugin) {
     GST_DEBUG ("loading plugin %s from file %s", name, plugin->filename);
     newplugin = gst_plugin_load_file (plugin->filename, &error);
@@ -1363,6 +1459,9 @@ gst_plugin_load (GstPlugin * plugin)
     return gst_object_ref (plugin);
   }
 
+  if (plugin->priv->prelinked)
+    return gst_plugin_load_prelinked (plugin);
+
   if (!(newplugin = gst_plugin_load_file (plugin->filename, &error)))
     goto load_error;
 
@@ -83,6 +83,15 @@
 #endif
 #include <sys/time.h>
 #include <sys/socket.h>
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_EPOLL_CREATE1)
+#define HAVE_EPOLL 1
+#include <sys/epoll.h>
+#endif
+#if defined(HAVE_SYS_EVENTFD_H) && defined(HAVE_EVENTFD)
+#include <sys/eventfd.h>
+#else
+#undef HAVE_EVENTFD
+#endif
 #endif
 
 #ifdef G_OS_WIN32
@@ -124,9 +133,14 @@ typedef enum
   GST_POLL_MODE_PSELECT,
   GST_POLL_MODE_POLL,
   GST_POLL_MODE_PPOLL,
+  GST_POLL_MODE_EPOLL,
   GST_POLL_MODE_WINDOWS
 } GstPollMode;
 
+/* minimum number of fds before a non-timer set switches to epoll, below
+ * this ppoll() is just as fast and needs no extra fd */
+#define GST_POLL_EPOLL_MIN_FDS 8
+
 struct _GstPoll
 {
   GstPollMode mode;
@@ -142,6 +156,18 @@ struct _GstPoll
 #ifndef G_OS_WIN32
   GstPollFD control_read_fd;
   GstPollFD control_write_fd;
+#ifdef HAVE_EPOLL
+  /* epoll instance mirroring the events in fds, -1 when not (yet) used */
+  gint epoll_fd;
+  /* set when the kernel refused one of our fds, we then stay with ppoll */
+  gboolean epoll_failed;
+  /* fd number to index in active_fds, -1 for fds not in active_fds */
+  GArray *active_index;
+  /* indexes in active_fds that got revents from the last wait */
+  GArray *epoll_ready;
+  /* result buffer for epoll_wait(), only used by the waiting thread */
+  GArray *epoll_events;
+#endif
 #else
   GArray *active_fds_ignored;
   GArray *events;
@@ -172,13 +198,46 @@ static gboolean gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd);
 #define TEST_REBUILD(s)     (g_atomic_int_compare_and_exchange(&(s)->rebuild, 1, 0))
 #define MARK_REBUILD(s)     (g_atomic_int_set(&(s)->rebuild, 1))
 
+#ifdef HAVE_EPOLL
+#define USE_EPOLL(s)        ((s)->epoll_fd >= 0 && !(s)->epoll_failed)
+#endif
+
 #ifndef G_OS_WIN32
 
+/* with an eventfd both control fds are the same and every read or write
+ * transfers a 64 bit counter, otherwise it's a socketpair and a byte */
+#define IS_EVENTFD(s)       ((s)->control_read_fd.fd == (s)->control_write_fd.fd)
+
+static gboolean
+make_control_fds (gint control_fds[2])
+{
+#ifdef HAVE_EVENTFD
+  gint efd;
+
+  if ((efd = eventfd (0, EFD_CLOEXEC)) >= 0) {
+    control_fds[0] = control_fds[1] = efd;
+    return TRUE;
+  }
+  GST_INFO ("can't create eventfd: %s", g_strerror (errno));
+#endif
+
+  return socketpair (PF_UNIX, SOCK_STREAM, 0, control_fds) == 0;
+}
+
 static gboolean
 wake_event (GstPoll * set)
 {
+  static const guint64 one = 1;
+  const void *buf = "W";
+  ssize_t len = 1;
   ssize_t num_written;
-  while ((num_written = write (set->control_write_fd.fd, "W", 1)) != 1) {
+
+  if (IS_EVENTFD (set)) {
+    buf = &one;
+    len = sizeof (one);
+  }
+
+  while ((num_written = write (set->control_write_fd.fd, buf, len)) != len) {
     if (num_written == -1 && errno != EAGAIN && errno != EINTR) {
       g_critical ("%p: failed to wake event: %s", set, strerror (errno));
       return FALSE;
@@ -190,9 +249,12 @@ wake_event (GstPoll * set)
 static gboolean
 release_event (GstPoll * set)
 {
-  gchar buf[1] = { '\0' };
+  guint64 buf = 0;
+  ssize_t len = IS_EVENTFD (set) ? sizeof (buf) : 1;
   ssize_t num_read;
-  while ((num_read = read (set->control_read_fd.fd, buf, 1)) != 1) {
+
+  /* reading an eventfd clears its counter at once */
+  while ((num_read = read (set->control_read_fd.fd, &buf, len)) != len) {
     if (num_read == -1 && errno != EAGAIN && errno != EINTR) {
       g_critical ("%p: failed to release event: %s", set, strerror (errno));
       return FALSE;
@@ -300,33 +362,41 @@ raise_wakeup (GstPoll * set)
   return result;
 }
 
-static inline gboolean
-release_wakeup (GstPoll * set)
+/* releases up to @count pending wakeups with at most one RELEASE_EVENT().
+ * Returns the number of wakeups that were released, 0 with errno set to
+ * EWOULDBLOCK when nothing was pending. */
+static inline gint
+release_wakeups (GstPoll * set, gint count)
 {
-  gboolean result = FALSE;
+  gint released = 0;
 
   /* makes testing/modifying control_pending and RELEASE_EVENT() atomic. */
   g_mutex_lock (&set->lock);
 
   if (set->control_pending > 0) {
-    /* release, only if this was the last pending. */
-    if (set->control_pending == 1) {
+    released = MIN (count, set->control_pending);
+
+    /* release, only if this releases the last pending. */
+    if (released == set->control_pending) {
       GST_LOG ("%p: release", set);
-      result = release_event (set);
-    } else {
-      result = TRUE;
+      if (!release_event (set))
+        released = 0;
     }
 
-    if (result) {
-      set->control_pending--;
-    }
+    set->control_pending -= released;
   } else {
     errno = EWOULDBLOCK;
   }
 
   g_mutex_unlock (&set->lock);
 
-  return result;
+  return released;
+}
+
+static inline gboolean
+release_wakeup (GstPoll * set)
+{
+  return release_wakeups (set, 1) == 1;
 }
 
 static inline gint
@@ -440,6 +510,10 @@ choose_mode (GstPoll * set, GstClockTime timeout)
   GstPollMode mode;
 
   if (set->mode == GST_POLL_MODE_AUTO) {
+#ifdef HAVE_EPOLL
+    if (USE_EPOLL (set))
+      return GST_POLL_MODE_EPOLL;
+#endif
 #ifdef HAVE_PPOLL
     mode = GST_POLL_MODE_PPOLL;
 #elif defined(HAVE_POLL)
@@ -463,6 +537,237 @@ choose_mode (GstPoll * set, GstClockTime timeout)
   return mode;
 }
 
+#ifdef HAVE_EPOLL
+static guint32
+pollfd_events_to_epoll (gshort events)
+{
+  guint32 res = 0;
+
+  if (events & POLLIN)
+    res |= EPOLLIN;
+  if (events & POLLOUT)
+    res |= EPOLLOUT;
+  if (events & POLLPRI)
+    res |= EPOLLPRI;
+
+  return res;
+}
+
+static gshort
+epoll_events_to_pollfd (guint32 events)
+{
+  gshort res = 0;
+
+  if (events & EPOLLIN)
+    res |= POLLIN;
+  if (events & EPOLLOUT)
+    res |= POLLOUT;
+  if (events & EPOLLPRI)
+    res |= POLLPRI;
+  if (events & EPOLLERR)
+    res |= POLLERR;
+  if (events & EPOLLHUP)
+    res |= POLLHUP;
+
+  return res;
+}
+
+/* mirror a change of @pfd in the epoll instance, must be called with the
+ * lock. The kernel refuses some fds that poll() accepts, like regular files
+ * or invalid fds, when that happens we give up on epoll for this set and go
+ * back to the generic implementation. */
+static void
+gst_poll_epoll_ctl (GstPoll * set, gint op, const struct pollfd *pfd)
+{
+  struct epoll_event ev;
+  gint res;
+
+  if (!USE_EPOLL (set))
+    return;
+
+  memset (&ev, 0, sizeof (ev));
+  ev.events = pollfd_events_to_epoll (pfd->events);
+  ev.data.fd = pfd->fd;
+
+  res = epoll_ctl (set->epoll_fd, op, pfd->fd, &ev);
+  if (res < 0 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+    /* the fd was closed and its number reused without removing it from the
+     * set, poll() would simply watch the new one */
+    res = epoll_ctl (set->epoll_fd, EPOLL_CTL_ADD, pfd->fd, &ev);
+  }
+  /* a closed fd is removed from the epoll set automatically */
+  if (res < 0 && op != EPOLL_CTL_DEL) {
+    GST_INFO ("%p: epoll_ctl (%d) failed for fd %d: %s, not using epoll", set,
+        op, pfd->fd, g_strerror (errno));
+    set->epoll_failed = TRUE;
+    MARK_REBUILD (set);
+  }
+}
+
+/* called with the lock */
+static void
+gst_poll_epoll_setup (GstPoll * set)
+{
+  guint i;
+
+  set->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+  if (set->epoll_fd < 0) {
+    GST_INFO ("%p: can't create epoll fd: %s", set, g_strerror (errno));
+    set->epoll_failed = TRUE;
+    return;
+  }
+
+  GST_DEBUG ("%p: switching to epoll with %u fds", set, set->fds->len);
+  for (i = 0; i < set->fds->len && USE_EPOLL (set); i++)
+    gst_poll_epoll_ctl (set, EPOLL_CTL_ADD, &g_array_index (set->fds,
+            struct pollfd, i));
+}
+
+/* called with the lock after active_fds was rebuilt */
+static void
+gst_poll_epoll_rebuild_index (GstPoll * set)
+{
+  gint max_fd = -1;
+  guint i;
+
+  for (i = 0; i < set->active_fds->len; i++)
+    max_fd = MAX (max_fd, g_array_index (set->active_fds, struct pollfd, i).fd);
+
+  g_array_set_size (set->active_index, max_fd + 1);
+  for (i = 0; i < set->active_index->len; i++)
+    g_array_index (set->active_index, gint, i) = -1;
+  for (i = 0; i < set->active_fds->len; i++)
+    g_array_index (set->active_index, gint,
+        g_array_index (set->active_fds, struct pollfd, i).fd) = i;
+
+  /* the copy from fds cleared all revents */
+  g_array_set_size (set->epoll_ready, 0);
+}
+#endif
+
+#ifndef G_OS_WIN32
+/* copy the fds that were changed since the last wait, called with the lock */
+static void
+gst_poll_rebuild_active_fds (GstPoll * set)
+{
+#ifdef HAVE_EPOLL
+  if (set->epoll_fd < 0 && !set->epoll_failed && !set->timer &&
+      set->mode == GST_POLL_MODE_AUTO &&
+      set->fds->len >= GST_POLL_EPOLL_MIN_FDS)
+    gst_poll_epoll_setup (set);
+#endif
+
+  g_array_set_size (set->active_fds, set->fds->len);
+  memcpy (set->active_fds->data, set->fds->data,
+      set->fds->len * sizeof (struct pollfd));
+
+#ifdef HAVE_EPOLL
+  if (USE_EPOLL (set))
+    gst_poll_epoll_rebuild_index (set);
+#endif
+}
+
+/* called after the events of the fd at @idx changed, with the lock */
+static void
+gst_poll_update_events (GstPoll * set, gint idx)
+{
+#ifdef HAVE_EPOLL
+  /* the epoll set is updated in place, there is no need to copy all fds
+   * again before the next wait */
+  if (USE_EPOLL (set)) {
+    gst_poll_epoll_ctl (set, EPOLL_CTL_MOD, &g_array_index (set->fds,
+            struct pollfd, idx));
+    return;
+  }
+#endif
+  MARK_REBUILD (set);
+}
+#endif
+
+#ifdef HAVE_EPOLL
+static gint
+gst_poll_epoll_wait (GstPoll * set, GstClockTime timeout)
+{
+  struct epoll_event *events;
+  struct pollfd *pfd;
+  gint maxevents;
+  gint res, idx, fd, n_ready;
+  guint i;
+
+  g_mutex_lock (&set->lock);
+  g_array_set_size (set->epoll_events, MAX (set->fds->len, 1));
+  events = (struct epoll_event *) set->epoll_events->data;
+  maxevents = set->epoll_events->len;
+  g_mutex_unlock (&set->lock);
+
+  if (timeout == GST_CLOCK_TIME_NONE) {
+    res = epoll_wait (set->epoll_fd, events, maxevents, -1);
+  } else if (timeout % GST_MSECOND == 0 && timeout / GST_MSECOND <= G_MAXINT) {
+    res = epoll_wait (set->epoll_fd, events, maxevents,
+        (gint) GST_TIME_AS_MSECONDS (timeout));
+  } else {
+#ifdef HAVE_PPOLL
+    /* epoll_wait() only has millisecond precision, wait for the epoll fd
+     * itself to become readable for other timeouts */
+    struct pollfd pfd;
+    struct timespec ts;
+
+    pfd.fd = set->epoll_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    GST_TIME_TO_TIMESPEC (timeout, ts);
+
+    res = ppoll (&pfd, 1, &ts, NULL);
+    if (res > 0)
+      res = epoll_wait (set->epoll_fd, events, maxevents, 0);
+#else
+    /* round up, we must not return before the timeout */
+    res = epoll_wait (set->epoll_fd, events, maxevents,
+        (gint) MIN (GST_TIME_AS_MSECONDS (timeout + GST_MSECOND - 1),
+            G_MAXINT));
+#endif
+  }
+
+  if (res < 0)
+    return res;
+
+  g_mutex_lock (&set->lock);
+
+  /* forget the results of the previous wait */
+  for (i = 0; i < set->epoll_ready->len; i++) {
+    idx = g_array_index (set->epoll_ready, gint, i);
+    g_array_index (set->active_fds, struct pollfd, idx).revents = 0;
+  }
+  g_array_set_size (set->epoll_ready, 0);
+
+  /* fds added while we were waiting can already have events */
+  if (TEST_REBUILD (set))
+    gst_poll_rebuild_active_fds (set);
+
+  n_ready = 0;
+  for (i = 0; i < (guint) res; i++) {
+    fd = events[i].data.fd;
+    if (fd < 0 || (guint) fd >= set->active_index->len)
+      continue;
+    /* removed while we were waiting */
+    idx = g_array_index (set->active_index, gint, fd);
+    if (idx < 0 || (guint) idx >= set->active_fds->len)
+      continue;
+    pfd = &g_array_index (set->active_fds, struct pollfd, idx);
+    if (pfd->fd != fd)
+      continue;
+
+    pfd->revents = epoll_events_to_pollfd (events[i].events);
+    g_array_append_val (set->epoll_ready, idx);
+    n_ready++;
+  }
+
+  g_mutex_unlock (&set->lock);
+
+  return n_ready;
+}
+#endif
+
 #ifndef G_OS_WIN32
 static gint
 pollfd_to_fd_set (GstPoll * set, fd_set * readfds, fd_set * writefds,
@@ -686,10 +991,16 @@ gst_poll_new (gboolean controllable)
   nset->active_fds = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
   nset->control_read_fd.fd = -1;
   nset->control_write_fd.fd = -1;
+#ifdef HAVE_EPOLL
+  nset->epoll_fd = -1;
+  nset->active_index = g_array_new (FALSE, FALSE, sizeof (gint));
+  nset->epoll_ready = g_array_new (FALSE, FALSE, sizeof (gint));
+  nset->epoll_events = g_array_new (FALSE, FALSE, sizeof (struct epoll_event));
+#endif
   {
     gint control_sock[2];
 
-    if (socketpair (PF_UNIX, SOCK_STREAM, 0, control_sock) < 0)
+    if (!make_control_fds (control_sock))
       goto no_socket_pair;
 
     nset->control_read_fd.fd = control_sock[0];
@@ -772,10 +1083,17 @@ gst_poll_free (GstPoll * set)
   GST_DEBUG ("%p: freeing", set);
 
 #ifndef G_OS_WIN32
-  if (set->control_write_fd.fd >= 0)
+  if (set->control_write_fd.fd >= 0 && !IS_EVENTFD (set))
     close (set->control_write_fd.fd);
   if (set->control_read_fd.fd >= 0)
     close (set->control_read_fd.fd);
+#ifdef HAVE_EPOLL
+  if (set->epoll_fd >= 0)
+    close (set->epoll_fd);
+  g_array_free (set->epoll_events, TRUE);
+  g_array_free (set->epoll_ready, TRUE);
+  g_array_free (set->active_index, TRUE);
+#endif
 #else
   CloseHandle (set->wakeup_event);
 
@@ -859,6 +1177,9 @@ gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd)
     g_array_append_val (set->fds, nfd);
 
     fd->idx = set->fds->len - 1;
+#ifdef HAVE_EPOLL
+    gst_poll_epoll_ctl (set, EPOLL_CTL_ADD, &nfd);
+#endif
 #else
     WinsockFd wfd;
     HANDLE event;
@@ -938,6 +1259,9 @@ gst_poll_remove_fd (GstPoll * set, GstPollFD * fd)
 #ifdef G_OS_WIN32
     gst_poll_free_winsock_event (set, idx);
     g_array_remove_index_fast (set->events, idx);
+#elif defined(HAVE_EPOLL)
+    gst_poll_epoll_ctl (set, EPOLL_CTL_DEL, &g_array_index (set->fds,
+            struct pollfd, idx));
 #endif
 
     /* remove the fd at index, we use _remove_index_fast, which copies the last
@@ -992,11 +1316,12 @@ gst_poll_fd_ctl_write (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLOUT;
 
     GST_LOG ("%p: pfd->events now %d (POLLOUT:%d)", set, pfd->events, POLLOUT);
+    gst_poll_update_events (set, idx);
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_WRITE | FD_CONNECT,
         active);
-#endif
     MARK_REBUILD (set);
+#endif
   } else {
     GST_WARNING ("%p: couldn't find fd !", set);
   }
@@ -1024,10 +1349,11 @@ gst_poll_fd_ctl_read_unlocked (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events |= POLLIN;
     else
       pfd->events &= ~POLLIN;
+    gst_poll_update_events (set, idx);
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_READ | FD_ACCEPT, active);
-#endif
     MARK_REBUILD (set);
+#endif
   } else {
     GST_WARNING ("%p: couldn't find fd !", set);
   }
@@ -1106,7 +1432,7 @@ gst_poll_fd_ctl_pri (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLPRI;
 
     GST_LOG ("%p: pfd->events now %d (POLLPRI:%d)", set, pfd->events, POLLOUT);
-    MARK_REBUILD (set);
+    gst_poll_update_events (set, idx);
   } else {
     GST_WARNING ("%p: couldn't find fd !", set);
   }
@@ -1432,14 +1758,10 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
     res = -1;
     restarting = FALSE;
 
-    mode = choose_mode (set, timeout);
-
     if (TEST_REBUILD (set)) {
       g_mutex_lock (&set->lock);
 #ifndef G_OS_WIN32
-      g_array_set_size (set->active_fds, set->fds->len);
-      memcpy (set->active_fds->data, set->fds->data,
-          set->fds->len * sizeof (struct pollfd));
+      gst_poll_rebuild_active_fds (set);
 #else
       if (!gst_poll_prepare_winsock_active_sets (set))
         goto winsock_error;
@@ -1447,6 +1769,8 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
       g_mutex_unlock (&set->lock);
     }
 
+    mode = choose_mode (set, timeout);
+
     switch (mode) {
       case GST_POLL_MODE_AUTO:
         g_assert_not_reached ();
@@ -1470,6 +1794,16 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
 #else
         g_assert_not_reached ();
         errno = ENOSYS;
+#endif
+        break;
+      }
+      case GST_POLL_MODE_EPOLL:
+      {
+#ifdef HAVE_EPOLL
+        res = gst_poll_epoll_wait (set, timeout);
+#else
+        g_assert_not_reached ();
+        errno = ENOSYS;
 #endif
         break;
       }
@@ -1787,3 +2121,20 @@ gst_poll_read_control (GstPoll * set)
 
   return res;
 }
+
+/* Read @count bytes from the control socket of the timer @set at once, the
+ * underlying fd is only read when the last pending byte is released. Used
+ * by #GstBus to acknowledge a batch of messages with a single read.
+ *
+ * Returns the number of bytes released, which can be less than @count if
+ * not all writes have happened yet. 0 is returned when nothing could be
+ * released, errno is then set like for gst_poll_read_control(). */
+guint
+priv_gst_poll_read_control_many (GstPoll * set, guint count)
+{
+  g_return_val_if_fail (set != NULL, 0);
+  g_return_val_if_fail (set->timer, 0);
+  g_return_val_if_fail (count > 0, 0);
+
+  return release_wakeups (set, MIN (count, G_MAXINT));
+}
@@ -78,6 +78,18 @@
  * checked to make sure the information is minimally valid. If not, the entry is
  * simply dropped.
  *
+ * ## Prelinked static plugins
+ *
+ * Applications that link their plugins statically can avoid initialising
+ * all of them at startup. At build time, the application is run once with
+ * all its plugins registered and saves them with
+ * gst_registry_save_prelinked(). The resulting file is compiled into the
+ * application as constant data, for example with `xxd -i`. At runtime, that
+ * data is passed to gst_registry_add_prelinked() after gst_init() and before
+ * the plugins are registered with gst_plugin_register_static(). Their
+ * features are then available right away and a plugin's init function only
+ * runs when one of its features is loaded.
+ *
  * ## Implementation notes:
  *
  * The "cache" and "registry" are different concepts and can represent
@@ -85,6 +97,12 @@
  * stored in the default registry, and plugins not relevant to the current
  * process are marked with the %GST_PLUGIN_FLAG_CACHED bit. These plugins are
  * removed at the end of initialization.
+ *
+ * When the cache file can be mapped, only its plugins are read at init time.
+ * The features stay in the mapped file and an index at its end maps their
+ * names to their offsets. A feature is created when it is looked up by name,
+ * and all remaining ones when the feature list is used, for example by
+ * gst_registry_get_feature_list() or when the cache is written.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -101,6 +119,7 @@
 #include <errno.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 /* For g_stat () */
 #include <glib/gstdio.h>
@@ -111,6 +130,7 @@
 #include "gstdeviceproviderfactory.h"
 
 #include "gstpluginloader.h"
+#include "gstregistrychunks.h"
 
 #include "gst-i18n-lib.h"
 
@@ -140,6 +160,8 @@ struct _GstRegistryPrivate
   GHashTable *feature_hash;
   /* hash to speedup _lookup */
   GHashTable *basename_hash;
+  /* directory path -> GstRegistryDirFingerprint */
+  GHashTable *dir_fingerprints;
 
   /* updated whenever the feature list changes */
   guint32 cookie;
@@ -150,6 +172,17 @@ struct _GstRegistryPrivate
   guint32 tfl_cookie;
   GList *device_provider_factory_list;
   guint32 dmfl_cookie;
+
+  /* features of the mapped registry cache, sorted by name. Pending ones are
+   * created on lookup, or all at once when the feature list is used.
+   * Changing the array needs both locks, the entries are protected by the
+   * object lock. */
+  GstRegistryLazyFeature *lazy_features;
+  guint n_lazy_features;
+  guint n_lazy_pending;
+  GBytes *lazy_backing;
+  /* serializes creating the pending features */
+  GMutex lazy_lock;
 };
 
 /* the one instance of the default registry and the mutex protecting the
@@ -240,6 +273,9 @@ gst_registry_init (GstRegistry * registry)
   registry->priv = gst_registry_get_instance_private (registry);
   registry->priv->feature_hash = g_hash_table_new (g_str_hash, g_str_equal);
   registry->priv->basename_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  registry->priv->dir_fingerprints = g_hash_table_new_full (g_str_hash,
+      g_str_equal, g_free, g_free);
+  g_mutex_init (&registry->priv->lazy_lock);
 }
 
 static void
@@ -287,6 +323,15 @@ gst_registry_finalize (GObject * object)
   registry->priv->feature_hash = NULL;
   g_hash_table_destroy (registry->priv->basename_hash);
   registry->priv->basename_hash = NULL;
+  g_hash_table_destroy (registry->priv->dir_fingerprints);
+  registry->priv->dir_fingerprints = NULL;
+
+  g_free (registry->priv->lazy_features);
+  registry->priv->lazy_features = NULL;
+  if (registry->priv->lazy_backing)
+    g_bytes_unref (registry->priv->lazy_backing);
+  registry->priv->lazy_backing = NULL;
+  g_mutex_clear (&registry->priv->lazy_lock);
 
   if (registry->priv->element_factory_list) {
     GST_DEBUG_OBJECT (registry, "Cleaning up cached element factory list");
@@ -307,6 +352,170 @@ gst_registry_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* must be called with the object lock or the lazy lock */
+static GstRegistryLazyFeature *
+gst_registry_find_lazy_feature (GstRegistry * registry, const gchar * name)
+{
+  GstRegistryPrivate *priv = registry->priv;
+  guint lo = 0, hi = priv->n_lazy_features;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    gint cmp = strcmp (name, priv->lazy_features[mid].name);
+
+    if (cmp == 0)
+      return &priv->lazy_features[mid];
+    if (cmp < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return NULL;
+}
+
+/* Creates the feature of a pending @entry and adds it to the registry. It
+ * already was part of the registry, so there is no feature-added signal and
+ * the cookie stays the same. Must be called with the lazy lock. */
+static void
+gst_registry_load_lazy_feature (GstRegistry * registry,
+    GstRegistryLazyFeature * entry)
+{
+  GstRegistryPrivate *priv = registry->priv;
+  GstPluginFeature *feature;
+  GstPlugin *plugin;
+  gchar *in, *end;
+
+  GST_OBJECT_LOCK (registry);
+  if (!entry->pending) {
+    GST_OBJECT_UNLOCK (registry);
+    return;
+  }
+  plugin = entry->plugin ? gst_object_ref (entry->plugin) : NULL;
+  GST_OBJECT_UNLOCK (registry);
+
+  in = entry->data;
+  end = (gchar *) g_bytes_get_data (priv->lazy_backing, NULL) +
+      g_bytes_get_size (priv->lazy_backing);
+  feature = _priv_gst_registry_chunks_load_feature (&in, end, plugin,
+      entry->plugin_name, priv->lazy_backing);
+
+  GST_OBJECT_LOCK (registry);
+  /* the plugin could have been removed while reading */
+  if (entry->pending) {
+    entry->pending = FALSE;
+    --priv->n_lazy_pending;
+
+    if (feature == NULL) {
+      GST_WARNING_OBJECT (registry, "could not read feature %s from the "
+          "registry cache", entry->name);
+    } else if (gst_registry_lookup_feature_locked (registry, entry->name)) {
+      GST_DEBUG_OBJECT (registry, "keeping existing feature %s", entry->name);
+    } else {
+      GST_LOG_OBJECT (registry, "created feature %p (%s)", feature,
+          entry->name);
+      priv->features = g_list_prepend (priv->features, feature);
+      g_hash_table_replace (priv->feature_hash, GST_OBJECT_NAME (feature),
+          feature);
+      gst_object_set_parent (GST_OBJECT_CAST (feature),
+          GST_OBJECT_CAST (registry));
+      feature = NULL;
+    }
+  }
+  GST_OBJECT_UNLOCK (registry);
+
+  if (feature)
+    gst_object_unref (feature);
+  if (plugin)
+    gst_object_unref (plugin);
+}
+
+/* must be called with the lazy lock */
+static void
+gst_registry_load_lazy_features_locked (GstRegistry * registry)
+{
+  guint i;
+
+  for (i = 0; i < registry->priv->n_lazy_features; i++)
+    gst_registry_load_lazy_feature (registry, &registry->priv->lazy_features[i]);
+}
+
+/* creates all pending features, before the feature list is used */
+static void
+gst_registry_load_lazy_features (GstRegistry * registry)
+{
+  guint n_pending;
+
+  GST_OBJECT_LOCK (registry);
+  n_pending = registry->priv->n_lazy_pending;
+  GST_OBJECT_UNLOCK (registry);
+
+  if (G_LIKELY (n_pending == 0))
+    return;
+
+  GST_DEBUG_OBJECT (registry, "creating %u features from the registry cache",
+      n_pending);
+
+  g_mutex_lock (&registry->priv->lazy_lock);
+  gst_registry_load_lazy_features_locked (registry);
+  g_mutex_unlock (&registry->priv->lazy_lock);
+}
+
+/* must be called with the object lock */
+static void
+gst_registry_drop_lazy_feature_unlocked (GstRegistry * registry,
+    GstRegistryLazyFeature * entry)
+{
+  if (entry->pending) {
+    GST_LOG_OBJECT (registry, "dropping pending feature %s", entry->name);
+    entry->pending = FALSE;
+    --registry->priv->n_lazy_pending;
+  }
+}
+
+void
+_priv_gst_registry_add_lazy_features (GstRegistry * registry,
+    GBytes * backing, GstRegistryLazyFeature * features, guint n_features)
+{
+  GstRegistryPrivate *priv = registry->priv;
+  GstRegistryLazyFeature *old_features;
+  GBytes *old_backing;
+  guint i;
+
+  g_mutex_lock (&priv->lazy_lock);
+  /* the pending features of an earlier cache point into its data */
+  gst_registry_load_lazy_features_locked (registry);
+
+  GST_OBJECT_LOCK (registry);
+  old_features = priv->lazy_features;
+  old_backing = priv->lazy_backing;
+  priv->lazy_features = features;
+  priv->n_lazy_features = n_features;
+  priv->n_lazy_pending = n_features;
+  priv->lazy_backing = g_bytes_ref (backing);
+
+  /* like when the features are read right away, the plugins of the cache
+   * replace the ones that were registered already */
+  for (i = 0; i < n_features; i++) {
+    GstPluginFeature *existing;
+
+    existing = gst_registry_lookup_feature_locked (registry, features[i].name);
+    if (G_UNLIKELY (existing)) {
+      GST_DEBUG_OBJECT (registry, "replacing existing feature %p (%s)",
+          existing, features[i].name);
+      priv->features = g_list_remove (priv->features, existing);
+      g_hash_table_remove (priv->feature_hash, features[i].name);
+      gst_object_unparent (GST_OBJECT_CAST (existing));
+      priv->cookie++;
+    }
+  }
+  GST_OBJECT_UNLOCK (registry);
+  g_mutex_unlock (&priv->lazy_lock);
+
+  g_free (old_features);
+  if (old_backing)
+    g_bytes_unref (old_backing);
+}
+
 /**
  * gst_registry_get:
  *
@@ -421,6 +630,7 @@ gboolean
 gst_registry_add_plugin (GstRegistry * registry, GstPlugin * plugin)
 {
   GstPlugin *existing_plugin;
+  guint i;
 
   g_return_val_if_fail (GST_IS_REGISTRY (registry), FALSE);
   g_return_val_if_fail (GST_IS_PLUGIN (plugin), FALSE);
@@ -454,6 +664,12 @@ gst_registry_add_plugin (GstRegistry * registry, GstPlugin * plugin)
       if (G_LIKELY (existing_plugin->basename))
         g_hash_table_remove (registry->priv->basename_hash,
             existing_plugin->basename);
+      /* like the features that were created already, the pending ones keep
+       * their plugin name but lose the plugin */
+      for (i = 0; i < registry->priv->n_lazy_features; i++) {
+        if (registry->priv->lazy_features[i].plugin == existing_plugin)
+          registry->priv->lazy_features[i].plugin = NULL;
+      }
       gst_object_unref (existing_plugin);
     }
   }
@@ -483,11 +699,18 @@ gst_registry_remove_features_for_plugin_unlocked (GstRegistry * registry,
     GstPlugin * plugin)
 {
   GList *f;
+  guint i;
 
   g_return_if_fail (GST_IS_REGISTRY (registry));
   g_return_if_fail (GST_IS_PLUGIN (plugin));
 
   /* Remove all features for this plugin */
+  for (i = 0; i < registry->priv->n_lazy_features; i++) {
+    if (registry->priv->lazy_features[i].plugin == plugin)
+      gst_registry_drop_lazy_feature_unlocked (registry,
+          &registry->priv->lazy_features[i]);
+  }
+
   f = registry->priv->features;
   while (f != NULL) {
     GList *next = g_list_next (f);
@@ -555,6 +778,7 @@ gboolean
 gst_registry_add_feature (GstRegistry * registry, GstPluginFeature * feature)
 {
   GstPluginFeature *existing_feature;
+  GstRegistryLazyFeature *lazy_feature;
 
   g_return_val_if_fail (GST_IS_REGISTRY (registry), FALSE);
   g_return_val_if_fail (GST_IS_PLUGIN_FEATURE (feature), FALSE);
@@ -562,6 +786,13 @@ gst_registry_add_feature (GstRegistry * registry, GstPluginFeature * feature)
   g_return_val_if_fail (feature->plugin_name != NULL, FALSE);
 
   GST_OBJECT_LOCK (registry);
+  /* a feature of the registry cache that was not created yet is replaced
+   * too */
+  lazy_feature = gst_registry_find_lazy_feature (registry,
+      GST_OBJECT_NAME (feature));
+  if (G_UNLIKELY (lazy_feature))
+    gst_registry_drop_lazy_feature_unlocked (registry, lazy_feature);
+
   existing_feature = gst_registry_lookup_feature_locked (registry,
       GST_OBJECT_NAME (feature));
   if (G_UNLIKELY (existing_feature)) {
@@ -746,6 +977,8 @@ gst_registry_get_element_factory_list (GstRegistry * registry)
 {
   GList *list;
 
+  gst_registry_load_lazy_features (registry);
+
   GST_OBJECT_LOCK (registry);
 
   gst_registry_get_feature_list_or_create (registry,
@@ -765,6 +998,8 @@ gst_registry_get_typefind_factory_list (GstRegistry * registry)
 {
   GList *list;
 
+  gst_registry_load_lazy_features (registry);
+
   GST_OBJECT_LOCK (registry);
 
   if (G_UNLIKELY (gst_registry_get_feature_list_or_create (registry,
@@ -788,6 +1023,8 @@ gst_registry_get_device_provider_factory_list (GstRegistry * registry)
 {
   GList *list;
 
+  gst_registry_load_lazy_features (registry);
+
   GST_OBJECT_LOCK (registry);
 
   gst_registry_get_feature_list_or_create (registry,
@@ -831,6 +1068,8 @@ gst_registry_feature_filter (GstRegistry * registry,
 
   g_return_val_if_fail (GST_IS_REGISTRY (registry), NULL);
 
+  gst_registry_load_lazy_features (registry);
+
   GST_OBJECT_LOCK (registry);
   n_features = g_hash_table_size (registry->priv->feature_hash);
   features = g_newa (GstPluginFeature *, n_features + 1);
@@ -1015,6 +1254,8 @@ GstPluginFeature *
 gst_registry_lookup_feature (GstRegistry * registry, const char *name)
 {
   GstPluginFeature *feature;
+  GstRegistryLazyFeature *lazy_feature;
+  guint n_pending;
 
   g_return_val_if_fail (GST_IS_REGISTRY (registry), NULL);
   g_return_val_if_fail (name != NULL, NULL);
@@ -1023,8 +1264,27 @@ gst_registry_lookup_feature (GstRegistry * registry, const char *name)
   feature = gst_registry_lookup_feature_locked (registry, name);
   if (feature)
     gst_object_ref (feature);
+  n_pending = registry->priv->n_lazy_pending;
   GST_OBJECT_UNLOCK (registry);
 
+  if (feature || G_LIKELY (n_pending == 0))
+    return feature;
+
+  /* create it from the registry cache */
+  g_mutex_lock (&registry->priv->lazy_lock);
+  lazy_feature = gst_registry_find_lazy_feature (registry, name);
+  if (lazy_feature)
+    gst_registry_load_lazy_feature (registry, lazy_feature);
+  g_mutex_unlock (&registry->priv->lazy_lock);
+
+  if (lazy_feature) {
+    GST_OBJECT_LOCK (registry);
+    feature = gst_registry_lookup_feature_locked (registry, name);
+    if (feature)
+      gst_object_ref (feature);
+    GST_OBJECT_UNLOCK (registry);
+  }
+
   return feature;
 }
 
@@ -1048,6 +1308,14 @@ gst_registry_lookup_bn (GstRegistry * registry, const char *basename)
   return plugin;
 }
 
+/* Fingerprints of the scanned directories, read from and written to the
+ * registry cache. Only used while scanning, from a single thread. */
+GHashTable *
+_priv_gst_registry_get_dir_fingerprints (GstRegistry * registry)
+{
+  return registry->priv->dir_fingerprints;
+}
+
 /**
  * gst_registry_lookup:
  * @registry: the registry to look up in
@@ -1086,18 +1354,61 @@ typedef enum
   REGISTRY_SCAN_HELPER_RUNNING
 } GstRegistryScanHelperState;
 
+/* Upper bound for the number of plugin scanner helpers loading plugins in
+ * parallel, the default is one per CPU core up to this number */
+#define MAX_SCAN_HELPERS 8
+
+/* Directories with at least this many entries are stat()ed in chunks on a
+ * thread pool, which mostly helps when the inodes are not cached yet */
+#define PARALLEL_STAT_MIN_ENTRIES 32
+#define PARALLEL_STAT_CHUNK_SIZE 16
+
 typedef struct
 {
   GstRegistry *registry;
   GstRegistryScanHelperState helper_state;
-  GstPluginLoader *helper;
+  GstPluginLoader *helpers[MAX_SCAN_HELPERS];
+  /* helpers that did not fail, the failed ones are dropped from helpers */
+  guint n_helpers;
+  guint next_helper;
+  guint n_started;
+  /* some plugins were loaded in-process after helpers failed */
+  gboolean fell_back;
+  /* files sent to a helper or loaded in-process, in scan order */
+  GPtrArray *scanned;
+  GThreadPool *stat_pool;
+  gboolean stat_pool_failed;
+  /* trust the cache for plugins in directories with the same fingerprint */
+  gboolean check_dirs;
+  time_t scan_time;
   gboolean changed;
 } GstRegistryScanContext;
 
+static guint
+get_n_scan_helpers (void)
+{
+  const gchar *env;
+  guint n;
+
+#ifndef GST_DISABLE_REGISTRY
+  /* every plugin gets its own helper, they can't be shared */
+  if (!__registry_reuse_plugin_scanner)
+    return 1;
+#endif
+
+  if ((env = g_getenv ("GST_REGISTRY_SCANNERS")))
+    n = (guint) g_ascii_strtoull (env, NULL, 10);
+  else
+    n = g_get_num_processors ();
+
+  return CLAMP (n, 1, MAX_SCAN_HELPERS);
+}
+
 static void
 init_scan_context (GstRegistryScanContext * context, GstRegistry * registry)
 {
   gboolean do_fork;
+  const gchar *validation_env;
 
   context->registry = registry;
 
@@ -1118,17 +1429,164 @@ init_scan_context (GstRegistryScanContext * context, GstRegistry * registry)
   else
     context->helper_state = REGISTRY_SCAN_HELPER_DISABLED;
 
-  context->helper = NULL;
+  memset (context->helpers, 0, sizeof (context->helpers));
+  context->n_helpers = get_n_scan_helpers ();
+  context->next_helper = 0;
+  context->n_started = 0;
+  context->fell_back = FALSE;
+  context->scanned = g_ptr_array_new_with_free_func (g_free);
+  context->stat_pool = NULL;
+  context->stat_pool_failed = FALSE;
+  context->check_dirs = FALSE;
+  if ((validation_env = g_getenv ("GST_REGISTRY_VALIDATION")))
+    context->check_dirs = (strcmp (validation_env, "dirs") == 0);
+  context->scan_time = time (NULL);
   context->changed = FALSE;
 }
 
+static gint
+compare_scan_order (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  GHashTable *order = user_data;
+  guint order_a, order_b;
+
+  order_a = GPOINTER_TO_UINT (g_hash_table_lookup (order, a));
+  order_b = GPOINTER_TO_UINT (g_hash_table_lookup (order, b));
+
+  /* plugins that were not scanned (0) stay behind the scanned ones */
+  if (order_a == 0 || order_b == 0)
+    return (order_a == 0) - (order_b == 0);
+
+  /* later scanned plugins were prepended last and go first */
+  return (order_a < order_b) - (order_a > order_b);
+}
+
+static gint
+compare_feature_scan_order (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  return compare_scan_order (GST_PLUGIN_FEATURE_CAST (a)->plugin,
+      GST_PLUGIN_FEATURE_CAST (b)->plugin, user_data);
+}
+
+/* With several helpers, plugins (and their features) are added to the
+ * registry in whatever order the helpers reply. Put them back in the order
+ * a single helper would have added them in, so the registry and the cache
+ * written from it don't depend on timing. */
+static void
+gst_registry_sort_scanned_plugins (GstRegistry * registry, GPtrArray * scanned)
+{
+  GstRegistryPrivate *priv = registry->priv;
+  GHashTable *scan_order, *order;
+  GList *l;
+  guint i;
+
+  scan_order = g_hash_table_new (g_str_hash, g_str_equal);
+  for (i = 0; i < scanned->len; i++)
+    g_hash_table_insert (scan_order, g_ptr_array_index (scanned, i),
+        GUINT_TO_POINTER (i + 1));
+
+  order = g_hash_table_new (NULL, NULL);
+
+  GST_OBJECT_LOCK (registry);
+  for (l = priv->plugins; l != NULL; l = l->next) {
+    GstPlugin *plugin = l->data;
+    gpointer pos;
+
+    if (plugin->filename &&
+        (pos = g_hash_table_lookup (scan_order, plugin->filename)))
+      g_hash_table_insert (order, plugin, pos);
+  }
+  /* g_list_sort() is stable, everything else keeps its order */
+  priv->plugins = g_list_sort_with_data (priv->plugins, compare_scan_order,
+      order);
+  priv->features = g_list_sort_with_data (priv->features,
+      compare_feature_scan_order, order);
+  priv->cookie++;
+  GST_OBJECT_UNLOCK (registry);
+
+  g_hash_table_destroy (order);
+  g_hash_table_destroy (scan_order);
+}
+
 static void
 clear_scan_context (GstRegistryScanContext * context)
 {
-  if (context->helper) {
-    context->changed |= _priv_gst_plugin_loader_funcs.destroy (context->helper);
-    context->helper = NULL;
+  guint i;
+
+  for (i = 0; i < context->n_helpers; i++) {
+    if (context->helpers[i]) {
+      context->changed |=
+          _priv_gst_plugin_loader_funcs.destroy (context->helpers[i]);
+      context->helpers[i] = NULL;
+    }
+  }
+
+  /* in-process loading also races with the replies of the helpers */
+  if (context->n_started > 1 || (context->n_started && context->fell_back))
+    gst_registry_sort_scanned_plugins (context->registry, context->scanned);
+  context->n_helpers = get_n_scan_helpers ();
+  context->n_started = 0;
+  context->next_helper = 0;
+  context->fell_back = FALSE;
+  g_ptr_array_set_size (context->scanned, 0);
+}
+
+static void
+free_scan_context (GstRegistryScanContext * context)
+{
+  clear_scan_context (context);
+
+  g_ptr_array_unref (context->scanned);
+  if (context->stat_pool)
+    g_thread_pool_free (context->stat_pool, FALSE, TRUE);
+}
+
+/* Takes the helper at @index out of the rotation, the others keep going */
+static void
+drop_scan_helper (GstRegistryScanContext * context, guint index)
+{
+  GstPluginLoader *helper = context->helpers[index];
+
+  if (helper)
+    context->changed |= _priv_gst_plugin_loader_funcs.destroy (helper);
+
+  context->n_helpers--;
+  context->helpers[index] = context->helpers[context->n_helpers];
+  context->helpers[context->n_helpers] = NULL;
+}
+
+/* Returns the helper for the next plugin and its index, the plugins are
+ * spread round-robin over the helpers, which are only started when they get
+ * their first plugin. Helpers that fail to start are dropped, %NULL is
+ * returned when none are left. */
+static GstPluginLoader *
+get_scan_helper (GstRegistryScanContext * context, const gchar * filename,
+    guint * index)
+{
+  while (context->n_helpers > 0) {
+    GstPluginLoader **helper;
+
+    *index = context->next_helper % context->n_helpers;
+    helper = &context->helpers[*index];
+
+    if (*helper == NULL) {
+      GST_DEBUG ("Starting plugin scanner for file %s", filename);
+      *helper = _priv_gst_plugin_loader_funcs.create (context->registry);
+      if (*helper == NULL) {
+        GST_WARNING ("Failed starting plugin scanner, %u left",
+            context->n_helpers - 1);
+        drop_scan_helper (context, *index);
+        continue;
+      }
+      context->n_started++;
+    }
+
+    context->next_helper = (*index + 1) % context->n_helpers;
+    return *helper;
   }
+
+  return NULL;
 }
 
 static gboolean
@@ -1137,36 +1595,39 @@ gst_registry_scan_plugin_file (GstRegistryScanContext * context,
 {
   gboolean changed = FALSE;
   GstPlugin *newplugin = NULL;
+  GstPluginLoader *helper;
+  guint index;
 
 #ifdef G_OS_WIN32
   /* Disable external plugin loader on Windows until it is ported properly. */
   context->helper_state = REGISTRY_SCAN_HELPER_DISABLED;
 #endif
 
+  g_ptr_array_add (context->scanned, g_strdup (filename));
 
-  /* Have a plugin to load - see if the scan-helper needs starting */
-  if (context->helper_state == REGISTRY_SCAN_HELPER_NOT_STARTED) {
-    GST_DEBUG ("Starting plugin scanner for file %s", filename);
-    context->helper = _priv_gst_plugin_loader_funcs.create (context->registry);
-    if (context->helper != NULL)
-      context->helper_state = REGISTRY_SCAN_HELPER_RUNNING;
-    else {
-      GST_WARNING ("Failed starting plugin scanner. Scanning in-process");
+  /* Have a plugin to load - see if a scan-helper needs starting. A helper
+   * that fails is dropped and the next one gets the plugin */
+  while (context->helper_state != REGISTRY_SCAN_HELPER_DISABLED) {
+    helper = get_scan_helper (context, filename, &index);
+    if (helper == NULL) {
+      GST_WARNING ("No plugin scanner left. Scanning in-process");
       context->helper_state = REGISTRY_SCAN_HELPER_DISABLED;
+      context->fell_back = TRUE;
+      break;
     }
-  }
+    context->helper_state = REGISTRY_SCAN_HELPER_RUNNING;
 
-  if (context->helper_state == REGISTRY_SCAN_HELPER_RUNNING) {
     GST_DEBUG ("Using scan-helper to load plugin %s", filename);
-    if (!_priv_gst_plugin_loader_funcs.load (context->helper,
-            filename, file_size, file_mtime)) {
-      g_warning ("External plugin loader failed. This most likely means that "
-          "the plugin loader helper binary was not found or could not be run. "
-          "You might need to set the GST_PLUGIN_SCANNER environment variable "
-          "if your setup is unusual. This should normally not be required "
-          "though.");
-      context->helper_state = REGISTRY_SCAN_HELPER_DISABLED;
-    }
+    if (_priv_gst_plugin_loader_funcs.load (helper,
+            filename, file_size, file_mtime))
+      break;
+
+    g_warning ("External plugin loader failed. This most likely means that "
+        "the plugin loader helper binary was not found or could not be run. "
+        "You might need to set the GST_PLUGIN_SCANNER environment variable "
+        "if your setup is unusual. This should normally not be required "
+        "though.");
+    drop_scan_helper (context, index);
   }
 
   /* Check if the helper is disabled (or just got disabled above) */
@@ -1197,6 +1658,220 @@ gst_registry_scan_plugin_file (GstRegistryScanContext * context,
   return changed;
 }
 
+typedef struct
+{
+  gchar *filename;
+  const gchar *dirent;          /* basename, points into filename */
+  GStatBuf status;
+  gboolean valid;
+  gboolean cached;              /* status taken from the registry cache */
+} GstRegistryScanEntry;
+
+#define PARALLEL_STAT_THREADS 4
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} StatJob;
+
+typedef struct
+{
+  StatJob *job;
+  GstRegistryScanEntry *entries;
+  guint n_entries;
+} StatChunk;
+
+static void
+stat_entries (GstRegistryScanEntry * entries, guint n_entries)
+{
+  guint i;
+
+  for (i = 0; i < n_entries; i++) {
+    if (!entries[i].cached)
+      entries[i].valid =
+          (g_stat (entries[i].filename, &entries[i].status) == 0);
+  }
+}
+
+static void
+stat_pool_func (gpointer data, gpointer user_data)
+{
+  StatChunk *chunk = data;
+  StatJob *job = chunk->job;
+
+  stat_entries (chunk->entries, chunk->n_entries);
+
+  g_mutex_lock (&job->lock);
+  if (--job->pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+static GThreadPool *
+get_stat_pool (GstRegistryScanContext * context)
+{
+  GError *err = NULL;
+
+  if (G_UNLIKELY (context->stat_pool == NULL && !context->stat_pool_failed)) {
+    /* stat() mostly waits for the disk, so this does not depend on the
+     * number of CPUs */
+    context->stat_pool = g_thread_pool_new (stat_pool_func, NULL,
+        PARALLEL_STAT_THREADS, FALSE, &err);
+    if (err != NULL) {
+      GST_WARNING ("failed to create stat thread pool: %s", err->message);
+      g_clear_error (&err);
+    }
+    context->stat_pool_failed = (context->stat_pool == NULL);
+  }
+
+  return context->stat_pool;
+}
+
+static void
+gst_registry_scan_stat_entries (GstRegistryScanContext * context,
+    GstRegistryScanEntry * entries, guint n_entries)
+{
+  GThreadPool *pool;
+  StatJob job;
+  StatChunk *chunks;
+  guint i, n_chunks;
+
+  if (n_entries < PARALLEL_STAT_MIN_ENTRIES ||
+      (pool = get_stat_pool (context)) == NULL) {
+    stat_entries (entries, n_entries);
+    return;
+  }
+
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+
+  n_chunks = (n_entries + PARALLEL_STAT_CHUNK_SIZE - 1) /
+      PARALLEL_STAT_CHUNK_SIZE;
+  chunks = g_new (StatChunk, n_chunks);
+  for (i = 0; i < n_chunks; i++) {
+    chunks[i].job = &job;
+    chunks[i].entries = entries + i * PARALLEL_STAT_CHUNK_SIZE;
+    chunks[i].n_entries = MIN (n_entries - i * PARALLEL_STAT_CHUNK_SIZE,
+        PARALLEL_STAT_CHUNK_SIZE);
+  }
+
+  /* the first chunk is done by this thread */
+  job.pending = n_chunks - 1;
+  for (i = 1; i < n_chunks; i++) {
+    if (!g_thread_pool_push (pool, &chunks[i], NULL))
+      stat_pool_func (&chunks[i], NULL);
+  }
+  stat_entries (chunks[0].entries, chunks[0].n_entries);
+
+  g_mutex_lock (&job.lock);
+  while (job.pending > 0)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
+  g_free (chunks);
+}
+
+static gboolean
+is_module_file_name (const gchar * dirent)
+{
+  return g_str_has_suffix (dirent, "." G_MODULE_SUFFIX)
+#ifdef GST_EXTRA_MODULE_SUFFIX
+      || g_str_has_suffix (dirent, GST_EXTRA_MODULE_SUFFIX)
+#endif
+      ;
+}
+
+/* Compares the mtime and number of entries of the directory at @path with
+ * the fingerprint from the registry cache and remembers the new values.
+ * Returns %TRUE if the directory is unchanged and the cache can be trusted
+ * for the files in it. */
+static gboolean
+gst_registry_scan_check_dir (GstRegistryScanContext * context,
+    const gchar * path, guint n_entries)
+{
+  GHashTable *fingerprints;
+  GstRegistryDirFingerprint *fp;
+  GStatBuf dir_status;
+  gboolean unchanged;
+
+  fingerprints = _priv_gst_registry_get_dir_fingerprints (context->registry);
+  fp = g_hash_table_lookup (fingerprints, path);
+
+  if (g_stat (path, &dir_status) < 0) {
+    if (fp)
+      g_hash_table_remove (fingerprints, path);
+    return FALSE;
+  }
+
+  unchanged = (fp != NULL && fp->mtime == (gint64) dir_status.st_mtime &&
+      fp->n_entries == n_entries);
+
+  if (!unchanged) {
+    /* the mtime only has a resolution of a second, a directory that was
+     * modified in the last second can change again without a new mtime */
+    if (dir_status.st_mtime >= context->scan_time - 1) {
+      if (fp) {
+        g_hash_table_remove (fingerprints, path);
+        context->changed = TRUE;
+      }
+      return FALSE;
+    }
+    if (fp == NULL) {
+      fp = g_new (GstRegistryDirFingerprint, 1);
+      g_hash_table_insert (fingerprints, g_strdup (path), fp);
+    }
+    GST_LOG_OBJECT (context->registry, "directory %s changed", path);
+    fp->mtime = dir_status.st_mtime;
+    fp->n_entries = n_entries;
+    context->changed = TRUE;
+  }
+  fp->seen = TRUE;
+
+  return unchanged && context->check_dirs;
+}
+
+/* In an unchanged directory, entries are known to be the same as when the
+ * registry cache was written. Subdirectories with a fingerprint and plugins
+ * from the cache then don't need a stat(). Everything else still does, it
+ * can also be a subdirectory whose fingerprint was dropped. */
+static void
+gst_registry_scan_fill_cached_entries (GstRegistryScanContext * context,
+    GstRegistryScanEntry * entries, guint n_entries)
+{
+  GHashTable *fingerprints;
+  guint i;
+
+  fingerprints = _priv_gst_registry_get_dir_fingerprints (context->registry);
+
+  for (i = 0; i < n_entries; i++) {
+    GstRegistryScanEntry *entry = &entries[i];
+    GstPlugin *plugin;
+
+    memset (&entry->status, 0, sizeof (GStatBuf));
+
+    if (g_hash_table_contains (fingerprints, entry->filename)) {
+      entry->status.st_mode = S_IFDIR;
+      entry->cached = TRUE;
+    } else if (is_module_file_name (entry->dirent) &&
+        (plugin = gst_registry_lookup_bn (context->registry,
+                entry->dirent))) {
+      if (plugin->registered || (plugin->filename &&
+              strcmp (plugin->filename, entry->filename) == 0)) {
+        entry->status.st_mode = S_IFREG;
+        entry->status.st_mtime = plugin->file_mtime;
+        entry->status.st_size = plugin->file_size;
+        entry->cached = TRUE;
+      }
+      gst_object_unref (plugin);
+    }
+    entry->valid = entry->cached;
+  }
+}
+
 static gboolean
 is_blacklisted_hidden_directory (const gchar * dirent)
 {
@@ -1221,30 +1896,55 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
     const gchar * path, int level)
 {
   GDir *dir;
+  GArray *entries;
   const gchar *dirent;
   gchar *filename;
   GstPlugin *plugin;
   gboolean changed = FALSE;
+  guint i;
 
   dir = g_dir_open (path, 0, NULL);
   if (!dir)
     return FALSE;
 
+  /* collect the entries first so they can all be stat()ed at once, they
+   * are still handled in directory order below */
+  entries = g_array_new (FALSE, FALSE, sizeof (GstRegistryScanEntry));
   while ((dirent = g_dir_read_name (dir))) {
+    GstRegistryScanEntry entry;
+
+    entry.filename = g_build_filename (path, dirent, NULL);
+    entry.dirent = entry.filename + strlen (entry.filename) - strlen (dirent);
+    entry.cached = FALSE;
+    g_array_append_val (entries, entry);
+  }
+  g_dir_close (dir);
+
+  if (gst_registry_scan_check_dir (context, path, entries->len)) {
+    GST_LOG_OBJECT (context->registry, "directory %s unchanged", path);
+    gst_registry_scan_fill_cached_entries (context,
+        (GstRegistryScanEntry *) entries->data, entries->len);
+  }
+  gst_registry_scan_stat_entries (context,
+      (GstRegistryScanEntry *) entries->data, entries->len);
+
+  for (i = 0; i < entries->len; i++) {
+    GstRegistryScanEntry *entry;
     GStatBuf file_status;
 
-    filename = g_build_filename (path, dirent, NULL);
-    if (g_stat (filename, &file_status) < 0) {
+    entry = &g_array_index (entries, GstRegistryScanEntry, i);
+    filename = entry->filename;
+    dirent = entry->dirent;
+    if (!entry->valid) {
       /* Plugin will be removed from cache after the scan completes if it
        * is still marked 'cached' */
-      g_free (filename);
       continue;
     }
+    file_status = entry->status;
 
     if (file_status.st_mode & S_IFDIR) {
       if (G_UNLIKELY (is_blacklisted_hidden_directory (dirent))) {
         GST_TRACE_OBJECT (context->registry, "ignoring %s directory", dirent);
-        g_free (filename);
         continue;
       }
       /* FIXME 2.0: Don't recurse into directories, this behaviour
@@ -1258,24 +1958,17 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
         GST_LOG_OBJECT (context->registry, "not recursing into directory %s, "
             "recursion level too deep", filename);
       }
-      g_free (filename);
       continue;
     }
     if (!(file_status.st_mode & S_IFREG)) {
       GST_TRACE_OBJECT (context->registry, "%s is not a regular file, ignoring",
           filename);
-      g_free (filename);
       continue;
     }
-    if (!g_str_has_suffix (dirent, "." G_MODULE_SUFFIX)
-#ifdef GST_EXTRA_MODULE_SUFFIX
-        && !g_str_has_suffix (dirent, GST_EXTRA_MODULE_SUFFIX)
-#endif
-        ) {
+    if (!is_module_file_name (dirent)) {
       GST_TRACE_OBJECT (context->registry,
           "extension is not recognized as module file, ignoring file %s",
           filename);
-      g_free (filename);
       continue;
     }
 
@@ -1289,7 +1982,6 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
           "has been merged into the corelements plugin", filename);
       /* Plugin will be removed from cache after the scan completes if it
        * is still marked 'cached' */
-      g_free (filename);
       continue;
     }
 
@@ -1303,7 +1995,6 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
         GST_DEBUG_OBJECT (context->registry,
             "plugin already registered from path \"%s\"",
             GST_STR_NULL (plugin->filename));
-        g_free (filename);
         gst_object_unref (plugin);
         continue;
       }
@@ -1345,11 +2036,11 @@ gst_registry_scan_path_level (GstRegistryScanContext * context,
       changed |= gst_registry_scan_plugin_file (context, filename,
           file_status.st_size, file_status.st_mtime);
     }
-
-    g_free (filename);
   }
 
-  g_dir_close (dir);
+  for (i = 0; i < entries->len; i++)
+    g_free (g_array_index (entries, GstRegistryScanEntry, i).filename);
+  g_array_free (entries, TRUE);
 
   return changed;
 }
@@ -1391,7 +2082,7 @@ gst_registry_scan_path (GstRegistry * registry, const gchar * path)
 
   result = gst_registry_scan_path_internal (&context, path);
 
-  clear_scan_context (&context);
+  free_scan_context (&context);
   result |= context.changed;
 
   return result;
@@ -1442,6 +2133,87 @@ _priv_gst_registry_cleanup (void)
     gst_object_unref (registry);
 }
 
+/**
+ * gst_registry_save_prelinked:
+ * @registry: a #GstRegistry
+ * @location: (type filename): the file to write
+ *
+ * Writes the static plugins of @registry, those registered with
+ * gst_plugin_register_static(), and their features to @location, for use
+ * with gst_registry_add_prelinked().
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 1.16
+ */
+gboolean
+gst_registry_save_prelinked (GstRegistry * registry, const gchar * location)
+{
+#ifndef GST_DISABLE_REGISTRY
+  GList *plugins = NULL, *l;
+  gboolean res;
+
+  g_return_val_if_fail (GST_IS_REGISTRY (registry), FALSE);
+  g_return_val_if_fail (location != NULL, FALSE);
+
+  GST_OBJECT_LOCK (registry);
+  for (l = registry->priv->plugins; l != NULL; l = l->next) {
+    GstPlugin *plugin = l->data;
+
+    if (plugin->filename == NULL)
+      plugins = g_list_prepend (plugins, gst_object_ref (plugin));
+  }
+  GST_OBJECT_UNLOCK (registry);
+
+  plugins = g_list_reverse (plugins);
+  res = priv_gst_registry_binary_write_cache (registry, plugins, location,
+      TRUE);
+  gst_plugin_list_free (plugins);
+
+  return res;
+#else
+  GST_WARNING ("registry support is disabled");
+  return FALSE;
+#endif
+}
+
+/**
+ * gst_registry_add_prelinked:
+ * @registry: a #GstRegistry
+ * @data: (array length=size): data written by gst_registry_save_prelinked()
+ * @size: the size of @data
+ *
+ * Adds the static plugins and features saved in @data to @registry. This is
+ * meant for data that is built into the application, @data is not copied
+ * and must stay valid and unchanged as long as @registry exists.
+ *
+ * @data should be aligned to the size of a pointer, e.g. by declaring the
+ * array with an alignment attribute. Data without that alignment, like the
+ * plain arrays written by `xxd -i`, is copied once.
+ *
+ * The plugins are only initialised when one of their features is loaded,
+ * after the application registered them with gst_plugin_register_static()
+ * as usual. Plugins that are registered already keep their features.
+ *
+ * Returns: %TRUE if @data could be read.
+ *
+ * Since: 1.16
+ */
+gboolean
+gst_registry_add_prelinked (GstRegistry * registry, const guint8 * data,
+    gsize size)
+{
+#ifndef GST_DISABLE_REGISTRY
+  g_return_val_if_fail (GST_IS_REGISTRY (registry), FALSE);
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  return priv_gst_registry_binary_read_prelinked (registry, data, size);
+#else
+  GST_WARNING ("registry support is disabled");
+  return FALSE;
+#endif
+}
+
 /**
  * gst_registry_check_feature_version:
  * @registry: a #GstRegistry
@@ -1671,7 +2443,7 @@ scan_and_update_registry (GstRegistry * default_registry,
     g_strfreev (list);
   }
 
-  clear_scan_context (&context);
+  free_scan_context (&context);
   changed |= context.changed;
 
   /* Remove cached plugins so stale info is cleared. */
@@ -1689,7 +2461,7 @@ scan_and_update_registry (GstRegistry * default_registry,
 
   GST_INFO ("Registry cache changed. Writing new registry cache");
   if (!priv_gst_registry_binary_write_cache (default_registry,
-          default_registry->priv->plugins, registry_file)) {
+          default_registry->priv->plugins, registry_file, FALSE)) {
     g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_FAILED,
         _("Error writing registry cache to %s: %s"),
         registry_file, g_strerror (errno));
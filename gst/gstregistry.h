@@ -124,6 +124,14 @@ gboolean                gst_registry_check_feature_version (GstRegistry *registr
                                                             guint        min_minor,
                                                             guint        min_micro);
 
+GST_API
+gboolean                gst_registry_save_prelinked     (GstRegistry *registry,
+                                                         const gchar *location);
+GST_API
+gboolean                gst_registry_add_prelinked      (GstRegistry *registry,
+                                                         const guint8 *data,
+                                                         gsize size);
+
 #ifdef G_DEFINE_AUTOPTR_CLEANUP_FUNC
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GstRegistry, gst_object_unref)
 #endif
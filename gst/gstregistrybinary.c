@@ -325,6 +325,78 @@ gst_registry_binary_write_chunk (BinaryRegistryCache * cache,
 }
 
 
+static gint
+gst_registry_binary_compare_index_entries (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  const GstRegistryChunkIndexEntry *ea = a, *eb = b;
+  const gchar *names = user_data;
+
+  return strcmp (names + ea->name, names + eb->name);
+}
+
+/*
+ * gst_registry_binary_write_index:
+ *
+ * Write the index with the plugin offsets and the sorted feature names and
+ * offsets, followed by the trailer that points to it.
+ *
+ * Returns: %TRUE for success
+ */
+static gboolean
+gst_registry_binary_write_index (BinaryRegistryCache * cache,
+    GArray * plugin_offsets, GArray * features, GString * names,
+    unsigned long *file_position)
+{
+  GstRegistryChunkIndexTrailer trailer;
+  GstRegistryChunkIndex *index;
+  GstRegistryChunkIndexEntry *entries;
+  GstRegistryChunk chunk;
+  gsize names_offset;
+  gboolean res;
+  guint i;
+
+  g_array_sort_with_data (features, gst_registry_binary_compare_index_entries,
+      names->str);
+
+  names_offset = sizeof (GstRegistryChunkIndex) +
+      plugin_offsets->len * sizeof (guint32) +
+      features->len * sizeof (GstRegistryChunkIndexEntry);
+
+  chunk.size = names_offset + names->len;
+  chunk.data = g_malloc (chunk.size);
+  chunk.flags = GST_REGISTRY_CHUNK_FLAG_MALLOC;
+  chunk.align = TRUE;
+
+  index = chunk.data;
+  index->n_plugins = plugin_offsets->len;
+  index->n_features = features->len;
+  memcpy (index + 1, plugin_offsets->data,
+      plugin_offsets->len * sizeof (guint32));
+  entries = (GstRegistryChunkIndexEntry *) ((guint32 *) (index + 1) +
+      plugin_offsets->len);
+  for (i = 0; i < features->len; i++) {
+    entries[i] = g_array_index (features, GstRegistryChunkIndexEntry, i);
+    entries[i].name += names_offset;
+  }
+  memcpy ((gchar *) chunk.data + names_offset, names->str, names->len);
+
+  res = gst_registry_binary_write_chunk (cache, &chunk, file_position);
+  g_free (chunk.data);
+  if (!res)
+    return FALSE;
+
+  trailer.offset = *file_position - chunk.size;
+  trailer.size = chunk.size;
+
+  chunk.data = &trailer;
+  chunk.size = sizeof (GstRegistryChunkIndexTrailer);
+  chunk.flags = GST_REGISTRY_CHUNK_FLAG_CONST;
+  chunk.align = TRUE;
+
+  return gst_registry_binary_write_chunk (cache, &chunk, file_position);
+}
+
 /*
  * gst_registry_binary_initialize_magic:
  *
@@ -351,6 +423,7 @@ gst_registry_binary_initialize_magic (GstBinaryRegistryMagic * m)
  * gst_registry_binary_write_cache:
  * @registry: a #GstRegistry
  * @location: a filename
+ * @prelinked: write the static @plugins for gst_registry_add_prelinked()
  *
  * Write the @registry to a cache to file at given @location.
  *
@@ -358,13 +431,15 @@ gst_registry_binary_initialize_magic (GstBinaryRegistryMagic * m)
  */
 gboolean
 priv_gst_registry_binary_write_cache (GstRegistry * registry, GList * plugins,
-    const char *location)
+    const char *location, gboolean prelinked)
 {
   GList *walk;
   GstBinaryRegistryMagic magic;
   GList *to_write = NULL;
   unsigned long file_position = 0;
-  BinaryRegistryCache *cache;
+  BinaryRegistryCache *cache = NULL;
+  GArray *plugin_offsets, *features;
+  GString *names;
 
   GST_INFO ("Building binary registry cache image");
 
@@ -377,7 +452,7 @@ priv_gst_registry_binary_write_cache (GstRegistry * registry, GList * plugins,
   for (walk = plugins; walk != NULL; walk = walk->next) {
     GstPlugin *plugin = GST_PLUGIN (walk->data);
 
-    if (!plugin->filename)
+    if (!plugin->filename && !prelinked)
       continue;
 
     if (GST_OBJECT_FLAG_IS_SET (plugin, GST_PLUGIN_FLAG_CACHED)) {
@@ -395,8 +470,9 @@ priv_gst_registry_binary_write_cache (GstRegistry * registry, GList * plugins,
     }
   }
 
+  /* static plugins are not found by scanning directories */
   _priv_gst_registry_chunks_save_global_header (&to_write, registry,
-      priv_gst_plugin_loading_get_whitelist_hash ());
+      priv_gst_plugin_loading_get_whitelist_hash (), !prelinked);
 
   GST_INFO ("Writing binary registry cache");
 
@@ -413,6 +489,10 @@ priv_gst_registry_binary_write_cache (GstRegistry * registry, GList * plugins,
   }
   file_position += sizeof (GstBinaryRegistryMagic);
 
+  plugin_offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+  features = g_array_new (FALSE, FALSE, sizeof (GstRegistryChunkIndexEntry));
+  names = g_string_new (NULL);
+
   /* write out data chunks */
   for (walk = to_write; walk; walk = g_list_next (walk)) {
     GstRegistryChunk *cur = walk->data;
@@ -420,12 +500,39 @@ priv_gst_registry_binary_write_cache (GstRegistry * registry, GList * plugins,
 
     res = gst_registry_binary_write_chunk (cache, cur, &file_position);
 
+    if (cur->flags & GST_REGISTRY_CHUNK_FLAG_PLUGIN) {
+      guint32 offset = file_position - cur->size;
+
+      g_array_append_val (plugin_offsets, offset);
+    } else if (cur->flags & GST_REGISTRY_CHUNK_FLAG_FEATURE) {
+      /* the type name of the feature is followed by its name */
+      GstRegistryChunk *name = walk->next->data;
+      GstRegistryChunkIndexEntry entry;
+
+      entry.name = names->len;
+      entry.offset = file_position - cur->size;
+      entry.plugin = plugin_offsets->len - 1;
+      g_array_append_val (features, entry);
+      g_string_append_len (names, name->data, name->size);
+    }
+
     _priv_gst_registry_chunk_free (cur);
     walk->data = NULL;
     if (!res)
-      goto fail_free_list;
+      goto fail_free_index;
   }
   g_list_free (to_write);
+  to_write = NULL;
+
+  if (!gst_registry_binary_write_index (cache, plugin_offsets, features,
+          names, &file_position)) {
+    GST_ERROR ("Failed to write binary registry index");
+    goto fail_free_index;
+  }
+
+  g_array_free (plugin_offsets, TRUE);
+  g_array_free (features, TRUE);
+  g_string_free (names, TRUE);
 
   if (!gst_registry_binary_cache_finish (cache, TRUE))
     return FALSE;
@@ -433,6 +540,13 @@ priv_gst_registry_binary_write_cache (GstRegistry * registry, GList * plugins,
   return TRUE;
 
   /* Errors */
+fail_free_index:
+  {
+    g_array_free (plugin_offsets, TRUE);
+    g_array_free (features, TRUE);
+    g_string_free (names, TRUE);
+    /* fall through */
+  }
 fail_free_list:
   {
     for (walk = to_write; walk; walk = g_list_next (walk)) {
@@ -498,6 +612,127 @@ fail:
   return -1;
 }
 
+/*
+ * gst_registry_binary_find_index:
+ *
+ * Find the index at the end of the registry data, the plugins end where the
+ * index starts.
+ *
+ * Returns: the index, or %NULL if it is missing or broken
+ */
+static GstRegistryChunkIndex *
+gst_registry_binary_find_index (gchar * data, gsize size, gsize * index_size)
+{
+  GstRegistryChunkIndexTrailer *trailer;
+  GstRegistryChunkIndex *index;
+  guint64 needed;
+
+  if (G_UNLIKELY (size < sizeof (GstBinaryRegistryMagic) +
+          sizeof (GstRegistryChunkIndexTrailer)))
+    goto broken;
+
+  trailer = (GstRegistryChunkIndexTrailer *) (data + size -
+      sizeof (GstRegistryChunkIndexTrailer));
+  if (G_UNLIKELY (alignment (trailer) != 0 ||
+          trailer->offset % ALIGNMENT != 0 ||
+          trailer->offset < sizeof (GstBinaryRegistryMagic) ||
+          trailer->size < sizeof (GstRegistryChunkIndex) ||
+          (guint64) trailer->offset + trailer->size >
+          size - sizeof (GstRegistryChunkIndexTrailer)))
+    goto broken;
+
+  index = (GstRegistryChunkIndex *) (data + trailer->offset);
+  needed = sizeof (GstRegistryChunkIndex) +
+      (guint64) index->n_plugins * sizeof (guint32) +
+      (guint64) index->n_features * sizeof (GstRegistryChunkIndexEntry);
+  if (G_UNLIKELY (needed > trailer->size))
+    goto broken;
+  /* the feature names are the last part of the index */
+  if (G_UNLIKELY (index->n_features > 0 &&
+          (needed == trailer->size ||
+              ((gchar *) index)[trailer->size - 1] != '\0')))
+    goto broken;
+
+  *index_size = trailer->size;
+  return index;
+
+broken:
+  GST_WARNING ("Missing or broken binary registry index");
+  return NULL;
+}
+
+/*
+ * gst_registry_binary_load_indexed:
+ *
+ * Read the plugins through the @index and hand the features to the
+ * registry, which only reads them when they are used.
+ *
+ * Returns: %TRUE on success.
+ */
+static gboolean
+gst_registry_binary_load_indexed (GstRegistry * registry, gchar * contents,
+    GstRegistryChunkIndex * index, gsize index_size, GBytes * backing)
+{
+  GstRegistryChunkIndexEntry *entries;
+  GstRegistryLazyFeature *features;
+  GstPlugin **plugins;
+  guint32 *plugin_offsets;
+  gchar *end = (gchar *) index;
+  gboolean res = FALSE;
+  guint i;
+
+  plugin_offsets = (guint32 *) (index + 1);
+  entries = (GstRegistryChunkIndexEntry *) (plugin_offsets + index->n_plugins);
+
+  plugins = g_new0 (GstPlugin *, index->n_plugins);
+  features = g_new (GstRegistryLazyFeature, index->n_features);
+
+  for (i = 0; i < index->n_plugins; i++) {
+    gchar *in = contents + plugin_offsets[i];
+
+    if (G_UNLIKELY (in >= end))
+      goto broken;
+    if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, backing,
+            FALSE, FALSE, &plugins[i]))
+      goto done;
+    /* keep the plugin alive until the registry took the features */
+    gst_object_ref (plugins[i]);
+  }
+
+  for (i = 0; i < index->n_features; i++) {
+    GstRegistryChunkIndexEntry *entry = &entries[i];
+
+    if (G_UNLIKELY (entry->name >= index_size ||
+            entry->offset >= (gsize) (end - contents) ||
+            entry->plugin >= index->n_plugins))
+      goto broken;
+
+    features[i].name = (gchar *) index + entry->name;
+    features[i].data = contents + entry->offset;
+    features[i].plugin = plugins[entry->plugin];
+    features[i].plugin_name = plugins[entry->plugin]->desc.name;
+    features[i].pending = TRUE;
+  }
+
+  GST_DEBUG ("Added %u plugins with %u features from the index",
+      index->n_plugins, index->n_features);
+  _priv_gst_registry_add_lazy_features (registry, backing, features,
+      index->n_features);
+  features = NULL;
+  res = TRUE;
+
+done:
+  for (i = 0; i < index->n_plugins && plugins[i]; i++)
+    gst_object_unref (plugins[i]);
+  g_free (plugins);
+  g_free (features);
+  return res;
+
+broken:
+  GST_ERROR ("Invalid offset in binary registry index");
+  goto done;
+}
+
 /**
  * gst_registry_binary_read_cache:
  * @registry: a #GstRegistry
@@ -512,6 +747,7 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
     const char *location)
 {
   GMappedFile *mapped = NULL;
+  GBytes *backing = NULL;
   gchar *contents = NULL;
   gchar *in = NULL;
   gsize size;
@@ -519,6 +755,8 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
   gboolean res = FALSE;
   guint32 filter_env_hash = 0;
   gint check_magic_result;
+  GstRegistryChunkIndex *index;
+  gsize index_size;
 #ifndef GST_DISABLE_GST_DEBUG
   GTimer *timer = NULL;
   gdouble seconds;
@@ -557,6 +795,12 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
     /* This can't fail if g_mapped_file_new() succeeded */
     contents = g_mapped_file_get_contents (mapped);
     size = g_mapped_file_get_length (mapped);
+#ifndef G_OS_WIN32
+    /* features keep the mapping alive for data they only parse when used.
+     * Updates replace the file with a rename, so the mapping stays valid.
+     * On win32 a mapped file can't be replaced, so data is copied there. */
+    backing = g_mapped_file_get_bytes (mapped);
+#endif
   }
 
   /* in is a cursor pointer, we initialize it with the begin of registry and is updated on each read */
@@ -590,21 +834,33 @@ priv_gst_registry_binary_read_cache (GstRegistry * registry,
     goto done;
   }
 
-  /* check if there are plugins in the file */
-  if (G_UNLIKELY (!(((gsize) in + sizeof (GstRegistryChunkPluginElement)) <
-              (gsize) contents + size))) {
+  if (!(index = gst_registry_binary_find_index (contents, size, &index_size))) {
+    GST_ERROR ("Couldn't find the index of binary registry %s", location);
+    goto Error;
+  }
+
+  if (backing) {
+    /* features are created from the mapped file when they are used */
+    if (!gst_registry_binary_load_indexed (registry, contents, index,
+            index_size, backing)) {
+      GST_ERROR ("Problem while reading binary registry %s", location);
+      goto Error;
+    }
+  } else if (G_UNLIKELY (!(((gsize) in +
+                  sizeof (GstRegistryChunkPluginElement)) < (gsize) index))) {
+    /* check if there are plugins in the file */
     GST_INFO ("No binary plugins structure to read");
     /* empty file, this is not an error */
   } else {
-    gchar *end = contents + size;
+    gchar *end = (gchar *) index;
     /* read as long as we still have space for a GstRegistryChunkPluginElement */
     for (;
-        ((gsize) in + sizeof (GstRegistryChunkPluginElement)) <
-        (gsize) contents + size;) {
+        ((gsize) in + sizeof (GstRegistryChunkPluginElement)) < (gsize) end;) {
       GST_DEBUG ("reading binary registry %" G_GSIZE_FORMAT "(%x)/%"
           G_GSIZE_FORMAT, (gsize) in - (gsize) contents,
           (guint) ((gsize) in - (gsize) contents), size);
-      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, NULL)) {
+      if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end,
+              backing, FALSE, TRUE, NULL)) {
         GST_ERROR ("Problem while reading binary registry %s", location);
         goto Error;
       }
@@ -621,12 +877,13 @@ done:
   GST_INFO ("loaded %s in %lf seconds", location, seconds);
 
   res = TRUE;
-  /* TODO: once we re-use the pointers to registry contents, return here */
 
 Error:
 #ifndef GST_DISABLE_GST_DEBUG
   g_timer_destroy (timer);
 #endif
+  if (backing)
+    g_bytes_unref (backing);
   if (mapped) {
     g_mapped_file_unref (mapped);
   } else {
@@ -634,3 +891,78 @@ Error:
   }
   return res;
 }
+
+/*
+ * priv_gst_registry_binary_read_prelinked:
+ * @registry: a #GstRegistry
+ * @data: registry data written for static plugins
+ * @size: the size of @data
+ *
+ * Adds the static plugins from @data to @registry. Features keep pointers
+ * into @data, which must stay valid as long as @registry exists. Data that
+ * is not aligned to the size of a pointer is copied first.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+priv_gst_registry_binary_read_prelinked (GstRegistry * registry,
+    const guint8 * data, gsize size)
+{
+  GBytes *backing;
+  gchar *in, *end;
+  guint32 filter_env_hash = 0;
+  gsize index_size;
+  gboolean res = FALSE;
+
+  /* make sure these types exist */
+  GST_TYPE_ELEMENT_FACTORY;
+  GST_TYPE_TYPE_FIND_FACTORY;
+  GST_TYPE_DEVICE_PROVIDER_FACTORY;
+  GST_TYPE_DYNAMIC_TYPE_FACTORY;
+
+  /* the writer aligns chunks relative to the start of the data and the
+   * reader aligns the addresses, so they only agree for aligned data.
+   * Arrays from `xxd -i` have no alignment guarantee, copy those. */
+  if (G_UNLIKELY ((gsize) data % sizeof (gpointer) != 0)) {
+    GST_DEBUG ("copying misaligned prelinked registry data");
+    backing = g_bytes_new (data, size);
+  } else {
+    backing = g_bytes_new_static (data, size);
+  }
+  in = (gchar *) g_bytes_get_data (backing, NULL);
+
+  if (G_UNLIKELY (size < sizeof (GstBinaryRegistryMagic) ||
+          gst_registry_binary_check_magic (&in, size) < 0)) {
+    GST_ERROR ("Invalid prelinked registry data");
+    goto done;
+  }
+
+  /* prelinked data is always read completely, up to the index */
+  end = (gchar *) gst_registry_binary_find_index ((gchar *)
+      g_bytes_get_data (backing, NULL), size, &index_size);
+  if (G_UNLIKELY (end == NULL)) {
+    GST_ERROR ("Invalid prelinked registry data");
+    goto done;
+  }
+
+  /* the plugin loading filter does not apply to static plugins, which are
+   * registered by the application itself */
+  if (!_priv_gst_registry_chunks_load_global_header (registry, &in, end,
+          &filter_env_hash)) {
+    GST_ERROR ("Couldn't read global header chunk");
+    goto done;
+  }
+
+  while (((gsize) in + sizeof (GstRegistryChunkPluginElement)) < (gsize) end) {
+    if (!_priv_gst_registry_chunks_load_plugin (registry, &in, end, backing,
+            TRUE, TRUE, NULL)) {
+      GST_ERROR ("Problem while reading prelinked registry");
+      goto done;
+    }
+  }
+  res = TRUE;
+
+done:
+  g_bytes_unref (backing);
+  return res;
+}
@@ -287,9 +287,13 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
       }
     }
 
-    /* pack element metadata strings */
-    gst_registry_chunks_save_string (list,
-        gst_structure_to_string (factory->metadata));
+    /* pack element metadata strings, as loaded if they were never parsed */
+    if (factory->metadata_string)
+      gst_registry_chunks_save_string (list,
+          g_strdup (factory->metadata_string));
+    else
+      gst_registry_chunks_save_string (list,
+          gst_structure_to_string (factory->metadata));
   } else if (GST_IS_TYPE_FIND_FACTORY (feature)) {
     GstRegistryChunkTypeFindFactory *tff;
     GstTypeFindFactory *factory = GST_TYPE_FIND_FACTORY (feature);
@@ -368,6 +372,8 @@ gst_registry_chunks_save_feature (GList ** list, GstPluginFeature * feature)
     /* pack plugin feature strings */
     gst_registry_chunks_save_const_string (list, GST_OBJECT_NAME (feature));
     gst_registry_chunks_save_const_string (list, (gchar *) type_name);
+    ((GstRegistryChunk *) (*list)->data)->flags |=
+        GST_REGISTRY_CHUNK_FLAG_FEATURE;
 
     return TRUE;
   }
@@ -433,21 +439,15 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
       gst_registry_chunks_make_data (pe,
       sizeof (GstRegistryChunkPluginElement));
 
+  chk->flags |= GST_REGISTRY_CHUNK_FLAG_PLUGIN;
+
   pe->file_size = plugin->file_size;
   pe->file_mtime = plugin->file_mtime;
   pe->nfeatures = 0;
   pe->n_deps = 0;
 
-  /* pack external deps */
-  for (walk = plugin->priv->deps; walk != NULL; walk = walk->next) {
-    if (!gst_registry_chunks_save_plugin_dep (list, walk->data)) {
-      GST_ERROR ("Could not save external plugin dependency, aborting.");
-      goto fail;
-    }
-    ++pe->n_deps;
-  }
-
-  /* pack plugin features */
+  /* pack plugin features, they come last so that a reader can stop after
+   * the dependencies and load the features from the index later */
   plugin_features =
       gst_registry_get_feature_list_by_plugin (registry, plugin->desc.name);
   for (walk = plugin_features; walk; walk = g_list_next (walk), pe->nfeatures++) {
@@ -460,6 +460,16 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
   }
 
   gst_plugin_feature_list_free (plugin_features);
+  plugin_features = NULL;
+
+  /* pack external deps */
+  for (walk = plugin->priv->deps; walk != NULL; walk = walk->next) {
+    if (!gst_registry_chunks_save_plugin_dep (list, walk->data)) {
+      GST_ERROR ("Could not save external plugin dependency, aborting.");
+      goto fail;
+    }
+    ++pe->n_deps;
+  }
 
   /* pack cache data */
   if (plugin->priv->cache_data) {
@@ -477,7 +487,9 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
   gst_registry_chunks_save_const_string (list, plugin->desc.source);
   gst_registry_chunks_save_const_string (list, plugin->desc.license);
   gst_registry_chunks_save_const_string (list, plugin->desc.version);
-  gst_registry_chunks_save_const_string (list, plugin->filename);
+  /* static plugins have no file */
+  gst_registry_chunks_save_const_string (list,
+      plugin->filename ? plugin->filename : "");
   gst_registry_chunks_save_const_string (list, plugin->desc.description);
   gst_registry_chunks_save_const_string (list, plugin->desc.name);
 
@@ -536,33 +548,32 @@ fail:
 }
 
 /*
- * gst_registry_chunks_load_feature:
+ * _priv_gst_registry_chunks_load_feature:
  *
- * Make a new GstPluginFeature from current binary plugin feature structure
+ * Make a new GstPluginFeature from current binary plugin feature structure.
+ * @plugin can be %NULL when the plugin that was read with the feature was
+ * replaced since, @plugin_name must stay valid as long as the feature exists.
  *
- * Returns: new GstPluginFeature
+ * Returns: new floating GstPluginFeature, or %NULL on error
  */
-static gboolean
-gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin * plugin)
+GstPluginFeature *
+_priv_gst_registry_chunks_load_feature (gchar ** in, gchar * end,
+    GstPlugin * plugin, const gchar * plugin_name, GBytes * backing)
 {
   GstRegistryChunkPluginFeature *pf = NULL;
   GstPluginFeature *feature = NULL;
   const gchar *const_str, *type_name;
   const gchar *feature_name;
-  const gchar *plugin_name;
   gchar *str;
   GType type;
   guint i;
 
-  plugin_name = plugin->desc.name;
-
   /* unpack plugin feature strings */
   unpack_string_nocopy (*in, type_name, end, fail);
 
   if (G_UNLIKELY (!type_name)) {
     GST_ERROR ("No feature type name");
-    return FALSE;
+    return NULL;
   }
 
   /* unpack more plugin feature strings */
@@ -574,11 +585,11 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
   if (G_UNLIKELY (!(type = g_type_from_name (type_name)))) {
     GST_ERROR ("Unknown type from typename '%s' for plugin '%s'", type_name,
         plugin_name);
-    return FALSE;
+    return NULL;
   }
   if (G_UNLIKELY ((feature = g_object_new (type, NULL)) == NULL)) {
     GST_ERROR ("Can't create feature from type");
-    return FALSE;
+    return NULL;
   }
   gst_plugin_feature_set_name (feature, feature_name);
 
@@ -600,15 +611,15 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
     unpack_element (*in, ef, GstRegistryChunkElementFactory, end, fail);
     pf = (GstRegistryChunkPluginFeature *) ef;
 
-    /* unpack element factory strings */
+    /* unpack element factory strings, the metadata is only parsed when it
+     * is used and stays in the mapped cache if there is one */
     unpack_string_nocopy (*in, meta_data_str, end, fail);
     if (meta_data_str && *meta_data_str) {
-      factory->metadata = gst_structure_from_string (meta_data_str, NULL);
-      if (!factory->metadata) {
-        GST_ERROR
-            ("Error when trying to deserialize structure for metadata '%s'",
-            meta_data_str);
-        goto fail;
+      if (backing) {
+        factory->metadata_string = (gchar *) meta_data_str;
+        factory->metadata_backing = g_bytes_ref (backing);
+      } else {
+        factory->metadata_string = g_strdup (meta_data_str);
       }
     }
     n = ef->npadtemplates;
@@ -722,14 +733,14 @@ gst_registry_chunks_load_feature (GstRegistry * registry, gchar ** in,
 
   feature->plugin_name = plugin_name;
   feature->plugin = plugin;
-  g_object_add_weak_pointer ((GObject *) plugin,
-      (gpointer *) & feature->plugin);
+  if (plugin)
+    g_object_add_weak_pointer ((GObject *) plugin,
+        (gpointer *) & feature->plugin);
 
-  gst_registry_add_feature (registry, feature);
-  GST_DEBUG ("Added feature %s, plugin %p %s", GST_OBJECT_NAME (feature),
+  GST_DEBUG ("Read feature %s, plugin %p %s", GST_OBJECT_NAME (feature),
       plugin, plugin_name);
 
-  return TRUE;
+  return feature;
 
   /* Errors */
 fail:
@@ -740,7 +751,7 @@ fail:
     else
       g_object_unref (feature);
   }
-  return FALSE;
+  return NULL;
 }
 
 static gchar **
@@ -810,11 +821,16 @@ fail:
  *
  * Make a new GstPlugin from current GstRegistryChunkPluginElement structure
  * and add it to the GstRegistry. Return an offset to the next
- * GstRegistryChunkPluginElement structure.
+ * GstRegistryChunkPluginElement structure. If @backing holds the data,
+ * features can keep pointers into it instead of copying. @prelinked is set
+ * for static plugins from gst_registry_add_prelinked(). Without
+ * @with_features, reading stops before the features of the plugin, which
+ * the caller loads on its own.
  */
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar * end, GstPlugin ** out_plugin)
+    gchar * end, GBytes * backing, gboolean prelinked, gboolean with_features,
+    GstPlugin ** out_plugin)
 {
 #ifndef GST_DISABLE_GST_DEBUG
   gchar *start = *in;
@@ -822,6 +838,7 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
   GstRegistryChunkPluginElement *pe;
   const gchar *cache_str = NULL;
   GstPlugin *plugin = NULL;
+  GstRegistry *scratch = NULL;
   guint i, n;
 
   align (*in);
@@ -870,7 +887,29 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
   if (strcmp (plugin->desc.license, "BLACKLIST") == 0)
     GST_OBJECT_FLAG_SET (plugin, GST_PLUGIN_FLAG_BLACKLISTED);
 
-  plugin->basename = g_path_get_basename (plugin->filename);
+  if (prelinked) {
+    GstPlugin *existing;
+
+    /* static plugin, its features are loaded once the application
+     * registered it */
+    g_free (plugin->filename);
+    plugin->filename = NULL;
+    plugin->priv->prelinked = TRUE;
+    GST_OBJECT_FLAG_UNSET (plugin, GST_PLUGIN_FLAG_CACHED);
+
+    /* plugins that are registered already, like the core elements, keep
+     * their features, the prelinked ones are only read past */
+    existing = gst_registry_find_plugin (registry, plugin->desc.name);
+    if (existing) {
+      GST_DEBUG ("static plugin '%s' is registered already",
+          plugin->desc.name);
+      gst_object_unref (existing);
+      scratch = gst_object_ref_sink (g_object_new (GST_TYPE_REGISTRY, NULL));
+      registry = scratch;
+    }
+  } else {
+    plugin->basename = g_path_get_basename (plugin->filename);
+  }
 
   /* Takes ownership of plugin */
   gst_registry_add_plugin (registry, plugin);
@@ -878,17 +917,6 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
   GST_DEBUG ("Added plugin '%s' plugin with %d features from binary registry",
       plugin->desc.name, n);
 
-  /* Load plugin features */
-  for (i = 0; i < n; i++) {
-    if (G_UNLIKELY (!gst_registry_chunks_load_feature (registry, in, end,
-                plugin))) {
-      GST_ERROR ("Error while loading binary feature for plugin '%s'",
-          GST_STR_NULL (plugin->desc.name));
-      gst_registry_remove_plugin (registry, plugin);
-      goto fail;
-    }
-  }
-
   /* Load external plugin dependencies */
   for (i = 0; i < pe->n_deps; ++i) {
     if (G_UNLIKELY (!gst_registry_chunks_load_plugin_dep (plugin, in, end))) {
@@ -899,33 +927,77 @@ _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
     }
   }
 
+  /* Load plugin features */
+  for (i = 0; with_features && i < n; i++) {
+    GstPluginFeature *feature;
+
+    feature = _priv_gst_registry_chunks_load_feature (in, end, plugin,
+        plugin->desc.name, backing);
+    if (G_UNLIKELY (feature == NULL)) {
+      GST_ERROR ("Error while loading binary feature for plugin '%s'",
+          GST_STR_NULL (plugin->desc.name));
+      gst_registry_remove_plugin (registry, plugin);
+      goto fail;
+    }
+    gst_registry_add_feature (registry, feature);
+  }
+
   if (out_plugin)
-    *out_plugin = plugin;
+    *out_plugin = scratch ? NULL : plugin;
+
+  if (scratch)
+    gst_object_unref (scratch);
 
   return TRUE;
 
   /* Errors */
 fail:
   GST_INFO ("Reading plugin failed after %u bytes", (guint) (end - start));
+  if (scratch)
+    gst_object_unref (scratch);
   return FALSE;
 }
 
 void
 _priv_gst_registry_chunks_save_global_header (GList ** list,
-    GstRegistry * registry, guint32 filter_env_hash)
+    GstRegistry * registry, guint32 filter_env_hash, gboolean save_dirs)
 {
   GstRegistryChunkGlobalHeader *hdr;
   GstRegistryChunk *chk;
+  GHashTableIter iter;
+  gpointer key, value;
 
   hdr = g_slice_new (GstRegistryChunkGlobalHeader);
   chk = gst_registry_chunks_make_data (hdr,
       sizeof (GstRegistryChunkGlobalHeader));
 
   hdr->filter_env_hash = filter_env_hash;
+  hdr->n_dirs = 0;
+
+  /* pack the fingerprints of the directories seen by the last scan */
+  g_hash_table_iter_init (&iter,
+      _priv_gst_registry_get_dir_fingerprints (registry));
+  while (save_dirs && g_hash_table_iter_next (&iter, &key, &value)) {
+    GstRegistryDirFingerprint *fp = value;
+    GstRegistryChunkDirectory *dir;
+
+    if (!fp->seen)
+      continue;
+
+    gst_registry_chunks_save_string (list, g_strdup (key));
+
+    dir = g_slice_new (GstRegistryChunkDirectory);
+    dir->mtime = fp->mtime;
+    dir->n_entries = fp->n_entries;
+    *list = g_list_prepend (*list, gst_registry_chunks_make_data (dir,
+            sizeof (GstRegistryChunkDirectory)));
+    hdr->n_dirs++;
+  }
 
   *list = g_list_prepend (*list, chk);
 
-  GST_LOG ("Saved global header (filter_env_hash=0x%08x)", filter_env_hash);
+  GST_LOG ("Saved global header (filter_env_hash=0x%08x, %u directories)",
+      filter_env_hash, hdr->n_dirs);
 }
 
 gboolean
@@ -933,11 +1005,30 @@ _priv_gst_registry_chunks_load_global_header (GstRegistry * registry,
     gchar ** in, gchar * end, guint32 * filter_env_hash)
 {
   GstRegistryChunkGlobalHeader *hdr;
+  GHashTable *fingerprints;
+  guint i;
 
   align (*in);
   GST_LOG ("Reading/casting for GstRegistryChunkGlobalHeader at %p", *in);
   unpack_element (*in, hdr, GstRegistryChunkGlobalHeader, end, fail);
   *filter_env_hash = hdr->filter_env_hash;
+
+  fingerprints = _priv_gst_registry_get_dir_fingerprints (registry);
+  for (i = 0; i < hdr->n_dirs; i++) {
+    GstRegistryChunkDirectory *dir;
+    GstRegistryDirFingerprint *fp;
+    const gchar *path;
+
+    align (*in);
+    unpack_element (*in, dir, GstRegistryChunkDirectory, end, fail);
+    unpack_string_nocopy (*in, path, end, fail);
+
+    fp = g_new (GstRegistryDirFingerprint, 1);
+    fp->mtime = dir->mtime;
+    fp->n_entries = dir->n_entries;
+    fp->seen = FALSE;
+    g_hash_table_replace (fingerprints, g_strdup (path), fp);
+  }
   return TRUE;
 
   /* Errors */
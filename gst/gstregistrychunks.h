@@ -30,11 +30,16 @@
  * we reference strings directly from the plugins and in this case set CONST to
  * avoid freeing them. If g_free() should be used, the MALLOC flag is set,
  * otherwise g_slice_free1() will be used!
+ *
+ * PLUGIN marks the first chunk of a plugin and FEATURE the first chunk of a
+ * plugin feature, the cache writer records their offsets in the index.
  */
 enum {
   GST_REGISTRY_CHUNK_FLAG_NONE = 0,
   GST_REGISTRY_CHUNK_FLAG_CONST = 1,
   GST_REGISTRY_CHUNK_FLAG_MALLOC = 2,
+  GST_REGISTRY_CHUNK_FLAG_PLUGIN = 4,
+  GST_REGISTRY_CHUNK_FLAG_FEATURE = 8,
 };
 
 /*
@@ -53,15 +58,27 @@ typedef struct _GstRegistryChunk
 typedef struct _GstRegistryChunkGlobalHeader
 {
   guint32  filter_env_hash;
+  guint32  n_dirs;
 } GstRegistryChunkGlobalHeader;
 
+/*
+ * GstRegistryChunkDirectory:
+ *
+ * Fingerprint of a scanned plugin directory, followed by its path.
+ */
+typedef struct _GstRegistryChunkDirectory
+{
+  gulong mtime;
+  guint n_entries;
+} GstRegistryChunkDirectory;
+
 /*
  * GstRegistryChunkPluginElement:
  *
  * @n_deps: Says how many dependency structures follows.
  *
  * @nfeatures: says how many binary plugin feature structures we will have
- * right after the structure itself.
+ * right after the dependencies.
  *
  * A structure containing (staticely) every information needed for a plugin
  */
@@ -165,6 +182,47 @@ typedef struct _GstRegistryChunkPadTemplate
   GstPadPresence presence;
 } GstRegistryChunkPadTemplate;
 
+/*
+ * GstRegistryChunkIndex:
+ * @n_plugins: the number of plugin offsets following the structure
+ * @n_features: the number of #GstRegistryChunkIndexEntry structures
+ * following the plugin offsets, sorted by feature name
+ *
+ * The index at the end of the registry cache. All offsets are relative to
+ * the start of the file. The feature names follow the entries.
+ */
+typedef struct _GstRegistryChunkIndex
+{
+  guint32 n_plugins;
+  guint32 n_features;
+} GstRegistryChunkIndex;
+
+/*
+ * GstRegistryChunkIndexEntry:
+ * @name: offset of the feature name, relative to the start of the index
+ * @offset: offset of the first chunk of the feature
+ * @plugin: position of the feature's plugin in the plugin offsets
+ */
+typedef struct _GstRegistryChunkIndexEntry
+{
+  guint32 name;
+  guint32 offset;
+  guint32 plugin;
+} GstRegistryChunkIndexEntry;
+
+/*
+ * GstRegistryChunkIndexTrailer:
+ * @offset: offset of the #GstRegistryChunkIndex
+ * @size: size of the index, including the feature names
+ *
+ * The last bytes of the registry cache.
+ */
+typedef struct _GstRegistryChunkIndexTrailer
+{
+  guint32 offset;
+  guint32 size;
+} GstRegistryChunkIndexTrailer;
+
 G_BEGIN_DECLS
 
 gboolean
@@ -173,11 +231,16 @@ _priv_gst_registry_chunks_save_plugin (GList ** list, GstRegistry * registry,
 
 gboolean
 _priv_gst_registry_chunks_load_plugin (GstRegistry * registry, gchar ** in,
-    gchar *end, GstPlugin **out_plugin);
+    gchar *end, GBytes * backing, gboolean prelinked, gboolean with_features,
+    GstPlugin **out_plugin);
+
+GstPluginFeature *
+_priv_gst_registry_chunks_load_feature (gchar ** in, gchar *end,
+    GstPlugin * plugin, const gchar * plugin_name, GBytes * backing);
 
 void
 _priv_gst_registry_chunks_save_global_header (GList ** list,
-    GstRegistry * registry, guint32 filter_env_hash);
+    GstRegistry * registry, guint32 filter_env_hash, gboolean save_dirs);
 
 gboolean
 _priv_gst_registry_chunks_load_global_header (GstRegistry * registry,
@@ -94,14 +94,36 @@ typedef struct
   /* owned by parent structure, NULL if no parent */
   gint *parent_refcount;
 
-  GArray *fields;
+  guint fields_len;             /* Number of valid items in fields */
+  guint fields_alloc;           /* Allocated items in fields */
+
+  /* Fields are allocated in arr, in the same allocation as the structure,
+   * until more are needed */
+  GstStructureField *fields;
+
+  /* Indices of the fields sorted by name, only kept for structures with
+   * many fields */
+  guint *sorted;
+
+  /* Data that string values may point into, when created from bytes */
+  GBytes *backing;
+
+  guint arr_alloc;              /* Allocated items in arr */
+  GstStructureField arr[1];
 } GstStructureImpl;
 
-#define GST_STRUCTURE_REFCOUNT(s) (((GstStructureImpl*)(s))->parent_refcount)
-#define GST_STRUCTURE_FIELDS(s) (((GstStructureImpl*)(s))->fields)
+/* number of fields that are allocated with the structure at least */
+#define STRUCTURE_MIN_INLINE_FIELDS 4
+
+/* structures with this many fields look up fields by binary search */
+#define STRUCTURE_SORTED_MIN_FIELDS 16
+
+#define GST_STRUCTURE_IMPL(s) ((GstStructureImpl*)(s))
+#define GST_STRUCTURE_REFCOUNT(s) (GST_STRUCTURE_IMPL(s)->parent_refcount)
+#define GST_STRUCTURE_LEN(s) (GST_STRUCTURE_IMPL(s)->fields_len)
 
 #define GST_STRUCTURE_FIELD(structure, index) \
-    &g_array_index(GST_STRUCTURE_FIELDS(structure), GstStructureField, (index))
+    (&GST_STRUCTURE_IMPL(structure)->fields[(index)])
 
 #define IS_MUTABLE(structure) \
     (!GST_STRUCTURE_REFCOUNT(structure) || \
@@ -139,23 +161,148 @@ _priv_gst_structure_initialize (void)
       "GstStructure debug");
 }
 
+#define STRUCTURE_IMPL_SIZE(n_fields) \
+    (G_STRUCT_OFFSET (GstStructureImpl, arr) + \
+     (n_fields) * sizeof (GstStructureField))
+
 static GstStructure *
 gst_structure_new_id_empty_with_size (GQuark quark, guint prealloc)
 {
   GstStructureImpl *structure;
+  guint n_alloc;
+
+  n_alloc = MAX (prealloc, STRUCTURE_MIN_INLINE_FIELDS);
 
-  structure = g_slice_new (GstStructureImpl);
+  structure = g_slice_alloc (STRUCTURE_IMPL_SIZE (n_alloc));
   ((GstStructure *) structure)->type = _gst_structure_type;
   ((GstStructure *) structure)->name = quark;
   GST_STRUCTURE_REFCOUNT (structure) = NULL;
-  GST_STRUCTURE_FIELDS (structure) =
-      g_array_sized_new (FALSE, FALSE, sizeof (GstStructureField), prealloc);
+
+  structure->fields_len = 0;
+  structure->fields_alloc = n_alloc;
+  structure->fields = structure->arr;
+  structure->sorted = NULL;
+  structure->backing = NULL;
+  structure->arr_alloc = n_alloc;
 
   GST_TRACE ("created structure %p", structure);
 
   return GST_STRUCTURE_CAST (structure);
 }
 
+/* Creates a structure that keeps a reference to @backing until it is freed.
+ * Used by the binary deserializer so that string values can point into the
+ * serialized data instead of being copied. */
+GstStructure *
+_priv_gst_structure_new_backed (GQuark quark, guint prealloc,
+    GBytes * backing)
+{
+  GstStructure *structure;
+
+  structure = gst_structure_new_id_empty_with_size (quark, prealloc);
+  if (backing)
+    GST_STRUCTURE_IMPL (structure)->backing = g_bytes_ref (backing);
+
+  return structure;
+}
+
+static gint
+compare_field_index (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+  GstStructureImpl *structure = user_data;
+  GQuark name_a = structure->fields[*(const guint *) a].name;
+  GQuark name_b = structure->fields[*(const guint *) b].name;
+
+  return name_a < name_b ? -1 : (name_a > name_b ? 1 : 0);
+}
+
+/* Returns the position in the sorted index where a field named @name is or
+ * would be inserted */
+static guint
+gst_structure_sorted_position (GstStructureImpl * structure, GQuark name)
+{
+  guint lo = 0, hi = structure->fields_len, mid;
+
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (structure->fields[structure->sorted[mid]].name < name)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static void
+gst_structure_append_field (GstStructure * s, const GstStructureField * field)
+{
+  GstStructureImpl *structure = GST_STRUCTURE_IMPL (s);
+  guint len = structure->fields_len;
+
+  if (G_UNLIKELY (len == structure->fields_alloc)) {
+    guint n_alloc = structure->fields_alloc * 2;
+
+    if (structure->fields == structure->arr) {
+      structure->fields = g_new (GstStructureField, n_alloc);
+      memcpy (structure->fields, structure->arr,
+          len * sizeof (GstStructureField));
+    } else {
+      structure->fields = g_renew (GstStructureField, structure->fields,
+          n_alloc);
+    }
+    if (structure->sorted)
+      structure->sorted = g_renew (guint, structure->sorted, n_alloc);
+    structure->fields_alloc = n_alloc;
+  }
+
+  structure->fields[len] = *field;
+
+  if (structure->sorted) {
+    guint pos = gst_structure_sorted_position (structure, field->name);
+
+    memmove (&structure->sorted[pos + 1], &structure->sorted[pos],
+        (len - pos) * sizeof (guint));
+    structure->sorted[pos] = len;
+    structure->fields_len++;
+  } else if (++structure->fields_len >= STRUCTURE_SORTED_MIN_FIELDS) {
+    guint i;
+
+    structure->sorted = g_new (guint, structure->fields_alloc);
+    for (i = 0; i < structure->fields_len; i++)
+      structure->sorted[i] = i;
+    g_qsort_with_data (structure->sorted, structure->fields_len,
+        sizeof (guint), compare_field_index, structure);
+  }
+}
+
+/* the value of the field must have been unset */
+static void
+gst_structure_remove_field_index (GstStructure * s, guint index)
+{
+  GstStructureImpl *structure = GST_STRUCTURE_IMPL (s);
+  guint i, pos, len = structure->fields_len;
+
+  if (structure->sorted) {
+    pos = gst_structure_sorted_position (structure,
+        structure->fields[index].name);
+    memmove (&structure->sorted[pos], &structure->sorted[pos + 1],
+        (len - pos - 1) * sizeof (guint));
+    for (i = 0; i < len - 1; i++) {
+      if (structure->sorted[i] > index)
+        structure->sorted[i]--;
+    }
+  }
+
+  memmove (&structure->fields[index], &structure->fields[index + 1],
+      (len - index - 1) * sizeof (GstStructureField));
+  structure->fields_len--;
+
+  if (structure->sorted && structure->fields_len < STRUCTURE_SORTED_MIN_FIELDS) {
+    g_free (structure->sorted);
+    structure->sorted = NULL;
+  }
+}
+
 /**
  * gst_structure_new_id_empty:
  * @quark: name of new structure
@@ -343,7 +490,8 @@ gst_structure_copy (const GstStructure * structure)
 
   g_return_val_if_fail (structure != NULL, NULL);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
+  /* all fields of the copy are in the same allocation */
   new_structure = gst_structure_new_id_empty_with_size (structure->name, len);
 
   for (i = 0; i < len; i++) {
@@ -353,7 +501,7 @@ gst_structure_copy (const GstStructure * structure)
 
     new_field.name = field->name;
     gst_value_init_and_copy (&new_field.value, &field->value);
-    g_array_append_val (GST_STRUCTURE_FIELDS (new_structure), new_field);
+    gst_structure_append_field (new_structure, &new_field);
   }
   GST_CAT_TRACE (GST_CAT_PERFORMANCE, "doing copy %p -> %p",
       structure, new_structure);
@@ -377,7 +525,7 @@ gst_structure_free (GstStructure * structure)
   g_return_if_fail (structure != NULL);
   g_return_if_fail (GST_STRUCTURE_REFCOUNT (structure) == NULL);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
 
@@ -385,13 +533,19 @@ gst_structure_free (GstStructure * structure)
       g_value_unset (&field->value);
     }
   }
-  g_array_free (GST_STRUCTURE_FIELDS (structure), TRUE);
+  if (GST_STRUCTURE_IMPL (structure)->fields !=
+      GST_STRUCTURE_IMPL (structure)->arr)
+    g_free (GST_STRUCTURE_IMPL (structure)->fields);
+  g_free (GST_STRUCTURE_IMPL (structure)->sorted);
+  if (GST_STRUCTURE_IMPL (structure)->backing)
+    g_bytes_unref (GST_STRUCTURE_IMPL (structure)->backing);
+  len = GST_STRUCTURE_IMPL (structure)->arr_alloc;
 #ifdef USE_POISONING
   memset (structure, 0xff, sizeof (GstStructure));
 #endif
   GST_TRACE ("free structure %p", structure);
 
-  g_slice_free1 (sizeof (GstStructureImpl), structure);
+  g_slice_free1 (STRUCTURE_IMPL_SIZE (len), structure);
 }
 
 /**
@@ -799,9 +953,6 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 {
   GstStructureField *f;
   GType field_value_type;
-  guint i, len;
-
-  len = GST_STRUCTURE_FIELDS (structure)->len;
 
   field_value_type = G_VALUE_TYPE (&field->value);
   if (field_value_type == G_TYPE_STRING) {
@@ -852,17 +1003,14 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
     }
   }
 
-  for (i = 0; i < len; i++) {
-    f = GST_STRUCTURE_FIELD (structure, i);
-
-    if (G_UNLIKELY (f->name == field->name)) {
-      g_value_unset (&f->value);
-      memcpy (f, field, sizeof (GstStructureField));
-      return;
-    }
+  f = gst_structure_id_get_field (structure, field->name);
+  if (G_UNLIKELY (f != NULL)) {
+    g_value_unset (&f->value);
+    memcpy (f, field, sizeof (GstStructureField));
+    return;
   }
 
-  g_array_append_val (GST_STRUCTURE_FIELDS (structure), *field);
+  gst_structure_append_field (structure, field);
 }
 
 /* If there is no field with the given ID, NULL is returned.
@@ -870,10 +1018,18 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 static GstStructureField *
 gst_structure_id_get_field (const GstStructure * structure, GQuark field_id)
 {
+  GstStructureImpl *impl = GST_STRUCTURE_IMPL (structure);
   GstStructureField *field;
   guint i, len;
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = impl->fields_len;
+
+  if (G_UNLIKELY (impl->sorted != NULL)) {
+    i = gst_structure_sorted_position (impl, field_id);
+    if (i < len && impl->fields[impl->sorted[i]].name == field_id)
+      return &impl->fields[impl->sorted[i]];
+    return NULL;
+  }
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -968,7 +1124,7 @@ gst_structure_remove_field (GstStructure * structure, const gchar * fieldname)
   g_return_if_fail (IS_MUTABLE (structure));
 
   id = g_quark_from_string (fieldname);
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -977,8 +1133,7 @@ gst_structure_remove_field (GstStructure * structure, const gchar * fieldname)
       if (G_IS_VALUE (&field->value)) {
         g_value_unset (&field->value);
       }
-      GST_STRUCTURE_FIELDS (structure) =
-          g_array_remove_index (GST_STRUCTURE_FIELDS (structure), i);
+      gst_structure_remove_field_index (structure, i);
       return;
     }
   }
@@ -1047,14 +1202,13 @@ gst_structure_remove_all_fields (GstStructure * structure)
   g_return_if_fail (structure != NULL);
   g_return_if_fail (IS_MUTABLE (structure));
 
-  for (i = GST_STRUCTURE_FIELDS (structure)->len - 1; i >= 0; i--) {
+  for (i = GST_STRUCTURE_LEN (structure) - 1; i >= 0; i--) {
     field = GST_STRUCTURE_FIELD (structure, i);
 
     if (G_IS_VALUE (&field->value)) {
       g_value_unset (&field->value);
     }
-    GST_STRUCTURE_FIELDS (structure) =
-        g_array_remove_index (GST_STRUCTURE_FIELDS (structure), i);
+    gst_structure_remove_field_index (structure, i);
   }
 }
 
@@ -1098,7 +1252,7 @@ gst_structure_n_fields (const GstStructure * structure)
 {
   g_return_val_if_fail (structure != NULL, 0);
 
-  return GST_STRUCTURE_FIELDS (structure)->len;
+  return GST_STRUCTURE_LEN (structure);
 }
 
 /**
@@ -1116,7 +1270,7 @@ gst_structure_nth_field_name (const GstStructure * structure, guint index)
   GstStructureField *field;
 
   g_return_val_if_fail (structure != NULL, NULL);
-  g_return_val_if_fail (index < GST_STRUCTURE_FIELDS (structure)->len, NULL);
+  g_return_val_if_fail (index < GST_STRUCTURE_LEN (structure), NULL);
 
   field = GST_STRUCTURE_FIELD (structure, index);
 
@@ -1147,7 +1301,7 @@ gst_structure_foreach (const GstStructure * structure,
   g_return_val_if_fail (structure != NULL, FALSE);
   g_return_val_if_fail (func != NULL, FALSE);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -1184,7 +1338,7 @@ gst_structure_map_in_place (GstStructure * structure,
   g_return_val_if_fail (structure != NULL, FALSE);
   g_return_val_if_fail (IS_MUTABLE (structure), FALSE);
   g_return_val_if_fail (func != NULL, FALSE);
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -1222,7 +1376,7 @@ gst_structure_filter_and_map_in_place (GstStructure * structure,
   g_return_if_fail (structure != NULL);
   g_return_if_fail (IS_MUTABLE (structure));
   g_return_if_fail (func != NULL);
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len;) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -1233,9 +1387,8 @@ gst_structure_filter_and_map_in_place (GstStructure * structure,
       if (G_IS_VALUE (&field->value)) {
         g_value_unset (&field->value);
       }
-      GST_STRUCTURE_FIELDS (structure) =
-          g_array_remove_index (GST_STRUCTURE_FIELDS (structure), i);
-      len = GST_STRUCTURE_FIELDS (structure)->len;
+      gst_structure_remove_field_index (structure, i);
+      len = GST_STRUCTURE_LEN (structure);
     } else {
       i++;
     }
@@ -1823,7 +1976,7 @@ priv_gst_structure_append_to_gstring (const GstStructure * structure,
 
   g_return_val_if_fail (s != NULL, FALSE);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
   for (i = 0; i < len; i++) {
     char *t;
     GType type;
@@ -2825,8 +2978,8 @@ gst_structure_is_equal (const GstStructure * structure1,
   if (structure1->name != structure2->name) {
     return FALSE;
   }
-  if (GST_STRUCTURE_FIELDS (structure1)->len !=
-      GST_STRUCTURE_FIELDS (structure2)->len) {
+  if (GST_STRUCTURE_LEN (structure1) !=
+      GST_STRUCTURE_LEN (structure2)) {
     return FALSE;
   }
 
@@ -2895,8 +3048,10 @@ gst_structure_intersect (const GstStructure * struct1,
     return NULL;
 
   /* copy fields from struct1 which we have not in struct2 to target
-   * intersect if we have the field in both */
-  data.dest = gst_structure_new_id_empty (struct1->name);
+   * intersect if we have the field in both. The result has at most the
+   * fields of both, allocate them with the structure. */
+  data.dest = gst_structure_new_id_empty_with_size (struct1->name,
+      GST_STRUCTURE_LEN (struct1) + GST_STRUCTURE_LEN (struct2));
   data.intersect = struct2;
   if (G_UNLIKELY (!gst_structure_foreach ((GstStructure *) struct1,
               gst_structure_intersect_field1, &data)))
@@ -2923,6 +3078,11 @@ gst_caps_structure_can_intersect_field (GQuark id, const GValue * val1,
   const GValue *val2 = gst_structure_id_get_value (other, id);
 
   if (G_LIKELY (val2)) {
+    gint res = _priv_gst_value_intersect_fast (NULL, val1, val2);
+
+    if (G_LIKELY (res >= 0))
+      return res;
+
     if (!gst_value_can_intersect (val1, val2)) {
       return FALSE;
     } else {
@@ -2978,6 +3138,10 @@ gst_caps_structure_is_superset_field (GQuark field_id, const GValue * value,
     /* field is missing in the subset => no subset */
     return FALSE;
 
+  comparison = _priv_gst_value_is_subset_fast (other, value);
+  if (G_LIKELY (comparison >= 0))
+    return comparison;
+
   comparison = gst_value_compare (value, other);
 
   /* equal values are subset */
@@ -331,6 +331,12 @@ gchar *               gst_structure_to_string    (const GstStructure * structure
 GST_API
 GstStructure *        gst_structure_from_string  (const gchar * string,
                                                   gchar      ** end) G_GNUC_MALLOC;
+GST_API
+GBytes *              gst_structure_to_bytes     (const GstStructure * structure) G_GNUC_MALLOC;
+
+GST_API
+GstStructure *        gst_structure_new_from_bytes (GBytes * bytes) G_GNUC_MALLOC;
+
 GST_API
 gboolean              gst_structure_fixate_field_nearest_int      (GstStructure * structure,
                                                                    const char   * field_name,
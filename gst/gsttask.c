@@ -69,6 +69,7 @@
 
 #include "gst_private.h"
 
+#include "gsterror.h"
 #include "gstinfo.h"
 #include "gsttask.h"
 #include "glib-compat-private.h"
@@ -385,6 +386,23 @@ gst_task_cleanup_all (void)
   _priv_gst_element_cleanup ();
 }
 
+/* used by gstpipeline.c to start the threads of its tasks on the process wide
+ * default pool */
+GstTaskPool *
+priv_gst_task_get_default_pool (void)
+{
+  GstTaskClass *klass;
+  GstTaskPool *pool;
+
+  klass = g_type_class_ref (GST_TYPE_TASK);
+  g_mutex_lock (&pool_lock);
+  pool = gst_object_ref (klass->pool);
+  g_mutex_unlock (&pool_lock);
+  g_type_class_unref (klass);
+
+  return pool;
+}
+
 /**
  * gst_task_new:
  * @func: The #GstTaskFunction to use
@@ -650,8 +668,20 @@ start_task (GstTask * task)
       task, &error);
 
   if (error != NULL) {
-    g_warning ("failed to create thread: %s", error->message);
+    /* pools report a refusal to start the task, like an exceeded thread
+     * quota, as a core error and post it themselves */
+    if (error->domain == GST_CORE_ERROR)
+      GST_WARNING_OBJECT (task, "failed to start task: %s", error->message);
+    else
+      g_warning ("failed to create thread: %s", error->message);
     g_error_free (error);
+    /* the pool did not start the task, undo the above so that the task can
+     * still be stopped and joined */
+    task->running = FALSE;
+    gst_object_unref (priv->pool_id);
+    priv->pool_id = NULL;
+    priv->id = NULL;
+    gst_object_unref (task);
     res = FALSE;
   }
   return res;
@@ -79,6 +79,11 @@ typedef enum /*< skip >*/
   GST_TRACER_QUARK_HOOK_MINI_OBJECT_UNREFFED,
   GST_TRACER_QUARK_HOOK_OBJECT_REFFED,
   GST_TRACER_QUARK_HOOK_OBJECT_UNREFFED,
+  GST_TRACER_QUARK_HOOK_PAD_QUERY_CAPS_CACHE,
+  GST_TRACER_QUARK_HOOK_CAPS_INTERSECT_PRE,
+  GST_TRACER_QUARK_HOOK_CAPS_INTERSECT_POST,
+  GST_TRACER_QUARK_HOOK_CAPS_FIXATE_PRE,
+  GST_TRACER_QUARK_HOOK_CAPS_FIXATE_POST,
   GST_TRACER_QUARK_MAX
 } GstTracerQuarkId;
 
@@ -694,6 +699,97 @@ typedef void (*GstTracerHookObjectDestroyed) (GObject *self, GstClockTime ts,
     GstTracerHookObjectDestroyed, (GST_TRACER_ARGS, object)); \
 }G_STMT_END
 
+/**
+ * GstTracerHookPadQueryCapsCache:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @pad: the pad
+ * @query: the caps query
+ * @hit: %TRUE if the result was taken from the cache of @pad
+ *
+ * Hook for caps queries on pads with %GST_PAD_FLAG_CACHE_CAPS named
+ * "pad-query-caps-cache".
+ *
+ * Since: 1.16
+ */
+typedef void (*GstTracerHookPadQueryCapsCache) (GObject *self, GstClockTime ts,
+    GstPad *pad, GstQuery *query, gboolean hit);
+#define GST_TRACER_PAD_QUERY_CAPS_CACHE(pad, query, hit) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_PAD_QUERY_CAPS_CACHE), \
+    GstTracerHookPadQueryCapsCache, (GST_TRACER_ARGS, pad, query, hit)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookCapsIntersectPre:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @caps1: the first caps
+ * @caps2: the second caps
+ *
+ * Pre-hook for gst_caps_intersect_full() named "caps-intersect-pre".
+ *
+ * Since: 1.16
+ */
+typedef void (*GstTracerHookCapsIntersectPre) (GObject *self, GstClockTime ts,
+    GstCaps *caps1, GstCaps *caps2);
+#define GST_TRACER_CAPS_INTERSECT_PRE(caps1, caps2) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_CAPS_INTERSECT_PRE), \
+    GstTracerHookCapsIntersectPre, (GST_TRACER_ARGS, caps1, caps2)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookCapsIntersectPost:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @caps1: the first caps
+ * @caps2: the second caps
+ * @res: the intersection
+ *
+ * Post-hook for gst_caps_intersect_full() named "caps-intersect-post".
+ *
+ * Since: 1.16
+ */
+typedef void (*GstTracerHookCapsIntersectPost) (GObject *self, GstClockTime ts,
+    GstCaps *caps1, GstCaps *caps2, GstCaps *res);
+#define GST_TRACER_CAPS_INTERSECT_POST(caps1, caps2, res) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_CAPS_INTERSECT_POST), \
+    GstTracerHookCapsIntersectPost, (GST_TRACER_ARGS, caps1, caps2, res)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookCapsFixatePre:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @caps: the caps to fixate
+ *
+ * Pre-hook for gst_caps_fixate() named "caps-fixate-pre".
+ *
+ * Since: 1.16
+ */
+typedef void (*GstTracerHookCapsFixatePre) (GObject *self, GstClockTime ts,
+    GstCaps *caps);
+#define GST_TRACER_CAPS_FIXATE_PRE(caps) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_CAPS_FIXATE_PRE), \
+    GstTracerHookCapsFixatePre, (GST_TRACER_ARGS, caps)); \
+}G_STMT_END
+
+/**
+ * GstTracerHookCapsFixatePost:
+ * @self: the tracer instance
+ * @ts: the current timestamp
+ * @res: the fixated caps
+ *
+ * Post-hook for gst_caps_fixate() named "caps-fixate-post".
+ *
+ * Since: 1.16
+ */
+typedef void (*GstTracerHookCapsFixatePost) (GObject *self, GstClockTime ts,
+    GstCaps *res);
+#define GST_TRACER_CAPS_FIXATE_POST(res) G_STMT_START{ \
+  GST_TRACER_DISPATCH(GST_TRACER_QUARK(HOOK_CAPS_FIXATE_POST), \
+    GstTracerHookCapsFixatePost, (GST_TRACER_ARGS, res)); \
+}G_STMT_END
+
 
 #else /* !GST_DISABLE_GST_TRACER_HOOKS */
 
@@ -718,6 +814,11 @@ _priv_gst_tracing_deinit (void)
 #define GST_TRACER_PAD_PUSH_EVENT_POST(pad, res)
 #define GST_TRACER_PAD_QUERY_PRE(pad, query)
 #define GST_TRACER_PAD_QUERY_POST(pad, query, res)
+#define GST_TRACER_PAD_QUERY_CAPS_CACHE(pad, query, hit)
+#define GST_TRACER_CAPS_INTERSECT_PRE(caps1, caps2)
+#define GST_TRACER_CAPS_INTERSECT_POST(caps1, caps2, res)
+#define GST_TRACER_CAPS_FIXATE_PRE(caps)
+#define GST_TRACER_CAPS_FIXATE_POST(res)
 #define GST_TRACER_ELEMENT_POST_MESSAGE_PRE(element, message)
 #define GST_TRACER_ELEMENT_POST_MESSAGE_POST(element, res)
 #define GST_TRACER_ELEMENT_QUERY_PRE(element, query)
@@ -1328,58 +1328,22 @@ static gboolean
 gst_element_factory_can_accept_all_caps_in_direction (GstElementFactory *
     factory, const GstCaps * caps, GstPadDirection direction)
 {
-  GList *templates;
-
   g_return_val_if_fail (factory != NULL, FALSE);
   g_return_val_if_fail (caps != NULL, FALSE);
 
-  templates = factory->staticpadtemplates;
-
-  while (templates) {
-    GstStaticPadTemplate *template = (GstStaticPadTemplate *) templates->data;
-
-    if (template->direction == direction) {
-      GstCaps *templcaps = gst_static_caps_get (&template->static_caps);
-
-      if (gst_caps_is_always_compatible (caps, templcaps)) {
-        gst_caps_unref (templcaps);
-        return TRUE;
-      }
-      gst_caps_unref (templcaps);
-    }
-    templates = g_list_next (templates);
-  }
-
-  return FALSE;
+  return _priv_gst_element_factory_can_accept_caps (factory, caps, direction,
+      TRUE);
 }
 
 static gboolean
 gst_element_factory_can_accept_any_caps_in_direction (GstElementFactory *
     factory, const GstCaps * caps, GstPadDirection direction)
 {
-  GList *templates;
-
   g_return_val_if_fail (factory != NULL, FALSE);
   g_return_val_if_fail (caps != NULL, FALSE);
 
-  templates = factory->staticpadtemplates;
-
-  while (templates) {
-    GstStaticPadTemplate *template = (GstStaticPadTemplate *) templates->data;
-
-    if (template->direction == direction) {
-      GstCaps *templcaps = gst_static_caps_get (&template->static_caps);
-
-      if (gst_caps_can_intersect (caps, templcaps)) {
-        gst_caps_unref (templcaps);
-        return TRUE;
-      }
-      gst_caps_unref (templcaps);
-    }
-    templates = g_list_next (templates);
-  }
-
-  return FALSE;
+  return _priv_gst_element_factory_can_accept_caps (factory, caps, direction,
+      FALSE);
 }
 
 /**
@@ -96,6 +96,8 @@ static void gst_value_register_intersect_func (GType type1,
 static void gst_value_register_subtract_func (GType minuend_type,
     GType subtrahend_type, GstValueSubtractFunc func);
 
+static gboolean gst_value_deserialize_int_helper (gint64 * to,
+    const gchar * s, gint64 min, gint64 max, gint size);
 static gboolean _priv_gst_value_parse_list (gchar * s, gchar ** after,
     GValue * value, GType type);
 static gboolean _priv_gst_value_parse_array (gchar * s, gchar ** after,
@@ -163,6 +165,8 @@ static gchar *gst_value_serialize_fraction (const GValue * value);
 static GstValueCompareFunc gst_value_get_compare_func (const GValue * value1);
 static gint gst_value_compare_with_func (const GValue * value1,
     const GValue * value2, GstValueCompareFunc compare);
+static gint gst_value_compare_fraction (const GValue * value1,
+    const GValue * value2);
 
 static gchar *gst_string_wrap (const gchar * s);
 static gchar *gst_string_unwrap (const gchar * s);
@@ -373,6 +377,23 @@ gst_value_init_list_or_array (GValue * value)
   value->data[0].v_pointer = g_array_new (FALSE, TRUE, sizeof (GValue));
 }
 
+/* like gst_value_init_and_copy(), but interned static strings, as
+ * created when parsing typed lists, are shared instead of duplicated */
+static inline void
+gst_value_init_and_copy_element (GValue * dest, const GValue * src)
+{
+  if (G_VALUE_TYPE (src) == G_TYPE_STRING
+      && (src->data[1].v_uint & G_VALUE_NOCOPY_CONTENTS)
+      && src->data[0].v_pointer != NULL
+      && g_quark_to_string (g_quark_try_string (src->data[0].v_pointer)) ==
+      src->data[0].v_pointer) {
+    g_value_init (dest, G_TYPE_STRING);
+    g_value_set_static_string (dest, src->data[0].v_pointer);
+  } else {
+    gst_value_init_and_copy (dest, src);
+  }
+}
+
 static GArray *
 copy_garray_of_gstvalue (const GArray * src)
 {
@@ -383,7 +404,7 @@ copy_garray_of_gstvalue (const GArray * src)
   dest = g_array_sized_new (FALSE, TRUE, sizeof (GValue), len);
   g_array_set_size (dest, len);
   for (i = 0; i < len; i++) {
-    gst_value_init_and_copy (&g_array_index (dest, GValue, i),
+    gst_value_init_and_copy_element (&g_array_index (dest, GValue, i),
         &g_array_index (src, GValue, i));
   }
 
@@ -2424,6 +2445,62 @@ _priv_gst_value_parse_range (gchar * s, gchar ** after, GValue * value,
   return TRUE;
 }
 
+/* Fast path for the elements of typed lists such as
+ * "(string){ I420, YV12, NV12 }" or "(int){ 1, 2, 4 }". Plain unquoted
+ * strings are interned and stored as static strings so that parsing and
+ * copying such lists does not allocate per element. Returns %FALSE without
+ * consuming any input if the element needs the generic parser. */
+static gboolean
+_priv_gst_value_parse_list_element_fast (gchar * s, gchar ** after,
+    GValue * value, GType type)
+{
+  gchar *end;
+  gchar c;
+
+  if (type != G_TYPE_STRING && type != G_TYPE_INT)
+    return FALSE;
+
+  switch (*s) {
+    case '(':
+    case '[':
+    case '{':
+    case '<':
+    case '"':
+      return FALSE;
+    default:
+      break;
+  }
+
+  if (G_UNLIKELY (!_priv_gst_value_parse_simple_string (s, &end)))
+    return FALSE;
+
+  c = *end;
+  *end = '\0';
+
+  if (type == G_TYPE_STRING) {
+    if (G_UNLIKELY (strcmp (s, "NULL") == 0)) {
+      *end = c;
+      return FALSE;
+    }
+    g_value_init (value, G_TYPE_STRING);
+    g_value_set_static_string (value, g_intern_string (s));
+  } else {
+    gint64 x;
+
+    if (!gst_value_deserialize_int_helper (&x, s, G_MININT, G_MAXINT,
+            sizeof (gint))) {
+      *end = c;
+      return FALSE;
+    }
+    g_value_init (value, G_TYPE_INT);
+    g_value_set_int (value, x);
+  }
+
+  *end = c;
+  *after = end;
+  return TRUE;
+}
+
 static gboolean
 _priv_gst_value_parse_any_list (gchar * s, gchar ** after, GValue * value,
     GType type, char begin, char end)
@@ -2446,9 +2523,11 @@ _priv_gst_value_parse_any_list (gchar * s, gchar ** after, GValue * value,
     return TRUE;
   }
 
-  ret = _priv_gst_value_parse_value (s, &s, &list_value, type);
-  if (!ret)
-    return FALSE;
+  if (!_priv_gst_value_parse_list_element_fast (s, &s, &list_value, type)) {
+    ret = _priv_gst_value_parse_value (s, &s, &list_value, type);
+    if (!ret)
+      return FALSE;
+  }
 
   g_array_append_val (array, list_value);
 
@@ -2464,9 +2543,11 @@ _priv_gst_value_parse_any_list (gchar * s, gchar ** after, GValue * value,
       s++;
 
     memset (&list_value, 0, sizeof (list_value));
-    ret = _priv_gst_value_parse_value (s, &s, &list_value, type);
-    if (!ret)
-      return FALSE;
+    if (!_priv_gst_value_parse_list_element_fast (s, &s, &list_value, type)) {
+      ret = _priv_gst_value_parse_value (s, &s, &list_value, type);
+      if (!ret)
+        return FALSE;
+    }
 
     g_array_append_val (array, list_value);
     while (g_ascii_isspace (*s))
@@ -4119,6 +4200,136 @@ gst_value_is_subset_structure_structure (const GValue * value1,
   return gst_structure_is_subset (s1, s2);
 }
 
+/* Lists of strings, like format lists, are intersected and compared
+ * through sorted arrays of their strings instead of by comparing every
+ * element of one list with every element of the other one. The lists
+ * themselves keep their order, which is a preference order in caps. */
+#define STRING_LIST_MIN_PAIRS 64
+#define STRING_LIST_STACK_SIZE 128
+
+static gint
+gst_value_compare_string_ptrs (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  const gchar *s1 = *(const gchar * const *) a;
+  const gchar *s2 = *(const gchar * const *) b;
+
+  /* interned strings are equal if the pointers are */
+  if (s1 == s2)
+    return 0;
+  return strcmp (s1, s2);
+}
+
+static gboolean
+gst_value_list_holds_strings (const GValue * list)
+{
+  guint i, size = VALUE_LIST_SIZE (list);
+
+  for (i = 0; i < size; i++) {
+    const GValue *v = VALUE_LIST_GET_VALUE (list, i);
+
+    if (G_VALUE_TYPE (v) != G_TYPE_STRING || v->data[0].v_pointer == NULL)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* Stores the sorted strings of @list, which must only hold non-NULL
+ * strings, in @strings, and returns the number of distinct strings if
+ * @dedup, or the size of the list otherwise */
+static guint
+gst_value_list_sort_strings (const GValue * list, const gchar ** strings,
+    gboolean dedup)
+{
+  guint i, n, size = VALUE_LIST_SIZE (list);
+
+  for (i = 0; i < size; i++)
+    strings[i] = VALUE_LIST_GET_VALUE (list, i)->data[0].v_pointer;
+
+  g_qsort_with_data (strings, size, sizeof (const gchar *),
+      gst_value_compare_string_ptrs, NULL);
+
+  if (!dedup || size == 0)
+    return size;
+
+  for (i = 1, n = 1; i < size; i++) {
+    if (gst_value_compare_string_ptrs (&strings[n - 1], &strings[i],
+            NULL) != 0)
+      strings[n++] = strings[i];
+  }
+  return n;
+}
+
+static gboolean
+gst_value_sorted_strings_contain (const gchar ** strings, guint n,
+    const gchar * str)
+{
+  guint lo = 0, hi = n;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    gint cmp = gst_value_compare_string_ptrs (&str, &strings[mid], NULL);
+
+    if (cmp == 0)
+      return TRUE;
+    if (cmp < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return FALSE;
+}
+
+/* Returns whether the string list @value1 is a strict subset of the string
+ * list @value2 with a linear merge of both sorted lists, or -1 if the
+ * lists are not lists of strings or too small to bother. */
+static gint
+gst_value_is_subset_string_list (const GValue * value1, const GValue * value2)
+{
+  const gchar *stack[STRING_LIST_STACK_SIZE];
+  const gchar **s1, **s2;
+  guint size1, size2, n1, n2, i, j;
+  gint res;
+
+  size1 = VALUE_LIST_SIZE (value1);
+  size2 = VALUE_LIST_SIZE (value2);
+  if (size1 * size2 < STRING_LIST_MIN_PAIRS)
+    return -1;
+  if (!gst_value_list_holds_strings (value1)
+      || !gst_value_list_holds_strings (value2))
+    return -1;
+
+  if (size1 + size2 <= STRING_LIST_STACK_SIZE)
+    s1 = stack;
+  else
+    s1 = g_new (const gchar *, size1 + size2);
+  s2 = s1 + size1;
+
+  n1 = gst_value_list_sort_strings (value1, s1, TRUE);
+  n2 = gst_value_list_sort_strings (value2, s2, TRUE);
+
+  /* value2 needs to hold all strings of value1 and at least one more */
+  res = n1 < n2;
+  for (i = 0, j = 0; res && i < n1; j++) {
+    gint cmp;
+
+    if (j == n2) {
+      res = FALSE;
+      break;
+    }
+    cmp = gst_value_compare_string_ptrs (&s1[i], &s2[j], NULL);
+    if (cmp < 0)
+      res = FALSE;
+    else if (cmp == 0)
+      i++;
+  }
+
+  if (s1 != stack)
+    g_free (s1);
+
+  return res;
+}
+
 /**
  * gst_value_is_subset:
  * @value1: a #GValue
@@ -4131,6 +4342,12 @@ gst_value_is_subset_structure_structure (const GValue * value1,
 gboolean
 gst_value_is_subset (const GValue * value1, const GValue * value2)
 {
+  gint res;
+
+  res = _priv_gst_value_is_subset_fast (value1, value2);
+  if (G_LIKELY (res >= 0))
+    return res;
+
   /* special case for int/int64 ranges, since we cannot compute
      the difference for those when they have different steps,
      and it's actually a lot simpler to compute whether a range
@@ -4146,6 +4363,10 @@ gst_value_is_subset (const GValue * value1, const GValue * value2)
   } else if (GST_VALUE_HOLDS_STRUCTURE (value1)
       && GST_VALUE_HOLDS_STRUCTURE (value2)) {
     return gst_value_is_subset_structure_structure (value1, value2);
+  } else if (GST_VALUE_HOLDS_LIST (value1) && GST_VALUE_HOLDS_LIST (value2)) {
+    res = gst_value_is_subset_string_list (value1, value2);
+    if (res >= 0)
+      return res;
   }
 
   /*
@@ -4590,38 +4811,73 @@ gst_value_intersect_list (GValue * dest, const GValue * value1,
   guint i, size;
   GValue intersection = { 0, };
   gboolean ret = FALSE;
+  const gchar *stack[STRING_LIST_STACK_SIZE];
+  const gchar **sorted = NULL;
+  guint n_sorted = 0;
 
   size = VALUE_LIST_SIZE (value1);
+
+  /* look up the strings of value1 in the sorted strings of value2. This
+   * only gives the same result as intersecting element by element if
+   * value2 has no duplicates */
+  if (GST_VALUE_HOLDS_LIST (value2)
+      && size * VALUE_LIST_SIZE (value2) >= STRING_LIST_MIN_PAIRS
+      && gst_value_list_holds_strings (value1)
+      && gst_value_list_holds_strings (value2)) {
+    guint size2 = VALUE_LIST_SIZE (value2);
+
+    sorted = size2 <= STRING_LIST_STACK_SIZE ? stack :
+        g_new (const gchar *, size2);
+    n_sorted = gst_value_list_sort_strings (value2, sorted, TRUE);
+    if (n_sorted != size2) {
+      if (sorted != stack)
+        g_free (sorted);
+      sorted = NULL;
+    }
+  }
+
   for (i = 0; i < size; i++) {
     const GValue *cur = VALUE_LIST_GET_VALUE (value1, i);
 
-    /* quicker version when we don't need the resulting set */
-    if (!dest) {
+    if (sorted) {
+      if (!gst_value_sorted_strings_contain (sorted, n_sorted,
+              cur->data[0].v_pointer))
+        continue;
+      if (!dest) {
+        ret = TRUE;
+        break;
+      }
+      gst_value_init_and_copy_element (&intersection, cur);
+    } else if (!dest) {
+      /* quicker version when we don't need the resulting set */
       if (gst_value_intersect (NULL, cur, value2)) {
         ret = TRUE;
         break;
       }
       continue;
+    } else if (!gst_value_intersect (&intersection, cur, value2)) {
+      continue;
     }
 
-    if (gst_value_intersect (&intersection, cur, value2)) {
-      /* append value */
-      if (!ret) {
-        gst_value_move (dest, &intersection);
-        ret = TRUE;
-      } else if (GST_VALUE_HOLDS_LIST (dest)) {
-        _gst_value_list_append_and_take_value (dest, &intersection);
-      } else {
-        GValue temp;
+    /* append value */
+    if (!ret) {
+      gst_value_move (dest, &intersection);
+      ret = TRUE;
+    } else if (GST_VALUE_HOLDS_LIST (dest)) {
+      _gst_value_list_append_and_take_value (dest, &intersection);
+    } else {
+      GValue temp;
 
-        gst_value_move (&temp, dest);
-        gst_value_list_merge (dest, &temp, &intersection);
-        g_value_unset (&temp);
-        g_value_unset (&intersection);
-      }
+      gst_value_move (&temp, dest);
+      gst_value_list_merge (dest, &temp, &intersection);
+      g_value_unset (&temp);
+      g_value_unset (&intersection);
     }
   }
 
+  if (sorted && sorted != stack)
+    g_free (sorted);
+
   return ret;
 }
 
@@ -4669,23 +4925,20 @@ gst_value_intersect_fraction_fraction_range (GValue * dest, const GValue * src1,
 {
   gint res1, res2;
   GValue *vals;
-  GstValueCompareFunc compare;
 
   vals = src2->data[0].v_pointer;
 
   if (vals == NULL)
     return FALSE;
 
-  if ((compare = gst_value_get_compare_func (src1))) {
-    res1 = gst_value_compare_with_func (&vals[0], src1, compare);
-    res2 = gst_value_compare_with_func (&vals[1], src1, compare);
+  res1 = gst_value_compare_fraction (&vals[0], src1);
+  res2 = gst_value_compare_fraction (&vals[1], src1);
 
-    if ((res1 == GST_VALUE_EQUAL || res1 == GST_VALUE_LESS_THAN) &&
-        (res2 == GST_VALUE_EQUAL || res2 == GST_VALUE_GREATER_THAN)) {
-      if (dest)
-        gst_value_init_and_copy (dest, src1);
-      return TRUE;
-    }
+  if ((res1 == GST_VALUE_EQUAL || res1 == GST_VALUE_LESS_THAN) &&
+      (res2 == GST_VALUE_EQUAL || res2 == GST_VALUE_GREATER_THAN)) {
+    if (dest)
+      gst_value_init_and_copy (dest, src1);
+    return TRUE;
   }
 
   return FALSE;
@@ -5787,6 +6040,59 @@ gst_value_can_intersect (const GValue * value1, const GValue * value2)
   return gst_value_can_compare_unchecked (value1, value2);
 }
 
+/* Intersects the scalar and range types that make up nearly all fixed and
+ * template caps, without looking up compare and intersect functions.
+ * Returns -1 if there is no fast path for the types of the values. */
+gint
+_priv_gst_value_intersect_fast (GValue * dest, const GValue * value1,
+    const GValue * value2)
+{
+  GType type1 = G_VALUE_TYPE (value1);
+  GType type2 = G_VALUE_TYPE (value2);
+  gboolean res;
+
+  if (type1 == type2) {
+    if (type1 == G_TYPE_INT)
+      res = value1->data[0].v_int == value2->data[0].v_int;
+    else if (type1 == G_TYPE_STRING)
+      res = gst_value_compare_string (value1, value2) == GST_VALUE_EQUAL;
+    else if (type1 == GST_TYPE_FRACTION)
+      res = gst_value_compare_fraction (value1, value2) == GST_VALUE_EQUAL;
+    else if (type1 == G_TYPE_BOOLEAN)
+      res = gst_value_compare_boolean (value1, value2) == GST_VALUE_EQUAL;
+    else
+      return -1;
+
+    if (res && dest)
+      gst_value_init_and_copy (dest, value1);
+    return res;
+  }
+
+  if (type1 == G_TYPE_INT && type2 == GST_TYPE_INT_RANGE)
+    return gst_value_intersect_int_int_range (dest, value1, value2);
+  if (type1 == GST_TYPE_INT_RANGE && type2 == G_TYPE_INT)
+    return gst_value_intersect_int_int_range (dest, value2, value1);
+  if (type1 == GST_TYPE_FRACTION && type2 == GST_TYPE_FRACTION_RANGE)
+    return gst_value_intersect_fraction_fraction_range (dest, value1, value2);
+  if (type1 == GST_TYPE_FRACTION_RANGE && type2 == GST_TYPE_FRACTION)
+    return gst_value_intersect_fraction_fraction_range (dest, value2, value1);
+
+  return -1;
+}
+
+/* Checks if @value1 is a subset of @value2 for the same types as
+ * _priv_gst_value_intersect_fast(), returns -1 for other types. */
+gint
+_priv_gst_value_is_subset_fast (const GValue * value1, const GValue * value2)
+{
+  /* a scalar is a subset if it intersects */
+  if (G_VALUE_TYPE (value1) == GST_TYPE_INT_RANGE ||
+      G_VALUE_TYPE (value1) == GST_TYPE_FRACTION_RANGE)
+    return -1;
+
+  return _priv_gst_value_intersect_fast (NULL, value1, value2);
+}
+
 /**
  * gst_value_intersect:
  * @dest: (out caller-allocates) (transfer full) (allow-none):
@@ -5810,10 +6116,15 @@ gst_value_intersect (GValue * dest, const GValue * value1,
   GstValueIntersectInfo *intersect_info;
   guint i, len;
   GType type1, type2;
+  gint res;
 
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
   g_return_val_if_fail (G_IS_VALUE (value2), FALSE);
 
+  res = _priv_gst_value_intersect_fast (dest, value1, value2);
+  if (G_LIKELY (res >= 0))
+    return res;
+
   type1 = G_VALUE_TYPE (value1);
   type2 = G_VALUE_TYPE (value2);
 
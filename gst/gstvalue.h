@@ -481,6 +481,12 @@ gchar *         gst_value_serialize             (const GValue          *value) G
 GST_API
 gboolean        gst_value_deserialize           (GValue                *dest,
                                                  const gchar           *src);
+GST_API
+GBytes *        gst_value_to_bytes              (const GValue          *value) G_GNUC_MALLOC;
+
+GST_API
+gboolean        gst_value_init_from_bytes       (GValue                *value,
+                                                 GBytes                *bytes);
 
 /* list */
 
@@ -0,0 +1,1279 @@
+/* GStreamer
+ * Copyright (C) 2018 GStreamer developers
+ *
+ * gstvaluebinary.c: binary serialization of values, structures and caps
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The binary format is a header made of a 4 byte magic, a version byte and a
+ * byte giving the kind of the payload, followed by the payload itself.
+ *
+ * Unsigned integers are written as LEB128 varints, signed integers are zigzag
+ * encoded first. Floating point numbers are written as little endian IEEE 754
+ * values. Strings are written as their length, their bytes and a terminating
+ * NUL byte, so that they can be used in place when reading.
+ *
+ * Each value starts with a tag byte giving its type. Types that have no
+ * binary representation of their own are stored with their type name and
+ * their gst_value_serialize() string. Enums, flags and flag sets are stored
+ * with their type name too and can only be read if that type is registered.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gst_private.h"
+#include <gst/gst.h>
+
+#define GST_CAT_DEFAULT GST_CAT_CAPS
+
+#define BINARY_MAGIC "GSTb"
+#define BINARY_MAGIC_LEN 4
+#define BINARY_VERSION 1
+#define BINARY_HEADER_LEN (BINARY_MAGIC_LEN + 2)
+
+/* limit for nested lists, structures and caps when reading */
+#define BINARY_MAX_DEPTH 64
+
+typedef enum
+{
+  KIND_VALUE = 'V',
+  KIND_STRUCTURE = 'S',
+  KIND_CAPS = 'C',
+  KIND_CAPS_FEATURES = 'F'
+} BinaryKind;
+
+typedef enum
+{
+  TAG_BOOLEAN = 1,
+  TAG_INT,
+  TAG_UINT,
+  TAG_INT64,
+  TAG_UINT64,
+  TAG_FLOAT,
+  TAG_DOUBLE,
+  TAG_STRING,
+  TAG_NULL_STRING,
+  TAG_FRACTION,
+  TAG_INT_RANGE,
+  TAG_INT64_RANGE,
+  TAG_DOUBLE_RANGE,
+  TAG_FRACTION_RANGE,
+  TAG_BITMASK,
+  TAG_FLAG_SET,
+  TAG_LIST,
+  TAG_ARRAY,
+  TAG_STRUCTURE,
+  TAG_CAPS,
+  TAG_CAPS_FEATURES,
+  TAG_ENUM,
+  TAG_FLAGS,
+  TAG_SERIALIZED
+} BinaryTag;
+
+/* how caps features are stored */
+enum
+{
+  FEATURES_DEFAULT = 0,         /* empty, or system memory inside caps */
+  FEATURES_ANY,
+  FEATURES_LIST
+};
+
+/* caps flags */
+#define CAPS_BINARY_ANY (1 << 0)
+
+static gboolean write_value (GByteArray * out, const GValue * value);
+static gboolean write_structure (GByteArray * out,
+    const GstStructure * structure);
+static gboolean write_caps (GByteArray * out, const GstCaps * caps);
+
+/* writing */
+
+static inline void
+write_byte (GByteArray * out, guint8 v)
+{
+  g_byte_array_append (out, &v, 1);
+}
+
+static void
+write_uint (GByteArray * out, guint64 v)
+{
+  guint8 buf[10];
+  guint n = 0;
+
+  do {
+    buf[n] = v & 0x7f;
+    v >>= 7;
+    if (v)
+      buf[n] |= 0x80;
+    n++;
+  } while (v);
+
+  g_byte_array_append (out, buf, n);
+}
+
+static inline void
+write_int (GByteArray * out, gint64 v)
+{
+  write_uint (out, ((guint64) v << 1) ^ (guint64) (v >> 63));
+}
+
+static void
+write_double (GByteArray * out, gdouble v)
+{
+  union
+  {
+    gdouble d;
+    guint64 i;
+  } u;
+
+  u.d = v;
+  u.i = GUINT64_TO_LE (u.i);
+  g_byte_array_append (out, (const guint8 *) &u.i, 8);
+}
+
+static void
+write_float (GByteArray * out, gfloat v)
+{
+  union
+  {
+    gfloat f;
+    guint32 i;
+  } u;
+
+  u.f = v;
+  u.i = GUINT32_TO_LE (u.i);
+  g_byte_array_append (out, (const guint8 *) &u.i, 4);
+}
+
+static void
+write_string (GByteArray * out, const gchar * str)
+{
+  gsize len = strlen (str);
+
+  write_uint (out, len);
+  g_byte_array_append (out, (const guint8 *) str, len + 1);
+}
+
+static void
+write_header (GByteArray * out, BinaryKind kind)
+{
+  g_byte_array_append (out, (const guint8 *) BINARY_MAGIC, BINARY_MAGIC_LEN);
+  write_byte (out, BINARY_VERSION);
+  write_byte (out, kind);
+}
+
+static void
+write_caps_features (GByteArray * out, const GstCapsFeatures * features,
+    gboolean in_caps)
+{
+  guint i, n;
+
+  if (gst_caps_features_is_any (features)) {
+    write_byte (out, FEATURES_ANY);
+    return;
+  }
+
+  n = gst_caps_features_get_size (features);
+  if (n == 0 || (in_caps && gst_caps_features_is_equal (features,
+              GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY))) {
+    write_byte (out, FEATURES_DEFAULT);
+    return;
+  }
+
+  write_byte (out, FEATURES_LIST);
+  write_uint (out, n);
+  for (i = 0; i < n; i++)
+    write_string (out, gst_caps_features_get_nth (features, i));
+}
+
+static gboolean
+write_list (GByteArray * out, const GValue * value)
+{
+  guint i, n;
+
+  if (GST_VALUE_HOLDS_LIST (value)) {
+    write_byte (out, TAG_LIST);
+    n = gst_value_list_get_size (value);
+    write_uint (out, n);
+    for (i = 0; i < n; i++) {
+      if (!write_value (out, gst_value_list_get_value (value, i)))
+        return FALSE;
+    }
+  } else {
+    write_byte (out, TAG_ARRAY);
+    n = gst_value_array_get_size (value);
+    write_uint (out, n);
+    for (i = 0; i < n; i++) {
+      if (!write_value (out, gst_value_array_get_value (value, i)))
+        return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+static gboolean
+write_value (GByteArray * out, const GValue * value)
+{
+  GType type = G_VALUE_TYPE (value);
+
+  if (type == G_TYPE_INT) {
+    write_byte (out, TAG_INT);
+    write_int (out, g_value_get_int (value));
+  } else if (type == G_TYPE_STRING) {
+    const gchar *str = g_value_get_string (value);
+
+    if (str) {
+      write_byte (out, TAG_STRING);
+      write_string (out, str);
+    } else {
+      write_byte (out, TAG_NULL_STRING);
+    }
+  } else if (type == GST_TYPE_FRACTION) {
+    write_byte (out, TAG_FRACTION);
+    write_int (out, gst_value_get_fraction_numerator (value));
+    write_int (out, gst_value_get_fraction_denominator (value));
+  } else if (type == GST_TYPE_INT_RANGE) {
+    write_byte (out, TAG_INT_RANGE);
+    write_int (out, gst_value_get_int_range_min (value));
+    write_int (out, gst_value_get_int_range_max (value));
+    write_int (out, gst_value_get_int_range_step (value));
+  } else if (type == GST_TYPE_FRACTION_RANGE) {
+    const GValue *min = gst_value_get_fraction_range_min (value);
+    const GValue *max = gst_value_get_fraction_range_max (value);
+
+    write_byte (out, TAG_FRACTION_RANGE);
+    write_int (out, gst_value_get_fraction_numerator (min));
+    write_int (out, gst_value_get_fraction_denominator (min));
+    write_int (out, gst_value_get_fraction_numerator (max));
+    write_int (out, gst_value_get_fraction_denominator (max));
+  } else if (type == GST_TYPE_LIST || type == GST_TYPE_ARRAY) {
+    return write_list (out, value);
+  } else if (type == G_TYPE_BOOLEAN) {
+    write_byte (out, TAG_BOOLEAN);
+    write_byte (out, g_value_get_boolean (value) ? 1 : 0);
+  } else if (type == G_TYPE_UINT) {
+    write_byte (out, TAG_UINT);
+    write_uint (out, g_value_get_uint (value));
+  } else if (type == G_TYPE_INT64) {
+    write_byte (out, TAG_INT64);
+    write_int (out, g_value_get_int64 (value));
+  } else if (type == G_TYPE_UINT64) {
+    write_byte (out, TAG_UINT64);
+    write_uint (out, g_value_get_uint64 (value));
+  } else if (type == G_TYPE_FLOAT) {
+    write_byte (out, TAG_FLOAT);
+    write_float (out, g_value_get_float (value));
+  } else if (type == G_TYPE_DOUBLE) {
+    write_byte (out, TAG_DOUBLE);
+    write_double (out, g_value_get_double (value));
+  } else if (type == GST_TYPE_INT64_RANGE) {
+    write_byte (out, TAG_INT64_RANGE);
+    write_int (out, gst_value_get_int64_range_min (value));
+    write_int (out, gst_value_get_int64_range_max (value));
+    write_int (out, gst_value_get_int64_range_step (value));
+  } else if (type == GST_TYPE_DOUBLE_RANGE) {
+    write_byte (out, TAG_DOUBLE_RANGE);
+    write_double (out, gst_value_get_double_range_min (value));
+    write_double (out, gst_value_get_double_range_max (value));
+  } else if (type == GST_TYPE_BITMASK) {
+    write_byte (out, TAG_BITMASK);
+    write_uint (out, gst_value_get_bitmask (value));
+  } else if (GST_VALUE_HOLDS_FLAG_SET (value)) {
+    write_byte (out, TAG_FLAG_SET);
+    write_string (out, g_type_name (type));
+    write_uint (out, gst_value_get_flagset_flags (value));
+    write_uint (out, gst_value_get_flagset_mask (value));
+  } else if (type == GST_TYPE_STRUCTURE) {
+    const GstStructure *structure = gst_value_get_structure (value);
+
+    write_byte (out, TAG_STRUCTURE);
+    write_byte (out, structure != NULL);
+    if (structure)
+      return write_structure (out, structure);
+  } else if (type == GST_TYPE_CAPS) {
+    const GstCaps *caps = gst_value_get_caps (value);
+
+    write_byte (out, TAG_CAPS);
+    write_byte (out, caps != NULL);
+    if (caps)
+      return write_caps (out, caps);
+  } else if (type == GST_TYPE_CAPS_FEATURES) {
+    const GstCapsFeatures *features = gst_value_get_caps_features (value);
+
+    write_byte (out, TAG_CAPS_FEATURES);
+    write_byte (out, features != NULL);
+    if (features)
+      write_caps_features (out, features, FALSE);
+  } else if (G_TYPE_IS_ENUM (type)) {
+    write_byte (out, TAG_ENUM);
+    write_string (out, g_type_name (type));
+    write_int (out, g_value_get_enum (value));
+  } else if (G_TYPE_IS_FLAGS (type)) {
+    write_byte (out, TAG_FLAGS);
+    write_string (out, g_type_name (type));
+    write_uint (out, g_value_get_flags (value));
+  } else {
+    gchar *str;
+
+    str = gst_value_serialize (value);
+    if (str == NULL)
+      goto not_serializable;
+
+    write_byte (out, TAG_SERIALIZED);
+    write_string (out, g_type_name (type));
+    write_string (out, str);
+    g_free (str);
+  }
+
+  return TRUE;
+
+  /* ERRORS */
+not_serializable:
+  {
+    GST_WARNING ("cannot serialize value of type %s", g_type_name (type));
+    return FALSE;
+  }
+}
+
+static gboolean
+write_field (GQuark field_id, const GValue * value, gpointer user_data)
+{
+  GByteArray *out = user_data;
+
+  write_string (out, g_quark_to_string (field_id));
+  return write_value (out, value);
+}
+
+static gboolean
+write_structure (GByteArray * out, const GstStructure * structure)
+{
+  write_string (out, gst_structure_get_name (structure));
+  write_uint (out, gst_structure_n_fields (structure));
+
+  return gst_structure_foreach (structure, write_field, out);
+}
+
+static gboolean
+write_caps (GByteArray * out, const GstCaps * caps)
+{
+  guint i, n;
+
+  if (gst_caps_is_any (caps)) {
+    write_byte (out, CAPS_BINARY_ANY);
+    return TRUE;
+  }
+
+  write_byte (out, 0);
+  n = gst_caps_get_size (caps);
+  write_uint (out, n);
+  for (i = 0; i < n; i++) {
+    if (!write_structure (out, gst_caps_get_structure (caps, i)))
+      return FALSE;
+    write_caps_features (out, gst_caps_get_features (caps, i), TRUE);
+  }
+  return TRUE;
+}
+
+static GBytes *
+finish_bytes (GByteArray * out, gboolean res)
+{
+  if (!res) {
+    g_byte_array_unref (out);
+    return NULL;
+  }
+  return g_byte_array_free_to_bytes (out);
+}
+
+/* reading */
+
+typedef struct
+{
+  const guint8 *data;
+  gsize size;
+  gsize pos;
+
+  /* the serialized data, kept alive by the structures that are read */
+  GBytes *bytes;
+
+  /* strings are only used in place when they end up in a structure that
+   * keeps the data alive */
+  guint in_structure;
+  guint depth;
+} BinaryReader;
+
+static gboolean read_value (BinaryReader * r, GValue * value);
+static GstStructure *read_structure (BinaryReader * r);
+static GstCaps *read_caps (BinaryReader * r);
+
+static inline gboolean
+read_byte (BinaryReader * r, guint8 * v)
+{
+  if (G_UNLIKELY (r->pos >= r->size))
+    return FALSE;
+
+  *v = r->data[r->pos++];
+  return TRUE;
+}
+
+static gboolean
+read_uint (BinaryReader * r, guint64 * v)
+{
+  guint64 res = 0;
+  guint shift = 0;
+  guint8 b;
+
+  do {
+    if (G_UNLIKELY (shift >= 64 || r->pos >= r->size))
+      return FALSE;
+
+    b = r->data[r->pos++];
+    res |= (guint64) (b & 0x7f) << shift;
+    shift += 7;
+  } while (b & 0x80);
+
+  *v = res;
+  return TRUE;
+}
+
+static inline gboolean
+read_int (BinaryReader * r, gint64 * v)
+{
+  guint64 u;
+
+  if (!read_uint (r, &u))
+    return FALSE;
+
+  *v = (gint64) ((u >> 1) ^ (~(u & 1) + 1));
+  return TRUE;
+}
+
+static gboolean
+read_int32 (BinaryReader * r, gint * v)
+{
+  gint64 i;
+
+  if (!read_int (r, &i) || i < G_MININT || i > G_MAXINT)
+    return FALSE;
+
+  *v = (gint) i;
+  return TRUE;
+}
+
+static gboolean
+read_uint32 (BinaryReader * r, guint * v)
+{
+  guint64 u;
+
+  if (!read_uint (r, &u) || u > G_MAXUINT)
+    return FALSE;
+
+  *v = (guint) u;
+  return TRUE;
+}
+
+static gboolean
+read_double (BinaryReader * r, gdouble * v)
+{
+  union
+  {
+    gdouble d;
+    guint64 i;
+  } u;
+
+  if (G_UNLIKELY (r->size - r->pos < 8))
+    return FALSE;
+
+  memcpy (&u.i, r->data + r->pos, 8);
+  r->pos += 8;
+  u.i = GUINT64_FROM_LE (u.i);
+  *v = u.d;
+  return TRUE;
+}
+
+static gboolean
+read_float (BinaryReader * r, gfloat * v)
+{
+  union
+  {
+    gfloat f;
+    guint32 i;
+  } u;
+
+  if (G_UNLIKELY (r->size - r->pos < 4))
+    return FALSE;
+
+  memcpy (&u.i, r->data + r->pos, 4);
+  r->pos += 4;
+  u.i = GUINT32_FROM_LE (u.i);
+  *v = u.f;
+  return TRUE;
+}
+
+/* Returns a pointer to the NUL terminated string in the data */
+static gboolean
+read_string (BinaryReader * r, const gchar ** str)
+{
+  const gchar *s;
+  guint64 len;
+
+  if (!read_uint (r, &len))
+    return FALSE;
+
+  if (G_UNLIKELY (len >= r->size - r->pos))
+    return FALSE;
+
+  s = (const gchar *) r->data + r->pos;
+  if (G_UNLIKELY (s[len] != '\0' || memchr (s, '\0', len) != NULL))
+    return FALSE;
+  if (G_UNLIKELY (!g_utf8_validate (s, len, NULL)))
+    return FALSE;
+
+  r->pos += len + 1;
+  *str = s;
+  return TRUE;
+}
+
+/* every serialized item takes at least one byte, which bounds the number of
+ * items a well formed length can announce */
+static gboolean
+read_length (BinaryReader * r, guint * len)
+{
+  guint64 n;
+
+  if (!read_uint (r, &n) || n > r->size - r->pos)
+    return FALSE;
+
+  *len = (guint) n;
+  return TRUE;
+}
+
+static gboolean
+read_type (BinaryReader * r, GType * type)
+{
+  const gchar *name;
+
+  if (!read_string (r, &name))
+    return FALSE;
+
+  *type = g_type_from_name (name);
+  if (*type == 0) {
+    GST_WARNING ("unknown type %s", name);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean
+caps_feature_name_is_valid (const gchar * feature)
+{
+  const gchar *sep = strchr (feature, ':');
+
+  return sep != NULL && sep != feature && g_ascii_isalpha (sep[1]);
+}
+
+/* Inside caps, the default features are returned as %NULL */
+static gboolean
+read_caps_features (BinaryReader * r, gboolean in_caps,
+    GstCapsFeatures ** features)
+{
+  const gchar *name;
+  guint8 kind;
+  guint i, n;
+
+  if (!read_byte (r, &kind))
+    return FALSE;
+
+  switch (kind) {
+    case FEATURES_DEFAULT:
+      *features = in_caps ? NULL : gst_caps_features_new_empty ();
+      return TRUE;
+    case FEATURES_ANY:
+      *features = gst_caps_features_new_any ();
+      return TRUE;
+    case FEATURES_LIST:
+      if (!read_length (r, &n))
+        return FALSE;
+
+      *features = gst_caps_features_new_empty ();
+      for (i = 0; i < n; i++) {
+        if (!read_string (r, &name) || !caps_feature_name_is_valid (name)) {
+          gst_caps_features_free (*features);
+          *features = NULL;
+          return FALSE;
+        }
+        gst_caps_features_add (*features, name);
+      }
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+static gboolean
+read_list (BinaryReader * r, GValue * value, GType type)
+{
+  GValue v = G_VALUE_INIT;
+  guint i, n;
+
+  if (!read_length (r, &n))
+    return FALSE;
+
+  g_value_init (value, type);
+  for (i = 0; i < n; i++) {
+    if (!read_value (r, &v)) {
+      g_value_unset (value);
+      return FALSE;
+    }
+    if (type == GST_TYPE_LIST)
+      gst_value_list_append_and_take_value (value, &v);
+    else
+      gst_value_array_append_and_take_value (value, &v);
+  }
+  return TRUE;
+}
+
+static gboolean
+read_value_unchecked (BinaryReader * r, GValue * value)
+{
+  GType type;
+  guint8 tag;
+
+  if (!read_byte (r, &tag))
+    return FALSE;
+
+  switch (tag) {
+    case TAG_BOOLEAN:{
+      guint8 b;
+
+      if (!read_byte (r, &b) || b > 1)
+        return FALSE;
+      g_value_init (value, G_TYPE_BOOLEAN);
+      g_value_set_boolean (value, b);
+      break;
+    }
+    case TAG_INT:{
+      gint i;
+
+      if (!read_int32 (r, &i))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT);
+      g_value_set_int (value, i);
+      break;
+    }
+    case TAG_UINT:{
+      guint u;
+
+      if (!read_uint32 (r, &u))
+        return FALSE;
+      g_value_init (value, G_TYPE_UINT);
+      g_value_set_uint (value, u);
+      break;
+    }
+    case TAG_INT64:{
+      gint64 i;
+
+      if (!read_int (r, &i))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT64);
+      g_value_set_int64 (value, i);
+      break;
+    }
+    case TAG_UINT64:{
+      guint64 u;
+
+      if (!read_uint (r, &u))
+        return FALSE;
+      g_value_init (value, G_TYPE_UINT64);
+      g_value_set_uint64 (value, u);
+      break;
+    }
+    case TAG_FLOAT:{
+      gfloat f;
+
+      if (!read_float (r, &f))
+        return FALSE;
+      g_value_init (value, G_TYPE_FLOAT);
+      g_value_set_float (value, f);
+      break;
+    }
+    case TAG_DOUBLE:{
+      gdouble d;
+
+      if (!read_double (r, &d))
+        return FALSE;
+      g_value_init (value, G_TYPE_DOUBLE);
+      g_value_set_double (value, d);
+      break;
+    }
+    case TAG_STRING:{
+      const gchar *str;
+
+      if (!read_string (r, &str))
+        return FALSE;
+      g_value_init (value, G_TYPE_STRING);
+      if (r->in_structure)
+        g_value_set_static_string (value, str);
+      else
+        g_value_set_string (value, str);
+      break;
+    }
+    case TAG_NULL_STRING:
+      g_value_init (value, G_TYPE_STRING);
+      break;
+    case TAG_FRACTION:{
+      gint num, den;
+
+      if (!read_int32 (r, &num) || !read_int32 (r, &den))
+        return FALSE;
+      if (den == 0 || num < -G_MAXINT || den < -G_MAXINT)
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION);
+      gst_value_set_fraction (value, num, den);
+      break;
+    }
+    case TAG_INT_RANGE:{
+      gint min, max, step;
+
+      if (!read_int32 (r, &min) || !read_int32 (r, &max) ||
+          !read_int32 (r, &step))
+        return FALSE;
+      if (min >= max || step <= 0 || min % step != 0 || max % step != 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT_RANGE);
+      gst_value_set_int_range_step (value, min, max, step);
+      break;
+    }
+    case TAG_INT64_RANGE:{
+      gint64 min, max, step;
+
+      if (!read_int (r, &min) || !read_int (r, &max) || !read_int (r, &step))
+        return FALSE;
+      if (min >= max || step <= 0 || min % step != 0 || max % step != 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT64_RANGE);
+      gst_value_set_int64_range_step (value, min, max, step);
+      break;
+    }
+    case TAG_DOUBLE_RANGE:{
+      gdouble min, max;
+
+      if (!read_double (r, &min) || !read_double (r, &max) || !(min < max))
+        return FALSE;
+      g_value_init (value, GST_TYPE_DOUBLE_RANGE);
+      gst_value_set_double_range (value, min, max);
+      break;
+    }
+    case TAG_FRACTION_RANGE:{
+      gint n1, d1, n2, d2;
+
+      if (!read_int32 (r, &n1) || !read_int32 (r, &d1) ||
+          !read_int32 (r, &n2) || !read_int32 (r, &d2))
+        return FALSE;
+      if (d1 == 0 || d2 == 0 || n1 < -G_MAXINT || d1 < -G_MAXINT ||
+          n2 < -G_MAXINT || d2 < -G_MAXINT)
+        return FALSE;
+      if (gst_util_fraction_compare (n1, d1, n2, d2) >= 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION_RANGE);
+      gst_value_set_fraction_range_full (value, n1, d1, n2, d2);
+      break;
+    }
+    case TAG_BITMASK:{
+      guint64 mask;
+
+      if (!read_uint (r, &mask))
+        return FALSE;
+      g_value_init (value, GST_TYPE_BITMASK);
+      gst_value_set_bitmask (value, mask);
+      break;
+    }
+    case TAG_FLAG_SET:{
+      guint flags, mask;
+
+      if (!read_type (r, &type) || !g_type_is_a (type, GST_TYPE_FLAG_SET))
+        return FALSE;
+      if (!read_uint32 (r, &flags) || !read_uint32 (r, &mask))
+        return FALSE;
+      g_value_init (value, type);
+      gst_value_set_flagset (value, flags, mask);
+      break;
+    }
+    case TAG_LIST:
+      return read_list (r, value, GST_TYPE_LIST);
+    case TAG_ARRAY:
+      return read_list (r, value, GST_TYPE_ARRAY);
+    case TAG_STRUCTURE:{
+      GstStructure *structure = NULL;
+      guint8 present;
+
+      if (!read_byte (r, &present) || present > 1)
+        return FALSE;
+      if (present && !(structure = read_structure (r)))
+        return FALSE;
+      g_value_init (value, GST_TYPE_STRUCTURE);
+      g_value_take_boxed (value, structure);
+      break;
+    }
+    case TAG_CAPS:{
+      GstCaps *caps = NULL;
+      guint8 present;
+
+      if (!read_byte (r, &present) || present > 1)
+        return FALSE;
+      if (present && !(caps = read_caps (r)))
+        return FALSE;
+      g_value_init (value, GST_TYPE_CAPS);
+      g_value_take_boxed (value, caps);
+      break;
+    }
+    case TAG_CAPS_FEATURES:{
+      GstCapsFeatures *features = NULL;
+      guint8 present;
+
+      if (!read_byte (r, &present) || present > 1)
+        return FALSE;
+      if (present && !read_caps_features (r, FALSE, &features))
+        return FALSE;
+      g_value_init (value, GST_TYPE_CAPS_FEATURES);
+      g_value_take_boxed (value, features);
+      break;
+    }
+    case TAG_ENUM:{
+      gint v;
+
+      if (!read_type (r, &type) || !G_TYPE_IS_ENUM (type) ||
+          !read_int32 (r, &v))
+        return FALSE;
+      g_value_init (value, type);
+      g_value_set_enum (value, v);
+      break;
+    }
+    case TAG_FLAGS:{
+      guint v;
+
+      if (!read_type (r, &type) || !G_TYPE_IS_FLAGS (type) ||
+          !read_uint32 (r, &v))
+        return FALSE;
+      g_value_init (value, type);
+      g_value_set_flags (value, v);
+      break;
+    }
+    case TAG_SERIALIZED:{
+      const gchar *str;
+
+      if (!read_type (r, &type) || !read_string (r, &str))
+        return FALSE;
+      if (!G_TYPE_IS_VALUE_TYPE (type) || G_TYPE_IS_ABSTRACT (type))
+        return FALSE;
+      g_value_init (value, type);
+      if (!gst_value_deserialize (value, str)) {
+        g_value_unset (value);
+        return FALSE;
+      }
+      break;
+    }
+    default:
+      GST_WARNING ("unknown value tag %u", tag);
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean
+read_value (BinaryReader * r, GValue * value)
+{
+  gboolean res;
+
+  if (G_UNLIKELY (r->depth >= BINARY_MAX_DEPTH)) {
+    GST_WARNING ("values nested too deep");
+    return FALSE;
+  }
+
+  r->depth++;
+  res = read_value_unchecked (r, value);
+  r->depth--;
+
+  return res;
+}
+
+static GstStructure *
+read_structure (BinaryReader * r)
+{
+  GstStructure *structure;
+  const gchar *name;
+  guint i, n;
+
+  if (!read_string (r, &name) || !g_ascii_isalpha (name[0]))
+    return NULL;
+  if (!read_length (r, &n))
+    return NULL;
+
+  structure = _priv_gst_structure_new_backed (g_quark_from_string (name), n,
+      r->bytes);
+
+  r->in_structure++;
+  for (i = 0; i < n; i++) {
+    GValue value = G_VALUE_INIT;
+    const gchar *field;
+
+    if (!read_string (r, &field) || field[0] == '\0')
+      goto error;
+    if (!read_value (r, &value))
+      goto error;
+
+    gst_structure_id_take_value (structure, g_quark_from_string (field),
+        &value);
+  }
+  r->in_structure--;
+
+  return structure;
+
+  /* ERRORS */
+error:
+  {
+    r->in_structure--;
+    gst_structure_free (structure);
+    return NULL;
+  }
+}
+
+static GstCaps *
+read_caps (BinaryReader * r)
+{
+  GstCaps *caps;
+  guint8 flags;
+  guint i, n;
+
+  if (!read_byte (r, &flags))
+    return NULL;
+  if (flags & CAPS_BINARY_ANY)
+    return gst_caps_new_any ();
+  if (!read_length (r, &n))
+    return NULL;
+
+  caps = gst_caps_new_empty ();
+  for (i = 0; i < n; i++) {
+    GstStructure *structure;
+    GstCapsFeatures *features;
+
+    if (!(structure = read_structure (r)))
+      goto error;
+    if (!read_caps_features (r, TRUE, &features)) {
+      gst_structure_free (structure);
+      goto error;
+    }
+    gst_caps_append_structure_full (caps, structure, features);
+  }
+  return caps;
+
+  /* ERRORS */
+error:
+  {
+    gst_caps_unref (caps);
+    return NULL;
+  }
+}
+
+static gboolean
+reader_init (BinaryReader * r, GBytes * bytes, BinaryKind kind)
+{
+  r->data = g_bytes_get_data (bytes, &r->size);
+  r->pos = BINARY_HEADER_LEN;
+  r->bytes = bytes;
+  r->in_structure = 0;
+  r->depth = 0;
+
+  if (r->size < BINARY_HEADER_LEN ||
+      memcmp (r->data, BINARY_MAGIC, BINARY_MAGIC_LEN) != 0)
+    goto wrong_magic;
+  if (r->data[BINARY_MAGIC_LEN] != BINARY_VERSION)
+    goto wrong_version;
+  if (r->data[BINARY_MAGIC_LEN + 1] != kind)
+    goto wrong_kind;
+
+  return TRUE;
+
+  /* ERRORS */
+wrong_magic:
+  {
+    GST_WARNING ("not serialized binary data");
+    return FALSE;
+  }
+wrong_version:
+  {
+    GST_WARNING ("unsupported binary version %u", r->data[BINARY_MAGIC_LEN]);
+    return FALSE;
+  }
+wrong_kind:
+  {
+    GST_WARNING ("binary data holds kind '%c', expected '%c'",
+        r->data[BINARY_MAGIC_LEN + 1], kind);
+    return FALSE;
+  }
+}
+
+/* Checks that all data was consumed */
+static gboolean
+reader_finish (BinaryReader * r)
+{
+  if (r->pos != r->size) {
+    GST_WARNING ("%" G_GSIZE_FORMAT " trailing bytes", r->size - r->pos);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* public API */
+
+/**
+ * gst_value_to_bytes:
+ * @value: a #GValue to serialize
+ *
+ * Serializes @value into a compact binary representation that can be turned
+ * back into an equal #GValue with gst_value_init_from_bytes(), also in
+ * another process. This is a lot faster than gst_value_serialize() and
+ * gst_value_deserialize().
+ *
+ * Values of types without a binary representation of their own are stored
+ * in their gst_value_serialize() form.
+ *
+ * Returns: (transfer full) (nullable): the serialized value, or %NULL if the
+ *     value cannot be serialized.
+ *
+ * Since: 1.16
+ */
+GBytes *
+gst_value_to_bytes (const GValue * value)
+{
+  GByteArray *out;
+
+  g_return_val_if_fail (G_IS_VALUE (value), NULL);
+
+  out = g_byte_array_new ();
+  write_header (out, KIND_VALUE);
+
+  return finish_bytes (out, write_value (out, value));
+}
+
+/**
+ * gst_value_init_from_bytes:
+ * @value: (out caller-allocates): an uninitialized #GValue
+ * @bytes: data created with gst_value_to_bytes()
+ *
+ * Initializes @value with the type and contents serialized in @bytes.
+ *
+ * Returns: %TRUE if @value was initialized, %FALSE if @bytes are not a valid
+ *     serialized value or use a type that is not registered.
+ *
+ * Since: 1.16
+ */
+gboolean
+gst_value_init_from_bytes (GValue * value, GBytes * bytes)
+{
+  BinaryReader r;
+
+  g_return_val_if_fail (value != NULL, FALSE);
+  g_return_val_if_fail (G_VALUE_TYPE (value) == 0, FALSE);
+  g_return_val_if_fail (bytes != NULL, FALSE);
+
+  if (!reader_init (&r, bytes, KIND_VALUE))
+    return FALSE;
+  if (!read_value (&r, value))
+    return FALSE;
+  if (!reader_finish (&r)) {
+    g_value_unset (value);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * gst_structure_to_bytes:
+ * @structure: a #GstStructure
+ *
+ * Serializes @structure into a compact binary representation, see
+ * gst_value_to_bytes().
+ *
+ * Returns: (transfer full) (nullable): the serialized structure, or %NULL if
+ *     one of its values cannot be serialized.
+ *
+ * Since: 1.16
+ */
+GBytes *
+gst_structure_to_bytes (const GstStructure * structure)
+{
+  GByteArray *out;
+
+  g_return_val_if_fail (structure != NULL, NULL);
+
+  out = g_byte_array_new ();
+  write_header (out, KIND_STRUCTURE);
+
+  return finish_bytes (out, write_structure (out, structure));
+}
+
+/**
+ * gst_structure_new_from_bytes:
+ * @bytes: data created with gst_structure_to_bytes()
+ *
+ * Creates a #GstStructure from its binary serialization.
+ *
+ * String values of the new structure are not copied but point into @bytes,
+ * of which the structure keeps a reference until it is freed.
+ *
+ * Free-function: gst_structure_free
+ *
+ * Returns: (transfer full) (nullable): a new #GstStructure, or %NULL if @bytes
+ *     are not a valid serialized structure.
+ *
+ * Since: 1.16
+ */
+GstStructure *
+gst_structure_new_from_bytes (GBytes * bytes)
+{
+  GstStructure *structure;
+  BinaryReader r;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  if (!reader_init (&r, bytes, KIND_STRUCTURE))
+    return NULL;
+  if (!(structure = read_structure (&r)))
+    return NULL;
+  if (!reader_finish (&r)) {
+    gst_structure_free (structure);
+    return NULL;
+  }
+  return structure;
+}
+
+/**
+ * gst_caps_to_bytes:
+ * @caps: a #GstCaps
+ *
+ * Serializes @caps into a compact binary representation, see
+ * gst_value_to_bytes(). Unlike gst_caps_to_string() this keeps the
+ * #GstCapsFeatures of all structures.
+ *
+ * Returns: (transfer full) (nullable): the serialized caps, or %NULL if one of
+ *     their values cannot be serialized.
+ *
+ * Since: 1.16
+ */
+GBytes *
+gst_caps_to_bytes (const GstCaps * caps)
+{
+  GByteArray *out;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
+
+  out = g_byte_array_new ();
+  write_header (out, KIND_CAPS);
+
+  return finish_bytes (out, write_caps (out, caps));
+}
+
+/**
+ * gst_caps_new_from_bytes:
+ * @bytes: data created with gst_caps_to_bytes()
+ *
+ * Creates a #GstCaps from its binary serialization. As with
+ * gst_structure_new_from_bytes(), string values are not copied.
+ *
+ * Returns: (transfer full) (nullable): a new #GstCaps, or %NULL if @bytes are
+ *     not valid serialized caps.
+ *
+ * Since: 1.16
+ */
+GstCaps *
+gst_caps_new_from_bytes (GBytes * bytes)
+{
+  GstCaps *caps;
+  BinaryReader r;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  if (!reader_init (&r, bytes, KIND_CAPS))
+    return NULL;
+  if (!(caps = read_caps (&r)))
+    return NULL;
+  if (!reader_finish (&r)) {
+    gst_caps_unref (caps);
+    return NULL;
+  }
+  return caps;
+}
+
+/**
+ * gst_caps_features_to_bytes:
+ * @features: a #GstCapsFeatures
+ *
+ * Serializes @features into a compact binary representation.
+ *
+ * Returns: (transfer full): the serialized caps features.
+ *
+ * Since: 1.16
+ */
+GBytes *
+gst_caps_features_to_bytes (const GstCapsFeatures * features)
+{
+  GByteArray *out;
+
+  g_return_val_if_fail (features != NULL, NULL);
+
+  out = g_byte_array_new ();
+  write_header (out, KIND_CAPS_FEATURES);
+  write_caps_features (out, features, FALSE);
+
+  return g_byte_array_free_to_bytes (out);
+}
+
+/**
+ * gst_caps_features_new_from_bytes:
+ * @bytes: data created with gst_caps_features_to_bytes()
+ *
+ * Creates a #GstCapsFeatures from its binary serialization.
+ *
+ * Free-function: gst_caps_features_free
+ *
+ * Returns: (transfer full) (nullable): a new #GstCapsFeatures, or %NULL if
+ *     @bytes are not valid serialized caps features.
+ *
+ * Since: 1.16
+ */
+GstCapsFeatures *
+gst_caps_features_new_from_bytes (GBytes * bytes)
+{
+  GstCapsFeatures *features;
+  BinaryReader r;
+
+  g_return_val_if_fail (bytes != NULL, NULL);
+
+  if (!reader_init (&r, bytes, KIND_CAPS_FEATURES))
+    return NULL;
+  if (!read_caps_features (&r, FALSE, &features))
+    return NULL;
+  if (!reader_finish (&r)) {
+    gst_caps_features_free (features);
+    return NULL;
+  }
+  return features;
+}
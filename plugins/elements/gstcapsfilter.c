@@ -165,6 +165,10 @@ gst_capsfilter_init (GstCapsFilter * filter)
   GstBaseTransform *trans = GST_BASE_TRANSFORM (filter);
   gst_base_transform_set_gap_aware (trans, TRUE);
   gst_base_transform_set_prefer_passthrough (trans, FALSE);
+  /* the caps query result only depends on the filter caps, which cause a
+   * reconfigure when changed, and on the peers */
+  GST_PAD_SET_CACHE_CAPS (GST_BASE_TRANSFORM_SINK_PAD (trans));
+  GST_PAD_SET_CACHE_CAPS (GST_BASE_TRANSFORM_SRC_PAD (trans));
   filter->filter_caps = gst_caps_new_any ();
   filter->filter_caps_used = FALSE;
   filter->got_sink_caps = FALSE;
@@ -216,17 +220,23 @@ gst_capsfilter_set_property (GObject * object, guint prop_id,
     }
     case PROP_CAPS_CHANGE_MODE:{
       GstCapsFilterCapsChangeMode old_change_mode;
+      gboolean changed;
 
       GST_OBJECT_LOCK (capsfilter);
       old_change_mode = capsfilter->caps_change_mode;
       capsfilter->caps_change_mode = g_value_get_enum (value);
 
-      if (capsfilter->caps_change_mode != old_change_mode) {
+      changed = capsfilter->caps_change_mode != old_change_mode;
+      if (changed) {
         g_list_free_full (capsfilter->previous_caps,
             (GDestroyNotify) gst_caps_unref);
         capsfilter->previous_caps = NULL;
       }
       GST_OBJECT_UNLOCK (capsfilter);
+
+      /* the previous caps are not accepted anymore */
+      if (changed)
+        gst_base_transform_reconfigure_sink (GST_BASE_TRANSFORM (object));
       break;
     }
     default:
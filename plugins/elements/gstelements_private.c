@@ -25,13 +25,23 @@
 #ifdef HAVE_CONFIG_H
 # include "config.h"
 #endif
+
+/* for copy_file_range() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 #include <stdio.h>
+#include <sys/types.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
 #ifdef HAVE_SYS_UIO_H
 #include <sys/uio.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #include <errno.h>
 #include <string.h>
 #include <string.h>
@@ -41,6 +51,7 @@
 #ifdef G_OS_WIN32
 #  define WIN32_LEAN_AND_MEAN   /* prevents from including too many things */
 #  include <windows.h>
+#  include <io.h>                 /* dup, close */
 #  undef WIN32_LEAN_AND_MEAN
 #  ifndef EWOULDBLOCK
 #  define EWOULDBLOCK EAGAIN
@@ -350,3 +361,256 @@ write_error:
     goto out;
   }
 }
+
+/* fd range memory */
+
+struct _GstFdHandle
+{
+  gint refcount;
+  gint fd;
+};
+
+typedef struct
+{
+  GstMemory mem;
+
+  GstFdHandle *handle;
+  guint64 fd_offset;            /* file offset of the start of maxsize */
+
+  GMutex lock;
+  guint8 *data;                 /* contents, read on first map */
+} GstFdRangeMemory;
+
+typedef struct
+{
+  GstAllocator parent;
+} GstFdRangeAllocator;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} GstFdRangeAllocatorClass;
+
+static GType gst_fd_range_allocator_get_type (void);
+G_DEFINE_TYPE (GstFdRangeAllocator, gst_fd_range_allocator,
+    GST_TYPE_ALLOCATOR);
+
+/* Returns a handle on a duplicate of @fd, so that memory referencing it stays
+ * valid when the element is done with @fd. */
+GstFdHandle *
+gst_fd_handle_new (gint fd)
+{
+  GstFdHandle *handle;
+  gint dup_fd;
+
+  dup_fd = dup (fd);
+  if (dup_fd < 0)
+    return NULL;
+
+  handle = g_slice_new (GstFdHandle);
+  handle->refcount = 1;
+  handle->fd = dup_fd;
+
+  return handle;
+}
+
+GstFdHandle *
+gst_fd_handle_ref (GstFdHandle * handle)
+{
+  g_atomic_int_inc (&handle->refcount);
+
+  return handle;
+}
+
+void
+gst_fd_handle_unref (GstFdHandle * handle)
+{
+  if (g_atomic_int_dec_and_test (&handle->refcount)) {
+    close (handle->fd);
+    g_slice_free (GstFdHandle, handle);
+  }
+}
+
+/* Returns memory referencing @size bytes at @offset of the file behind
+ * @handle. The file must stay at least that large while the memory is
+ * used. */
+GstMemory *
+gst_fd_range_memory_new (GstFdHandle * handle, guint64 offset, gsize size)
+{
+  static GstAllocator *allocator;
+  GstFdRangeMemory *mem;
+
+  if (g_once_init_enter (&allocator)) {
+    GstAllocator *alloc;
+
+    alloc = g_object_new (gst_fd_range_allocator_get_type (), NULL);
+    gst_object_ref_sink (alloc);
+    GST_OBJECT_FLAG_SET (alloc, GST_OBJECT_FLAG_MAY_BE_LEAKED);
+    g_once_init_leave (&allocator, alloc);
+  }
+
+  mem = g_slice_new0 (GstFdRangeMemory);
+  gst_memory_init (GST_MEMORY_CAST (mem), GST_MEMORY_FLAG_READONLY, allocator,
+      NULL, size, 0, 0, size);
+  mem->handle = gst_fd_handle_ref (handle);
+  mem->fd_offset = offset;
+  g_mutex_init (&mem->lock);
+
+  return GST_MEMORY_CAST (mem);
+}
+
+gboolean
+gst_is_fd_range_memory (GstMemory * mem)
+{
+  return gst_memory_is_type (mem, GST_FD_RANGE_MEMORY_TYPE);
+}
+
+static gpointer
+gst_fd_range_mem_map (GstFdRangeMemory * mem, gsize maxsize,
+    GstMapFlags flags)
+{
+  guint8 *data;
+
+  g_mutex_lock (&mem->lock);
+  if (mem->data == NULL) {
+    gsize done = 0;
+    gssize ret;
+
+    data = g_malloc (maxsize);
+    while (done < maxsize) {
+#ifdef G_OS_UNIX
+      ret = pread (mem->handle->fd, data + done, maxsize - done,
+          (off_t) (mem->fd_offset + done));
+#else
+      errno = ENOSYS;
+      ret = -1;
+#endif
+      if (ret < 0 && errno == EINTR)
+        continue;
+      if (ret <= 0)
+        break;
+      done += ret;
+    }
+
+    if (done < maxsize) {
+      GST_WARNING ("could only read %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT
+          " bytes from fd %d: %s", done, maxsize, mem->handle->fd,
+          g_strerror (errno));
+      g_free (data);
+    } else {
+      mem->data = data;
+    }
+  }
+  data = mem->data;
+  g_mutex_unlock (&mem->lock);
+
+  return data;
+}
+
+static void
+gst_fd_range_mem_unmap (GstFdRangeMemory * mem)
+{
+}
+
+static GstFdRangeMemory *
+gst_fd_range_mem_share (GstFdRangeMemory * mem, gssize offset, gssize size)
+{
+  if (size == -1)
+    size = mem->mem.size - offset;
+
+  /* the shared memory only references its own range, which it reads when it
+   * is mapped */
+  return (GstFdRangeMemory *) gst_fd_range_memory_new (mem->handle,
+      mem->fd_offset + mem->mem.offset + offset, size);
+}
+
+static void
+gst_fd_range_allocator_free (GstAllocator * allocator, GstMemory * gmem)
+{
+  GstFdRangeMemory *mem = (GstFdRangeMemory *) gmem;
+
+  g_free (mem->data);
+  g_mutex_clear (&mem->lock);
+  gst_fd_handle_unref (mem->handle);
+  g_slice_free (GstFdRangeMemory, mem);
+}
+
+static void
+gst_fd_range_allocator_class_init (GstFdRangeAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = NULL;
+  allocator_class->free = gst_fd_range_allocator_free;
+}
+
+static void
+gst_fd_range_allocator_init (GstFdRangeAllocator * allocator)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (allocator);
+
+  alloc->mem_type = GST_FD_RANGE_MEMORY_TYPE;
+  alloc->mem_map = (GstMemoryMapFunction) gst_fd_range_mem_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) gst_fd_range_mem_unmap;
+  alloc->mem_share = (GstMemoryShareFunction) gst_fd_range_mem_share;
+
+  GST_OBJECT_FLAG_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+#if defined (HAVE_COPY_FILE_RANGE) || defined (HAVE_SYS_SENDFILE_H)
+static gboolean
+gst_fd_range_copy_unsupported (gint err)
+{
+  return err == ENOSYS || err == EINVAL || err == EXDEV || err == EOPNOTSUPP;
+}
+#endif
+
+/* Copies the contents of fd range memory @mem, starting @skip bytes into
+ * it, to the current position of @fd without going through user space.
+ * Returns the number of bytes a single copy call transferred, or -1 with
+ * errno set. errno is ENOSYS if the kernel can't copy between the two file
+ * descriptors and the data has to be mapped and written instead. */
+gssize
+gst_fd_range_memory_copy_to_fd (GstMemory * gmem, gsize skip, gint fd)
+{
+#if defined (HAVE_COPY_FILE_RANGE) || defined (HAVE_SYS_SENDFILE_H)
+  GstFdRangeMemory *mem = (GstFdRangeMemory *) gmem;
+  guint64 offset = mem->fd_offset + gmem->offset + skip;
+  gsize len = gmem->size - skip;
+  gssize ret;
+#endif
+
+#ifdef HAVE_COPY_FILE_RANGE
+  {
+    off_t in_off = offset;
+
+    /* file to file, possibly with reflinks or server-side copies */
+    ret = copy_file_range (mem->handle->fd, &in_off, fd, NULL, len, 0);
+    if (ret >= 0 || !(gst_fd_range_copy_unsupported (errno) || errno == EBADF))
+      goto done;
+  }
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+  {
+    off_t in_off = offset;
+
+    /* file to anything, including pipes and sockets */
+    ret = sendfile (fd, mem->handle->fd, &in_off, len);
+    if (ret >= 0 || !gst_fd_range_copy_unsupported (errno))
+      goto done;
+  }
+#endif
+
+  errno = ENOSYS;
+  return -1;
+
+#if defined (HAVE_COPY_FILE_RANGE) || defined (HAVE_SYS_SENDFILE_H)
+done:
+  if (ret == 0 && len > 0) {
+    /* the file got shorter than the memory */
+    errno = EIO;
+    return -1;
+  }
+  return ret;
+#endif
+}
@@ -39,6 +39,32 @@ GstFlowReturn  gst_writev_buffers (GstObject * sink, gint fd, GstPoll * fdset,
                                    guint8 * mem_nums, guint total_mem_num,
                                    guint64 * bytes_written, guint64 skip);
 
+/* Memory referencing a byte range of a file descriptor. Sinks can copy it
+ * inside the kernel, mapping it reads the range into memory. */
+#define GST_FD_RANGE_MEMORY_TYPE "FdRange"
+
+typedef struct _GstFdHandle GstFdHandle;
+
+G_GNUC_INTERNAL
+GstFdHandle *  gst_fd_handle_new (gint fd);
+
+G_GNUC_INTERNAL
+GstFdHandle *  gst_fd_handle_ref (GstFdHandle * handle);
+
+G_GNUC_INTERNAL
+void           gst_fd_handle_unref (GstFdHandle * handle);
+
+G_GNUC_INTERNAL
+GstMemory *    gst_fd_range_memory_new (GstFdHandle * handle, guint64 offset,
+                                        gsize size);
+
+G_GNUC_INTERNAL
+gboolean       gst_is_fd_range_memory (GstMemory * mem);
+
+G_GNUC_INTERNAL
+gssize         gst_fd_range_memory_copy_to_fd (GstMemory * mem, gsize skip,
+                                               gint fd);
+
 G_END_DECLS
 
 #endif /* __GST_ELEMENTS_PRIVATE_H__ */
@@ -238,6 +238,81 @@ gst_fd_sink_query (GstBaseSink * bsink, GstQuery * query)
   return res;
 }
 
+static gboolean
+gst_fd_sink_all_fd_ranges (GstBuffer ** buffers, guint num_buffers,
+    guint8 * mem_nums)
+{
+  guint i, j;
+
+  for (i = 0; i < num_buffers; ++i) {
+    for (j = 0; j < mem_nums[i]; ++j) {
+      if (!gst_is_fd_range_memory (gst_buffer_peek_memory (buffers[i], j)))
+        return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/* Copies buffers that only reference ranges of other file descriptors inside
+ * the kernel. Returns GST_FLOW_NOT_SUPPORTED with the number of bytes that
+ * were copied in @copied if the remainder needs to be written normally. */
+static GstFlowReturn
+gst_fd_sink_copy_fd_ranges (GstFdSink * sink, GstBuffer ** buffers,
+    guint num_buffers, guint8 * mem_nums, guint64 * copied)
+{
+  guint i, j;
+
+  for (i = 0; i < num_buffers; ++i) {
+    for (j = 0; j < mem_nums[i]; ++j) {
+      GstMemory *mem = gst_buffer_peek_memory (buffers[i], j);
+      gsize done = 0;
+
+      while (done < mem->size) {
+        gssize ret;
+
+        ret = gst_fd_range_memory_copy_to_fd (mem, done, sink->fd);
+        if (ret < 0) {
+          if (errno == EINTR)
+            continue;
+          if (errno == ENOSYS || errno == EINVAL || errno == EXDEV) {
+            GST_INFO_OBJECT (sink, "kernel can't copy to fd %d", sink->fd);
+            sink->no_kernel_copy = TRUE;
+            return GST_FLOW_NOT_SUPPORTED;
+          }
+          /* let the normal write path wait for the fd to become writable */
+          if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return GST_FLOW_NOT_SUPPORTED;
+          goto copy_error;
+        }
+
+        done += ret;
+        *copied += ret;
+        sink->bytes_written += ret;
+        sink->current_pos += ret;
+      }
+    }
+  }
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+copy_error:
+  {
+    switch (errno) {
+      case ENOSPC:
+        GST_ELEMENT_ERROR (sink, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
+        break;
+      default:
+        GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+            ("Error while copying to file descriptor %d: %s", sink->fd,
+                g_strerror (errno)));
+        break;
+    }
+    return GST_FLOW_ERROR;
+  }
+}
+
 static GstFlowReturn
 gst_fd_sink_render_buffers (GstFdSink * sink, GstBuffer ** buffers,
     guint num_buffers, guint8 * mem_nums, guint total_mems)
@@ -245,6 +320,15 @@ gst_fd_sink_render_buffers (GstFdSink * sink, GstBuffer ** buffers,
   GstFlowReturn ret;
   guint64 skip = 0;
 
+  if (!sink->no_kernel_copy &&
+      gst_fd_sink_all_fd_ranges (buffers, num_buffers, mem_nums)) {
+    ret = gst_fd_sink_copy_fd_ranges (sink, buffers, num_buffers, mem_nums,
+        &skip);
+    if (ret != GST_FLOW_NOT_SUPPORTED)
+      return ret;
+    /* write the rest with writev() */
+  }
+
   for (;;) {
     guint64 bytes_written = 0;
 
@@ -386,6 +470,7 @@ gst_fd_sink_start (GstBaseSink * basesink)
 
   fdsink->bytes_written = 0;
   fdsink->current_pos = 0;
+  fdsink->no_kernel_copy = FALSE;
 
   fdsink->seekable = gst_fd_sink_do_seek (fdsink, 0);
   GST_INFO_OBJECT (fdsink, "seeking supported: %d", fdsink->seekable);
@@ -467,6 +552,7 @@ gst_fd_sink_update_fd (GstFdSink * fdsink, int new_fd, GError ** error)
     gst_poll_fd_ctl_write (fdsink->fdset, &fd, TRUE);
   }
   fdsink->fd = new_fd;
+  fdsink->no_kernel_copy = FALSE;
   g_free (fdsink->uri);
   fdsink->uri = g_strdup_printf ("fd://%d", fdsink->fd);
 
@@ -63,6 +63,9 @@ struct _GstFdSink {
 
   gboolean seekable;
   gboolean unlock; /* OBJECT LOCK */
+
+  /* the kernel can't copy file ranges to fd */
+  gboolean no_kernel_copy;
 };
 
 struct _GstFdSinkClass {
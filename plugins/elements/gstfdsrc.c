@@ -79,6 +79,7 @@
 #include <errno.h>
 
 #include "gstfdsrc.h"
+#include "gstelements_private.h"
 
 #ifdef __BIONIC__               /* Android */
 #if defined(__ANDROID_API__) && __ANDROID_API__ >= 21
@@ -97,6 +98,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_fd_src_debug);
 
 #define DEFAULT_FD              0
 #define DEFAULT_TIMEOUT         0
+#define DEFAULT_ZERO_COPY       FALSE
 
 enum
 {
@@ -104,6 +106,7 @@ enum
 
   PROP_FD,
   PROP_TIMEOUT,
+  PROP_ZERO_COPY,
 
   PROP_LAST
 };
@@ -164,6 +167,23 @@ gst_fd_src_class_init (GstFdSrcClass * klass)
           G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFdSrc:zero-copy
+   *
+   * For regular files, output buffers that reference ranges of the file
+   * instead of containing the data. Elements that look at the data read it
+   * when mapping the buffer, but sinks such as #GstFdSink can copy the
+   * ranges inside the kernel, so that data relayed from file descriptor to
+   * file descriptor never passes through user space.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_ZERO_COPY,
+      g_param_spec_boolean ("zero-copy", "Zero copy",
+          "Output references to the file instead of reading regular files",
+          DEFAULT_ZERO_COPY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "Filedescriptor Source",
       "Source/File",
@@ -192,6 +212,7 @@ gst_fd_src_init (GstFdSrc * fdsrc)
   fdsrc->timeout = DEFAULT_TIMEOUT;
   fdsrc->uri = g_strdup_printf ("fd://0");
   fdsrc->curoffset = 0;
+  fdsrc->zero_copy = DEFAULT_ZERO_COPY;
 }
 
 static void
@@ -278,6 +299,15 @@ gst_fd_src_start (GstBaseSrc * bsrc)
 
   gst_fd_src_update_fd (src, -1);
 
+#ifdef G_OS_UNIX
+  if (src->zero_copy && src->seekable_fd) {
+    src->fd_handle = gst_fd_handle_new (src->fd);
+    if (src->fd_handle == NULL)
+      GST_WARNING_OBJECT (src, "could not duplicate fd %d, reading it: %s",
+          src->fd, g_strerror (errno));
+  }
+#endif
+
   return TRUE;
 
   /* ERRORS */
@@ -299,6 +329,11 @@ gst_fd_src_stop (GstBaseSrc * bsrc)
     src->fdset = NULL;
   }
 
+  if (src->fd_handle) {
+    gst_fd_handle_unref (src->fd_handle);
+    src->fd_handle = NULL;
+  }
+
   return TRUE;
 }
 
@@ -354,6 +389,9 @@ gst_fd_src_set_property (GObject * object, guint prop_id, const GValue * value,
       GST_DEBUG_OBJECT (src, "poll timeout set to %" GST_TIME_FORMAT,
           GST_TIME_ARGS (src->timeout));
       break;
+    case PROP_ZERO_COPY:
+      src->zero_copy = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -373,12 +411,62 @@ gst_fd_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, src->timeout);
       break;
+    case PROP_ZERO_COPY:
+      g_value_set_boolean (value, src->zero_copy);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Outputs the next block of the file as a reference to its range */
+static GstFlowReturn
+gst_fd_src_create_range (GstFdSrc * src, guint blocksize, GstBuffer ** outbuf)
+{
+  struct stat stat_results;
+  GstBuffer *buf;
+  guint64 size;
+  gsize len;
+
+  /* the file may still grow */
+  if (fstat (src->fd, &stat_results) < 0)
+    goto stat_error;
+
+  size = stat_results.st_size;
+  if (src->curoffset >= size)
+    goto eos;
+
+  len = MIN (blocksize, size - src->curoffset);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf,
+      gst_fd_range_memory_new (src->fd_handle, src->curoffset, len));
+
+  GST_BUFFER_OFFSET (buf) = src->curoffset;
+  GST_BUFFER_TIMESTAMP (buf) = GST_CLOCK_TIME_NONE;
+  src->curoffset += len;
+
+  GST_LOG_OBJECT (src, "Referenced range of size %" G_GSIZE_FORMAT, len);
+
+  *outbuf = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+stat_error:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("fstat on file descriptor: %s.", g_strerror (errno)));
+    return GST_FLOW_ERROR;
+  }
+eos:
+  {
+    GST_DEBUG_OBJECT (src, "At end of file. EOS.");
+    return GST_FLOW_EOS;
+  }
+}
+
 static GstFlowReturn
 gst_fd_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
@@ -434,6 +522,9 @@ gst_fd_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 
   blocksize = GST_BASE_SRC (src)->blocksize;
 
+  if (src->fd_handle)
+    return gst_fd_src_create_range (src, blocksize, outbuf);
+
   /* create the buffer */
   buf = gst_buffer_new_allocate (NULL, blocksize, NULL);
   if (G_UNLIKELY (buf == NULL))
@@ -588,6 +679,7 @@ gst_fd_src_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
   if (G_UNLIKELY (res < 0 || res != offset))
     goto seek_failed;
 
+  src->curoffset = offset;
   segment->position = segment->start;
   segment->time = segment->start;
 
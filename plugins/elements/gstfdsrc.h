@@ -71,6 +71,9 @@ struct _GstFdSrc {
   GstPoll *fdset;
 
   gulong curoffset; /* current offset in file */
+
+  gboolean zero_copy;
+  gpointer fd_handle; /* GstFdHandle of fd in zero-copy mode */
 };
 
 struct _GstFdSrcClass {
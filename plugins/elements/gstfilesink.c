@@ -38,6 +38,11 @@
 #  include "config.h"
 #endif
 
+/* for O_DIRECT, fallocate() and sync_file_range() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
 #include "../../gst/gst-i18n-lib.h"
 
 #include <gst/gst.h>
@@ -49,6 +54,7 @@
 #include "gstfilesink.h"
 #include <string.h>
 #include <sys/types.h>
+#include <fcntl.h>
 
 #ifdef G_OS_WIN32
 #include <io.h>                 /* lseek, open, close, read */
@@ -106,6 +112,13 @@ GST_DEBUG_CATEGORY_STATIC (gst_file_sink_debug);
 #define DEFAULT_BUFFER_MODE 	GST_FILE_SINK_BUFFER_MODE_DEFAULT
 #define DEFAULT_BUFFER_SIZE 	64 * 1024
 #define DEFAULT_APPEND		FALSE
+#define DEFAULT_WRITE_BEHIND	0
+#define DEFAULT_O_DIRECT	FALSE
+
+/* in o-direct mode, preallocate the file in steps of this size */
+#define DIRECT_PREALLOC_SIZE	(64 * 1024 * 1024)
+/* and start writeback of data that went through the page cache this often */
+#define DIRECT_SYNC_INTERVAL	(8 * 1024 * 1024)
 
 enum
 {
@@ -114,6 +127,8 @@ enum
   PROP_BUFFER_MODE,
   PROP_BUFFER_SIZE,
   PROP_APPEND,
+  PROP_WRITE_BEHIND,
+  PROP_O_DIRECT,
   PROP_LAST
 };
 
@@ -162,6 +177,8 @@ static void gst_file_sink_set_property (GObject * object, guint prop_id,
 static void gst_file_sink_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static void gst_file_sink_finalize (GObject * object);
+
 static gboolean gst_file_sink_open_file (GstFileSink * sink);
 static void gst_file_sink_close_file (GstFileSink * sink);
 
@@ -179,11 +196,14 @@ static gboolean gst_file_sink_get_current_offset (GstFileSink * filesink,
     guint64 * p_pos);
 
 static gboolean gst_file_sink_query (GstBaseSink * bsink, GstQuery * query);
+static gboolean gst_file_sink_propose_allocation (GstBaseSink * bsink,
+    GstQuery * query);
 
 static void gst_file_sink_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 
 static GstFlowReturn gst_file_sink_flush_buffer (GstFileSink * filesink);
+static GstFlowReturn gst_file_sink_drain (GstFileSink * filesink);
 
 #define _do_init \
   G_IMPLEMENT_INTERFACE (GST_TYPE_URI_HANDLER, gst_file_sink_uri_handler_init); \
@@ -200,6 +220,7 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   GstBaseSinkClass *gstbasesink_class = GST_BASE_SINK_CLASS (klass);
 
   gobject_class->dispose = gst_file_sink_dispose;
+  gobject_class->finalize = gst_file_sink_finalize;
 
   gobject_class->set_property = gst_file_sink_set_property;
   gobject_class->get_property = gst_file_sink_get_property;
@@ -230,6 +251,44 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
           "Append to an already existing file", DEFAULT_APPEND,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFileSink:write-behind
+   *
+   * Maximum number of bytes that may be handed to a separate writer thread
+   * without having been written to the file yet. Rendering only blocks once
+   * this many bytes are outstanding, which decouples the streaming thread
+   * from the latency of the storage. 0 writes synchronously from the
+   * streaming thread.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_WRITE_BEHIND,
+      g_param_spec_uint64 ("write-behind", "Write behind",
+          "Maximum number of bytes written asynchronously from a separate "
+          "thread (0 = write synchronously)", 0, G_MAXUINT64,
+          DEFAULT_WRITE_BEHIND, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstFileSink:o-direct
+   *
+   * Write the file with O_DIRECT, bypassing the page cache so that writing
+   * large streams does not evict other data from it. Data is collected in a
+   * staging buffer of #GstFileSink:buffer-size bytes, rounded up to the
+   * block size of the file system, and written in whole blocks; memory from
+   * upstream that is suitably aligned is written without copying. The file is
+   * preallocated as it grows. If the file system does not support O_DIRECT
+   * the data goes through the page cache, and writeback is started
+   * periodically instead of letting dirty pages pile up.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_O_DIRECT,
+      g_param_spec_boolean ("o-direct", "O_DIRECT",
+          "Write in aligned blocks bypassing the page cache", DEFAULT_O_DIRECT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "File Sink",
       "Sink/File", "Write stream to a file",
@@ -239,6 +298,8 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_file_sink_start);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_file_sink_stop);
   gstbasesink_class->query = GST_DEBUG_FUNCPTR (gst_file_sink_query);
+  gstbasesink_class->propose_allocation =
+      GST_DEBUG_FUNCPTR (gst_file_sink_propose_allocation);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_file_sink_render);
   gstbasesink_class->render_list =
       GST_DEBUG_FUNCPTR (gst_file_sink_render_list);
@@ -259,6 +320,12 @@ gst_file_sink_init (GstFileSink * filesink)
   filesink->buffer_mode = DEFAULT_BUFFER_MODE;
   filesink->buffer_size = DEFAULT_BUFFER_SIZE;
   filesink->append = FALSE;
+  filesink->write_behind = DEFAULT_WRITE_BEHIND;
+  filesink->o_direct = DEFAULT_O_DIRECT;
+
+  g_mutex_init (&filesink->writer_lock);
+  g_cond_init (&filesink->writer_cond);
+  g_queue_init (&filesink->writer_queue);
 
   gst_base_sink_set_sync (GST_BASE_SINK (filesink), FALSE);
 }
@@ -276,6 +343,17 @@ gst_file_sink_dispose (GObject * object)
   sink->filename = NULL;
 }
 
+static void
+gst_file_sink_finalize (GObject * object)
+{
+  GstFileSink *sink = GST_FILE_SINK (object);
+
+  g_mutex_clear (&sink->writer_lock);
+  g_cond_clear (&sink->writer_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static gboolean
 gst_file_sink_set_location (GstFileSink * sink, const gchar * location,
     GError ** error)
@@ -330,6 +408,12 @@ gst_file_sink_set_property (GObject * object, guint prop_id,
     case PROP_APPEND:
       sink->append = g_value_get_boolean (value);
       break;
+    case PROP_WRITE_BEHIND:
+      sink->write_behind = g_value_get_uint64 (value);
+      break;
+    case PROP_O_DIRECT:
+      sink->o_direct = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -355,12 +439,492 @@ gst_file_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_APPEND:
       g_value_set_boolean (value, sink->append);
       break;
+    case PROP_WRITE_BEHIND:
+      g_value_set_uint64 (value, sink->write_behind);
+      break;
+    case PROP_O_DIRECT:
+      g_value_set_boolean (value, sink->o_direct);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Writes one list handed over by the streaming thread. Called from the
+ * writer thread without the writer lock. */
+static GstFlowReturn
+gst_file_sink_writer_write (GstFileSink * sink, GstBufferList * list)
+{
+  GstBuffer **buffers;
+  guint8 *mem_nums;
+  guint i, num_buffers, total_mems;
+  guint64 written = 0;
+
+  num_buffers = gst_buffer_list_length (list);
+  buffers = g_newa (GstBuffer *, num_buffers);
+  mem_nums = g_newa (guint8, num_buffers);
+  for (i = 0, total_mems = 0; i < num_buffers; ++i) {
+    buffers[i] = gst_buffer_list_get (list, i);
+    mem_nums[i] = gst_buffer_n_memory (buffers[i]);
+    total_mems += mem_nums[i];
+  }
+
+  return gst_writev_buffers (GST_OBJECT_CAST (sink), fileno (sink->file),
+      NULL, buffers, num_buffers, mem_nums, total_mems, &written, 0);
+}
+
+static gpointer
+gst_file_sink_writer_func (GstFileSink * sink)
+{
+  GstBufferList *list;
+
+  g_mutex_lock (&sink->writer_lock);
+  while (TRUE) {
+    GstFlowReturn flow;
+    gsize size;
+
+    while (g_queue_is_empty (&sink->writer_queue) && !sink->writer_stop)
+      g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+
+    list = g_queue_pop_head (&sink->writer_queue);
+    if (list == NULL)
+      break;
+    g_mutex_unlock (&sink->writer_lock);
+
+    size = gst_buffer_list_calculate_size (list);
+    flow = gst_file_sink_writer_write (sink, list);
+    gst_buffer_list_unref (list);
+
+    g_mutex_lock (&sink->writer_lock);
+    if (flow != GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (sink, "write failed: %s, discarding %u pending lists",
+          gst_flow_get_name (flow), g_queue_get_length (&sink->writer_queue));
+      sink->writer_flow = flow;
+      while ((list = g_queue_pop_head (&sink->writer_queue)))
+        gst_buffer_list_unref (list);
+      sink->writer_pending = 0;
+    } else {
+      sink->writer_pending -= size;
+    }
+    g_cond_broadcast (&sink->writer_cond);
+  }
+  g_mutex_unlock (&sink->writer_lock);
+
+  return NULL;
+}
+
+static gboolean
+gst_file_sink_writer_start (GstFileSink * sink)
+{
+  GError *err = NULL;
+
+  sink->writer_pending = 0;
+  sink->writer_stop = FALSE;
+  sink->writer_flow = GST_FLOW_OK;
+
+  sink->writer = g_thread_try_new ("filesink-writer",
+      (GThreadFunc) gst_file_sink_writer_func, sink, &err);
+  if (sink->writer == NULL) {
+    GST_WARNING_OBJECT (sink, "could not start writer thread, writing "
+        "synchronously: %s", err->message);
+    g_clear_error (&err);
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (sink, "writing behind up to %" G_GUINT64_FORMAT " bytes",
+      sink->write_behind);
+
+  return TRUE;
+}
+
+static void
+gst_file_sink_writer_stop (GstFileSink * sink)
+{
+  if (sink->writer == NULL)
+    return;
+
+  g_mutex_lock (&sink->writer_lock);
+  sink->writer_stop = TRUE;
+  g_cond_broadcast (&sink->writer_cond);
+  g_mutex_unlock (&sink->writer_lock);
+
+  g_thread_join (sink->writer);
+  sink->writer = NULL;
+}
+
+/* Hands @list over to the writer thread, waiting for earlier writes to
+ * complete first if that would exceed the write-behind limit. A list larger
+ * than the limit is accepted once the writer is idle. */
+static GstFlowReturn
+gst_file_sink_writer_submit (GstFileSink * sink, GstBufferList * list,
+    gsize size)
+{
+  GstFlowReturn flow;
+
+  g_mutex_lock (&sink->writer_lock);
+  while (sink->writer_flow == GST_FLOW_OK && sink->writer_pending > 0 &&
+      sink->writer_pending + size > sink->write_behind)
+    g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+
+  flow = sink->writer_flow;
+  if (flow == GST_FLOW_OK) {
+    g_queue_push_tail (&sink->writer_queue, list);
+    sink->writer_pending += size;
+    g_cond_broadcast (&sink->writer_cond);
+  } else {
+    gst_buffer_list_unref (list);
+  }
+  g_mutex_unlock (&sink->writer_lock);
+
+  return flow;
+}
+
+/* Discards the lists that were not written yet, waits for the one that is
+ * being written and clears a previous error, for flushing. */
+static void
+gst_file_sink_writer_flush (GstFileSink * sink)
+{
+  GstBufferList *list;
+
+  if (sink->writer == NULL)
+    return;
+
+  g_mutex_lock (&sink->writer_lock);
+  while ((list = g_queue_pop_head (&sink->writer_queue))) {
+    sink->writer_pending -= gst_buffer_list_calculate_size (list);
+    gst_buffer_list_unref (list);
+  }
+  while (sink->writer_flow == GST_FLOW_OK && sink->writer_pending > 0)
+    g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+  sink->writer_pending = 0;
+  sink->writer_flow = GST_FLOW_OK;
+  g_mutex_unlock (&sink->writer_lock);
+}
+
+/* Waits until everything handed to the writer thread is in the file and
+ * returns the result of the writes. Afterwards the file position of the
+ * stream is the logical write position again. */
+static GstFlowReturn
+gst_file_sink_writer_drain (GstFileSink * sink)
+{
+  GstFlowReturn flow;
+
+  if (sink->writer == NULL)
+    return GST_FLOW_OK;
+
+  g_mutex_lock (&sink->writer_lock);
+  while (sink->writer_flow == GST_FLOW_OK && sink->writer_pending > 0)
+    g_cond_wait (&sink->writer_cond, &sink->writer_lock);
+  flow = sink->writer_flow;
+  g_mutex_unlock (&sink->writer_lock);
+
+  return flow;
+}
+
+static gboolean
+gst_file_sink_direct_set_flag (GstFileSink * sink, gboolean enable)
+{
+#ifdef O_DIRECT
+  gint fd = fileno (sink->file);
+  gint flags;
+
+  flags = fcntl (fd, F_GETFL);
+  if (flags == -1)
+    return FALSE;
+
+  flags = enable ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+
+  return fcntl (fd, F_SETFL, flags) == 0;
+#else
+  return FALSE;
+#endif
+}
+
+/* Writes @size bytes at the current file position. If @aligned, @data,
+ * @size and the file position are multiples of the block size and O_DIRECT
+ * is used when available, otherwise the write goes through the page cache. */
+static GstFlowReturn
+gst_file_sink_direct_write (GstFileSink * sink, const guint8 * data,
+    gsize size, gboolean aligned)
+{
+  gint fd = fileno (sink->file);
+  gboolean toggle = sink->direct && !aligned;
+  gint write_errno = 0;
+
+  GST_LOG_OBJECT (sink, "writing %" G_GSIZE_FORMAT " bytes at offset %"
+      G_GUINT64_FORMAT "%s", size, sink->direct_pos,
+      aligned && sink->direct ? " with O_DIRECT" : "");
+
+#if defined (HAVE_FALLOCATE) && defined (FALLOC_FL_KEEP_SIZE)
+  if (sink->direct_pos + size > sink->direct_prealloc_end) {
+    guint64 len = size + DIRECT_PREALLOC_SIZE;
+
+    if (fallocate (fd, FALLOC_FL_KEEP_SIZE, (off_t) sink->direct_pos,
+            (off_t) len) == 0) {
+      sink->direct_prealloc_end = sink->direct_pos + len;
+    } else {
+      GST_DEBUG_OBJECT (sink, "not preallocating, fallocate failed: %s",
+          g_strerror (errno));
+      sink->direct_prealloc_end = G_MAXUINT64;
+    }
+  }
+#endif
+
+  if (toggle)
+    gst_file_sink_direct_set_flag (sink, FALSE);
+
+  while (size > 0) {
+    gssize ret;
+
+    ret = write (fd, data, size);
+    if (ret < 0) {
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+      write_errno = errno;
+      break;
+    }
+    data += ret;
+    size -= ret;
+    sink->direct_pos += ret;
+  }
+
+  if (toggle)
+    gst_file_sink_direct_set_flag (sink, TRUE);
+
+  if (write_errno != 0)
+    goto write_failed;
+
+#ifdef HAVE_SYNC_FILE_RANGE
+  /* only needed when O_DIRECT is not available, with it just the small
+   * unaligned pieces around the O_DIRECT writes go through the page cache */
+  if (!sink->direct) {
+    if (sink->direct_pos < sink->direct_synced_pos) {
+      sink->direct_synced_pos = sink->direct_pos;
+    } else if (sink->direct_pos - sink->direct_synced_pos >=
+        DIRECT_SYNC_INTERVAL) {
+      sync_file_range (fd, (off_t) sink->direct_synced_pos,
+          (off_t) (sink->direct_pos - sink->direct_synced_pos),
+          SYNC_FILE_RANGE_WRITE);
+      sink->direct_synced_pos = sink->direct_pos;
+    }
+  }
+#endif
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+write_failed:
+  {
+    switch (write_errno) {
+      case ENOSPC:
+        GST_ELEMENT_ERROR (sink, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
+        break;
+      default:
+        GST_ELEMENT_ERROR (sink, RESOURCE, WRITE,
+            (_("Error while writing to file \"%s\"."), sink->filename),
+            ("%s", g_strerror (write_errno)));
+        break;
+    }
+    return GST_FLOW_ERROR;
+  }
+}
+
+/* Writes out the staging buffer. Only whole blocks are written unless @all
+ * is TRUE, the remainder is kept at the start of the staging buffer. */
+static GstFlowReturn
+gst_file_sink_direct_flush_staging (GstFileSink * sink, gboolean all)
+{
+  guint8 *data = sink->direct_map.data;
+  gsize align = sink->direct_align;
+  gsize fill = sink->direct_fill;
+  gsize misalign, head, body;
+  GstFlowReturn flow = GST_FLOW_OK;
+
+  /* after a seek or a partial flush, first get the file position back to a
+   * block boundary */
+  misalign = sink->direct_pos % align;
+  if (misalign > 0 && fill > 0) {
+    head = MIN (align - misalign, fill);
+    flow = gst_file_sink_direct_write (sink, data, head, FALSE);
+    if (flow != GST_FLOW_OK)
+      goto done;
+    fill -= head;
+    memmove (data, data + head, fill);
+  }
+
+  body = fill - fill % align;
+  if (body > 0) {
+    flow = gst_file_sink_direct_write (sink, data, body, TRUE);
+    if (flow != GST_FLOW_OK)
+      goto done;
+    fill -= body;
+  }
+
+  if (fill > 0) {
+    if (all) {
+      flow = gst_file_sink_direct_write (sink, data + body, fill, FALSE);
+      fill = 0;
+    } else {
+      memmove (data, data + body, fill);
+    }
+  }
+
+done:
+  sink->direct_fill = flow == GST_FLOW_OK ? fill : 0;
+
+  return flow;
+}
+
+static GstFlowReturn
+gst_file_sink_direct_render (GstFileSink * sink, GstBuffer ** buffers,
+    guint num_buffers, gsize size)
+{
+  gsize align = sink->direct_align;
+  gsize stage_size = sink->direct_map.size;
+  GstFlowReturn flow = GST_FLOW_OK;
+  guint i, j;
+
+  GST_DEBUG_OBJECT (sink, "staging %u buffers (%" G_GSIZE_FORMAT
+      " bytes) at position %" G_GUINT64_FORMAT, num_buffers, size,
+      sink->current_pos);
+
+  for (i = 0; i < num_buffers && flow == GST_FLOW_OK; ++i) {
+    guint n_mem = gst_buffer_n_memory (buffers[i]);
+
+    for (j = 0; j < n_mem && flow == GST_FLOW_OK; ++j) {
+      GstMemory *mem = gst_buffer_peek_memory (buffers[i], j);
+      const guint8 *data;
+      GstMapInfo info;
+      gsize left, n;
+
+      if (!gst_memory_map (mem, &info, GST_MAP_READ))
+        goto map_failed;
+
+      data = info.data;
+      left = info.size;
+      while (left > 0 && flow == GST_FLOW_OK) {
+        if (sink->direct_fill == 0 && sink->direct_pos % align == 0 &&
+            ((guintptr) data) % align == 0 && left >= align) {
+          /* aligned memory is written without going through the staging
+           * buffer */
+          n = left - left % align;
+          flow = gst_file_sink_direct_write (sink, data, n, TRUE);
+        } else {
+          n = MIN (left, stage_size - sink->direct_fill);
+          memcpy (sink->direct_map.data + sink->direct_fill, data, n);
+          sink->direct_fill += n;
+          if (sink->direct_fill == stage_size)
+            flow = gst_file_sink_direct_flush_staging (sink, FALSE);
+        }
+        data += n;
+        left -= n;
+      }
+
+      gst_memory_unmap (mem, &info);
+    }
+  }
+
+  if (flow == GST_FLOW_OK)
+    sink->current_pos += size;
+
+  return flow;
+
+  /* ERRORS */
+map_failed:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, WRITE, (NULL),
+        ("Failed to map memory"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static void
+gst_file_sink_direct_start (GstFileSink * sink)
+{
+  GstAllocationParams params;
+  gsize stage_size;
+
+  sink->direct_align = 4096;
+#ifdef O_DIRECT
+  {
+    struct stat stat_results;
+
+    /* use the preferred I/O block size, which is a multiple of the logical
+     * block size O_DIRECT requires */
+    if (fstat (fileno (sink->file), &stat_results) == 0 &&
+        stat_results.st_blksize >= 512 &&
+        (stat_results.st_blksize & (stat_results.st_blksize - 1)) == 0)
+      sink->direct_align = stat_results.st_blksize;
+  }
+#endif
+
+  /* with O_APPEND we don't know where in the file we write */
+  sink->direct = !sink->append && gst_file_sink_direct_set_flag (sink, TRUE);
+  if (!sink->direct)
+    GST_WARNING_OBJECT (sink, "O_DIRECT not available, writing through the "
+        "page cache");
+
+  stage_size = MAX (sink->buffer_size, sink->direct_align);
+  stage_size = (stage_size + sink->direct_align - 1) &
+      ~(sink->direct_align - 1);
+
+  gst_allocation_params_init (&params);
+  params.align = sink->direct_align - 1;
+  sink->direct_mem = gst_allocator_alloc (NULL, stage_size, &params);
+  gst_memory_map (sink->direct_mem, &sink->direct_map, GST_MAP_WRITE);
+
+  sink->direct_fill = 0;
+  sink->direct_pos = sink->current_pos;
+  sink->direct_prealloc_end = sink->direct_pos;
+  sink->direct_synced_pos = sink->direct_pos;
+
+  GST_DEBUG_OBJECT (sink, "writing in blocks of %" G_GSIZE_FORMAT " bytes, "
+      "staging %" G_GSIZE_FORMAT " bytes", sink->direct_align, stage_size);
+}
+
+static void
+gst_file_sink_direct_stop (GstFileSink * sink)
+{
+  if (sink->direct_mem == NULL)
+    return;
+
+#if defined (HAVE_FALLOCATE) && defined (FALLOC_FL_KEEP_SIZE)
+  /* give back the preallocated blocks past the end of the file. Truncating
+   * to the current size releases them, direct_pos can be before the end
+   * after a seek. */
+  if (sink->direct_prealloc_end != G_MAXUINT64) {
+    gint fd = fileno (sink->file);
+    struct stat stat_results;
+
+    if (fstat (fd, &stat_results) == 0 &&
+        sink->direct_prealloc_end > (guint64) stat_results.st_size &&
+        ftruncate (fd, stat_results.st_size) != 0)
+      GST_DEBUG_OBJECT (sink, "failed to release preallocated space: %s",
+          g_strerror (errno));
+  }
+#endif
+
+  gst_memory_unmap (sink->direct_mem, &sink->direct_map);
+  gst_memory_unref (sink->direct_mem);
+  sink->direct_mem = NULL;
+  sink->direct_fill = 0;
+  sink->direct = FALSE;
+}
+
+/* Makes sure everything rendered so far was handed to the file */
+static GstFlowReturn
+gst_file_sink_drain (GstFileSink * sink)
+{
+  GstFlowReturn flow;
+
+  flow = gst_file_sink_writer_drain (sink);
+  if (flow == GST_FLOW_OK && sink->direct_mem != NULL)
+    flow = gst_file_sink_direct_flush_staging (sink, TRUE);
+
+  return flow;
+}
+
 static gboolean
 gst_file_sink_open_file (GstFileSink * sink)
 {
@@ -382,7 +946,9 @@ gst_file_sink_open_file (GstFileSink * sink)
   if (sink->buffer)
     gst_buffer_list_unref (sink->buffer);
   sink->buffer = NULL;
-  if (sink->buffer_mode != GST_FILE_SINK_BUFFER_MODE_UNBUFFERED) {
+  /* o-direct mode uses its own staging buffer */
+  if (sink->buffer_mode != GST_FILE_SINK_BUFFER_MODE_UNBUFFERED &&
+      !sink->o_direct) {
     if (sink->buffer_size == 0) {
       sink->buffer_size = DEFAULT_BUFFER_SIZE;
       g_object_notify (G_OBJECT (sink), "buffer-size");
@@ -392,6 +958,11 @@ gst_file_sink_open_file (GstFileSink * sink)
     sink->current_buffer_size = 0;
   }
 
+  if (sink->o_direct)
+    gst_file_sink_direct_start (sink);
+  else if (sink->write_behind > 0)
+    gst_file_sink_writer_start (sink);
+
   GST_DEBUG_OBJECT (sink, "opened file %s, seekable %d",
       sink->filename, sink->seekable);
 
@@ -417,10 +988,14 @@ static void
 gst_file_sink_close_file (GstFileSink * sink)
 {
   if (sink->file) {
-    if (gst_file_sink_flush_buffer (sink) != GST_FLOW_OK)
+    if (gst_file_sink_flush_buffer (sink) != GST_FLOW_OK ||
+        gst_file_sink_drain (sink) != GST_FLOW_OK)
       GST_ELEMENT_ERROR (sink, RESOURCE, CLOSE,
           (_("Error closing file \"%s\"."), sink->filename), NULL);
 
+    gst_file_sink_writer_stop (sink);
+    gst_file_sink_direct_stop (sink);
+
     if (fclose (sink->file) != 0)
       GST_ELEMENT_ERROR (sink, RESOURCE, CLOSE,
           (_("Error closing file \"%s\"."), sink->filename), GST_ERROR_SYSTEM);
@@ -489,6 +1064,40 @@ gst_file_sink_query (GstBaseSink * bsink, GstQuery * query)
   return res;
 }
 
+static gboolean
+gst_file_sink_propose_allocation (GstBaseSink * bsink, GstQuery * query)
+{
+  GstFileSink *sink = GST_FILE_SINK_CAST (bsink);
+  GstAllocationParams params;
+  GstBufferPool *pool;
+  GstStructure *config;
+  GstCaps *caps;
+  gboolean need_pool;
+
+  if (sink->direct_mem == NULL)
+    return FALSE;
+
+  /* memory aligned to the block size can be written without copying it to
+   * the staging buffer first */
+  gst_allocation_params_init (&params);
+  params.align = sink->direct_align - 1;
+  gst_query_add_allocation_param (query, NULL, &params);
+
+  gst_query_parse_allocation (query, &caps, &need_pool);
+  if (need_pool) {
+    pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, sink->direct_map.size, 0,
+        0);
+    gst_buffer_pool_config_set_allocator (config, NULL, &params);
+    if (gst_buffer_pool_set_config (pool, config))
+      gst_query_add_allocation_pool (query, pool, sink->direct_map.size, 0, 0);
+    gst_object_unref (pool);
+  }
+
+  return TRUE;
+}
+
 #ifdef HAVE_FSEEKO
 # define __GST_STDIO_SEEK_FUNCTION "fseeko"
 #elif defined (G_OS_UNIX) || defined (G_OS_WIN32)
@@ -506,6 +1115,10 @@ gst_file_sink_do_seek (GstFileSink * filesink, guint64 new_offset)
   if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
     goto flush_buffer_failed;
 
+  /* pending data is written at the current file position */
+  if (gst_file_sink_drain (filesink) != GST_FLOW_OK)
+    goto flush_buffer_failed;
+
 #ifdef HAVE_FSEEKO
   if (fseeko (filesink->file, (off_t) new_offset, SEEK_SET) != 0)
     goto seek_failed;
@@ -521,6 +1134,7 @@ gst_file_sink_do_seek (GstFileSink * filesink, guint64 new_offset)
   /* adjust position reporting after seek;
    * presumably this should basically yield new_offset */
   gst_file_sink_get_current_offset (filesink, &filesink->current_pos);
+  filesink->direct_pos = filesink->current_pos;
 
   return TRUE;
 
@@ -577,8 +1191,12 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
       break;
     }
     case GST_EVENT_FLUSH_STOP:
+      /* flushed data must not reach the file, also when it is not seekable */
+      gst_file_sink_writer_flush (filesink);
+      filesink->direct_fill = 0;
       if (filesink->current_pos != 0 && filesink->seekable) {
-        gst_file_sink_do_seek (filesink, 0);
+        if (!gst_file_sink_do_seek (filesink, 0))
+          goto seek_failed;
         if (ftruncate (fileno (filesink->file), 0))
           goto truncate_failed;
       }
@@ -591,6 +1209,8 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
     case GST_EVENT_EOS:
       if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
         goto flush_buffer_failed;
+      if (gst_file_sink_drain (filesink) != GST_FLOW_OK)
+        goto flush_buffer_failed;
       break;
     default:
       break;
@@ -652,6 +1272,29 @@ static GstFlowReturn
 gst_file_sink_render_buffers (GstFileSink * sink, GstBuffer ** buffers,
     guint num_buffers, guint8 * mem_nums, guint total_mems, gsize size)
 {
+  if (sink->direct_mem)
+    return gst_file_sink_direct_render (sink, buffers, num_buffers, size);
+
+  if (sink->writer) {
+    GstBufferList *list;
+    GstFlowReturn flow;
+    guint i;
+
+    GST_DEBUG_OBJECT (sink, "queueing %u buffers (%" G_GSIZE_FORMAT
+        " bytes) for writing at position %" G_GUINT64_FORMAT, num_buffers,
+        size, sink->current_pos);
+
+    list = gst_buffer_list_new_sized (num_buffers);
+    for (i = 0; i < num_buffers; ++i)
+      gst_buffer_list_add (list, gst_buffer_ref (buffers[i]));
+
+    flow = gst_file_sink_writer_submit (sink, list, size);
+    if (flow == GST_FLOW_OK)
+      sink->current_pos += size;
+
+    return flow;
+  }
+
   GST_DEBUG_OBJECT (sink,
       "writing %u buffers (%u memories, %" G_GSIZE_FORMAT
       " bytes) at position %" G_GUINT64_FORMAT, num_buffers, total_mems, size,
@@ -787,6 +1430,9 @@ gst_file_sink_render_list (GstBaseSink * bsink, GstBufferList * buffer_list)
       flow = GST_FLOW_OK;
   }
 
+  if (flow == GST_FLOW_OK && sync_after)
+    flow = gst_file_sink_drain (sink);
+
   if (flow == GST_FLOW_OK && sync_after) {
     if (fsync (fileno (sink->file))) {
       GST_ELEMENT_ERROR (sink, RESOURCE, WRITE,
@@ -842,6 +1488,9 @@ gst_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
     flow = GST_FLOW_OK;
   }
 
+  if (flow == GST_FLOW_OK && sync_after)
+    flow = gst_file_sink_drain (filesink);
+
   if (flow == GST_FLOW_OK && sync_after) {
     if (fsync (fileno (filesink->file))) {
       GST_ELEMENT_ERROR (filesink, RESOURCE, WRITE,
@@ -85,6 +85,27 @@ struct _GstFileSink {
   guint   current_buffer_size;
 
   gboolean append;
+
+  /* write-behind thread, protected by writer_lock */
+  guint64  write_behind;
+  GThread *writer;
+  GMutex   writer_lock;
+  GCond    writer_cond;
+  GQueue   writer_queue;
+  guint64  writer_pending;
+  gboolean writer_stop;
+  GstFlowReturn writer_flow;
+
+  /* O_DIRECT staging buffer */
+  gboolean o_direct;
+  gboolean direct;
+  gsize    direct_align;
+  GstMemory *direct_mem;
+  GstMapInfo direct_map;
+  gsize    direct_fill;
+  guint64  direct_pos;
+  guint64  direct_prealloc_end;
+  guint64  direct_synced_pos;
 };
 
 struct _GstFileSinkClass {
@@ -65,6 +65,11 @@
 #  include <unistd.h>
 #endif
 
+#if defined (HAVE_SYS_MMAN_H) && defined (G_OS_UNIX)
+#include <sys/mman.h>
+#define USE_MMAP 1
+#endif
+
 #ifdef __BIONIC__               /* Android */
 #if defined(__ANDROID_API__) && __ANDROID_API__ >= 21
 #undef fstat
@@ -136,11 +141,18 @@ enum
 };
 
 #define DEFAULT_BLOCKSIZE       4*1024
+#define DEFAULT_READ_AHEAD      0
+#define DEFAULT_USE_MMAP        FALSE
+
+/* size of the windows of the file we map at a time */
+#define MMAP_WINDOW_SIZE        (4 * 1024 * 1024)
 
 enum
 {
   PROP_0,
-  PROP_LOCATION
+  PROP_LOCATION,
+  PROP_READ_AHEAD,
+  PROP_USE_MMAP
 };
 
 static void gst_file_src_finalize (GObject * object);
@@ -157,6 +169,10 @@ static gboolean gst_file_src_is_seekable (GstBaseSrc * src);
 static gboolean gst_file_src_get_size (GstBaseSrc * src, guint64 * size);
 static GstFlowReturn gst_file_src_fill (GstBaseSrc * src, guint64 offset,
     guint length, GstBuffer * buf);
+static GstFlowReturn gst_file_src_create (GstBaseSrc * src, guint64 offset,
+    guint length, GstBuffer ** buf);
+static gboolean gst_file_src_unlock (GstBaseSrc * src);
+static gboolean gst_file_src_unlock_stop (GstBaseSrc * src);
 
 static void gst_file_src_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
@@ -187,6 +203,42 @@ gst_file_src_class_init (GstFileSrcClass * klass)
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
 
+  /**
+   * GstFileSrc:read-ahead
+   *
+   * Number of blocks to read ahead of the consumer from a separate thread.
+   * While the pipeline processes one block the following ones are already
+   * being read, which hides the latency of the storage for sequential
+   * reading. Only used for regular files. 0 reads synchronously from the
+   * streaming thread.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD,
+      g_param_spec_uint ("read-ahead", "Read ahead",
+          "Number of blocks to read ahead from a separate thread "
+          "(0 = read synchronously)", 0, G_MAXUINT, DEFAULT_READ_AHEAD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  /**
+   * GstFileSrc:use-mmap
+   *
+   * Map regular files into memory and output buffers wrapping the mapped
+   * pages instead of copying the data with read(). Windows of the file are
+   * mapped as reading progresses, so this also works for large files and for
+   * files that grow while being read. Truncating the file while its buffers
+   * are in use results in a crash, so this should only be used for files that
+   * are not modified that way.
+   *
+   * Since: 1.16
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_MMAP,
+      g_param_spec_boolean ("use-mmap", "Use mmap",
+          "Map the file into memory instead of reading it", DEFAULT_USE_MMAP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   gobject_class->finalize = gst_file_src_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -201,6 +253,9 @@ gst_file_src_class_init (GstFileSrcClass * klass)
   gstbasesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_file_src_is_seekable);
   gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_file_src_get_size);
   gstbasesrc_class->fill = GST_DEBUG_FUNCPTR (gst_file_src_fill);
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_file_src_create);
+  gstbasesrc_class->unlock = GST_DEBUG_FUNCPTR (gst_file_src_unlock);
+  gstbasesrc_class->unlock_stop = GST_DEBUG_FUNCPTR (gst_file_src_unlock_stop);
 
   if (sizeof (off_t) < 8) {
     GST_LOG ("No large file support, sizeof (off_t) = %" G_GSIZE_FORMAT "!",
@@ -217,6 +272,12 @@ gst_file_src_init (GstFileSrc * src)
 
   src->is_regular = FALSE;
 
+  src->read_ahead = DEFAULT_READ_AHEAD;
+  src->use_mmap = DEFAULT_USE_MMAP;
+  g_mutex_init (&src->ra_lock);
+  g_cond_init (&src->ra_cond);
+  g_queue_init (&src->ra_queue);
+
   gst_base_src_set_blocksize (GST_BASE_SRC (src), DEFAULT_BLOCKSIZE);
 }
 
@@ -230,6 +291,9 @@ gst_file_src_finalize (GObject * object)
   g_free (src->filename);
   g_free (src->uri);
 
+  g_mutex_clear (&src->ra_lock);
+  g_cond_clear (&src->ra_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -294,6 +358,12 @@ gst_file_src_set_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       gst_file_src_set_location (src, g_value_get_string (value), NULL);
       break;
+    case PROP_READ_AHEAD:
+      src->read_ahead = g_value_get_uint (value);
+      break;
+    case PROP_USE_MMAP:
+      src->use_mmap = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -314,6 +384,12 @@ gst_file_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_LOCATION:
       g_value_set_string (value, src->filename);
       break;
+    case PROP_READ_AHEAD:
+      g_value_set_uint (value, src->read_ahead);
+      break;
+    case PROP_USE_MMAP:
+      g_value_set_boolean (value, src->use_mmap);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -419,6 +495,407 @@ buffer_write_fail:
   }
 }
 
+#ifdef G_OS_UNIX
+/* Reads one block at @offset into a new buffer. Returns NULL and sets
+ * @read_errno on error, or returns NULL with @read_errno 0 at the end of the
+ * file. Called from the reader thread without the lock, it uses pread() so
+ * that the file position used by gst_file_src_fill() is left alone. */
+static GstBuffer *
+gst_file_src_read_block (GstFileSrc * src, guint64 offset, guint length,
+    gint * read_errno)
+{
+  GstBuffer *buf;
+  GstMapInfo info;
+  gsize bytes_read = 0;
+  ssize_t ret;
+
+  *read_errno = 0;
+
+  buf = gst_buffer_new_allocate (NULL, length, NULL);
+  if (buf == NULL || !gst_buffer_map (buf, &info, GST_MAP_WRITE)) {
+    *read_errno = ENOMEM;
+    if (buf)
+      gst_buffer_unref (buf);
+    return NULL;
+  }
+
+  while (bytes_read < length) {
+    ret = pread (src->fd, info.data + bytes_read, length - bytes_read,
+        (off_t) (offset + bytes_read));
+    if (G_UNLIKELY (ret < 0)) {
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+      *read_errno = errno;
+      break;
+    }
+    if (ret == 0)
+      break;
+    bytes_read += ret;
+  }
+
+  gst_buffer_unmap (buf, &info);
+
+  if (*read_errno != 0 || bytes_read == 0) {
+    gst_buffer_unref (buf);
+    return NULL;
+  }
+
+  if (bytes_read != length)
+    gst_buffer_resize (buf, 0, bytes_read);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + bytes_read;
+
+  return buf;
+}
+
+static gpointer
+gst_file_src_reader_func (GstFileSrc * src)
+{
+  g_mutex_lock (&src->ra_lock);
+  while (TRUE) {
+    GstBuffer *buf;
+    guint64 offset;
+    guint length, generation;
+    gint read_errno;
+
+    while (!src->ra_stop && (src->ra_eos || src->ra_errno != 0 ||
+            g_queue_get_length (&src->ra_queue) >= src->read_ahead))
+      g_cond_wait (&src->ra_cond, &src->ra_lock);
+
+    if (src->ra_stop)
+      break;
+
+    offset = src->ra_next;
+    length = src->ra_blocksize;
+    generation = src->ra_generation;
+    g_mutex_unlock (&src->ra_lock);
+
+    GST_LOG_OBJECT (src, "Reading ahead %u bytes at offset 0x%"
+        G_GINT64_MODIFIER "x", length, offset);
+    buf = gst_file_src_read_block (src, offset, length, &read_errno);
+
+    g_mutex_lock (&src->ra_lock);
+    if (generation != src->ra_generation) {
+      /* the consumer moved elsewhere while we were reading */
+      if (buf)
+        gst_buffer_unref (buf);
+      continue;
+    }
+
+    if (buf) {
+      src->ra_next += gst_buffer_get_size (buf);
+      g_queue_push_tail (&src->ra_queue, buf);
+    } else if (read_errno != 0) {
+      src->ra_errno = read_errno;
+    } else {
+      src->ra_eos = TRUE;
+    }
+    g_cond_broadcast (&src->ra_cond);
+  }
+  g_mutex_unlock (&src->ra_lock);
+
+  return NULL;
+}
+#endif
+
+/* must be called with ra_lock */
+static void
+gst_file_src_reader_reset (GstFileSrc * src, guint64 offset, guint length)
+{
+  GstBuffer *buf;
+
+  while ((buf = g_queue_pop_head (&src->ra_queue)))
+    gst_buffer_unref (buf);
+
+  src->ra_offset = src->ra_next = offset;
+  src->ra_blocksize = length;
+  src->ra_generation++;
+  src->ra_errno = 0;
+  src->ra_eos = FALSE;
+  g_cond_broadcast (&src->ra_cond);
+}
+
+static void
+gst_file_src_reader_start (GstFileSrc * src)
+{
+#ifdef G_OS_UNIX
+  GError *err = NULL;
+
+  g_mutex_lock (&src->ra_lock);
+  gst_file_src_reader_reset (src, 0,
+      gst_base_src_get_blocksize (GST_BASE_SRC_CAST (src)));
+  src->ra_stop = FALSE;
+  src->ra_flushing = FALSE;
+  g_mutex_unlock (&src->ra_lock);
+
+  src->reader = g_thread_try_new ("filesrc-reader",
+      (GThreadFunc) gst_file_src_reader_func, src, &err);
+  if (src->reader == NULL) {
+    GST_WARNING_OBJECT (src, "could not start reader thread, reading "
+        "synchronously: %s", err->message);
+    g_clear_error (&err);
+    return;
+  }
+
+  GST_DEBUG_OBJECT (src, "reading ahead %u blocks", src->read_ahead);
+#else
+  GST_DEBUG_OBJECT (src, "read-ahead not supported on this platform");
+#endif
+}
+
+static void
+gst_file_src_reader_stop (GstFileSrc * src)
+{
+  if (src->reader == NULL)
+    return;
+
+  g_mutex_lock (&src->ra_lock);
+  src->ra_stop = TRUE;
+  g_cond_broadcast (&src->ra_cond);
+  g_mutex_unlock (&src->ra_lock);
+
+  g_thread_join (src->reader);
+  src->reader = NULL;
+
+  g_mutex_lock (&src->ra_lock);
+  gst_file_src_reader_reset (src, 0, 0);
+  g_mutex_unlock (&src->ra_lock);
+}
+
+#ifdef USE_MMAP
+/* A mapped window of the file. Buffers wrapping it keep a reference, so the
+ * window stays mapped until the last of them is freed. */
+typedef struct
+{
+  gint refcount;
+  guint8 *data;
+  gsize size;
+  guint64 offset;
+} GstFileSrcMapping;
+
+static void
+gst_file_src_mapping_unref (GstFileSrcMapping * mapping)
+{
+  if (g_atomic_int_dec_and_test (&mapping->refcount)) {
+    munmap (mapping->data, mapping->size);
+    g_slice_free (GstFileSrcMapping, mapping);
+  }
+}
+
+/* Maps a window of the file starting at or before @offset and covering at
+ * least @length bytes, but never extending beyond the end of the file:
+ * accessing pages past it would raise SIGBUS. */
+static GstFileSrcMapping *
+gst_file_src_map_window (GstFileSrc * src, guint64 offset, guint length)
+{
+  GstFileSrcMapping *mapping;
+  guint64 map_offset;
+  gsize map_size;
+  gpointer data;
+
+  map_offset = offset - offset % src->pagesize;
+  map_size = MAX (MMAP_WINDOW_SIZE, offset - map_offset + length);
+  if (map_offset + map_size > src->mmap_file_size)
+    map_size = src->mmap_file_size - map_offset;
+
+  data = mmap (NULL, map_size, PROT_READ, MAP_SHARED, src->fd,
+      (off_t) map_offset);
+  if (data == MAP_FAILED) {
+    GST_WARNING_OBJECT (src, "mmap of %" G_GSIZE_FORMAT " bytes at offset %"
+        G_GUINT64_FORMAT " failed: %s", map_size, map_offset,
+        g_strerror (errno));
+    return NULL;
+  }
+
+  /* we mostly read through the window once, from start to end */
+#ifdef MADV_SEQUENTIAL
+  madvise (data, map_size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+  madvise (data, map_size, MADV_WILLNEED);
+#endif
+
+  GST_LOG_OBJECT (src, "mapped %" G_GSIZE_FORMAT " bytes at offset %"
+      G_GUINT64_FORMAT, map_size, map_offset);
+
+  mapping = g_slice_new (GstFileSrcMapping);
+  mapping->refcount = 1;
+  mapping->data = data;
+  mapping->size = map_size;
+  mapping->offset = map_offset;
+
+  return mapping;
+}
+
+static GstFlowReturn
+gst_file_src_create_mmap (GstFileSrc * src, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstFileSrcMapping *mapping;
+  GstMemory *mem;
+  GstBuffer *buf;
+
+  /* the file may have grown since we last looked */
+  if (offset + length > src->mmap_file_size) {
+    struct stat stat_results;
+
+    if (fstat (src->fd, &stat_results) == 0)
+      src->mmap_file_size = stat_results.st_size;
+  }
+
+  if (offset >= src->mmap_file_size)
+    goto eos;
+
+  length = MIN (length, src->mmap_file_size - offset);
+
+  mapping = src->mapping;
+  if (mapping == NULL || offset < mapping->offset ||
+      offset + length > mapping->offset + mapping->size) {
+    mapping = gst_file_src_map_window (src, offset, length);
+    if (mapping == NULL)
+      return GST_FLOW_CUSTOM_SUCCESS;
+
+    if (src->mapping)
+      gst_file_src_mapping_unref (src->mapping);
+    src->mapping = mapping;
+  }
+
+  g_atomic_int_inc (&mapping->refcount);
+  mem = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, mapping->data,
+      mapping->size, offset - mapping->offset, length, mapping,
+      (GDestroyNotify) gst_file_src_mapping_unref);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + length;
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERROR */
+eos:
+  {
+    GST_DEBUG_OBJECT (src, "EOS");
+    return GST_FLOW_EOS;
+  }
+}
+#endif
+
+static void
+gst_file_src_unmap (GstFileSrc * src)
+{
+#ifdef USE_MMAP
+  if (src->mapping) {
+    gst_file_src_mapping_unref (src->mapping);
+    src->mapping = NULL;
+  }
+#endif
+  src->mmapped = FALSE;
+}
+
+static GstFlowReturn
+gst_file_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstFileSrc *src = GST_FILE_SRC_CAST (basesrc);
+  GstBuffer *buf;
+  gint read_errno;
+
+#ifdef USE_MMAP
+  if (src->mmapped && *buffer == NULL && length > 0) {
+    GstFlowReturn ret;
+
+    ret = gst_file_src_create_mmap (src, offset, length, buffer);
+    if (ret != GST_FLOW_CUSTOM_SUCCESS)
+      return ret;
+
+    /* mapping failed, read the file the usual way from now on */
+    gst_file_src_unmap (src);
+  }
+#endif
+
+  /* no read-ahead, downstream provided the buffer to fill or an empty read */
+  if (src->reader == NULL || *buffer != NULL || length == 0)
+    return GST_BASE_SRC_CLASS (parent_class)->create (basesrc, offset, length,
+        buffer);
+
+  g_mutex_lock (&src->ra_lock);
+  if (offset != src->ra_offset || length != src->ra_blocksize) {
+    GST_DEBUG_OBJECT (src, "restarting read-ahead at offset %" G_GUINT64_FORMAT
+        " with %u byte blocks", offset, length);
+    gst_file_src_reader_reset (src, offset, length);
+  }
+
+  while (g_queue_is_empty (&src->ra_queue) && !src->ra_eos &&
+      src->ra_errno == 0 && !src->ra_flushing)
+    g_cond_wait (&src->ra_cond, &src->ra_lock);
+
+  if (src->ra_flushing)
+    goto flushing;
+
+  buf = g_queue_pop_head (&src->ra_queue);
+  if (buf == NULL)
+    goto no_buffer;
+
+  src->ra_offset += gst_buffer_get_size (buf);
+  /* wake up the reader, there is room for another block */
+  g_cond_broadcast (&src->ra_cond);
+  g_mutex_unlock (&src->ra_lock);
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERROR */
+flushing:
+  {
+    g_mutex_unlock (&src->ra_lock);
+    return GST_FLOW_FLUSHING;
+  }
+no_buffer:
+  {
+    read_errno = src->ra_errno;
+    g_mutex_unlock (&src->ra_lock);
+
+    if (read_errno == 0) {
+      GST_DEBUG_OBJECT (src, "EOS");
+      return GST_FLOW_EOS;
+    }
+
+    GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+        ("system error: %s", g_strerror (read_errno)));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static gboolean
+gst_file_src_unlock (GstBaseSrc * basesrc)
+{
+  GstFileSrc *src = GST_FILE_SRC_CAST (basesrc);
+
+  g_mutex_lock (&src->ra_lock);
+  src->ra_flushing = TRUE;
+  g_cond_broadcast (&src->ra_cond);
+  g_mutex_unlock (&src->ra_lock);
+
+  return TRUE;
+}
+
+static gboolean
+gst_file_src_unlock_stop (GstBaseSrc * basesrc)
+{
+  GstFileSrc *src = GST_FILE_SRC_CAST (basesrc);
+
+  g_mutex_lock (&src->ra_lock);
+  src->ra_flushing = FALSE;
+  g_mutex_unlock (&src->ra_lock);
+
+  return TRUE;
+}
+
 static gboolean
 gst_file_src_is_seekable (GstBaseSrc * basesrc)
 {
@@ -516,6 +993,17 @@ gst_file_src_start (GstBaseSrc * basesrc)
 
   gst_base_src_set_dynamic_size (basesrc, src->seekable);
 
+#ifdef USE_MMAP
+  if (src->use_mmap && src->seekable) {
+    src->mmapped = TRUE;
+    src->mmap_file_size = stat_results.st_size;
+    src->pagesize = (gsize) sysconf (_SC_PAGESIZE);
+  }
+#endif
+
+  if (src->read_ahead > 0 && src->seekable && !src->mmapped)
+    gst_file_src_reader_start (src);
+
   return TRUE;
 
   /* ERROR */
@@ -577,6 +1065,9 @@ gst_file_src_stop (GstBaseSrc * basesrc)
 {
   GstFileSrc *src = GST_FILE_SRC (basesrc);
 
+  gst_file_src_reader_stop (src);
+  gst_file_src_unmap (src);
+
   /* close the file */
   close (src->fd);
 
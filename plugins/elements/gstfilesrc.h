@@ -63,6 +63,27 @@ struct _GstFileSrc {
   gboolean seekable;                    /* whether the file is seekable */
   gboolean is_regular;                  /* whether it's a (symlink to a)
                                            regular file */
+
+  /* read-ahead thread, protected by ra_lock */
+  guint read_ahead;                     /* number of blocks to read ahead */
+  GThread *reader;
+  GMutex ra_lock;
+  GCond ra_cond;
+  GQueue ra_queue;                      /* blocks read ahead, in order */
+  guint64 ra_offset;                    /* offset of the first queued block */
+  guint64 ra_next;                      /* offset the reader reads next */
+  guint ra_blocksize;
+  guint ra_generation;                  /* bumped whenever ra_next jumps */
+  gint ra_errno;                        /* errno of a failed read, or 0 */
+  gboolean ra_eos;
+  gboolean ra_flushing;
+  gboolean ra_stop;
+
+  gboolean use_mmap;                    /* use-mmap property */
+  gboolean mmapped;                     /* whether we serve from mappings */
+  gpointer mapping;                     /* current mapped window, or NULL */
+  guint64 mmap_file_size;               /* file size when last checked */
+  gsize pagesize;
 };
 
 struct _GstFileSrcClass {
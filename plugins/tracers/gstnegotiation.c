@@ -0,0 +1,435 @@
+/* GStreamer
+ * Copyright (C) 2018 GStreamer developers
+ *
+ * gstnegotiation.c: tracing module that logs caps negotiation costs
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+/**
+ * SECTION:element-negotiationtracer
+ * @short_description: log caps negotiation costs
+ *
+ * A tracing module that logs every caps and accept-caps query, every
+ * gst_caps_intersect_full() and every gst_caps_fixate() call with its
+ * duration and the number of caps structures involved.
+ *
+ * Queries that are sent while handling another query on the same thread are
+ * nested into it. For each query the time spent in nested queries is logged
+ * separately from the time spent in the query itself, together with the chain
+ * of pads along the slowest path of nested queries. Intersections and
+ * fixations are attributed to the innermost query that is being handled.
+ *
+ * gst-stats aggregates these logs per pad and lists the slowest negotiation
+ * chains.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstnegotiation.h"
+
+GST_DEBUG_CATEGORY_STATIC (gst_negotiation_debug);
+#define GST_CAT_DEFAULT gst_negotiation_debug
+
+#define _do_init \
+    GST_DEBUG_CATEGORY_INIT (gst_negotiation_debug, "negotiation", 0, \
+        "negotiation tracer");
+#define gst_negotiation_tracer_parent_class parent_class
+G_DEFINE_TYPE_WITH_CODE (GstNegotiationTracer, gst_negotiation_tracer,
+    GST_TYPE_TRACER, _do_init);
+
+static GstTracerRecord *tr_query;
+static GstTracerRecord *tr_intersect;
+static GstTracerRecord *tr_fixate;
+
+/* a query that is being handled */
+typedef struct
+{
+  GstPad *pad;
+  GstQuery *query;
+  gchar *pad_name;
+  GstClockTime start;
+  /* time spent in nested queries */
+  GstClockTime nested_time;
+  gboolean cached;
+  /* slowest chain of nested queries */
+  gchar *chain;
+  GstClockTime chain_time;
+} NegotiationFrame;
+
+typedef struct
+{
+  GArray *stack;
+  GstClockTime intersect_start;
+  GstClockTime fixate_start;
+  guint fixate_size;
+} NegotiationThread;
+
+static void
+clear_frame (NegotiationFrame * frame)
+{
+  g_free (frame->pad_name);
+  g_free (frame->chain);
+}
+
+static void
+free_thread (NegotiationThread * thread)
+{
+  g_array_free (thread->stack, TRUE);
+  g_slice_free (NegotiationThread, thread);
+}
+
+static GPrivate thread_key = G_PRIVATE_INIT ((GDestroyNotify) free_thread);
+
+/* data helpers */
+
+static NegotiationThread *
+get_thread (void)
+{
+  NegotiationThread *thread = g_private_get (&thread_key);
+
+  if (G_UNLIKELY (thread == NULL)) {
+    thread = g_slice_new0 (NegotiationThread);
+    thread->stack = g_array_new (FALSE, FALSE, sizeof (NegotiationFrame));
+    g_array_set_clear_func (thread->stack, (GDestroyNotify) clear_frame);
+    g_private_set (&thread_key, thread);
+  }
+  return thread;
+}
+
+static inline guint64
+get_thread_id (void)
+{
+  return (guint64) (guintptr) g_thread_self ();
+}
+
+static inline guint
+get_caps_size (GstCaps * caps)
+{
+  return caps ? gst_caps_get_size (caps) : 0;
+}
+
+static const gchar *
+get_current_pad_name (NegotiationThread * thread)
+{
+  if (thread->stack->len == 0)
+    return "";
+
+  return g_array_index (thread->stack, NegotiationFrame,
+      thread->stack->len - 1).pad_name;
+}
+
+static inline gboolean
+is_negotiation_query (GstQuery * query)
+{
+  return GST_QUERY_TYPE (query) == GST_QUERY_CAPS ||
+      GST_QUERY_TYPE (query) == GST_QUERY_ACCEPT_CAPS;
+}
+
+/* hooks */
+
+static void
+do_query_pre (GstTracer * self, guint64 ts, GstPad * pad, GstQuery * query)
+{
+  NegotiationThread *thread;
+  NegotiationFrame frame = { NULL, };
+
+  if (!is_negotiation_query (query))
+    return;
+
+  thread = get_thread ();
+
+  frame.pad = pad;
+  frame.query = query;
+  frame.pad_name = g_strdup_printf ("%s:%s", GST_DEBUG_PAD_NAME (pad));
+  frame.start = ts;
+  g_array_append_val (thread->stack, frame);
+}
+
+static void
+do_query_caps_cache (GstTracer * self, guint64 ts, GstPad * pad,
+    GstQuery * query, gboolean hit)
+{
+  NegotiationThread *thread = get_thread ();
+  NegotiationFrame *frame;
+
+  if (thread->stack->len == 0)
+    return;
+
+  frame = &g_array_index (thread->stack, NegotiationFrame,
+      thread->stack->len - 1);
+  if (frame->pad == pad && frame->query == query)
+    frame->cached = hit;
+}
+
+static void
+do_query_post (GstTracer * self, guint64 ts, GstPad * pad, GstQuery * query,
+    gboolean res)
+{
+  NegotiationThread *thread;
+  NegotiationFrame *frame, *parent;
+  GstClockTime time;
+  GstCaps *caps = NULL;
+  gchar *chain;
+  guint depth;
+
+  if (!is_negotiation_query (query))
+    return;
+
+  thread = get_thread ();
+
+  /* Find our frame. Queries that failed early don't call the post hook, drop
+   * the frames they left behind */
+  depth = thread->stack->len;
+  while (depth > 0) {
+    frame = &g_array_index (thread->stack, NegotiationFrame, depth - 1);
+    if (frame->pad == pad && frame->query == query)
+      break;
+    depth--;
+  }
+  if (depth == 0) {
+    GST_DEBUG ("no frame for query %" GST_PTR_FORMAT " on %s:%s", query,
+        GST_DEBUG_PAD_NAME (pad));
+    return;
+  }
+  depth--;
+  frame = &g_array_index (thread->stack, NegotiationFrame, depth);
+
+  time = GST_CLOCK_DIFF (frame->start, ts);
+  if (frame->chain)
+    chain = g_strdup_printf ("%s > %s", frame->pad_name, frame->chain);
+  else
+    chain = g_strdup (frame->pad_name);
+
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CAPS)
+    gst_query_parse_caps_result (query, &caps);
+  else
+    gst_query_parse_accept_caps (query, &caps);
+
+  gst_tracer_record_log (tr_query, get_thread_id (), ts, frame->pad_name,
+      depth > 0 ? g_array_index (thread->stack, NegotiationFrame,
+          depth - 1).pad_name : "", GST_QUERY_TYPE_NAME (query), res,
+      frame->cached, get_caps_size (caps), time,
+      time - MIN (frame->nested_time, time), depth, chain);
+
+  if (depth > 0) {
+    parent = &g_array_index (thread->stack, NegotiationFrame, depth - 1);
+    parent->nested_time += time;
+    if (parent->chain == NULL || time > parent->chain_time) {
+      g_free (parent->chain);
+      parent->chain = chain;
+      parent->chain_time = time;
+      chain = NULL;
+    }
+  }
+  g_free (chain);
+
+  g_array_set_size (thread->stack, depth);
+}
+
+static void
+do_caps_intersect_pre (GstTracer * self, guint64 ts, GstCaps * caps1,
+    GstCaps * caps2)
+{
+  get_thread ()->intersect_start = ts;
+}
+
+static void
+do_caps_intersect_post (GstTracer * self, guint64 ts, GstCaps * caps1,
+    GstCaps * caps2, GstCaps * res)
+{
+  NegotiationThread *thread = get_thread ();
+
+  gst_tracer_record_log (tr_intersect, get_thread_id (), ts,
+      get_current_pad_name (thread), get_caps_size (caps1),
+      get_caps_size (caps2), get_caps_size (res),
+      GST_CLOCK_DIFF (thread->intersect_start, ts));
+}
+
+static void
+do_caps_fixate_pre (GstTracer * self, guint64 ts, GstCaps * caps)
+{
+  NegotiationThread *thread = get_thread ();
+
+  thread->fixate_start = ts;
+  thread->fixate_size = get_caps_size (caps);
+}
+
+static void
+do_caps_fixate_post (GstTracer * self, guint64 ts, GstCaps * res)
+{
+  NegotiationThread *thread = get_thread ();
+
+  gst_tracer_record_log (tr_fixate, get_thread_id (), ts,
+      get_current_pad_name (thread), thread->fixate_size,
+      GST_CLOCK_DIFF (thread->fixate_start, ts));
+}
+
+/* tracer class */
+
+static void
+gst_negotiation_tracer_class_init (GstNegotiationTracerClass * klass)
+{
+  /* announce trace formats */
+  /* *INDENT-OFF* */
+  tr_query = gst_tracer_record_new ("negotiation-query.class",
+      "thread-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_THREAD,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the query returned",
+          NULL),
+      "pad", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "parent-pad", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "name", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING, "name of the query",
+          NULL),
+      "res", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_BOOLEAN,
+          "description", G_TYPE_STRING, "result of the query",
+          NULL),
+      "cached", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_BOOLEAN,
+          "description", G_TYPE_STRING, "result was taken from the caps cache",
+          NULL),
+      "caps-size", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT,
+          "description", G_TYPE_STRING, "number of structures in the caps",
+          "min", G_TYPE_UINT, 0,
+          "max", G_TYPE_UINT, G_MAXUINT,
+          NULL),
+      "time", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "time spent in the query in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "self-time", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING,
+              "time spent in the query but not in nested queries in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      "depth", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT,
+          "description", G_TYPE_STRING, "number of queries this is nested in",
+          "min", G_TYPE_UINT, 0,
+          "max", G_TYPE_UINT, G_MAXUINT,
+          NULL),
+      "chain", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "description", G_TYPE_STRING,
+              "pads along the slowest path of nested queries",
+          NULL),
+      NULL);
+  tr_intersect = gst_tracer_record_new ("negotiation-intersect.class",
+      "thread-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_THREAD,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the intersection finished",
+          NULL),
+      "pad", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "caps1-size", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT,
+          "description", G_TYPE_STRING, "number of structures in the first caps",
+          "min", G_TYPE_UINT, 0,
+          "max", G_TYPE_UINT, G_MAXUINT,
+          NULL),
+      "caps2-size", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT,
+          "description", G_TYPE_STRING, "number of structures in the second caps",
+          "min", G_TYPE_UINT, 0,
+          "max", G_TYPE_UINT, G_MAXUINT,
+          NULL),
+      "result-size", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT,
+          "description", G_TYPE_STRING, "number of structures in the result",
+          "min", G_TYPE_UINT, 0,
+          "max", G_TYPE_UINT, G_MAXUINT,
+          NULL),
+      "time", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "time spent intersecting in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      NULL);
+  tr_fixate = gst_tracer_record_new ("negotiation-fixate.class",
+      "thread-id", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_THREAD,
+          NULL),
+      "ts", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "ts when the fixation finished",
+          NULL),
+      "pad", GST_TYPE_STRUCTURE, gst_structure_new ("scope",
+          "type", G_TYPE_GTYPE, G_TYPE_STRING,
+          "related-to", GST_TYPE_TRACER_VALUE_SCOPE, GST_TRACER_VALUE_SCOPE_PAD,
+          NULL),
+      "caps-size", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT,
+          "description", G_TYPE_STRING, "number of structures before fixating",
+          "min", G_TYPE_UINT, 0,
+          "max", G_TYPE_UINT, G_MAXUINT,
+          NULL),
+      "time", GST_TYPE_STRUCTURE, gst_structure_new ("value",
+          "type", G_TYPE_GTYPE, G_TYPE_UINT64,
+          "description", G_TYPE_STRING, "time spent fixating in ns",
+          "min", G_TYPE_UINT64, G_GUINT64_CONSTANT (0),
+          "max", G_TYPE_UINT64, G_MAXUINT64,
+          NULL),
+      NULL);
+  /* *INDENT-ON* */
+}
+
+static void
+gst_negotiation_tracer_init (GstNegotiationTracer * self)
+{
+  GstTracer *tracer = GST_TRACER (self);
+
+  gst_tracing_register_hook (tracer, "pad-query-pre",
+      G_CALLBACK (do_query_pre));
+  gst_tracing_register_hook (tracer, "pad-query-caps-cache",
+      G_CALLBACK (do_query_caps_cache));
+  gst_tracing_register_hook (tracer, "pad-query-post",
+      G_CALLBACK (do_query_post));
+  gst_tracing_register_hook (tracer, "caps-intersect-pre",
+      G_CALLBACK (do_caps_intersect_pre));
+  gst_tracing_register_hook (tracer, "caps-intersect-post",
+      G_CALLBACK (do_caps_intersect_post));
+  gst_tracing_register_hook (tracer, "caps-fixate-pre",
+      G_CALLBACK (do_caps_fixate_pre));
+  gst_tracing_register_hook (tracer, "caps-fixate-post",
+      G_CALLBACK (do_caps_fixate_post));
+}
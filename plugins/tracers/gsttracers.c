@@ -26,6 +26,7 @@
 #include <gst/gst.h>
 #include "gstlatency.h"
 #include "gstlog.h"
+#include "gstnegotiation.h"
 #include "gstrusage.h"
 #include "gststats.h"
 #include "gstleaks.h"
@@ -39,6 +40,9 @@ plugin_init (GstPlugin * plugin)
   if (!gst_tracer_register (plugin, "log", gst_log_tracer_get_type ()))
     return FALSE;
 #endif
+  if (!gst_tracer_register (plugin, "negotiation",
+          gst_negotiation_tracer_get_type ()))
+    return FALSE;
 #ifdef HAVE_GETRUSAGE
   if (!gst_tracer_register (plugin, "rusage", gst_rusage_tracer_get_type ()))
     return FALSE;
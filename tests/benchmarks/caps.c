@@ -24,6 +24,8 @@
 
 
 #define NUM_CAPS 10000
+#define NUM_LOOKUPS 1000000
+#define NUM_FIELDS 32
 
 #define AUDIO_FORMATS_ALL " { S8, U8, " \
     "S16LE, S16BE, U16LE, U16BE, " \
@@ -45,7 +47,9 @@ gint
 main (gint argc, gchar * argv[])
 {
   GstCaps **capses;
-  GstCaps *protocaps;
+  GstCaps *protocaps, *fixedcaps, *res;
+  GstStructure *s;
+  GQuark fields[NUM_FIELDS];
   GstClockTime start, end;
   gint i;
 
@@ -69,7 +73,89 @@ main (gint argc, gchar * argv[])
       GST_TIME_ARGS (end - start), i);
 
   g_free (capses);
+
+  fixedcaps = gst_caps_from_string ("audio/x-raw, format=(string)F32LE, "
+      "rate=(int)48000, channels=(int)2");
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++) {
+    res = gst_caps_intersect (fixedcaps, protocaps);
+    gst_caps_unref (res);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - intersecting %d fixed caps\n",
+      GST_TIME_ARGS (end - start), i);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++)
+    gst_caps_is_subset (fixedcaps, protocaps);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - checking %d fixed caps for subset\n",
+      GST_TIME_ARGS (end - start), i);
+  gst_caps_unref (fixedcaps);
+
+  fixedcaps = gst_caps_from_string ("audio/x-raw, format=(string)"
+      "{ F64BE, F64LE, F32BE, F32LE, S32BE, S32LE, S16BE, S16LE, U8, S8 }");
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++) {
+    res = gst_caps_intersect (fixedcaps, protocaps);
+    gst_caps_unref (res);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - intersecting %d format lists\n",
+      GST_TIME_ARGS (end - start), i);
+  gst_caps_unref (fixedcaps);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++) {
+    gchar *str = gst_caps_to_string (protocaps);
+
+    res = gst_caps_from_string (str);
+    gst_caps_unref (res);
+    g_free (str);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %d caps to and from string\n",
+      GST_TIME_ARGS (end - start), i);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++) {
+    GBytes *bytes = gst_caps_to_bytes (protocaps);
+
+    res = gst_caps_new_from_bytes (bytes);
+    gst_caps_unref (res);
+    g_bytes_unref (bytes);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %d caps to and from bytes\n",
+      GST_TIME_ARGS (end - start), i);
+
+  s = gst_caps_get_structure (protocaps, 0);
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_LOOKUPS; i++)
+    gst_structure_get_value (s, "channels");
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %d lookups in %d fields\n",
+      GST_TIME_ARGS (end - start), i, gst_structure_n_fields (s));
+
   gst_caps_unref (protocaps);
 
+  s = gst_structure_new_empty ("test/large");
+  for (i = 0; i < NUM_FIELDS; i++) {
+    gchar *name = g_strdup_printf ("field-%d", i);
+
+    fields[i] = g_quark_from_string (name);
+    gst_structure_id_set (s, fields[i], G_TYPE_INT, i, NULL);
+    g_free (name);
+  }
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_LOOKUPS; i++)
+    gst_structure_id_get_value (s, fields[i % NUM_FIELDS]);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %d lookups in %d fields\n",
+      GST_TIME_ARGS (end - start), i, gst_structure_n_fields (s));
+
+  gst_structure_free (s);
+
   return 0;
 }
@@ -28,6 +28,10 @@
  *  -c children: is the number of branches on each level
  *  -f <flavour>: can be "audio" or "video" and is controlling the kind of
  *                elements that are used.
+ *  -C: sets GST_PAD_FLAG_CACHE_CAPS on all pads
+ *
+ * Afterwards the time for repeated caps queries on the sink's peer pad is
+ * measured.
  */
 
 #include <gst/gst.h>
@@ -181,6 +185,21 @@ event_loop (GstElement * bin)
   gst_object_unref (bus);
 }
 
+static gboolean
+set_cache_caps (GstElement * element, GstPad * pad, gpointer user_data)
+{
+  GST_PAD_SET_CACHE_CAPS (pad);
+  return TRUE;
+}
+
+static void
+set_cache_caps_on_element (const GValue * item, gpointer user_data)
+{
+  GstElement *element = g_value_get_object (item);
+
+  gst_element_foreach_pad (element, set_cache_caps, NULL);
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
@@ -190,6 +209,7 @@ main (gint argc, gchar * argv[])
   gint children = 3;
   gint depth = 4;
   gint loops = 50;
+  gboolean cache_caps = FALSE;
 
   GOptionContext *ctx;
   GOptionEntry options[] = {
@@ -206,12 +226,18 @@ main (gint argc, gchar * argv[])
     {"loops", 'l', 0, G_OPTION_ARG_INT, &loops,
         "How many loops to run (default: 50)", NULL}
     ,
+    {"cache-caps", 'C', 0, G_OPTION_ARG_NONE, &cache_caps,
+        "Cache caps query results on all pads", NULL}
+    ,
     {NULL}
   };
   GError *err = NULL;
   GstBin *bin;
   GstClockTime start, end;
   GstElement *sink, *new_sink;
+  GstIterator *it;
+  GstPad *pad;
+  GstCaps *caps;
   gint i;
 
   g_set_prgname ("capsnego");
@@ -251,6 +277,12 @@ main (gint argc, gchar * argv[])
   g_print ("%" GST_TIME_FORMAT " built pipeline with %d elements\n",
       GST_TIME_ARGS (end - start), GST_BIN_NUMCHILDREN (bin));
 
+  if (cache_caps) {
+    it = gst_bin_iterate_elements (bin);
+    gst_iterator_foreach (it, set_cache_caps_on_element, NULL);
+    gst_iterator_free (it);
+  }
+
   /* measure */
   g_print ("starting pipeline\n");
   gst_element_set_state (GST_ELEMENT (bin), GST_STATE_READY);
@@ -265,6 +297,17 @@ main (gint argc, gchar * argv[])
   end = gst_util_get_timestamp ();
   g_print ("%" GST_TIME_FORMAT " reached PAUSED state (%d loop iterations)\n",
       GST_TIME_ARGS (end - start), loops);
+
+  pad = gst_element_get_static_pad (sink, "sink");
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < loops; ++i) {
+    caps = gst_pad_peer_query_caps (pad, NULL);
+    gst_caps_unref (caps);
+  }
+  end = gst_util_get_timestamp ();
+  gst_object_unref (pad);
+  g_print ("%" GST_TIME_FORMAT " for %d caps queries%s\n",
+      GST_TIME_ARGS (end - start), loops, cache_caps ? " (cached)" : "");
   /* clean up */
 Error:
   gst_element_set_state (GST_ELEMENT (bin), GST_STATE_NULL);
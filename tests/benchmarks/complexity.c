@@ -21,6 +21,8 @@
 #include <stdlib.h>
 #include <gst/gst.h>
 
+#include "state-changes.h"
+
 #define BUFFER_COUNT (1000)
 
 gint
@@ -93,6 +95,8 @@ main (gint argc, gchar * argv[])
   g_print ("%" GST_TIME_FORMAT " - creating and linking %u elements\n",
       GST_TIME_ARGS (end - start), i);
 
+  benchmark_state_changes (pipeline, i + 1);
+
   start = gst_util_get_timestamp ();
   if (gst_element_set_state (pipeline,
           GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
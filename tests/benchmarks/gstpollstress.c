@@ -20,7 +20,12 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <gst/gst.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
 #include "gst/glib-compat-private.h"
 
 static GstPoll *set;
@@ -136,6 +141,81 @@ run_test (void *threadid)
   return NULL;
 }
 
+#ifdef G_OS_UNIX
+#define SCALING_ITERATIONS 10000
+
+/* measure the cost of a wakeup with one readable fd among @num_fds idle ones,
+ * toggling the read interest of another fd in between like multi-client
+ * sinks do */
+static gboolean
+run_scaling_one (gint num_fds)
+{
+  GstPoll *pset;
+  GstPollFD *pfds;
+  gint *socks;
+  gint i, created;
+  gboolean ok = TRUE;
+
+  pset = gst_poll_new (TRUE);
+  pfds = g_new0 (GstPollFD, num_fds);
+  socks = g_new0 (gint, 2 * num_fds);
+
+  for (created = 0; created < num_fds; created++) {
+    if (socketpair (PF_UNIX, SOCK_STREAM, 0, &socks[2 * created]) < 0) {
+      g_print ("%8d  could not create sockets: %s\n", num_fds,
+          g_strerror (errno));
+      ok = FALSE;
+      goto done;
+    }
+    gst_poll_fd_init (&pfds[created]);
+    pfds[created].fd = socks[2 * created];
+    gst_poll_add_fd (pset, &pfds[created]);
+    gst_poll_fd_ctl_read (pset, &pfds[created], TRUE);
+  }
+
+  if (write (socks[1], "X", 1) != 1) {
+    ok = FALSE;
+    goto done;
+  }
+
+  g_timer_start (timer);
+  for (i = 0; i < SCALING_ITERATIONS; i++) {
+    gst_poll_fd_ctl_read (pset, &pfds[num_fds - 1], (i & 1));
+    if (gst_poll_wait (pset, 0) != 1
+        || !gst_poll_fd_can_read (pset, &pfds[0])) {
+      g_print ("%8d  unexpected poll result\n", num_fds);
+      ok = FALSE;
+      goto done;
+    }
+  }
+  g_print ("%8d %14.3f\n", num_fds,
+      g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC / SCALING_ITERATIONS);
+
+done:
+  gst_poll_free (pset);
+  for (i = 0; i < created; i++) {
+    close (socks[2 * i]);
+    close (socks[2 * i + 1]);
+  }
+  g_free (socks);
+  g_free (pfds);
+
+  return ok;
+}
+
+static void
+run_scaling (gint max_fds)
+{
+  gint num_fds;
+
+  g_print ("%8s %14s\n", "fds", "usec/wakeup");
+  for (num_fds = 4; num_fds <= max_fds; num_fds *= 2) {
+    if (!run_scaling_one (num_fds))
+      break;
+  }
+}
+#endif
+
 gint
 main (gint argc, gchar * argv[])
 {
@@ -148,8 +228,18 @@ main (gint argc, gchar * argv[])
   g_mutex_init (&fdlock);
   timer = g_timer_new ();
 
+#ifdef G_OS_UNIX
+  if (argc == 3 && !strcmp (argv[1], "--scaling")) {
+    run_scaling (atoi (argv[2]));
+    return 0;
+  }
+#endif
+
   if (argc != 2) {
     g_print ("usage: %s <num_threads>\n", argv[0]);
+#ifdef G_OS_UNIX
+    g_print ("       %s --scaling <max_fds>\n", argv[0]);
+#endif
     exit (-1);
   }
 
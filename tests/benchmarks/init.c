@@ -22,10 +22,60 @@
 
 #include <gst/gst.h>
 
+#ifdef G_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+static void
+print_rss (const gchar * what)
+{
+#ifdef G_OS_UNIX
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) == 0)
+    g_print ("%ld kB max RSS - %s\n", (glong) usage.ru_maxrss, what);
+#endif
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
+  GstClockTime start, end;
+  GList *factories, *res;
+  GstCaps *caps;
+
+  start = gst_util_get_timestamp ();
   gst_init (&argc, &argv);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - gst_init\n", GST_TIME_ARGS (end - start));
+  print_rss ("after gst_init");
+
+  start = gst_util_get_timestamp ();
+  factories = gst_element_factory_list_get_elements
+      (GST_ELEMENT_FACTORY_TYPE_DECODABLE, GST_RANK_MARGINAL);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - listing %u decodable factories\n",
+      GST_TIME_ARGS (end - start), g_list_length (factories));
+
+  caps = gst_caps_from_string ("video/x-h264, stream-format=(string)avc, "
+      "alignment=(string)au");
+  start = gst_util_get_timestamp ();
+  res = gst_element_factory_list_filter (factories, caps, GST_PAD_SINK, FALSE);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - filtering for %u factories\n",
+      GST_TIME_ARGS (end - start), g_list_length (res));
+  gst_plugin_feature_list_free (res);
+
+  start = gst_util_get_timestamp ();
+  res = gst_element_factory_list_filter (factories, caps, GST_PAD_SINK, FALSE);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - filtering again\n",
+      GST_TIME_ARGS (end - start));
+  gst_plugin_feature_list_free (res);
+  print_rss ("after filtering");
+
+  gst_caps_unref (caps);
+  gst_plugin_feature_list_free (factories);
 
   return 0;
 }
@@ -20,12 +20,13 @@
 #include <stdlib.h>
 #include <gst/gst.h>
 
+#include "state-changes.h"
+
 #define IDENTITY_COUNT (1000)
 #define BUFFER_COUNT (1000)
 #define SRC_ELEMENT "fakesrc"
 #define SINK_ELEMENT "fakesink"
 
-
 gint
 main (gint argc, gchar * argv[])
 {
@@ -81,6 +82,8 @@ main (gint argc, gchar * argv[])
   g_print ("%" GST_TIME_FORMAT " - creating %u identity elements\n",
       GST_TIME_ARGS (end - start), identities);
 
+  benchmark_state_changes (pipeline, identities + 2);
+
   start = gst_util_get_timestamp ();
   if (gst_element_set_state (pipeline,
           GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2004 Benjamin Otte <otte@gnome.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* shared by the complexity and mass-elements benchmarks */
+
+#ifndef __BENCHMARKS_STATE_CHANGES_H__
+#define __BENCHMARKS_STATE_CHANGES_H__
+
+#include <gst/gst.h>
+
+#define STATE_CHANGE_COUNT (20)
+#define SORT_COUNT (100)
+
+/* measure the time needed by state changes of the pipeline and by the
+ * topological sort of its children, as a function of the element count */
+static void
+benchmark_state_changes (GstElement * pipeline, guint n_elements)
+{
+  GstClockTime start, end;
+  GstIterator *it;
+  GValue item = { 0, };
+  guint i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < STATE_CHANGE_COUNT; i++) {
+    if (gst_element_set_state (pipeline,
+            GST_STATE_READY) != GST_STATE_CHANGE_SUCCESS)
+      g_assert_not_reached ();
+    if (gst_element_set_state (pipeline,
+            GST_STATE_NULL) != GST_STATE_CHANGE_SUCCESS)
+      g_assert_not_reached ();
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %u NULL -> READY -> NULL cycles with %u "
+      "elements (%" GST_TIME_FORMAT " per cycle)\n",
+      GST_TIME_ARGS (end - start), STATE_CHANGE_COUNT, n_elements,
+      GST_TIME_ARGS ((end - start) / STATE_CHANGE_COUNT));
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < SORT_COUNT; i++) {
+    it = gst_bin_iterate_sorted (GST_BIN (pipeline));
+    while (gst_iterator_next (it, &item) == GST_ITERATOR_OK)
+      g_value_reset (&item);
+    gst_iterator_free (it);
+  }
+  g_value_unset (&item);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - %u sorted iterations over %u elements "
+      "(%" GST_TIME_FORMAT " per iteration)\n",
+      GST_TIME_ARGS (end - start), SORT_COUNT, n_elements,
+      GST_TIME_ARGS ((end - start) / SORT_COUNT));
+}
+
+#endif /* __BENCHMARKS_STATE_CHANGES_H__ */
@@ -30,7 +30,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <string.h>
 
+#include <glib/gstdio.h>
 #include <gst/check/gstcheck.h>
 
 static gboolean have_eos = FALSE;
@@ -202,6 +204,61 @@ GST_START_TEST (test_seeking)
 
 GST_END_TEST;
 
+GST_START_TEST (test_zero_copy)
+{
+  GstElement *pipe, *src, *sink;
+  GstMessage *msg;
+  gchar *in_name, *out_name, *out_data;
+  guint8 data[10000];
+  gsize out_len;
+  gint in_fd, out_fd;
+  guint i;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i % 251;
+
+  in_fd = g_file_open_tmp (NULL, &in_name, NULL);
+  fail_unless (in_fd >= 0);
+  fail_unless (write (in_fd, data, sizeof (data)) == sizeof (data));
+  fail_unless (lseek (in_fd, 0, SEEK_SET) == 0);
+  out_fd = g_file_open_tmp (NULL, &out_name, NULL);
+  fail_unless (out_fd >= 0);
+
+  pipe = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("fdsrc", NULL);
+  sink = gst_element_factory_make ("fdsink", NULL);
+  fail_unless (src != NULL && sink != NULL);
+  g_object_set (src, "fd", in_fd, "zero-copy", TRUE, "blocksize", 3000, NULL);
+  g_object_set (sink, "fd", out_fd, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipe), src, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  fail_unless (gst_element_set_state (pipe,
+          GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipe),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  fail_unless (gst_element_set_state (pipe,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipe);
+
+  /* the output has to be the same, however it got copied */
+  fail_unless (g_file_get_contents (out_name, &out_data, &out_len, NULL));
+  fail_unless_equals_int (out_len, sizeof (data));
+  fail_unless (memcmp (out_data, data, sizeof (data)) == 0);
+  g_free (out_data);
+
+  close (in_fd);
+  close (out_fd);
+  g_remove (in_name);
+  g_remove (out_name);
+  g_free (in_name);
+  g_free (out_name);
+}
+
+GST_END_TEST;
+
 static Suite *
 fdsrc_suite (void)
 {
@@ -212,6 +269,7 @@ fdsrc_suite (void)
   tcase_add_test (tc_chain, test_num_buffers);
   tcase_add_test (tc_chain, test_nonseeking);
   tcase_add_test (tc_chain, test_seeking);
+  tcase_add_test (tc_chain, test_zero_copy);
 
   return s;
 }
@@ -381,6 +381,130 @@ GST_START_TEST (test_flush)
 
 GST_END_TEST;
 
+GST_START_TEST (test_write_behind)
+{
+  GstElement *filesink;
+  gchar *tmp_fn;
+  GstSegment segment;
+
+  tmp_fn = create_temporary_file ();
+  if (tmp_fn == NULL)
+    return;
+  filesink = setup_filesink ();
+
+  sync_buffers = FALSE;
+
+  GST_LOG ("using temp file '%s'", tmp_fn);
+  g_object_set (filesink, "location", tmp_fn, "write-behind", (guint64) 1000,
+      NULL);
+  gst_util_set_object_arg (G_OBJECT (filesink), "buffer-mode", "unbuffered");
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  /* the position includes data the writer thread did not write yet */
+  PUSH_BYTES (100);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 100);
+  PUSH_BYTES (8800);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 8900);
+  PUSH_BUFFER_LIST (3, 10);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 8930);
+
+  /* seeking waits for pending writes */
+  segment.start = 100;
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 100);
+  CHECK_WRITTEN_BYTES (100, 8800, 8930);
+  CHECK_WRITTEN_BYTES (8920, 10, 8930);
+
+  PUSH_BYTES (50);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 150);
+
+  /* so does EOS */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  CHECK_WRITTEN_BYTES (0, 100, 8930);
+  CHECK_WRITTEN_BYTES (100, 50, 8930);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cleanup_filesink (filesink);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_o_direct)
+{
+  GstElement *filesink;
+  gchar *tmp_fn;
+  GstSegment segment;
+
+  tmp_fn = create_temporary_file ();
+  if (tmp_fn == NULL)
+    return;
+  filesink = setup_filesink ();
+
+  sync_buffers = FALSE;
+
+  GST_LOG ("using temp file '%s'", tmp_fn);
+  g_object_set (filesink, "location", tmp_fn, "o-direct", TRUE,
+      "buffer-size", 4096, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  /* writes of any size are staged and written out in whole blocks */
+  PUSH_BYTES (100);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 100);
+  PUSH_BYTES (8800);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 8900);
+  PUSH_BYTES (70000);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 78900);
+  PUSH_BUFFER_LIST (3, 10);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 78930);
+
+  /* seeking writes out the partial block first */
+  segment.start = 100;
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 100);
+  CHECK_WRITTEN_BYTES (100, 8800, 78930);
+  CHECK_WRITTEN_BYTES (8900, 70000, 78930);
+  CHECK_WRITTEN_BYTES (78920, 10, 78930);
+
+  /* writing from an unaligned position */
+  PUSH_BYTES (50);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 150);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  CHECK_WRITTEN_BYTES (0, 100, 78930);
+  CHECK_WRITTEN_BYTES (100, 50, 78930);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cleanup_filesink (filesink);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_coverage)
 {
   GstElement *filesink;
@@ -496,6 +620,8 @@ filesink_suite (void)
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_seeking);
   tcase_add_test (tc_chain, test_flush);
+  tcase_add_test (tc_chain, test_write_behind);
+  tcase_add_test (tc_chain, test_o_direct);
 
   return s;
 }
@@ -303,6 +303,135 @@ GST_START_TEST (test_pull)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pull_read_ahead)
+{
+  GstElement *src;
+  GstPad *pad;
+  GstFlowReturn ret;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gchar *contents;
+  gsize size, offset;
+
+  fail_unless (g_file_get_contents (TESTFILE, &contents, &size, NULL));
+  fail_unless (size > 1000);
+
+  src = setup_filesrc ();
+
+  g_object_set (G_OBJECT (src), "location", TESTFILE, "read-ahead", 4, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to ready");
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  /* read the whole file sequentially, the last block is a short one */
+  for (offset = 0; offset < size; offset += 100) {
+    buffer = NULL;
+    ret = gst_pad_get_range (pad, offset, 100, &buffer);
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+    fail_unless_equals_int (gst_buffer_get_size (buffer),
+        MIN (100, size - offset));
+    fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), offset);
+    fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+    fail_unless (memcmp (info.data, contents + offset, info.size) == 0);
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
+  }
+
+  buffer = NULL;
+  ret = gst_pad_get_range (pad, size, 100, &buffer);
+  fail_unless_equals_int (ret, GST_FLOW_EOS);
+
+  /* jumping back restarts reading ahead at the new position */
+  buffer = NULL;
+  ret = gst_pad_get_range (pad, 10, 50, &buffer);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+  fail_unless_equals_int (info.size, 50);
+  fail_unless (memcmp (info.data, contents + 10, 50) == 0);
+  gst_buffer_unmap (buffer, &info);
+  gst_buffer_unref (buffer);
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  gst_object_unref (pad);
+  cleanup_filesrc (src);
+  g_free (contents);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pull_mmap)
+{
+  GstElement *src;
+  GstPad *pad;
+  GstFlowReturn ret;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gchar *contents;
+  gsize size, offset;
+
+  fail_unless (g_file_get_contents (TESTFILE, &contents, &size, NULL));
+  fail_unless (size > 1000);
+
+  src = setup_filesrc ();
+
+  g_object_set (G_OBJECT (src), "location", TESTFILE, "use-mmap", TRUE, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to ready");
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  for (offset = 0; offset < size; offset += 333) {
+    buffer = NULL;
+    ret = gst_pad_get_range (pad, offset, 333, &buffer);
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+    fail_unless_equals_int (gst_buffer_get_size (buffer),
+        MIN (333, size - offset));
+    fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+    fail_unless (memcmp (info.data, contents + offset, info.size) == 0);
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
+  }
+
+  buffer = NULL;
+  ret = gst_pad_get_range (pad, size, 10, &buffer);
+  fail_unless_equals_int (ret, GST_FLOW_EOS);
+
+  /* buffers stay valid after the element released the file */
+  buffer = NULL;
+  ret = gst_pad_get_range (pad, 1, 100, &buffer);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+  fail_unless_equals_int (info.size, 100);
+  fail_unless (memcmp (info.data, contents + 1, 100) == 0);
+  gst_buffer_unmap (buffer, &info);
+  gst_buffer_unref (buffer);
+
+  gst_object_unref (pad);
+  cleanup_filesrc (src);
+  g_free (contents);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_coverage)
 {
   GstElement *src;
@@ -554,6 +683,8 @@ filesrc_suite (void)
   tcase_add_test (tc_chain, test_seeking);
   tcase_add_test (tc_chain, test_reverse);
   tcase_add_test (tc_chain, test_pull);
+  tcase_add_test (tc_chain, test_pull_read_ahead);
+  tcase_add_test (tc_chain, test_pull_mmap);
   tcase_add_test (tc_chain, test_coverage);
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_uri_query);
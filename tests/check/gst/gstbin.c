@@ -1042,6 +1042,81 @@ GST_START_TEST (test_children_state_change_order_two_sink)
 
 GST_END_TEST;
 
+#define NUM_BRANCHES 4
+
+GST_START_TEST (test_parallel_state_change)
+{
+  GstElement *src[NUM_BRANCHES], *sink[NUM_BRANCHES], *pipeline;
+  gint src_pos[NUM_BRANCHES], sink_pos[NUM_BRANCHES];
+  GstStateChangeReturn ret;
+  GstState current, pending;
+  GstMessage *msg;
+  GstBus *bus;
+  gint i, pos = 0;
+  gboolean parallel;
+
+  pipeline = gst_pipeline_new (NULL);
+  g_object_set (pipeline, "parallel-state-change", TRUE, NULL);
+  g_object_get (pipeline, "parallel-state-change", &parallel, NULL);
+  fail_unless (parallel);
+
+  bus = gst_element_get_bus (pipeline);
+
+  for (i = 0; i < NUM_BRANCHES; i++) {
+    src[i] = gst_element_factory_make ("fakesrc", NULL);
+    sink[i] = gst_element_factory_make ("fakesink", NULL);
+    src_pos[i] = sink_pos[i] = -1;
+    gst_bin_add_many (GST_BIN (pipeline), src[i], sink[i], NULL);
+    fail_unless (gst_element_link (src[i], sink[i]));
+  }
+
+  ret = gst_element_set_state (pipeline, GST_STATE_READY);
+  fail_unless_equals_int (ret, GST_STATE_CHANGE_SUCCESS);
+
+  /* all sinks must have changed state before the sources */
+  while ((msg = gst_bus_pop_filtered (bus, GST_MESSAGE_STATE_CHANGED))) {
+    for (i = 0; i < NUM_BRANCHES; i++) {
+      if (GST_MESSAGE_SRC (msg) == GST_OBJECT (src[i]))
+        src_pos[i] = pos;
+      else if (GST_MESSAGE_SRC (msg) == GST_OBJECT (sink[i]))
+        sink_pos[i] = pos;
+    }
+    pos++;
+    gst_message_unref (msg);
+  }
+  for (i = 0; i < NUM_BRANCHES; i++) {
+    fail_unless (sink_pos[i] >= 0);
+    fail_unless (src_pos[i] >= 0);
+    fail_unless (sink_pos[i] < src_pos[i]);
+    fail_unless (sink_pos[i] < NUM_BRANCHES);
+  }
+
+  ret = gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  fail_unless_equals_int (ret, GST_STATE_CHANGE_ASYNC);
+  ret = gst_element_get_state (pipeline, &current, &pending,
+      GST_CLOCK_TIME_NONE);
+  fail_unless_equals_int (ret, GST_STATE_CHANGE_SUCCESS);
+  fail_unless_equals_int (current, GST_STATE_PAUSED);
+  for (i = 0; i < NUM_BRANCHES; i++) {
+    fail_unless_equals_int (GST_STATE (src[i]), GST_STATE_PAUSED);
+    fail_unless_equals_int (GST_STATE (sink[i]), GST_STATE_PAUSED);
+  }
+
+  ret = gst_element_set_state (pipeline, GST_STATE_NULL);
+  fail_unless_equals_int (ret, GST_STATE_CHANGE_SUCCESS);
+  for (i = 0; i < NUM_BRANCHES; i++) {
+    fail_unless_equals_int (GST_STATE (src[i]), GST_STATE_NULL);
+    fail_unless_equals_int (GST_STATE (sink[i]), GST_STATE_NULL);
+  }
+
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+#undef NUM_BRANCHES
+
 GST_START_TEST (test_iterate_sorted)
 {
   GstElement *src, *tee, *identity, *sink1, *sink2, *pipeline, *bin;
@@ -1101,6 +1176,223 @@ GST_START_TEST (test_iterate_sorted)
 
 GST_END_TEST;
 
+/* check that the sort order is updated after the cached order was used */
+GST_START_TEST (test_iterate_sorted_cached)
+{
+  GstElement *pipeline, *src, *sink, *identity;
+  GstIterator *it;
+  GValue elem = { 0, };
+  gint i;
+
+  pipeline = gst_pipeline_new (NULL);
+  fail_unless (pipeline != NULL, "Could not create pipeline");
+
+  src = gst_element_factory_make ("fakesrc", NULL);
+  identity = gst_element_factory_make ("identity", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, identity, sink, NULL);
+  fail_unless (gst_element_link_many (src, identity, sink, NULL));
+
+  /* the second iteration uses the cached order */
+  for (i = 0; i < 2; i++) {
+    it = gst_bin_iterate_sorted (GST_BIN (pipeline));
+    fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+    fail_unless (g_value_get_object (&elem) == (gpointer) sink);
+    g_value_reset (&elem);
+
+    fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+    fail_unless (g_value_get_object (&elem) == (gpointer) identity);
+    g_value_reset (&elem);
+
+    fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+    fail_unless (g_value_get_object (&elem) == (gpointer) src);
+    g_value_reset (&elem);
+
+    fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_DONE);
+    gst_iterator_free (it);
+  }
+
+  /* relinking invalidates the cached order */
+  gst_element_unlink_many (src, identity, sink, NULL);
+  fail_unless (gst_element_link (src, sink));
+
+  it = gst_bin_iterate_sorted (GST_BIN (pipeline));
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&elem) == (gpointer) sink);
+  g_value_reset (&elem);
+
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&elem) == (gpointer) src);
+  g_value_reset (&elem);
+
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&elem) == (gpointer) identity);
+  g_value_reset (&elem);
+
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_DONE);
+  gst_iterator_free (it);
+
+  /* removing an element invalidates the cached order */
+  gst_bin_remove (GST_BIN (pipeline), identity);
+
+  it = gst_bin_iterate_sorted (GST_BIN (pipeline));
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&elem) == (gpointer) sink);
+  g_value_reset (&elem);
+
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_OK);
+  fail_unless (g_value_get_object (&elem) == (gpointer) src);
+  g_value_reset (&elem);
+
+  fail_unless (gst_iterator_next (it, &elem) == GST_ITERATOR_DONE);
+
+  g_value_unset (&elem);
+  gst_iterator_free (it);
+
+  ASSERT_OBJECT_REFCOUNT (pipeline, "pipeline", 1);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+count_latency_queries (GstPad * pad, GstPadProbeInfo * info, gpointer data)
+{
+  if (GST_QUERY_TYPE (GST_PAD_PROBE_INFO_QUERY (info)) == GST_QUERY_LATENCY)
+    g_atomic_int_inc ((gint *) data);
+
+  return GST_PAD_PROBE_OK;
+}
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gint queries;
+  /* reported by the source when valid */
+  GstClockTime latency;
+  /* the sink got a LATENCY event */
+  gboolean configured;
+} LatencyTestData;
+
+static GstPadProbeReturn
+answer_latency_queries (GstPad * pad, GstPadProbeInfo * info, gpointer data)
+{
+  LatencyTestData *test = data;
+  GstQuery *query = GST_PAD_PROBE_INFO_QUERY (info);
+  GstClockTime latency;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_LATENCY)
+    return GST_PAD_PROBE_OK;
+
+  g_mutex_lock (&test->lock);
+  test->queries++;
+  latency = test->latency;
+  g_mutex_unlock (&test->lock);
+
+  if (!GST_CLOCK_TIME_IS_VALID (latency))
+    return GST_PAD_PROBE_OK;
+
+  gst_query_set_latency (query, TRUE, latency, GST_CLOCK_TIME_NONE);
+  return GST_PAD_PROBE_HANDLED;
+}
+
+static GstPadProbeReturn
+signal_latency_event (GstPad * pad, GstPadProbeInfo * info, gpointer data)
+{
+  LatencyTestData *test = data;
+
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) == GST_EVENT_LATENCY) {
+    g_mutex_lock (&test->lock);
+    test->configured = TRUE;
+    g_cond_signal (&test->cond);
+    g_mutex_unlock (&test->lock);
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_incremental_latency)
+{
+  GstElement *pipeline, *src1, *sink1, *src2, *sink2;
+  LatencyTestData test;
+  GstPad *pad;
+  gint count2 = 0;
+
+  g_mutex_init (&test.lock);
+  g_cond_init (&test.cond);
+  test.queries = 0;
+  test.latency = GST_CLOCK_TIME_NONE;
+  test.configured = FALSE;
+
+  pipeline = gst_pipeline_new (NULL);
+  g_object_set (pipeline, "incremental-latency", TRUE, NULL);
+
+  src1 = gst_element_factory_make ("fakesrc", NULL);
+  sink1 = gst_element_factory_make ("fakesink", NULL);
+  src2 = gst_element_factory_make ("fakesrc", NULL);
+  sink2 = gst_element_factory_make ("fakesink", NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src1, sink1, src2, sink2, NULL);
+  fail_unless (gst_element_link (src1, sink1));
+  fail_unless (gst_element_link (src2, sink2));
+
+  pad = gst_element_get_static_pad (src1, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_QUERY_UPSTREAM,
+      answer_latency_queries, &test, NULL);
+  gst_object_unref (pad);
+  pad = gst_element_get_static_pad (src2, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_QUERY_UPSTREAM,
+      count_latency_queries, &count2, NULL);
+  gst_object_unref (pad);
+  /* the sink forwards the LATENCY event it was configured with upstream */
+  pad = gst_element_get_static_pad (sink1, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_EVENT_UPSTREAM,
+      signal_latency_event, &test, NULL);
+  gst_object_unref (pad);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) ==
+      GST_STATE_CHANGE_ASYNC);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+
+  /* the second recalculation uses the cached results */
+  g_mutex_lock (&test.lock);
+  test.queries = 0;
+  g_mutex_unlock (&test.lock);
+  g_atomic_int_set (&count2, 0);
+  fail_unless (gst_bin_recalculate_latency (GST_BIN (pipeline)));
+  fail_unless (gst_bin_recalculate_latency (GST_BIN (pipeline)));
+  fail_unless_equals_int (test.queries, 1);
+  fail_unless_equals_int (g_atomic_int_get (&count2), 1);
+
+  /* a latency change in the first branch only requeries that branch, the
+   * pipeline recalculates the latency by itself and configures the new
+   * latency on the sinks */
+  g_mutex_lock (&test.lock);
+  test.latency = 10 * GST_MSECOND;
+  test.configured = FALSE;
+  g_mutex_unlock (&test.lock);
+  gst_element_post_message (src1,
+      gst_message_new_latency (GST_OBJECT_CAST (src1)));
+
+  g_mutex_lock (&test.lock);
+  while (!test.configured)
+    g_cond_wait (&test.cond, &test.lock);
+  fail_unless_equals_int (test.queries, 2);
+  g_mutex_unlock (&test.lock);
+  fail_unless_equals_int (g_atomic_int_get (&count2), 1);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (pipeline);
+
+  g_mutex_clear (&test.lock);
+  g_cond_clear (&test.cond);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_iterate_sorted_unlinked)
 {
   GstElement *pipeline, *src, *sink, *identity;
@@ -1779,6 +2071,98 @@ GST_START_TEST (test_suppressed_flags_when_removing)
 
 GST_END_TEST;
 
+#ifndef GST_DISABLE_GST_DEBUG
+static const GstStructure *
+snapshot_array_get (const GstStructure * s, const gchar * fieldname, guint i)
+{
+  const GValue *array = gst_structure_get_value (s, fieldname);
+
+  fail_unless (array != NULL);
+  fail_unless (GST_VALUE_HOLDS_ARRAY (array));
+  return gst_value_get_structure (gst_value_array_get_value (array, i));
+}
+
+GST_START_TEST (test_debug_snapshot)
+{
+  GstElement *pipeline, *bin, *src, *identity, *sink;
+  const GstStructure *child, *pad;
+  GstStructure *snapshot;
+  GstPad *ghost, *target;
+  gchar *dot, *str;
+  gint state;
+
+  pipeline = gst_pipeline_new ("pipeline");
+  bin = gst_bin_new ("bin");
+  src = gst_element_factory_make ("fakesrc", "src");
+  identity = gst_element_factory_make ("identity", "identity");
+  sink = gst_element_factory_make ("fakesink", "sink");
+
+  gst_bin_add (GST_BIN (bin), identity);
+  target = gst_element_get_static_pad (identity, "sink");
+  ghost = gst_ghost_pad_new ("sink", target);
+  gst_object_unref (target);
+  gst_element_add_pad (bin, ghost);
+  target = gst_element_get_static_pad (identity, "src");
+  ghost = gst_ghost_pad_new ("src", target);
+  gst_object_unref (target);
+  gst_element_add_pad (bin, ghost);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, bin, sink, NULL);
+  fail_unless (gst_element_link_many (src, bin, sink, NULL));
+
+  snapshot = gst_debug_bin_snapshot (GST_BIN (pipeline),
+      GST_DEBUG_GRAPH_SHOW_ALL);
+  fail_unless (snapshot != NULL);
+  fail_unless (gst_structure_has_name (snapshot, "element"));
+  fail_unless_equals_string (gst_structure_get_string (snapshot, "name"),
+      "pipeline");
+  fail_unless_equals_string (gst_structure_get_string (snapshot, "type"),
+      "GstPipeline");
+  fail_unless (gst_structure_get_enum (snapshot, "state", GST_TYPE_STATE,
+          &state));
+  fail_unless_equals_int (state, GST_STATE_NULL);
+  fail_unless (gst_structure_has_field (snapshot, "timestamp"));
+  fail_unless_equals_int (gst_value_array_get_size (gst_structure_get_value
+          (snapshot, "children")), 3);
+
+  /* children are listed most recently added first */
+  child = snapshot_array_get (snapshot, "children", 1);
+  fail_unless_equals_string (gst_structure_get_string (child, "name"), "bin");
+  fail_unless (gst_structure_has_field (child, "children"));
+  pad = snapshot_array_get (child, "pads", 0);
+  fail_unless_equals_string (gst_structure_get_string (pad, "name"), "sink");
+  fail_unless (gst_structure_has_field (pad, "internal"));
+  fail_unless (gst_structure_has_field (pad, "peer"));
+
+  child = snapshot_array_get (snapshot, "children", 2);
+  fail_unless_equals_string (gst_structure_get_string (child, "name"), "src");
+  fail_if (gst_structure_has_field (child, "children"));
+  pad = snapshot_array_get (child, "pads", 0);
+  fail_unless (gst_structure_has_field (pad, "caps"));
+  fail_unless (gst_structure_has_field (pad, "peer-caps"));
+
+  /* the snapshot is detached from the pipeline */
+  gst_element_unlink (bin, sink);
+  dot = gst_debug_snapshot_to_dot_data (snapshot);
+  str = gst_debug_bin_to_dot_data (GST_BIN (pipeline),
+      GST_DEBUG_GRAPH_SHOW_ALL);
+  fail_unless (g_str_has_prefix (dot, "digraph pipeline {"));
+  fail_unless (strstr (dot, "cluster_bin_") != NULL);
+  fail_unless (strlen (dot) > strlen (str));
+  g_free (str);
+  g_free (dot);
+
+  str = gst_structure_to_string (snapshot);
+  fail_unless (strstr (str, "identity") != NULL);
+  g_free (str);
+  gst_structure_free (snapshot);
+
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+#endif
+
 static Suite *
 gst_bin_suite (void)
 {
@@ -1794,6 +2178,7 @@ gst_bin_suite (void)
   tcase_add_test (tc_chain, test_children_state_change_order_flagged_sink);
   tcase_add_test (tc_chain, test_children_state_change_order_semi_sink);
   tcase_add_test (tc_chain, test_children_state_change_order_two_sink);
+  tcase_add_test (tc_chain, test_parallel_state_change);
   tcase_add_test (tc_chain, test_message_state_changed);
   tcase_add_test (tc_chain, test_message_state_changed_child);
   tcase_add_test (tc_chain, test_message_state_changed_children);
@@ -1803,6 +2188,8 @@ gst_bin_suite (void)
   tcase_add_test (tc_chain, test_add_self);
   tcase_add_test (tc_chain, test_iterate_sorted);
   tcase_add_test (tc_chain, test_iterate_sorted_unlinked);
+  tcase_add_test (tc_chain, test_iterate_sorted_cached);
+  tcase_add_test (tc_chain, test_incremental_latency);
   tcase_add_test (tc_chain, test_link_structure_change);
   tcase_add_test (tc_chain, test_state_failure_remove);
   tcase_add_test (tc_chain, test_state_failure_unref);
@@ -1812,6 +2199,9 @@ gst_bin_suite (void)
   tcase_add_test (tc_chain, test_deep_added_removed);
   tcase_add_test (tc_chain, test_suppressed_flags);
   tcase_add_test (tc_chain, test_suppressed_flags_when_removing);
+#ifndef GST_DISABLE_GST_DEBUG
+  tcase_add_test (tc_chain, test_debug_snapshot);
+#endif
 
   /* fails on OSX build bot for some reason, and is a bit silly anyway */
   if (0)
@@ -448,6 +448,93 @@ GST_START_TEST (test_timed_pop)
 
 GST_END_TEST;
 
+/* test that you get the messages with pop_batch, and that the poll fd is
+ * fully acknowledged afterwards. */
+GST_START_TEST (test_pop_batch)
+{
+  GstMessage *msgs[4];
+  guint i, n, total = 0;
+
+  test_bus = gst_bus_new ();
+
+  send_10_app_messages ();
+
+  do {
+    n = gst_bus_pop_batch (test_bus, msgs, G_N_ELEMENTS (msgs));
+    fail_unless (n <= G_N_ELEMENTS (msgs));
+    for (i = 0; i < n; i++) {
+      fail_unless (GST_MESSAGE_TYPE (msgs[i]) == GST_MESSAGE_APPLICATION);
+      gst_message_unref (msgs[i]);
+    }
+    total += n;
+  } while (n > 0);
+
+  fail_unless_equals_int (total, 10);
+  fail_if (gst_bus_have_pending (test_bus), "unexpected messages on bus");
+
+  /* nothing left, must time out */
+  n = gst_bus_timed_pop_batch_filtered (test_bus, 10 * GST_MSECOND,
+      GST_MESSAGE_ANY, msgs, G_N_ELEMENTS (msgs));
+  fail_unless_equals_int (n, 0);
+
+  /* non-matching messages are discarded */
+  send_messages (NULL);
+  n = gst_bus_timed_pop_batch_filtered (test_bus, 0, GST_MESSAGE_EOS, msgs,
+      G_N_ELEMENTS (msgs));
+  fail_unless_equals_int (n, 4);
+  for (i = 0; i < n; i++) {
+    fail_unless (GST_MESSAGE_TYPE (msgs[i]) == GST_MESSAGE_EOS);
+    gst_message_unref (msgs[i]);
+  }
+  gst_bus_set_flushing (test_bus, TRUE);
+
+  gst_object_unref (test_bus);
+}
+
+GST_END_TEST;
+
+static gboolean
+batch_message_func (GstBus * bus, GstMessage ** messages, guint n_messages,
+    gpointer user_data)
+{
+  guint *p_counter = user_data;
+
+  fail_unless (n_messages > 0 && n_messages <= 8);
+  *p_counter += n_messages;
+
+  return TRUE;
+}
+
+/* test that a batch watch gets all messages in fewer dispatches */
+GST_START_TEST (test_batch_watch)
+{
+  guint num_msgs = 0;
+  guint id;
+
+  test_bus = gst_bus_new ();
+
+  id = gst_bus_add_batch_watch_full (test_bus, G_PRIORITY_DEFAULT, 8,
+      batch_message_func, &num_msgs, NULL);
+  fail_if (id == 0);
+
+  /* a batch needs room for at least one message */
+  ASSERT_CRITICAL (gst_bus_add_batch_watch_full (test_bus, G_PRIORITY_DEFAULT,
+          0, batch_message_func, &num_msgs, NULL));
+
+  send_messages (NULL);
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  fail_unless_equals_int (num_msgs, 20);
+  fail_if (gst_bus_have_pending (test_bus), "unexpected messages on bus");
+
+  fail_unless (gst_bus_remove_watch (test_bus));
+
+  gst_object_unref ((GstObject *) test_bus);
+}
+
+GST_END_TEST;
+
 typedef struct
 {
   GstDevice device;
@@ -812,6 +899,65 @@ GST_START_TEST (test_async_message)
 
 GST_END_TEST;
 
+static GstBusSyncReply
+test_group_async_sync_handler (GstBus * bus, GstMessage * msg,
+    gpointer user_data)
+{
+  return GST_BUS_ASYNC;
+}
+
+static gint group_message_posted;
+
+static gpointer
+post_to_group_member_thread (gpointer data)
+{
+  GstBus *member = data;
+
+  gst_bus_post (member, gst_message_new_application (NULL, NULL));
+  g_atomic_int_set (&group_message_posted, 1);
+  return NULL;
+}
+
+/* Test that GST_BUS_ASYNC from the sync handler of a bus that is part of a
+ * group blocks the poster until the message was freed off the group bus */
+GST_START_TEST (test_group_async_message)
+{
+  GstBus *group, *member;
+  GstObject *owner;
+  GstMessage *msg;
+  GThread *thread;
+
+  group = gst_bus_new ();
+  owner = GST_OBJECT (gst_bin_new (NULL));
+  member = gst_bus_new_for_group (group, owner);
+
+  gst_bus_set_sync_handler (member, test_group_async_sync_handler, NULL,
+      NULL);
+
+  g_atomic_int_set (&group_message_posted, 0);
+
+  thread = g_thread_new ("poster", post_to_group_member_thread, member);
+
+  msg = gst_bus_timed_pop (group, GST_CLOCK_TIME_NONE);
+  fail_unless (msg != NULL);
+  fail_unless (gst_bus_message_get_owner (msg) == owner);
+
+  /* the poster is still blocked while we hold the message */
+  g_usleep (G_USEC_PER_SEC / 20);
+  fail_if (g_atomic_int_get (&group_message_posted));
+  gst_message_unref (msg);
+
+  g_thread_join (thread);
+  fail_unless (g_atomic_int_get (&group_message_posted));
+  fail_if (gst_bus_have_pending (group), "unexpected messages on bus");
+
+  gst_object_unref (member);
+  gst_object_unref (owner);
+  gst_object_unref (group);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_bus_suite (void)
 {
@@ -831,8 +977,11 @@ gst_bus_suite (void)
   tcase_add_test (tc_chain, test_timed_pop_thread);
   tcase_add_test (tc_chain, test_timed_pop_filtered);
   tcase_add_test (tc_chain, test_timed_pop_filtered_with_timeout);
+  tcase_add_test (tc_chain, test_pop_batch);
+  tcase_add_test (tc_chain, test_batch_watch);
   tcase_add_test (tc_chain, test_custom_main_context);
   tcase_add_test (tc_chain, test_async_message);
+  tcase_add_test (tc_chain, test_group_async_message);
   return s;
 }
 
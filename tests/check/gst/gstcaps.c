@@ -111,14 +111,14 @@ GST_START_TEST (test_static_caps)
   /* caps creation */
   caps1 = gst_static_caps_get (&scaps);
   fail_unless (caps1 != NULL);
-  /* 1 refcount core, one from us */
-  fail_unless (GST_CAPS_REFCOUNT (caps1) == 2);
+  /* 2 refcounts core (static caps and interned caps), one from us */
+  fail_unless (GST_CAPS_REFCOUNT (caps1) == 3);
 
   /* caps should be the same */
   caps2 = gst_static_caps_get (&scaps);
   fail_unless (caps2 != NULL);
-  /* 1 refcount core, two from us */
-  fail_unless (GST_CAPS_REFCOUNT (caps1) == 3);
+  /* 2 refcounts core, two from us */
+  fail_unless (GST_CAPS_REFCOUNT (caps1) == 4);
   /* caps must be equal */
   fail_unless (caps1 == caps2);
 
@@ -1393,6 +1393,246 @@ GST_START_TEST (test_filter_and_map_in_place)
 
 GST_END_TEST;
 
+GST_START_TEST (test_intersect_fixed_template)
+{
+  GstCaps *templ, *fixed, *res;
+
+  templ = gst_caps_from_string ("video/x-raw, format=(string){ I420, YV12 }, "
+      "width=(int)[ 16, 4096, 2 ], height=(int)[ 16, 4096 ], "
+      "framerate=(fraction)[ 0/1, 60/1 ], interlaced=(boolean)false");
+
+  fixed = gst_caps_from_string ("video/x-raw, format=(string)I420, "
+      "width=(int)320, height=(int)240, framerate=(fraction)30/1, "
+      "interlaced=(boolean)false");
+  res = gst_caps_intersect (fixed, templ);
+  fail_unless (gst_caps_is_equal (res, fixed));
+  fail_unless (gst_caps_is_subset (fixed, templ));
+  fail_unless (gst_caps_can_intersect (templ, fixed));
+  gst_caps_unref (res);
+  gst_caps_unref (fixed);
+
+  /* odd width is not in the stepped range */
+  fixed = gst_caps_from_string ("video/x-raw, format=(string)I420, "
+      "width=(int)321, height=(int)240, framerate=(fraction)30/1");
+  res = gst_caps_intersect (fixed, templ);
+  fail_unless (gst_caps_is_empty (res));
+  fail_if (gst_caps_is_subset (fixed, templ));
+  fail_if (gst_caps_can_intersect (templ, fixed));
+  gst_caps_unref (res);
+  gst_caps_unref (fixed);
+
+  /* framerate out of range */
+  fixed = gst_caps_from_string ("video/x-raw, format=(string)YV12, "
+      "width=(int)320, height=(int)240, framerate=(fraction)120/1");
+  fail_if (gst_caps_can_intersect (fixed, templ));
+  fail_if (gst_caps_is_subset (fixed, templ));
+  gst_caps_unref (fixed);
+
+  /* different fixed values */
+  fixed = gst_caps_from_string ("video/x-raw, format=(string)I420, "
+      "width=(int)320, height=(int)240, framerate=(fraction)30/1, "
+      "interlaced=(boolean)true");
+  fail_if (gst_caps_can_intersect (fixed, templ));
+  res = gst_caps_from_string ("video/x-raw, format=(string)I420, "
+      "width=(int)320, height=(int)240, framerate=(fraction)60/2, "
+      "interlaced=(boolean)true");
+  fail_unless (gst_caps_is_equal (fixed, res));
+  fail_unless (gst_caps_can_intersect (fixed, res));
+  gst_caps_unref (res);
+  gst_caps_unref (fixed);
+
+  gst_caps_unref (templ);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_to_from_bytes)
+{
+  const gchar *caps_str[] = {
+    "ANY",
+    "EMPTY",
+    "video/x-raw, format=(string){ I420, YV12 }, width=(int)[ 16, 4096, 2 ], "
+        "framerate=(fraction)[ 0/1, 2147483647/1 ]",
+    "video/x-raw(memory:SystemMemory, meta:Foo), width=(int)320; "
+        "video/x-raw(ANY), width=(int)320; video/x-raw(foo:bar)",
+    "audio/x-raw, channel-mask=(bitmask)0x3, layout=(string)interleaved",
+  };
+  GstCapsFeatures *features, *features2;
+  GstCaps *caps, *caps2;
+  GBytes *bytes;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (caps_str); i++) {
+    caps = gst_caps_from_string (caps_str[i]);
+    fail_unless (caps != NULL);
+
+    bytes = gst_caps_to_bytes (caps);
+    fail_unless (bytes != NULL);
+    caps2 = gst_caps_new_from_bytes (bytes);
+    g_bytes_unref (bytes);
+
+    fail_unless (caps2 != NULL);
+    fail_unless (gst_caps_is_strictly_equal (caps, caps2), "%s", caps_str[i]);
+    fail_unless (gst_caps_is_any (caps) == gst_caps_is_any (caps2));
+    fail_unless (gst_caps_is_empty (caps) == gst_caps_is_empty (caps2));
+    gst_caps_unref (caps);
+    gst_caps_unref (caps2);
+  }
+
+  features = gst_caps_features_new ("memory:Foo", "meta:Bar", NULL);
+  bytes = gst_caps_features_to_bytes (features);
+  features2 = gst_caps_features_new_from_bytes (bytes);
+  fail_unless (features2 != NULL);
+  fail_unless (gst_caps_features_is_equal (features, features2));
+  fail_unless (gst_structure_new_from_bytes (bytes) == NULL);
+  g_bytes_unref (bytes);
+  gst_caps_features_free (features);
+  gst_caps_features_free (features2);
+
+  bytes = g_bytes_new_static ("GSTb\002C\000\000", 8);
+  fail_unless (gst_caps_new_from_bytes (bytes) == NULL);
+  g_bytes_unref (bytes);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_intern)
+{
+  GstCaps *c1, *c2, *c3, *i1, *i2, *i3, *r1, *r2;
+  GstStaticCaps sc1 = GST_STATIC_CAPS ("audio/x-raw, channels=(int)2");
+  GstStaticCaps sc2 = GST_STATIC_CAPS ("audio/x-raw, channels=(int)2");
+
+  c1 = gst_caps_from_string ("video/x-raw, width=(int)320, height=(int)240");
+  c2 = gst_caps_from_string ("video/x-raw, height=(int)240, width=(int)320");
+  c3 = gst_caps_from_string ("video/x-raw, width=(int)[ 1, 640 ]");
+
+  /* strictly equal caps are interned to the same instance */
+  i1 = gst_caps_intern (c1);
+  fail_unless (i1 == c1);
+  i2 = gst_caps_intern (c2);
+  fail_unless (i2 == i1);
+  fail_if (gst_caps_is_writable (i1));
+  i3 = gst_caps_intern (c3);
+  fail_unless (i3 != i1);
+
+  fail_unless (gst_caps_is_equal (i1, i2));
+  fail_unless (gst_caps_is_strictly_equal (i1, i2));
+  fail_if (gst_caps_is_equal (i1, i3));
+  fail_if (gst_caps_is_strictly_equal (i1, i3));
+  fail_unless (gst_caps_is_subset (i1, i3));
+
+  /* intersections of interned caps are remembered */
+  r1 = gst_caps_intersect (i1, i3);
+  fail_unless (gst_caps_is_equal (r1, i1));
+  r2 = gst_caps_intersect (i1, i3);
+  fail_unless (r1 == r2);
+  gst_caps_unref (r1);
+  gst_caps_unref (r2);
+
+  /* copies are not interned and can be changed */
+  c1 = gst_caps_make_writable (gst_caps_ref (i1));
+  fail_unless (c1 != i1);
+  gst_caps_set_simple (c1, "width", G_TYPE_INT, 640, NULL);
+  fail_if (gst_caps_is_equal (c1, i1));
+  c2 = gst_caps_copy (i1);
+  fail_unless (gst_caps_is_strictly_equal (c2, i1));
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+
+  gst_caps_unref (i1);
+  gst_caps_unref (i2);
+  gst_caps_unref (i3);
+
+  /* static caps with the same contents share the caps */
+  c1 = gst_static_caps_get (&sc1);
+  c2 = gst_static_caps_get (&sc2);
+  fail_unless (c1 == c2);
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+  gst_static_caps_cleanup (&sc1);
+  gst_static_caps_cleanup (&sc2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_intern_features)
+{
+  GstCaps *c1, *c2, *c3, *i1, *i2, *i3;
+  GstCapsFeatures *f;
+
+  c1 = gst_caps_from_string ("video/x-intern-test, width=(int)320");
+  c2 = gst_caps_from_string ("video/x-intern-test, width=(int)320");
+  c3 = gst_caps_from_string
+      ("video/x-intern-test(memory:SystemMemory), width=(int)320");
+
+  i1 = gst_caps_intern (c1);
+  fail_unless (i1 == c1);
+
+  /* getting the features installs system memory features in the interned
+   * caps, they must still be found for caps without features */
+  f = gst_caps_get_features (i1, 0);
+  fail_unless (gst_caps_features_is_equal (f,
+          GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY));
+
+  i2 = gst_caps_intern (c2);
+  fail_unless (i2 == i1);
+  i3 = gst_caps_intern (c3);
+  fail_unless (i3 == i1);
+  fail_unless (gst_caps_is_strictly_equal (i1, i3));
+
+  gst_caps_unref (i1);
+  gst_caps_unref (i2);
+  gst_caps_unref (i3);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_intern_media_types)
+{
+  GstCaps *templ, *caps, *res;
+
+  templ = gst_caps_intern (gst_caps_from_string ("audio/x-raw, "
+          "channels=(int)[ 1, 2 ]; audio/x-alaw; audio/x-mulaw"));
+
+  /* no media type in common */
+  caps = gst_caps_from_string ("video/x-raw; image/jpeg");
+  fail_if (gst_caps_can_intersect (caps, templ));
+  fail_if (gst_caps_can_intersect (templ, caps));
+  fail_if (gst_caps_is_subset (caps, templ));
+  res = gst_caps_intersect (caps, templ);
+  fail_unless (gst_caps_is_empty (res));
+  gst_caps_unref (res);
+  gst_caps_unref (caps);
+
+  /* only some media types in common */
+  caps = gst_caps_from_string ("video/x-raw; audio/x-alaw, rate=(int)8000");
+  fail_unless (gst_caps_can_intersect (caps, templ));
+  fail_if (gst_caps_is_subset (caps, templ));
+  res = gst_caps_intersect_full (templ, caps, GST_CAPS_INTERSECT_FIRST);
+  fail_unless_equals_int (gst_caps_get_size (res), 1);
+  fail_unless (gst_structure_has_name (gst_caps_get_structure (res, 0),
+          "audio/x-alaw"));
+  gst_caps_unref (res);
+  gst_caps_unref (caps);
+
+  /* same media types, but the fields still need to match */
+  caps = gst_caps_from_string ("audio/x-raw, channels=(int)6");
+  fail_if (gst_caps_can_intersect (caps, templ));
+  fail_if (gst_caps_is_subset (caps, templ));
+  gst_caps_unref (caps);
+
+  caps = gst_caps_from_string ("audio/x-mulaw; audio/x-raw, channels=(int)2");
+  fail_unless (gst_caps_is_subset (caps, templ));
+  gst_caps_unref (caps);
+
+  fail_unless (gst_caps_can_intersect (GST_CAPS_ANY, templ));
+  fail_unless (gst_caps_is_subset (templ, GST_CAPS_ANY));
+
+  gst_caps_unref (templ);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_caps_suite (void)
 {
@@ -1427,6 +1667,11 @@ gst_caps_suite (void)
   tcase_add_test (tc_chain, test_foreach);
   tcase_add_test (tc_chain, test_map_in_place);
   tcase_add_test (tc_chain, test_filter_and_map_in_place);
+  tcase_add_test (tc_chain, test_intersect_fixed_template);
+  tcase_add_test (tc_chain, test_to_from_bytes);
+  tcase_add_test (tc_chain, test_intern);
+  tcase_add_test (tc_chain, test_intern_features);
+  tcase_add_test (tc_chain, test_intern_media_types);
 
   return s;
 }
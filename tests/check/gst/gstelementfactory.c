@@ -119,6 +119,105 @@ GST_START_TEST (test_can_sink_all_caps)
 
 GST_END_TEST;
 
+static GstStaticPadTemplate video_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw, format=(string){ I420, YV12 }; "
+        "image/jpeg")
+    );
+
+/* test filtering factories on their pad templates */
+GST_START_TEST (test_list_filter)
+{
+  GstElementFactory *audio, *video;
+  GList *factories, *res;
+  GstCaps *caps;
+
+  audio = setup_factory ();
+  video = GST_ELEMENT_FACTORY_CAST (g_object_new (GST_TYPE_ELEMENT_FACTORY,
+          NULL));
+  gst_plugin_feature_set_name (GST_PLUGIN_FEATURE_CAST (video), "video");
+  setup_pad_template (video, &video_sink_template);
+
+  factories = g_list_append (NULL, audio);
+  factories = g_list_append (factories, video);
+
+  caps = gst_caps_from_string ("video/x-raw, format=(string)I420");
+  fail_if (gst_element_factory_can_sink_any_caps (audio, caps));
+  fail_unless (gst_element_factory_can_sink_any_caps (video, caps));
+  fail_unless (gst_element_factory_can_sink_all_caps (video, caps));
+  fail_if (gst_element_factory_can_src_any_caps (video, caps));
+
+  res = gst_element_factory_list_filter (factories, caps, GST_PAD_SINK, FALSE);
+  fail_unless_equals_int (g_list_length (res), 1);
+  fail_unless (res->data == video);
+  gst_plugin_feature_list_free (res);
+  gst_caps_unref (caps);
+
+  /* only a subset if all the media types are in one template */
+  caps = gst_caps_from_string ("image/jpeg; audio/x-raw, channels=(int)2");
+  fail_unless (gst_element_factory_can_sink_any_caps (audio, caps));
+  fail_unless (gst_element_factory_can_sink_any_caps (video, caps));
+  fail_if (gst_element_factory_can_sink_all_caps (audio, caps));
+  fail_if (gst_element_factory_can_sink_all_caps (video, caps));
+
+  res = gst_element_factory_list_filter (factories, caps, GST_PAD_SINK, FALSE);
+  fail_unless_equals_int (g_list_length (res), 2);
+  gst_plugin_feature_list_free (res);
+  res = gst_element_factory_list_filter (factories, caps, GST_PAD_SINK, TRUE);
+  fail_unless (res == NULL);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_from_string ("audio/x-raw, channels=(int)[ 2, 4 ]");
+  res = gst_element_factory_list_filter (factories, caps, GST_PAD_SRC, TRUE);
+  fail_unless_equals_int (g_list_length (res), 1);
+  fail_unless (res->data == audio);
+  gst_plugin_feature_list_free (res);
+  gst_caps_unref (caps);
+
+  g_list_free (factories);
+  g_object_unref (audio);
+  g_object_unref (video);
+}
+
+GST_END_TEST;
+
+/* long lists are filtered in parallel, the result must keep the order */
+GST_START_TEST (test_list_filter_many)
+{
+  GList *factories = NULL, *res, *walk;
+  GstCaps *caps;
+  guint i;
+
+  for (i = 0; i < 1000; i++) {
+    GstElementFactory *factory;
+
+    if (i % 3 == 0) {
+      factory = setup_factory ();
+    } else {
+      factory = GST_ELEMENT_FACTORY_CAST (g_object_new
+          (GST_TYPE_ELEMENT_FACTORY, NULL));
+      gst_plugin_feature_set_name (GST_PLUGIN_FEATURE_CAST (factory), "video");
+      setup_pad_template (factory, &video_sink_template);
+    }
+    factories = g_list_prepend (factories, factory);
+  }
+  factories = g_list_reverse (factories);
+
+  caps = gst_caps_from_string ("audio/x-raw, channels=(int)2");
+  res = gst_element_factory_list_filter (factories, caps, GST_PAD_SINK, TRUE);
+  fail_unless_equals_int (g_list_length (res), 334);
+  for (walk = res, i = 0; walk; walk = walk->next, i += 3)
+    fail_unless (walk->data == g_list_nth_data (factories, i));
+  gst_plugin_feature_list_free (res);
+  gst_caps_unref (caps);
+
+  g_list_free_full (factories, g_object_unref);
+}
+
+GST_END_TEST;
+
 /* check if the elementfactory of a class is filled (see #131079) */
 GST_START_TEST (test_class)
 {
@@ -176,6 +275,8 @@ gst_element_factory_suite (void)
   tcase_add_test (tc_chain, test_create);
   tcase_add_test (tc_chain, test_can_sink_any_caps);
   tcase_add_test (tc_chain, test_can_sink_all_caps);
+  tcase_add_test (tc_chain, test_list_filter);
+  tcase_add_test (tc_chain, test_list_filter_many);
 
   return s;
 }
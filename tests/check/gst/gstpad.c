@@ -3279,6 +3279,119 @@ GST_START_TEST (test_pad_offset_src)
 
 GST_END_TEST;
 
+static gint caps_query_count;
+
+static gboolean
+count_caps_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_CAPS)
+    caps_query_count++;
+
+  return gst_pad_query_default (pad, parent, query);
+}
+
+GST_START_TEST (test_cache_caps)
+{
+  GstPad *src, *sink;
+  GstCaps *caps, *filter, *gotcaps;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_query_function (src, count_caps_query);
+  GST_PAD_SET_CACHE_CAPS (src);
+  fail_unless (gst_pad_link (src, sink) == GST_PAD_LINK_OK);
+
+  caps_query_count = 0;
+
+  /* the second query is answered from the cache */
+  gotcaps = gst_pad_query_caps (src, NULL);
+  gst_caps_unref (gotcaps);
+  gotcaps = gst_pad_query_caps (src, NULL);
+  fail_unless_equals_int (caps_query_count, 1);
+  caps = gst_pad_query_caps (sink, NULL);
+  fail_unless (gst_caps_is_equal (gotcaps, caps));
+  gst_caps_unref (gotcaps);
+  gst_caps_unref (caps);
+
+  /* a different filter is queried again, an equal one is not */
+  filter = gst_caps_from_string ("foo/bar");
+  gotcaps = gst_pad_query_caps (src, filter);
+  fail_unless (gst_caps_is_equal (gotcaps, filter));
+  gst_caps_unref (gotcaps);
+  gst_caps_unref (filter);
+  fail_unless_equals_int (caps_query_count, 2);
+  filter = gst_caps_from_string ("foo/bar");
+  gotcaps = gst_pad_query_caps (src, filter);
+  gst_caps_unref (gotcaps);
+  gst_caps_unref (filter);
+  fail_unless_equals_int (caps_query_count, 2);
+
+  /* reconfiguration and unlinking invalidate the cache */
+  gst_pad_mark_reconfigure (sink);
+  gotcaps = gst_pad_query_caps (src, NULL);
+  gst_caps_unref (gotcaps);
+  fail_unless_equals_int (caps_query_count, 3);
+
+  gst_pad_unlink (src, sink);
+  gotcaps = gst_pad_query_caps (src, NULL);
+  gst_caps_unref (gotcaps);
+  fail_unless_equals_int (caps_query_count, 4);
+
+  /* without the flag every query is answered by the pad */
+  GST_PAD_UNSET_CACHE_CAPS (src);
+  gotcaps = gst_pad_query_caps (src, NULL);
+  gst_caps_unref (gotcaps);
+  fail_unless_equals_int (caps_query_count, 5);
+
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+
+/* changes below one toplevel bin don't invalidate the cache of another */
+GST_START_TEST (test_cache_caps_scope)
+{
+  GstElement *bin1, *bin2;
+  GstPad *src, *other;
+  GstCaps *caps;
+
+  bin1 = gst_bin_new (NULL);
+  bin2 = gst_bin_new (NULL);
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  gst_pad_set_query_function (src, count_caps_query);
+  GST_PAD_SET_CACHE_CAPS (src);
+  fail_unless (gst_element_add_pad (bin1, src));
+  other = gst_pad_new ("sink", GST_PAD_SINK);
+  fail_unless (gst_element_add_pad (bin2, other));
+
+  caps_query_count = 0;
+  caps = gst_pad_query_caps (src, NULL);
+  gst_caps_unref (caps);
+  fail_unless_equals_int (caps_query_count, 1);
+
+  gst_pad_mark_reconfigure (other);
+  fail_unless_equals_int (gst_element_set_state (bin2, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  caps = gst_pad_query_caps (src, NULL);
+  gst_caps_unref (caps);
+  fail_unless_equals_int (caps_query_count, 1);
+
+  /* going to READY might open resources the caps depend on */
+  fail_unless_equals_int (gst_element_set_state (bin1, GST_STATE_READY),
+      GST_STATE_CHANGE_SUCCESS);
+  caps = gst_pad_query_caps (src, NULL);
+  gst_caps_unref (caps);
+  fail_unless_equals_int (caps_query_count, 2);
+
+  gst_element_set_state (bin1, GST_STATE_NULL);
+  gst_element_set_state (bin2, GST_STATE_NULL);
+  gst_object_unref (bin1);
+  gst_object_unref (bin2);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_pad_suite (void)
 {
@@ -3339,6 +3452,8 @@ gst_pad_suite (void)
   tcase_add_test (tc_chain, test_proxy_accept_caps_with_proxy);
   tcase_add_test (tc_chain, test_proxy_accept_caps_with_incompatible_proxy);
   tcase_add_test (tc_chain, test_pad_offset_src);
+  tcase_add_test (tc_chain, test_cache_caps);
+  tcase_add_test (tc_chain, test_cache_caps_scope);
 
   return s;
 }
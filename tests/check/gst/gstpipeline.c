@@ -808,6 +808,125 @@ GST_START_TEST (test_pipeline_processing_deadline_no_queue)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pipeline_bus_group)
+{
+  GstElement *pipeline1, *pipeline2;
+  GstBus *group, *bus;
+  GstMessage *msgs[8];
+  guint i, n, n_p1 = 0, n_p2 = 0;
+
+  group = gst_bus_new ();
+
+  pipeline1 = gst_pipeline_new (NULL);
+  pipeline2 = gst_pipeline_new (NULL);
+  gst_pipeline_set_bus_group (GST_PIPELINE (pipeline1), group);
+  gst_pipeline_set_bus_group (GST_PIPELINE (pipeline2), group);
+
+  bus = gst_pipeline_get_bus (GST_PIPELINE (pipeline1));
+  fail_unless (bus != group);
+  gst_object_unref (bus);
+
+  for (i = 0; i < 3; i++) {
+    gst_element_post_message (pipeline1,
+        gst_message_new_application (GST_OBJECT (pipeline1), NULL));
+    gst_element_post_message (pipeline2,
+        gst_message_new_application (GST_OBJECT (pipeline2), NULL));
+  }
+
+  n = gst_bus_pop_batch (group, msgs, G_N_ELEMENTS (msgs));
+  fail_unless_equals_int (n, 6);
+  for (i = 0; i < n; i++) {
+    GstObject *owner = gst_bus_message_get_owner (msgs[i]);
+
+    fail_unless (owner == GST_MESSAGE_SRC (msgs[i]));
+    if (owner == GST_OBJECT (pipeline1))
+      n_p1++;
+    else if (owner == GST_OBJECT (pipeline2))
+      n_p2++;
+    gst_message_unref (msgs[i]);
+  }
+  fail_unless_equals_int (n_p1, 3);
+  fail_unless_equals_int (n_p2, 3);
+
+  /* shutting down a pipeline does not flush the group */
+  gst_element_post_message (pipeline2,
+      gst_message_new_application (GST_OBJECT (pipeline2), NULL));
+  fail_unless (gst_element_set_state (pipeline1, GST_STATE_READY) ==
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_element_set_state (pipeline1, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_bus_have_pending (group));
+  gst_bus_set_flushing (group, TRUE);
+
+  gst_object_unref (pipeline1);
+  gst_object_unref (pipeline2);
+  ASSERT_OBJECT_REFCOUNT (group, "group", 1);
+  gst_object_unref (group);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_pipeline_thread_quota)
+{
+  GstElement *pipeline, *src1, *sink1, *src2, *sink2;
+  GstStateChangeReturn ret;
+  GstMessage *msg;
+  GstBus *bus;
+  GError *err;
+  gchar *cpu_set;
+
+  pipeline = gst_pipeline_new (NULL);
+  src1 = gst_element_factory_make ("fakesrc", NULL);
+  sink1 = gst_element_factory_make ("fakesink", NULL);
+  src2 = gst_element_factory_make ("fakesrc", NULL);
+  sink2 = gst_element_factory_make ("fakesink", NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src1, sink1, src2, sink2, NULL);
+  fail_unless (gst_element_link (src1, sink1));
+  fail_unless (gst_element_link (src2, sink2));
+
+  fail_unless (gst_pipeline_set_cpu_set (GST_PIPELINE (pipeline), "0"));
+  cpu_set = gst_pipeline_get_cpu_set (GST_PIPELINE (pipeline));
+  fail_unless_equals_string (cpu_set, "0");
+  g_free (cpu_set);
+  fail_if (gst_pipeline_set_cpu_set (GST_PIPELINE (pipeline), "3-1"));
+  fail_if (gst_pipeline_set_cpu_set (GST_PIPELINE (pipeline), "foo"));
+  fail_unless (gst_pipeline_set_cpu_set (GST_PIPELINE (pipeline), NULL));
+
+  /* the two sources need two streaming threads */
+  gst_pipeline_set_max_threads (GST_PIPELINE (pipeline), 1);
+  fail_unless_equals_int (gst_pipeline_get_max_threads (GST_PIPELINE
+          (pipeline)), 1);
+  ret = gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  fail_unless_equals_int (ret, GST_STATE_CHANGE_FAILURE);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  fail_unless (msg != NULL);
+  fail_unless (GST_MESSAGE_SRC (msg) == GST_OBJECT (pipeline));
+  gst_message_parse_error (msg, &err, NULL);
+  fail_unless (g_error_matches (err, GST_CORE_ERROR, GST_CORE_ERROR_THREAD));
+  g_error_free (err);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  gst_pipeline_set_max_threads (GST_PIPELINE (pipeline), 2);
+  ret = gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  fail_if (ret == GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) == GST_STATE_CHANGE_SUCCESS);
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+#ifdef HAVE_PTHREAD_GETCPUCLOCKID
+  fail_unless (GST_CLOCK_TIME_IS_VALID (gst_pipeline_get_cpu_time
+          (GST_PIPELINE (pipeline))));
+#endif
+
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
 
 static Suite *
 gst_pipeline_suite (void)
@@ -829,6 +948,8 @@ gst_pipeline_suite (void)
   tcase_add_test (tc_chain, test_pipeline_reset_start_time);
   tcase_add_test (tc_chain, test_pipeline_processing_deadline);
   tcase_add_test (tc_chain, test_pipeline_processing_deadline_no_queue);
+  tcase_add_test (tc_chain, test_pipeline_bus_group);
+  tcase_add_test (tc_chain, test_pipeline_thread_quota);
 
   return s;
 }
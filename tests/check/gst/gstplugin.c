@@ -25,6 +25,8 @@
 #endif
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
+#include <string.h>
 
 
 static gboolean
@@ -49,6 +51,153 @@ GST_START_TEST (test_register_static)
 
 GST_END_TEST;
 
+typedef GstElement GstPrelinkedTest;
+typedef GstElementClass GstPrelinkedTestClass;
+
+G_DEFINE_TYPE (GstPrelinkedTest, gst_prelinked_test, GST_TYPE_ELEMENT);
+
+static void
+gst_prelinked_test_class_init (GstPrelinkedTestClass * klass)
+{
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "Prelinked test", "Testing", "Element of a prelinked static plugin",
+      "GStreamer developers");
+}
+
+static void
+gst_prelinked_test_init (GstPrelinkedTest * element)
+{
+}
+
+static guint prelinked_init_count;
+
+static gboolean
+register_prelinked_elements (GstPlugin * plugin)
+{
+  prelinked_init_count++;
+
+  return gst_element_register (plugin, "prelinkedtest", GST_RANK_NONE,
+      gst_prelinked_test_get_type ());
+}
+
+/* saves the prelinked data and removes the plugin again, as if the
+ * application had just been started */
+static gchar *
+save_prelinked (gsize * size)
+{
+  GstRegistry *registry = gst_registry_get ();
+  GstPlugin *plugin;
+  gchar *location, *data;
+  gint fd;
+
+  fail_unless (gst_plugin_register_static (GST_VERSION_MAJOR,
+          GST_VERSION_MINOR, "prelinked", "prelinked",
+          register_prelinked_elements, VERSION, GST_LICENSE, PACKAGE,
+          GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN));
+  fail_unless_equals_int (prelinked_init_count, 1);
+
+  fd = g_file_open_tmp ("gstprelinked-XXXXXX", &location, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+  fail_unless (gst_registry_save_prelinked (registry, location));
+  fail_unless (g_file_get_contents (location, &data, size, NULL));
+  g_unlink (location);
+  g_free (location);
+
+  plugin = gst_registry_find_plugin (registry, "prelinked");
+  fail_unless (plugin != NULL);
+  gst_registry_remove_plugin (registry, plugin);
+  gst_object_unref (plugin);
+  fail_unless (gst_registry_lookup_feature (registry, "prelinkedtest") == NULL);
+
+  return data;
+}
+
+GST_START_TEST (test_prelinked_static)
+{
+  /* the registry keeps pointers into the data, so it is never freed */
+  static gchar *data;
+  GstRegistry *registry = gst_registry_get ();
+  GstPluginFeature *feature;
+  GstPlugin *plugin;
+  GstElement *element;
+  gsize size;
+
+  data = save_prelinked (&size);
+
+  /* already registered static plugins, like the core elements, are kept */
+  fail_unless (gst_registry_add_prelinked (registry, (const guint8 *) data,
+          size));
+  plugin = gst_registry_find_plugin (registry, "prelinked");
+  fail_unless (plugin != NULL);
+  fail_if (gst_plugin_is_loaded (plugin));
+  gst_object_unref (plugin);
+  feature = gst_registry_lookup_feature (registry, "prelinkedtest");
+  fail_unless (feature != NULL);
+  fail_if (gst_plugin_feature_is_loaded (feature));
+  gst_object_unref (feature);
+  feature = gst_registry_lookup_feature (registry, "pipeline");
+  fail_unless (feature != NULL);
+  fail_unless (gst_plugin_feature_is_loaded (feature));
+  gst_object_unref (feature);
+
+  /* registering only takes the init function */
+  fail_unless (gst_plugin_register_static (GST_VERSION_MAJOR,
+          GST_VERSION_MINOR, "prelinked", "prelinked",
+          register_prelinked_elements, VERSION, GST_LICENSE, PACKAGE,
+          GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN));
+  fail_unless_equals_int (prelinked_init_count, 1);
+
+  /* which runs when a feature is loaded */
+  element = gst_element_factory_make ("prelinkedtest", NULL);
+  fail_unless (element != NULL);
+  fail_unless_equals_int (prelinked_init_count, 2);
+  gst_object_unref (element);
+
+  plugin = gst_registry_find_plugin (registry, "prelinked");
+  fail_unless (gst_plugin_is_loaded (plugin));
+  gst_object_unref (plugin);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_prelinked_misaligned)
+{
+  static gchar *data;
+  GstRegistry *registry = gst_registry_get ();
+  GstPluginFeature *feature;
+  GstElement *element;
+  gchar *saved;
+  gsize size;
+
+  /* data compiled into an application has no particular alignment */
+  saved = save_prelinked (&size);
+  data = g_malloc (size + 1);
+  memcpy (data + 1, saved, size);
+  g_free (saved);
+
+  fail_unless (gst_registry_add_prelinked (registry,
+          (const guint8 *) data + 1, size));
+  feature = gst_registry_lookup_feature (registry, "prelinkedtest");
+  fail_unless (feature != NULL);
+  fail_if (gst_plugin_feature_is_loaded (feature));
+  fail_unless_equals_string (gst_element_factory_get_metadata
+      (GST_ELEMENT_FACTORY (feature), GST_ELEMENT_METADATA_LONGNAME),
+      "Prelinked test");
+  gst_object_unref (feature);
+
+  fail_unless (gst_plugin_register_static (GST_VERSION_MAJOR,
+          GST_VERSION_MINOR, "prelinked", "prelinked",
+          register_prelinked_elements, VERSION, GST_LICENSE, PACKAGE,
+          GST_PACKAGE_NAME, GST_PACKAGE_ORIGIN));
+  element = gst_element_factory_make ("prelinkedtest", NULL);
+  fail_unless (element != NULL);
+  fail_unless_equals_int (prelinked_init_count, 2);
+  gst_object_unref (element);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_registry)
 {
   GList *list, *g;
@@ -318,6 +467,8 @@ gst_plugin_suite (void)
   tcase_add_test (tc_chain, test_old_register_static);
 #endif
   tcase_add_test (tc_chain, test_register_static);
+  tcase_add_test (tc_chain, test_prelinked_static);
+  tcase_add_test (tc_chain, test_prelinked_misaligned);
   tcase_add_test (tc_chain, test_registry);
   tcase_add_test (tc_chain, test_load_coreelements);
   tcase_add_test (tc_chain, test_registry_get_plugin_list);
@@ -31,6 +31,7 @@
 #else
 #include <unistd.h>
 #include <sys/socket.h>
+#include <glib/gstdio.h>
 #endif
 
 GST_START_TEST (test_poll_wait)
@@ -321,6 +322,117 @@ GST_START_TEST (test_poll_controllable)
 
 GST_END_TEST;
 
+GST_START_TEST (test_poll_control_coalesce)
+{
+  GstPoll *set;
+  GPollFD pfd;
+
+  set = gst_poll_new_timer ();
+  fail_if (set == NULL, "Failed to create a GstPoll");
+  gst_poll_get_read_gpollfd (set, &pfd);
+
+  fail_unless_equals_int (g_poll (&pfd, 1, 0), 0);
+
+  /* all writes are visible as one readable control fd */
+  fail_unless (gst_poll_write_control (set));
+  fail_unless (gst_poll_write_control (set));
+  fail_unless (gst_poll_write_control (set));
+  fail_unless_equals_int (g_poll (&pfd, 1, 0), 1);
+  fail_unless_equals_int (gst_poll_wait (set, 0), 1);
+
+  /* which stays readable until the last write is read */
+  fail_unless (gst_poll_read_control (set));
+  fail_unless (gst_poll_read_control (set));
+  fail_unless_equals_int (g_poll (&pfd, 1, 0), 1);
+  fail_unless (gst_poll_read_control (set));
+  fail_unless_equals_int (g_poll (&pfd, 1, 0), 0);
+  fail_unless_equals_int (gst_poll_wait (set, 0), 0);
+
+  fail_if (gst_poll_read_control (set));
+  fail_unless (errno == EWOULDBLOCK || errno == EAGAIN);
+
+  /* and it can be raised again */
+  fail_unless (gst_poll_write_control (set));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 1);
+  fail_unless (gst_poll_read_control (set));
+
+  gst_poll_free (set);
+}
+
+GST_END_TEST;
+
+#ifndef G_OS_WIN32
+#define N_MANY_FDS 32
+
+GST_START_TEST (test_poll_many_fds)
+{
+  GstPoll *set;
+  GstPollFD fds[N_MANY_FDS];
+  GstPollFD file_fd = GST_POLL_FD_INIT;
+  gint socks[N_MANY_FDS][2];
+  gchar *filename;
+  gint i;
+
+  set = gst_poll_new (TRUE);
+  fail_if (set == NULL, "Failed to create a GstPoll");
+
+  for (i = 0; i < N_MANY_FDS; i++) {
+    fail_if (socketpair (PF_UNIX, SOCK_STREAM, 0, socks[i]) < 0);
+    gst_poll_fd_init (&fds[i]);
+    fds[i].fd = socks[i][0];
+    fail_unless (gst_poll_add_fd (set, &fds[i]));
+    fail_unless (gst_poll_fd_ctl_read (set, &fds[i], TRUE));
+  }
+
+  fail_unless_equals_int (gst_poll_wait (set, 0), 0);
+
+  fail_unless (write (socks[5][1], "X", 1) == 1);
+  fail_unless_equals_int (gst_poll_wait (set, GST_SECOND), 1);
+  for (i = 0; i < N_MANY_FDS; i++)
+    fail_unless (gst_poll_fd_can_read (set, &fds[i]) == (i == 5));
+
+  /* not interested in reading anymore */
+  fail_unless (gst_poll_fd_ctl_read (set, &fds[5], FALSE));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 0);
+  fail_if (gst_poll_fd_can_read (set, &fds[5]));
+  fail_unless (gst_poll_fd_ctl_read (set, &fds[5], TRUE));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 1);
+  fail_unless (gst_poll_fd_can_read (set, &fds[5]));
+
+  /* removed fds are not reported */
+  fail_unless (gst_poll_remove_fd (set, &fds[5]));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 0);
+
+  /* timeouts that are not a multiple of a millisecond */
+  fail_unless_equals_int (gst_poll_wait (set, 1500 * GST_USECOND), 0);
+  fail_unless (write (socks[7][1], "X", 1) == 1);
+  fail_unless_equals_int (gst_poll_wait (set, 1500 * GST_USECOND), 1);
+  fail_unless (gst_poll_fd_can_read (set, &fds[7]));
+
+  /* regular files are always readable, also when added to a large set */
+  file_fd.fd = g_file_open_tmp (NULL, &filename, NULL);
+  fail_unless (file_fd.fd >= 0);
+  fail_unless (gst_poll_add_fd (set, &file_fd));
+  fail_unless (gst_poll_fd_ctl_read (set, &file_fd, TRUE));
+  fail_unless_equals_int (gst_poll_wait (set, 0), 2);
+  fail_unless (gst_poll_fd_can_read (set, &file_fd));
+  fail_unless (gst_poll_fd_can_read (set, &fds[7]));
+  fail_unless (gst_poll_remove_fd (set, &file_fd));
+  close (file_fd.fd);
+  g_unlink (filename);
+  g_free (filename);
+
+  gst_poll_free (set);
+
+  for (i = 0; i < N_MANY_FDS; i++) {
+    close (socks[i][0]);
+    close (socks[i][1]);
+  }
+}
+
+GST_END_TEST;
+#endif
+
 static Suite *
 gst_poll_suite (void)
 {
@@ -339,6 +451,8 @@ gst_poll_suite (void)
   tcase_add_test (tc_chain, test_poll_wait_restart);
   tcase_add_test (tc_chain, test_poll_wait_flush);
   tcase_add_test (tc_chain, test_poll_controllable);
+  tcase_add_test (tc_chain, test_poll_many_fds);
+  tcase_add_test (tc_chain, test_poll_control_coalesce);
 #else
   tcase_skip_broken_test (tc_chain, test_poll_basic);
   tcase_skip_broken_test (tc_chain, test_poll_wait);
@@ -346,6 +460,7 @@ gst_poll_suite (void)
   tcase_skip_broken_test (tc_chain, test_poll_wait_restart);
   tcase_skip_broken_test (tc_chain, test_poll_wait_flush);
   tcase_skip_broken_test (tc_chain, test_poll_controllable);
+  tcase_skip_broken_test (tc_chain, test_poll_control_coalesce);
 #endif
 
   return s;
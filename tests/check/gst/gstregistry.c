@@ -23,7 +23,10 @@
 #endif
 
 #include <gst/check/gstcheck.h>
+#include <glib/gstdio.h>
 #include <string.h>
+#include <time.h>
+#include <utime.h>
 
 static gint
 plugin_name_cmp (GstPlugin * a, GstPlugin * b)
@@ -203,6 +206,140 @@ GST_START_TEST (test_registry_update)
 
 GST_END_TEST;
 
+GST_START_TEST (test_registry_scan_unchanged_dirs)
+{
+  GstRegistry *registry;
+  GstPlugin *core, *plugin;
+  struct utimbuf times;
+  gchar *root, *sub, *basename, *copy, *contents;
+  gsize len;
+
+  core = gst_registry_find_plugin (gst_registry_get (), "coreelements");
+  fail_unless (core != NULL);
+  if (gst_plugin_get_filename (core) == NULL) {
+    GST_INFO ("coreelements is a static plugin, skipping");
+    gst_object_unref (core);
+    return;
+  }
+
+  g_setenv ("GST_REGISTRY_VALIDATION", "dirs", TRUE);
+
+  root = g_dir_make_tmp ("gst-registry-XXXXXX", NULL);
+  fail_unless (root != NULL);
+  sub = g_build_filename (root, "sub", NULL);
+  fail_unless_equals_int (g_mkdir (sub, 0755), 0);
+
+  /* only directories that were not modified in the last second get a
+   * fingerprint, make the root directory old enough */
+  times.actime = times.modtime = time (NULL) - 60;
+  fail_unless_equals_int (g_utime (root, &times), 0);
+
+  registry = g_object_new (GST_TYPE_REGISTRY, NULL);
+  gst_object_ref_sink (registry);
+
+  gst_registry_scan_path (registry, root);
+  plugin = gst_registry_find_plugin (registry, "coreelements");
+  fail_unless (plugin == NULL);
+
+  /* the root directory is unchanged now, but its subdirectory has no
+   * fingerprint and must still be scanned */
+  fail_unless (g_file_get_contents (gst_plugin_get_filename (core), &contents,
+          &len, NULL));
+  basename = g_path_get_basename (gst_plugin_get_filename (core));
+  copy = g_build_filename (sub, basename, NULL);
+  fail_unless (g_file_set_contents (copy, contents, len, NULL));
+  g_free (contents);
+
+  gst_registry_scan_path (registry, root);
+  plugin = gst_registry_find_plugin (registry, "coreelements");
+  fail_unless (plugin != NULL);
+  fail_unless_equals_string (gst_plugin_get_filename (plugin), copy);
+  gst_object_unref (plugin);
+
+  /* and the plugin is still found when nothing changed at all */
+  gst_registry_scan_path (registry, root);
+  plugin = gst_registry_find_plugin (registry, "coreelements");
+  fail_unless (plugin != NULL);
+  gst_object_unref (plugin);
+
+  gst_object_unref (registry);
+  gst_object_unref (core);
+
+  g_unlink (copy);
+  g_rmdir (sub);
+  g_rmdir (root);
+  g_free (copy);
+  g_free (basename);
+  g_free (sub);
+  g_free (root);
+
+  g_unsetenv ("GST_REGISTRY_VALIDATION");
+}
+
+GST_END_TEST;
+
+static GstRegistry *
+scan_with_helpers (const gchar * path, const gchar * n_helpers)
+{
+  GstRegistry *registry;
+
+  g_setenv ("GST_REGISTRY_SCANNERS", n_helpers, TRUE);
+
+  registry = g_object_new (GST_TYPE_REGISTRY, NULL);
+  gst_object_ref_sink (registry);
+  gst_registry_scan_path (registry, path);
+
+  g_unsetenv ("GST_REGISTRY_SCANNERS");
+
+  return registry;
+}
+
+/* plugins and features end up in the same order no matter how many scanner
+ * helpers loaded them */
+GST_START_TEST (test_registry_scan_helpers_order)
+{
+  GstRegistry *single, *multi;
+  GList *list1, *list2, *l1, *l2;
+  const gchar *env;
+  gchar **paths;
+
+  env = g_getenv ("GST_PLUGIN_PATH_1_0");
+  if (env == NULL || *env == '\0') {
+    GST_INFO ("no plugin path set, skipping");
+    return;
+  }
+  paths = g_strsplit (env, G_SEARCHPATH_SEPARATOR_S, 2);
+
+  single = scan_with_helpers (paths[0], "1");
+  multi = scan_with_helpers (paths[0], "4");
+
+  list1 = gst_registry_get_plugin_list (single);
+  list2 = gst_registry_get_plugin_list (multi);
+  fail_if (list1 == NULL);
+  fail_unless_equals_int (g_list_length (list1), g_list_length (list2));
+  for (l1 = list1, l2 = list2; l1 && l2; l1 = l1->next, l2 = l2->next)
+    fail_unless_equals_string (gst_plugin_get_name (l1->data),
+        gst_plugin_get_name (l2->data));
+  gst_plugin_list_free (list1);
+  gst_plugin_list_free (list2);
+
+  list1 = gst_registry_get_feature_list (single, GST_TYPE_PLUGIN_FEATURE);
+  list2 = gst_registry_get_feature_list (multi, GST_TYPE_PLUGIN_FEATURE);
+  fail_if (list1 == NULL);
+  fail_unless_equals_int (g_list_length (list1), g_list_length (list2));
+  for (l1 = list1, l2 = list2; l1 && l2; l1 = l1->next, l2 = l2->next)
+    fail_unless_equals_string (GST_OBJECT_NAME (l1->data),
+        GST_OBJECT_NAME (l2->data));
+  gst_plugin_feature_list_free (list1);
+  gst_plugin_feature_list_free (list2);
+
+  gst_object_unref (single);
+  gst_object_unref (multi);
+  g_strfreev (paths);
+}
+
+GST_END_TEST;
+
 static Suite *
 registry_suite (void)
 {
@@ -212,6 +349,8 @@ registry_suite (void)
   suite_add_tcase (s, tc_chain);
 
   tcase_add_test (tc_chain, test_registry_update);
+  tcase_add_test (tc_chain, test_registry_scan_unchanged_dirs);
+  tcase_add_test (tc_chain, test_registry_scan_helpers_order);
 
   return s;
 }
@@ -888,6 +888,163 @@ GST_START_TEST (test_flagset)
 
 GST_END_TEST;
 
+GST_START_TEST (test_many_fields)
+{
+  GstStructure *s, *s2;
+  gchar name[16];
+  gint i, val;
+
+  s = gst_structure_new_empty ("test/many");
+
+  /* fields are moved out of the structure allocation and looked up in
+   * sorted order once there are enough of them */
+  for (i = 0; i < 64; i++) {
+    g_snprintf (name, sizeof (name), "f%d", 63 - i);
+    gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 64);
+  fail_unless_equals_string (gst_structure_nth_field_name (s, 0), "f63");
+
+  for (i = 0; i < 64; i++) {
+    g_snprintf (name, sizeof (name), "f%d", 63 - i);
+    fail_unless (gst_structure_get_int (s, name, &val));
+    fail_unless_equals_int (val, i);
+  }
+  fail_if (gst_structure_has_field (s, "f64"));
+
+  /* replacing a value keeps the number of fields */
+  gst_structure_set (s, "f10", G_TYPE_INT, 100, NULL);
+  fail_unless_equals_int (gst_structure_n_fields (s), 64);
+  fail_unless (gst_structure_get_int (s, "f10", &val));
+  fail_unless_equals_int (val, 100);
+
+  s2 = gst_structure_copy (s);
+  fail_unless (gst_structure_is_equal (s, s2));
+
+  /* remove every other field, down to a small structure */
+  for (i = 0; i < 64; i += 2) {
+    g_snprintf (name, sizeof (name), "f%d", i);
+    gst_structure_remove_field (s, name);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 32);
+  for (i = 0; i < 48; i++) {
+    g_snprintf (name, sizeof (name), "f%d", i);
+    fail_unless (gst_structure_has_field (s, name) == (i % 2 == 1));
+  }
+  for (i = 1; i < 48; i += 2) {
+    g_snprintf (name, sizeof (name), "f%d", i);
+    gst_structure_remove_field (s, name);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 8);
+  fail_unless (gst_structure_get_int (s, "f63", &val));
+  fail_unless_equals_int (val, 0);
+  fail_if (gst_structure_is_equal (s, s2));
+
+  gst_structure_remove_all_fields (s2);
+  fail_unless_equals_int (gst_structure_n_fields (s2), 0);
+  gst_structure_set (s2, "f1", G_TYPE_INT, 1, NULL);
+  fail_unless (gst_structure_has_field (s2, "f1"));
+
+  gst_structure_free (s);
+  gst_structure_free (s2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_to_from_bytes)
+{
+  GstStructure *s, *s2;
+  GstCaps *caps;
+  GstDateTime *dt;
+  GValue list = G_VALUE_INIT, v = G_VALUE_INIT;
+  GBytes *bytes, *part;
+  const gchar *str, *data;
+  gsize size, i;
+
+  caps = gst_caps_from_string ("video/x-raw(memory:SystemMemory, meta:Foo), "
+      "width=(int)[ 16, 4096 ]; audio/x-raw(ANY)");
+  dt = gst_date_time_new_ymd (2018, 4, 1);
+
+  s = gst_structure_new ("test/bytes",
+      "int", G_TYPE_INT, -5,
+      "uint", G_TYPE_UINT, G_MAXUINT,
+      "int64", G_TYPE_INT64, G_MININT64,
+      "uint64", G_TYPE_UINT64, G_MAXUINT64,
+      "double", G_TYPE_DOUBLE, 0.25,
+      "float", G_TYPE_FLOAT, -1.5f,
+      "boolean", G_TYPE_BOOLEAN, TRUE,
+      "string", G_TYPE_STRING, "some string",
+      "null-string", G_TYPE_STRING, NULL,
+      "fraction", GST_TYPE_FRACTION, 30000, 1001,
+      "int-range", GST_TYPE_INT_RANGE, 16, 4096,
+      "int64-range", GST_TYPE_INT64_RANGE, G_GINT64_CONSTANT (-1000000000000),
+      G_GINT64_CONSTANT (1000000000000),
+      "double-range", GST_TYPE_DOUBLE_RANGE, 0.5, 1.5,
+      "fraction-range", GST_TYPE_FRACTION_RANGE, 0, 1, 60, 1,
+      "bitmask", GST_TYPE_BITMASK, G_GUINT64_CONSTANT (0xf0000000000000ff),
+      "flagset", GST_TYPE_FLAG_SET, 0x1, 0x3,
+      "enum", GST_TYPE_FORMAT, GST_FORMAT_TIME,
+      "flags", GST_TYPE_SEEK_FLAGS,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
+      "caps", GST_TYPE_CAPS, caps,
+      "date-time", GST_TYPE_DATE_TIME, dt, NULL);
+  gst_caps_unref (caps);
+  gst_date_time_unref (dt);
+
+  g_value_init (&list, GST_TYPE_LIST);
+  g_value_init (&v, G_TYPE_STRING);
+  g_value_set_string (&v, "I420");
+  gst_value_list_append_value (&list, &v);
+  g_value_set_string (&v, "NV12");
+  gst_value_list_append_value (&list, &v);
+  g_value_unset (&v);
+  gst_structure_take_value (s, "list", &list);
+
+  s2 = gst_structure_new ("nested", "string", G_TYPE_STRING, "nested", NULL);
+  gst_structure_set (s, "structure", GST_TYPE_STRUCTURE, s2, NULL);
+  gst_structure_free (s2);
+
+  bytes = gst_structure_to_bytes (s);
+  fail_unless (bytes != NULL);
+  data = g_bytes_get_data (bytes, &size);
+
+  s2 = gst_structure_new_from_bytes (bytes);
+  fail_unless (s2 != NULL);
+  fail_unless (gst_structure_is_equal (s, s2));
+
+  /* strings point into the serialized data */
+  str = gst_structure_get_string (s2, "string");
+  fail_unless_equals_string (str, "some string");
+  fail_unless (str > data && str < data + size);
+
+  /* every truncation is rejected */
+  for (i = 0; i < size; i++) {
+    part = g_bytes_new_from_bytes (bytes, 0, i);
+    fail_unless (gst_structure_new_from_bytes (part) == NULL);
+    g_bytes_unref (part);
+  }
+  fail_unless (gst_caps_new_from_bytes (bytes) == NULL);
+
+  /* the structure keeps the data alive */
+  g_bytes_unref (bytes);
+  fail_unless_equals_string (gst_structure_get_string (s2, "string"),
+      "some string");
+  fail_unless (gst_structure_is_equal (s, s2));
+  gst_structure_free (s2);
+
+  /* values outside of structures own their strings */
+  bytes = gst_value_to_bytes (gst_structure_get_value (s, "list"));
+  fail_unless (gst_value_init_from_bytes (&v, bytes));
+  g_bytes_unref (bytes);
+  fail_unless_equals_int (gst_value_compare (&v,
+          gst_structure_get_value (s, "list")), GST_VALUE_EQUAL);
+  g_value_unset (&v);
+
+  gst_structure_free (s);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_structure_suite (void)
 {
@@ -918,6 +1075,8 @@ gst_structure_suite (void)
   tcase_add_test (tc_chain, test_map_in_place);
   tcase_add_test (tc_chain, test_filter_and_map_in_place);
   tcase_add_test (tc_chain, test_flagset);
+  tcase_add_test (tc_chain, test_many_fields);
+  tcase_add_test (tc_chain, test_to_from_bytes);
   return s;
 }
 
@@ -3435,6 +3435,146 @@ GST_START_TEST (test_serialize_null_aray)
 
 GST_END_TEST;
 
+GST_START_TEST (test_deserialize_typed_list)
+{
+  GstStructure *st1, *st2;
+  const GValue *v1, *v2;
+  GValue v3 = G_VALUE_INIT;
+  const gchar *s;
+
+  st1 = gst_structure_from_string ("test, f=(string){ I420, YV12, "
+      "\"quoted string\", NULL }, i=(int){ 1, -2, 0x10, MIN, MAX }, "
+      "a=(int)< 3, 4 >", NULL);
+  fail_unless (st1 != NULL);
+
+  v1 = gst_structure_get_value (st1, "f");
+  fail_unless (GST_VALUE_HOLDS_LIST (v1));
+  fail_unless_equals_int (gst_value_list_get_size (v1), 4);
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (v1, 0)), "I420");
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (v1, 1)), "YV12");
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (v1, 2)), "quoted string");
+  fail_unless (g_value_get_string (gst_value_list_get_value (v1, 3)) == NULL);
+
+  /* plain strings are interned and shared between parses and copies */
+  s = g_value_get_string (gst_value_list_get_value (v1, 0));
+  fail_unless (s == g_intern_string ("I420"));
+
+  st2 = gst_structure_from_string ("test, f=(string){ YV12, I420 }", NULL);
+  fail_unless (st2 != NULL);
+  v2 = gst_structure_get_value (st2, "f");
+  fail_unless (g_value_get_string (gst_value_list_get_value (v2, 1)) == s);
+  fail_unless (gst_value_can_intersect (v1, v2));
+  gst_structure_free (st2);
+
+  g_value_init (&v3, GST_TYPE_LIST);
+  g_value_copy (v1, &v3);
+  fail_unless (g_value_get_string (gst_value_list_get_value (&v3, 0)) == s);
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (&v3, 2)), "quoted string");
+  fail_unless (gst_value_compare (v1, &v3) == GST_VALUE_EQUAL);
+  g_value_unset (&v3);
+
+  v1 = gst_structure_get_value (st1, "i");
+  fail_unless (GST_VALUE_HOLDS_LIST (v1));
+  fail_unless_equals_int (gst_value_list_get_size (v1), 5);
+  fail_unless_equals_int (g_value_get_int (gst_value_list_get_value (v1, 0)),
+      1);
+  fail_unless_equals_int (g_value_get_int (gst_value_list_get_value (v1, 1)),
+      -2);
+  fail_unless_equals_int (g_value_get_int (gst_value_list_get_value (v1, 2)),
+      16);
+  fail_unless_equals_int (g_value_get_int (gst_value_list_get_value (v1, 3)),
+      G_MININT);
+  fail_unless_equals_int (g_value_get_int (gst_value_list_get_value (v1, 4)),
+      G_MAXINT);
+
+  v1 = gst_structure_get_value (st1, "a");
+  fail_unless (GST_VALUE_HOLDS_ARRAY (v1));
+  fail_unless_equals_int (gst_value_array_get_size (v1), 2);
+  fail_unless_equals_int (g_value_get_int (gst_value_array_get_value (v1, 1)),
+      4);
+  gst_structure_free (st1);
+
+  fail_unless (gst_structure_from_string ("test, a=(int)< 1, foo >",
+          NULL) == NULL);
+}
+
+GST_END_TEST;
+
+static void
+setup_string_list (GValue * list, const gchar * str)
+{
+  gchar **strv, **p;
+
+  g_value_init (list, GST_TYPE_LIST);
+  strv = g_strsplit (str, " ", -1);
+  for (p = strv; *p; p++) {
+    GValue v = G_VALUE_INIT;
+
+    g_value_init (&v, G_TYPE_STRING);
+    g_value_set_string (&v, *p);
+    gst_value_list_append_and_take_value (list, &v);
+  }
+  g_strfreev (strv);
+}
+
+GST_START_TEST (test_intersect_string_lists)
+{
+  GValue l1 = G_VALUE_INIT, l2 = G_VALUE_INIT, l3 = G_VALUE_INIT;
+  GValue res = G_VALUE_INIT;
+
+  /* large enough to use the sorted lookup */
+  setup_string_list (&l1, "I420 YV12 NV12 NV21 YUY2 UYVY AYUV RGBx BGRx "
+      "xRGB xBGR RGBA BGRA ARGB ABGR RGB BGR GRAY8");
+  setup_string_list (&l2, "GRAY8 BGRA NV12 P010 I420 v210 Y444");
+  setup_string_list (&l3, "P010 v210 Y444 Y42B Y41B IYU1 NV16 NV24");
+
+  /* the order of the first list is kept */
+  fail_unless (gst_value_intersect (&res, &l1, &l2));
+  fail_unless (GST_VALUE_HOLDS_LIST (&res));
+  fail_unless_equals_int (gst_value_list_get_size (&res), 4);
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (&res, 0)), "I420");
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (&res, 1)), "NV12");
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (&res, 2)), "BGRA");
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (&res, 3)), "GRAY8");
+  g_value_unset (&res);
+
+  fail_unless (gst_value_intersect (&res, &l2, &l1));
+  fail_unless_equals_int (gst_value_list_get_size (&res), 4);
+  fail_unless_equals_string (g_value_get_string (gst_value_list_get_value
+          (&res, 0)), "GRAY8");
+  g_value_unset (&res);
+
+  fail_unless (gst_value_can_intersect (&l1, &l2));
+  fail_if (gst_value_intersect (NULL, &l1, &l3));
+  fail_if (gst_value_intersect (&res, &l1, &l3));
+
+  fail_unless (gst_value_intersect (&res, &l2, &l3));
+  fail_unless_equals_int (gst_value_list_get_size (&res), 3);
+  g_value_unset (&res);
+
+  /* strict subsets only */
+  fail_if (gst_value_is_subset (&l2, &l1));
+  fail_if (gst_value_is_subset (&l1, &l1));
+  g_value_unset (&l2);
+  setup_string_list (&l2, "xBGR RGB I420 AYUV GRAY8 NV12 YV12 I420");
+  fail_unless (gst_value_is_subset (&l2, &l1));
+  fail_if (gst_value_is_subset (&l1, &l2));
+
+  g_value_unset (&l1);
+  g_value_unset (&l2);
+  g_value_unset (&l3);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_value_suite (void)
 {
@@ -3487,6 +3627,8 @@ gst_value_suite (void)
   tcase_add_test (tc_chain, test_transform_array);
   tcase_add_test (tc_chain, test_transform_list);
   tcase_add_test (tc_chain, test_serialize_null_aray);
+  tcase_add_test (tc_chain, test_deserialize_typed_list);
+  tcase_add_test (tc_chain, test_intersect_string_lists);
 
   return s;
 }
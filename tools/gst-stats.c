@@ -44,6 +44,13 @@ static GstClockTime last_ts = G_GUINT64_CONSTANT (0);
 static guint total_cpuload = 0;
 static gboolean have_cpuload = FALSE;
 
+/* negotiation statistics */
+#define MAX_NEGOTIATION_CHAINS 10
+static GHashTable *negotiation_pads = NULL;
+static GSList *negotiation_chains = NULL;
+static guint num_negotiation_chains = 0;
+static GstClockTime negotiation_time = G_GUINT64_CONSTANT (0);
+
 typedef struct
 {
   /* human readable pad name and details */
@@ -88,6 +95,28 @@ typedef struct
   guint cpuload;
 } GstThreadStats;
 
+typedef struct
+{
+  /* human readable pad name */
+  const gchar *name;
+  /* query statistics */
+  guint num_caps_queries, num_accept_caps_queries, num_cached, num_failed;
+  guint max_caps_size;
+  /* time spend in queries, and in queries without nested queries */
+  GstClockTime time, self_time;
+  /* caps operations while handling queries on this pad */
+  guint num_intersects, num_fixates;
+  GstClockTime intersect_time, fixate_time;
+} GstNegotiationStats;
+
+typedef struct
+{
+  /* time spend in a query that was not nested in another query */
+  GstClockTime time, ts;
+  /* pads along the slowest path of nested queries */
+  gchar *chain;
+} GstNegotiationChain;
+
 /* stats helper */
 
 static void
@@ -129,6 +158,52 @@ get_thread_stats (gpointer id)
   return stats;
 }
 
+static void
+free_negotiation_stats (gpointer data)
+{
+  g_slice_free (GstNegotiationStats, data);
+}
+
+static GstNegotiationStats *
+get_negotiation_stats (const gchar * name)
+{
+  GstNegotiationStats *stats;
+
+  /* caps operations outside of queries are logged without a pad */
+  if (!name)
+    name = "";
+
+  stats = g_hash_table_lookup (negotiation_pads, name);
+
+  if (G_UNLIKELY (!stats)) {
+    gchar *key = g_strdup (name);
+
+    stats = g_slice_new0 (GstNegotiationStats);
+    stats->name = key;
+    g_hash_table_insert (negotiation_pads, key, stats);
+  }
+  return stats;
+}
+
+static void
+free_negotiation_chain (gpointer data)
+{
+  GstNegotiationChain *chain = data;
+
+  g_free (chain->chain);
+  g_slice_free (GstNegotiationChain, chain);
+}
+
+static gint
+sort_negotiation_chains_by_time (gconstpointer c1, gconstpointer c2)
+{
+  const GstNegotiationChain *chain1 = c1, *chain2 = c2;
+
+  if (chain1->time == chain2->time)
+    return 0;
+  return (chain1->time < chain2->time) ? 1 : -1;
+}
+
 static void
 new_pad_stats (GstStructure * s)
 {
@@ -382,6 +457,88 @@ do_query_stats (GstStructure * s)
   elem_stats->num_queries++;
 }
 
+static void
+do_negotiation_query_stats (GstStructure * s)
+{
+  guint64 ts, time, self_time;
+  gboolean res, cached;
+  guint caps_size, depth;
+  const gchar *name;
+  GstNegotiationStats *stats;
+
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts,
+      "res", G_TYPE_BOOLEAN, &res, "cached", G_TYPE_BOOLEAN, &cached,
+      "caps-size", G_TYPE_UINT, &caps_size, "time", G_TYPE_UINT64, &time,
+      "self-time", G_TYPE_UINT64, &self_time, "depth", G_TYPE_UINT, &depth,
+      NULL);
+  last_ts = MAX (last_ts, ts);
+
+  stats = get_negotiation_stats (gst_structure_get_string (s, "pad"));
+  name = gst_structure_get_string (s, "name");
+  if (!g_strcmp0 (name, "caps"))
+    stats->num_caps_queries++;
+  else
+    stats->num_accept_caps_queries++;
+  if (cached)
+    stats->num_cached++;
+  if (!res)
+    stats->num_failed++;
+  stats->max_caps_size = MAX (stats->max_caps_size, caps_size);
+  stats->time += time;
+  stats->self_time += self_time;
+
+  /* keep the slowest chains of queries */
+  if (depth == 0) {
+    GstNegotiationChain *chain;
+
+    negotiation_time += time;
+
+    chain = g_slice_new (GstNegotiationChain);
+    chain->time = time;
+    chain->ts = ts;
+    chain->chain = g_strdup (gst_structure_get_string (s, "chain"));
+    negotiation_chains = g_slist_insert_sorted (negotiation_chains, chain,
+        sort_negotiation_chains_by_time);
+    if (++num_negotiation_chains > MAX_NEGOTIATION_CHAINS) {
+      GSList *last = g_slist_last (negotiation_chains);
+
+      free_negotiation_chain (last->data);
+      negotiation_chains = g_slist_delete_link (negotiation_chains, last);
+      num_negotiation_chains--;
+    }
+  }
+}
+
+static void
+do_negotiation_intersect_stats (GstStructure * s)
+{
+  guint64 ts, time;
+  GstNegotiationStats *stats;
+
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts,
+      "time", G_TYPE_UINT64, &time, NULL);
+  last_ts = MAX (last_ts, ts);
+
+  stats = get_negotiation_stats (gst_structure_get_string (s, "pad"));
+  stats->num_intersects++;
+  stats->intersect_time += time;
+}
+
+static void
+do_negotiation_fixate_stats (GstStructure * s)
+{
+  guint64 ts, time;
+  GstNegotiationStats *stats;
+
+  gst_structure_get (s, "ts", G_TYPE_UINT64, &ts,
+      "time", G_TYPE_UINT64, &time, NULL);
+  last_ts = MAX (last_ts, ts);
+
+  stats = get_negotiation_stats (gst_structure_get_string (s, "pad"));
+  stats->num_fixates++;
+  stats->fixate_time += time;
+}
+
 static void
 do_thread_rusage_stats (GstStructure * s)
 {
@@ -540,6 +697,32 @@ accum_element_stats (gpointer value, gpointer user_data)
   }
 }
 
+static void
+print_negotiation_stats (gpointer value, gpointer user_data)
+{
+  GstNegotiationStats *stats = (GstNegotiationStats *) value;
+
+  printf ("  %-40.40s: caps/accept-caps queries %5u/%5u (cached %5u, "
+      "failed %5u, max caps size %3u), time %" GST_TIME_FORMAT ", self %"
+      GST_TIME_FORMAT ", intersect %5u in %" GST_TIME_FORMAT ", fixate %5u in %"
+      GST_TIME_FORMAT "\n", *stats->name ? stats->name : "(no query)",
+      stats->num_caps_queries, stats->num_accept_caps_queries,
+      stats->num_cached, stats->num_failed, stats->max_caps_size,
+      GST_TIME_ARGS (stats->time), GST_TIME_ARGS (stats->self_time),
+      stats->num_intersects, GST_TIME_ARGS (stats->intersect_time),
+      stats->num_fixates, GST_TIME_ARGS (stats->fixate_time));
+}
+
+static void
+print_negotiation_chain (gpointer value, gpointer user_data)
+{
+  GstNegotiationChain *chain = (GstNegotiationChain *) value;
+
+  printf ("  %" GST_TIME_FORMAT " at %" GST_TIME_FORMAT ": %s\n",
+      GST_TIME_ARGS (chain->time), GST_TIME_ARGS (chain->ts),
+      GST_STR_NULL (chain->chain));
+}
+
 /* sorting */
 
 static gint
@@ -556,6 +739,17 @@ sort_pad_stats_by_first_activity (gconstpointer ps1, gconstpointer ps2)
   return (order);
 }
 
+static gint
+sort_negotiation_stats_by_self_time (gconstpointer ns1, gconstpointer ns2)
+{
+  const GstNegotiationStats *s1 = ns1, *s2 = ns2;
+
+  /* the self time already includes the intersect and fixate time */
+  if (s1->self_time == s2->self_time)
+    return 0;
+  return (s1->self_time < s2->self_time) ? 1 : -1;
+}
+
 static void
 sort_pad_stats (gpointer value, gpointer user_data)
 {
@@ -668,6 +862,8 @@ init (void)
   elements = g_ptr_array_new_with_free_func (free_element_stats);
   pads = g_ptr_array_new_with_free_func (free_pad_stats);
   threads = g_hash_table_new_full (NULL, NULL, NULL, free_thread_stats);
+  negotiation_pads = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+      free_negotiation_stats);
 
   return TRUE;
 }
@@ -681,6 +877,9 @@ done (void)
     g_ptr_array_free (elements, TRUE);
   if (threads)
     g_hash_table_destroy (threads);
+  if (negotiation_pads)
+    g_hash_table_destroy (negotiation_pads);
+  g_slist_free_full (negotiation_chains, free_negotiation_chain);
 
   if (raw_log)
     g_regex_unref (raw_log);
@@ -758,6 +957,24 @@ print_stats (void)
     puts ("");
     g_slist_free (list);
   }
+
+  /* negotiation stats */
+  if (g_hash_table_size (negotiation_pads)) {
+    GList *list;
+
+    puts ("Negotiation Statistics:");
+    printf ("  Time: %" GST_TIME_FORMAT "\n", GST_TIME_ARGS (negotiation_time));
+    /* sort by time spent on the pad itself */
+    list = g_hash_table_get_values (negotiation_pads);
+    list = g_list_sort (list, sort_negotiation_stats_by_self_time);
+    g_list_foreach (list, print_negotiation_stats, NULL);
+    g_list_free (list);
+    puts ("");
+
+    puts ("Slowest Negotiation Chains:");
+    g_slist_foreach (negotiation_chains, print_negotiation_chain, NULL);
+    puts ("");
+  }
 }
 
 static void
@@ -812,6 +1029,12 @@ collect_stats (const gchar * filename)
                   do_thread_rusage_stats (s);
                 } else if (!strcmp (name, "proc-rusage")) {
                   do_proc_rusage_stats (s);
+                } else if (!strcmp (name, "negotiation-query")) {
+                  do_negotiation_query_stats (s);
+                } else if (!strcmp (name, "negotiation-intersect")) {
+                  do_negotiation_intersect_stats (s);
+                } else if (!strcmp (name, "negotiation-fixate")) {
+                  do_negotiation_fixate_stats (s);
                 } else {
                   // TODO(ensonic): parse the xxx.class log lines
                   if (!g_str_has_suffix (data, ".class")) {